@@ -10,6 +10,7 @@
 #include "esp_event.h"
 #include "nvs_flash.h"
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -102,12 +103,49 @@ private:
                 std::cout << "Reply: ";
                 std::cout.write(reply_, length);
                 std::cout << "\n";
+#if CONFIG_EXAMPLE_ECHO_BENCHMARK
+                echo_start_ = std::chrono::steady_clock::now();
+                echo_block();
+#endif // CONFIG_EXAMPLE_ECHO_BENCHMARK
             } else {
                 std::cout << "Read failed: " << error.message() << "\n";
             }
         });
     }
 
+#if CONFIG_EXAMPLE_ECHO_BENCHMARK
+    // Sends blocks of max_length bytes and waits for every block to be echoed back by the server
+    void echo_block()
+    {
+        if (echoed_ >= CONFIG_EXAMPLE_ECHO_BENCHMARK_SIZE * 1024) {
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - echo_start_).count();
+            std::cout << "Echo benchmark: " << echoed_ << " bytes in " << ms << " ms, "
+                      << (ms > 0 ? echoed_ / ms : 0) << " KB/s\n";
+            return;
+        }
+        std::memset(request_, 'a' + (echoed_ / max_length) % 26, max_length);
+        asio::async_write(socket_, asio::buffer(request_, max_length),
+        [this](const std::error_code & error, std::size_t length) {
+            if (error) {
+                std::cout << "Write failed: " << error.message() << "\n";
+                return;
+            }
+            asio::async_read(socket_, asio::buffer(reply_, length),
+            [this](const std::error_code & error, std::size_t length) {
+                if (error || std::memcmp(reply_, request_, length) != 0) {
+                    std::cout << "Echo failed: " << error.message() << "\n";
+                    return;
+                }
+                echoed_ += length;
+                echo_block();
+            });
+        });
+    }
+
+    std::chrono::steady_clock::time_point echo_start_;
+    std::size_t echoed_ = 0;
+#endif // CONFIG_EXAMPLE_ECHO_BENCHMARK
+
     asio::ssl::stream<tcp::socket> socket_;
     char request_[max_length] = "GET / HTTP/1.1\r\n\r\n";
     char reply_[max_length];
@@ -143,9 +181,11 @@ private:
         socket_.async_read_some(asio::buffer(data_),
         [this, self](const std::error_code & ec, std::size_t length) {
             if (!ec) {
+#if !CONFIG_EXAMPLE_ECHO_BENCHMARK
                 std::cout << "Server received: ";
                 std::cout.write(data_, length);
                 std::cout << std::endl;
+#endif
                 do_write(length);
             }
         });
@@ -1,43 +1,54 @@
 //
-// SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+// SPDX-FileCopyrightText: 2021-2024 Espressif Systems (Shanghai) CO LTD
 //
 // SPDX-License-Identifier: BSL-1.0
 //
 #pragma once
 
-#include "asio/ssl/context_base.hpp"
-#include "asio/ssl/context.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
 #include "sdkconfig.h"
 
 namespace asio {
 namespace ssl {
 namespace mbedtls {
 
+void throw_alloc_failure(const char *location);
+
+/**
+ * @brief One end of a BIO pair
+ *
+ * Every end owns a circular buffer, which it writes to and its peer reads from,
+ * so that no data are moved when the reader consumes the buffer partially.
+ */
 class bio {
-    static constexpr int BIO_SIZE = CONFIG_ASIO_SSL_BIO_SIZE;
+    static constexpr size_t BIO_SIZE = CONFIG_ASIO_SSL_BIO_SIZE;
     static constexpr int BIO_FLAGS_READ = 1;
     static constexpr int BIO_FLAGS_WRITE = 2;
 
 public:
+    using span = std::pair<uint8_t *, size_t>;
+    using const_span = std::pair<const uint8_t *, size_t>;
+
     int write(const void *buf, int len)
     {
         if (buf == nullptr || len <= 0) {
             // not an error, just empty operation (as in openssl/bio)
             return 0;
         }
-        int remaining = size_ - offset_;
-        if (remaining <= 0) {
+        if (len_ == BIO_SIZE) {
             flags_ |= BIO_FLAGS_WRITE;
             return -1;
         }
-        int len_to_write = len > remaining ? remaining : len;
-        std::memcpy(&data_[offset_], buf, len_to_write);
-        offset_ += len_to_write;
-        dlen_ = offset_;
-        if (len_to_write == len) {
+        size_t written = put(buf, len);
+        if (written == static_cast<size_t>(len)) {
             flags_ &= ~BIO_FLAGS_WRITE;
         }
-        return len_to_write;
+        return static_cast<int>(written);
     }
 
     int read(void *buf, int len)
@@ -46,35 +57,105 @@ public:
             // not an error, just empty operation (as in openssl/bio)
             return 0;
         }
-        int remaining = peer_->dlen_ - peer_->roffset_;
-        if (remaining <= 0) {
+        if (peer_->len_ == 0) {
             flags_ |= BIO_FLAGS_READ;
             return -1;
         }
-        int len_to_read = remaining > len ? len : remaining;
-        std::memcpy(buf, &peer_->data_[peer_->roffset_], len_to_read);
-        peer_->roffset_ += len_to_read;
-        if (len_to_read == len) {
+        size_t done = get(buf, len);
+        if (done == static_cast<size_t>(len)) {
             flags_ &= ~BIO_FLAGS_READ;
         }
-        if (peer_->offset_) {
-            // shift data back to the beginning of the buffer
-            std::memmove(&peer_->data_[0], &peer_->data_[peer_->roffset_], peer_->offset_ - peer_->roffset_);
-            peer_->offset_ -= peer_->roffset_;
-            peer_->roffset_ = 0;
-            peer_->dlen_ = peer_->offset_;
+        return static_cast<int>(done);
+    }
+
+    /**
+     * @brief Copies as much of the data as fits to this end, without touching the flags
+     *
+     * @return Number of bytes copied, 0 if the buffer is full
+     */
+    size_t put(const void *buf, size_t len)
+    {
+        auto src = static_cast<const uint8_t *>(buf);
+        size_t done = 0;
+        span free;
+        // at most two chunks: up to the end of the buffer and from its beginning
+        while (done < len && (free = write_span()).second > 0) {
+            size_t chunk = std::min(free.second, len - done);
+            std::memcpy(free.first, src + done, chunk);
+            commit(chunk);
+            done += chunk;
+        }
+        return done;
+    }
+
+    /**
+     * @brief Copies up to len bytes written by the peer, without touching the flags
+     *
+     * @return Number of bytes copied, 0 if there's nothing to read
+     */
+    size_t get(void *buf, size_t len)
+    {
+        auto dst = static_cast<uint8_t *>(buf);
+        size_t done = 0;
+        const_span data;
+        while (done < len && (data = read_span()).second > 0) {
+            size_t chunk = std::min(data.second, len - done);
+            std::memcpy(dst + done, data.first, chunk);
+            consume(chunk);
+            done += chunk;
+        }
+        return done;
+    }
+
+    /**
+     * @brief Contiguous free space of this end, to be filled and then committed
+     *
+     * Empty if the buffer is full, the rest of the free space (after wrapping around) is returned
+     * by the next call once the span is committed.
+     */
+    span write_span()
+    {
+        size_t tail = head_ + len_;
+        if (tail >= BIO_SIZE) {
+            tail -= BIO_SIZE;
+            return { &data_[tail], head_ - tail };
         }
-        return len_to_read;
+        return { &data_[tail], BIO_SIZE - tail };
+    }
+
+    /**
+     * @brief Makes the first len bytes of the write_span() available to the peer
+     */
+    void commit(size_t len)
+    {
+        len_ += len;
+    }
+
+    /**
+     * @brief Contiguous data written by the peer, to be consumed after processing
+     */
+    const_span read_span() const
+    {
+        return { &peer_->data_[peer_->head_], std::min(peer_->len_, BIO_SIZE - peer_->head_) };
+    }
+
+    /**
+     * @brief Releases the first len bytes of the read_span() to the peer
+     */
+    void consume(size_t len)
+    {
+        peer_->len_ -= len;
+        peer_->head_ = peer_->len_ == 0 ? 0 : (peer_->head_ + len) % BIO_SIZE;
     }
 
     size_t wpending() const
     {
-        return dlen_ - roffset_;
+        return len_;
     }
 
     size_t ctrl_pending()
     {
-        return peer_->dlen_ - peer_->roffset_;
+        return peer_->len_;
     }
 
     bool should_write() const
@@ -94,19 +175,17 @@ public:
         if (b1 == nullptr || b2 == nullptr) {
             throw_alloc_failure(error_location);
         } else {
-            b1->peer_ = b2;
-            b2->peer_ = b1;
+            b1->peer_ = b2.get();
+            b2->peer_ = b1.get();
         }
         return std::make_pair(b1, b2);
     }
 
 private:
     std::array<uint8_t, BIO_SIZE> data_ {};
-    size_t size_ {BIO_SIZE};
-    std::shared_ptr<bio> peer_ {nullptr};
-    int dlen_ {0};
-    size_t offset_ {0};
-    size_t roffset_ {0};
+    bio *peer_ {nullptr};   // both ends are owned by the pair, a shared_ptr here would be a cycle
+    size_t head_ {0};   // first byte to be read by the peer
+    size_t len_ {0};    // bytes written and not read yet
     size_t flags_ {0};
 };
 
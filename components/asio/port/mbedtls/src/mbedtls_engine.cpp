@@ -3,7 +3,7 @@
 //
 // SPDX-License-Identifier: BSL-1.0
 //
-// SPDX-FileContributor: 2021-2022 Espressif Systems (Shanghai) CO LTD
+// SPDX-FileContributor: 2021-2024 Espressif Systems (Shanghai) CO LTD
 //
 
 #include "asio/detail/config.hpp"
@@ -87,19 +87,17 @@ engine::want engine::read(const asio::mutable_buffer &data,
 asio::mutable_buffer engine::get_output(
     const asio::mutable_buffer &data)
 {
-    int length = ssl_->ext_bio()->read(data.data(), static_cast<int>(data.size()));
+    std::size_t length = ssl_->ext_bio()->get(data.data(), data.size());
 
-    return asio::buffer(data,
-                        length > 0 ? static_cast<std::size_t>(length) : 0);
+    return asio::buffer(data, length);
 }
 
 asio::const_buffer engine::put_input(
     const asio::const_buffer &data)
 {
-    int length = ssl_->ext_bio()->write(data.data(), static_cast<int>(data.size()));
+    std::size_t length = ssl_->ext_bio()->put(data.data(), data.size());
 
-    return asio::buffer(data +
-                        (length > 0 ? static_cast<std::size_t>(length) : 0));
+    return asio::buffer(data + length);
 }
 
 const asio::error_code &engine::map_error_code(
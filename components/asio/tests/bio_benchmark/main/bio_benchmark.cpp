@@ -0,0 +1,192 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "mbedtls_bio.hpp"
+
+using asio::ssl::mbedtls::bio;
+
+namespace {
+constexpr size_t header = 5;                        // TLS record header
+constexpr size_t stream_bytes = static_cast<size_t>(CONFIG_BIO_BENCHMARK_MB) << 20;
+std::vector<uint8_t> s_source;                      // transport data, repeated
+std::vector<uint8_t> s_sink;
+}
+
+namespace asio::ssl::mbedtls {
+void throw_alloc_failure(const char *location)
+{
+    printf("Failed to allocate %s\n", location);
+    abort();
+}
+}
+
+namespace {
+
+std::vector<int> parse_list(const char *list)
+{
+    std::vector<int> values;
+    for (const char *p = list; *p; ++p) {
+        int value = atoi(p);
+        if (value > 0) {
+            values.push_back(value);
+        }
+        while (*p && *p != ',') {
+            ++p;
+        }
+        if (!*p) {
+            break;
+        }
+    }
+    return values;
+}
+
+/**
+ * Reads one record as mbedtls does: the header first, then the body, each of them possibly
+ * in several calls if the BIO runs out of data
+ */
+struct RecordReader {
+    size_t record;
+    size_t done{0};
+    uint8_t buf[header + 16384]{};
+
+    // returns false if the BIO is empty
+    bool read_some(bio &ssl_bio)
+    {
+        size_t want = done < header ? header - done : header + record - done;
+        int ret = ssl_bio.read(buf + done, static_cast<int>(want));
+        if (ret <= 0) {
+            return false;
+        }
+        done += ret;
+        if (done == header + record) {
+            done = 0;
+        }
+        return true;
+    }
+};
+
+/**
+ * Transport chunks are put into the BIO (engine::put_input()) and records are read from it by the SSL end
+ */
+double bench_input(size_t record, size_t chunk)
+{
+    auto pair = bio::new_pair("bio-benchmark");
+    bio &ssl_bio = *pair.first;
+    bio &ext_bio = *pair.second;
+    RecordReader reader{record};
+    size_t moved = 0;
+    size_t offset = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (moved < stream_bytes) {
+        // put_input(): one chunk received from the socket, as much of it as fits
+        size_t put = ext_bio.put(&s_source[offset], chunk);
+        offset = (offset + put) % (s_source.size() - chunk);
+        moved += put;
+        while (reader.read_some(ssl_bio)) {
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return moved / secs / (1 << 20);
+}
+
+/**
+ * Records are written to the BIO by the SSL end and taken out in transport chunks (engine::get_output())
+ */
+double bench_output(size_t record, size_t chunk)
+{
+    auto pair = bio::new_pair("bio-benchmark");
+    bio &ssl_bio = *pair.first;
+    bio &ext_bio = *pair.second;
+    size_t written = 0;     // of the current record
+    size_t moved = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (moved < stream_bytes) {
+        int ret;
+        while ((ret = ssl_bio.write(&s_source[written], static_cast<int>(header + record - written))) > 0) {
+            written = (written + ret) % (header + record);
+        }
+        // get_output(): one chunk to be sent to the socket
+        moved += ext_bio.get(s_sink.data(), chunk);
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return moved / secs / (1 << 20);
+}
+
+/**
+ * Checks that the bytes read out of the pair are the ones written into it, in both directions:
+ * the SSL end writes (write()) and the engine takes the output (get()), while the engine puts
+ * the input (put()) and the SSL end reads it (read())
+ */
+bool check_stream()
+{
+    auto pair = bio::new_pair("bio-benchmark");
+    bio &ssl_bio = *pair.first;
+    bio &ext_bio = *pair.second;
+    uint8_t buf[3 * CONFIG_BIO_BENCHMARK_BIO_SIZE / 2];
+    size_t in[2] = {};     // written to the pair, per direction
+    size_t out[2] = {};    // read out of the pair and checked
+    unsigned seed = 1;
+    while (out[0] < s_source.size() || out[1] < s_source.size()) {
+        seed = seed * 1103515245 + 12345;
+        size_t len = (seed >> 8) % sizeof(buf) + 1;
+        int dir = (seed >> 6) & 1;      // 0: SSL end -> engine, 1: engine -> SSL end
+        size_t got;
+        if (seed & 0x80) {
+            len = std::min(len, s_source.size() - in[dir]);
+            if (dir == 0) {
+                int ret = ssl_bio.write(&s_source[in[dir]], static_cast<int>(len));
+                in[dir] += ret > 0 ? ret : 0;
+            } else {
+                in[dir] += ext_bio.put(&s_source[in[dir]], len);
+            }
+            continue;
+        }
+        if (dir == 0) {
+            got = ext_bio.get(buf, len);
+        } else {
+            int ret = ssl_bio.read(buf, static_cast<int>(len));
+            got = ret > 0 ? ret : 0;
+        }
+        if (got > in[dir] - out[dir] || memcmp(buf, &s_source[out[dir]], got) != 0) {
+            return false;
+        }
+        out[dir] += got;
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * Linux target only: throughput of the BIO pair of the asio mbedtls engine
+ */
+int main()
+{
+    s_source.resize(1 << 20);
+    s_sink.resize(1 << 16);
+    for (size_t i = 0; i < s_source.size(); ++i) {
+        s_source[i] = static_cast<uint8_t>(i * 31 + (i >> 8));
+    }
+    if (!check_stream()) {
+        printf("BIO pair corrupted the data\n");
+        return 1;
+    }
+    for (int record : parse_list(CONFIG_BIO_BENCHMARK_RECORD_SIZES)) {
+        for (int chunk : parse_list(CONFIG_BIO_BENCHMARK_CHUNK_SIZES)) {
+            if (record > 16384 || chunk > static_cast<int>(s_sink.size())) {
+                continue;
+            }
+            printf("{\"test\": \"bio_input\", \"bio_size\": %d, \"record\": %d, \"chunk\": %d, \"mb_per_sec\": %.1f}\n",
+                   CONFIG_BIO_BENCHMARK_BIO_SIZE, record, chunk, bench_input(record, chunk));
+            printf("{\"test\": \"bio_output\", \"bio_size\": %d, \"record\": %d, \"chunk\": %d, \"mb_per_sec\": %.1f}\n",
+                   CONFIG_BIO_BENCHMARK_BIO_SIZE, record, chunk, bench_output(record, chunk));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_console.h"
+#include "eppp_link.h"
+
+#define TRACE_PRINT_ENTRIES 32
+
+static const char *TAG = "eppp_console";
+
+typedef struct eppp_op_t {
+    char *name;
+    esp_err_t (*operation)(struct eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif);
+    int arg_cnt;
+    int start_index;
+    char *help;
+    int netif_flag;
+} eppp_op_t;
+
+static esp_err_t eppp_help_op(eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif);
+static esp_err_t eppp_print_op(eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif);
+static esp_err_t eppp_reset_op(eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif);
+static esp_err_t eppp_trace_op(eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif);
+
+static eppp_op_t cmd_list[] = {
+    {.name = "help",      .operation = eppp_help_op,    .arg_cnt = 2, .start_index = 1, .netif_flag = false,  .help = "eppp help: Prints the help text for all eppp commands"},
+    {.name = "eppp",      .operation = eppp_print_op,   .arg_cnt = 1, .start_index = 0, .netif_flag = false,  .help = "eppp: Display the link statistics of all eppp interfaces"},
+    {.name = "eppp",      .operation = eppp_print_op,   .arg_cnt = 2, .start_index = 0, .netif_flag = true,   .help = "eppp <iface>: Display the link statistics of the named interface"},
+    {.name = "reset",     .operation = eppp_reset_op,   .arg_cnt = 3, .start_index = 2, .netif_flag = true,   .help = "eppp <iface> reset: Clear the statistics and the trace of the named interface"},
+    {.name = "trace",     .operation = eppp_trace_op,   .arg_cnt = 3, .start_index = 2, .netif_flag = true,   .help = "eppp <iface> trace: Display the last SPI transactions (CONFIG_EPPP_LINK_TRACE_ENTRIES)"},
+};
+
+static esp_err_t eppp_help_op(eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif)
+{
+    int cmd_count = sizeof(cmd_list) / sizeof(cmd_list[0]);
+
+    for (int i = 0; i < cmd_count; i++) {
+        if ((cmd_list[i].help != NULL) && (strlen(cmd_list[i].help) != 0)) {
+            printf(" %s\n", cmd_list[i].help);
+        }
+    }
+
+    return ESP_OK;
+}
+
+static bool is_eppp_netif(esp_netif_t *esp_netif)
+{
+    const char *ifkey = esp_netif_get_ifkey(esp_netif);
+    return ifkey && strncmp(ifkey, "EPPP", 4) == 0;
+}
+
+static esp_netif_t *get_esp_netif_from_ifname(char *if_name)
+{
+    esp_netif_t *esp_netif = NULL;
+    char interface[10];
+
+    while ((esp_netif = esp_netif_next_unsafe(esp_netif)) != NULL) {
+        if (esp_netif_get_netif_impl_name(esp_netif, interface) != ESP_OK) {
+            continue;
+        }
+        if (!strcmp(interface, if_name)) {
+            return is_eppp_netif(esp_netif) ? esp_netif : NULL;
+        }
+    }
+
+    return NULL;
+}
+
+static void print_stats(esp_netif_t *esp_netif)
+{
+    eppp_stats_t s;
+    char interface[10] = "";
+
+    if (eppp_get_stats(esp_netif, &s) != ESP_OK) {
+        return;
+    }
+    esp_netif_get_netif_impl_name(esp_netif, interface);
+    printf("%s (%s):\n", interface, esp_netif_get_desc(esp_netif));
+    printf("\tTX: packets %" PRIu32 ", bytes %" PRIu64 ", dropped %" PRIu32 "\n", s.tx_packets, s.tx_bytes, s.tx_dropped);
+    printf("\tRX: packets %" PRIu32 ", bytes %" PRIu64 ", dropped %" PRIu32 ", errors %" PRIu32 "\n", s.rx_packets, s.rx_bytes, s.rx_dropped, s.rx_errors);
+    if (s.transactions == 0) {
+        return;
+    }
+    printf("\tTransactions: %" PRIu32 " (header only %" PRIu32 "), size avg %" PRIu32 " max %" PRIu32 ", master wants read %" PRIu32 "\n",
+           s.transactions, s.empty_transactions, (uint32_t)(s.transaction_bytes / s.transactions), s.transaction_max, s.master_wants_read);
+    printf("\tTX buffers in use: %" PRIu32 ", max %" PRIu32 "\n", s.tx_queue_depth, s.tx_queue_max);
+    if (s.latency_samples) {
+        printf("\tLatency from ready signal: avg %" PRIu32 " us, max %" PRIu32 " us\n",
+               (uint32_t)(s.latency_sum_us / s.latency_samples), s.latency_max_us);
+    }
+}
+
+static esp_err_t eppp_print_op(eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif)
+{
+    if (esp_netif) {
+        print_stats(esp_netif);
+        return ESP_OK;
+    }
+
+    while ((esp_netif = esp_netif_next_unsafe(esp_netif)) != NULL) {
+        if (is_eppp_netif(esp_netif)) {
+            print_stats(esp_netif);
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t eppp_reset_op(eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif)
+{
+    return eppp_reset_stats(esp_netif);
+}
+
+static esp_err_t eppp_trace_op(eppp_op_t *self, int argc, char *argv[], esp_netif_t *esp_netif)
+{
+    eppp_trace_entry_t entries[TRACE_PRINT_ENTRIES];
+    size_t count = eppp_get_trace(esp_netif, entries, TRACE_PRINT_ENTRIES);
+
+    if (count == 0) {
+        printf("No transactions traced (CONFIG_EPPP_LINK_TRACE_ENTRIES)\n");
+        return ESP_OK;
+    }
+    printf("%12s %6s %6s %6s %6s %10s\n", "time [us]", "event", "size", "tx", "rx", "latency");
+    for (size_t i = 0; i < count; i++) {
+        eppp_trace_entry_t *e = &entries[i];
+        printf("%12" PRId64 " %6s %6u %6u %6u %10" PRIu32 "\n", e->timestamp_us,
+               e->event == EPPP_TRACE_ERROR ? "error" : "trans", e->size, e->tx_len, e->rx_len, e->latency_us);
+    }
+
+    return ESP_OK;
+}
+
+/* handle 'eppp' command */
+static int do_cmd_eppp(int argc, char **argv)
+{
+    esp_netif_t *esp_netif = NULL;
+    int cmd_count = sizeof(cmd_list) / sizeof(cmd_list[0]);
+    eppp_op_t cmd;
+
+    for (int i = 0; i < cmd_count; i++) {
+        cmd = cmd_list[i];
+
+        if (argc < cmd.start_index + 1) {
+            continue;
+        }
+
+        if (!strcmp(cmd.name, argv[cmd.start_index])) {
+
+            /* Get interface for eligible commands */
+            if (cmd.netif_flag == true) {
+                esp_netif = get_esp_netif_from_ifname(argv[1]);
+                if (NULL == esp_netif) {
+                    ESP_LOGE(TAG, "eppp interface %s not available", argv[1]);
+                    return 0;
+                }
+            }
+
+            if (cmd.arg_cnt == argc) {
+                if (cmd.operation != NULL) {
+                    if (cmd.operation(&cmd, argc, argv, esp_netif) != ESP_OK) {
+                        ESP_LOGE(TAG, "Usage:\n%s", cmd.help);
+                        return 0;
+                    }
+                }
+                return 0;
+            }
+        }
+    }
+
+    ESP_LOGE(TAG, "Command not available");
+
+    return 1;
+}
+
+esp_err_t eppp_console_cmd_register(void)
+{
+    esp_err_t ret;
+    esp_console_cmd_t command = {
+        .command = "eppp",
+        .help = "Statistics and transaction trace of eppp links\nFor more info run 'eppp help'",
+        .func = &do_cmd_eppp
+    };
+
+    ret = esp_console_cmd_register(&command);
+    if (ret) {
+        ESP_LOGE(TAG, "Unable to register eppp");
+    }
+
+    return ret;
+}
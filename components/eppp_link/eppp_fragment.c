@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "esp_log.h"
+#include "eppp_transport.h"
+
+static const char *TAG = "eppp_fragment";
+
+void eppp_reassemble(struct eppp_handle *h, struct eppp_reassembly *r, const struct eppp_fragment_header *head, uint8_t *data)
+{
+    bool in_order = head->seq == r->next_seq;
+    bool first = head->flags & EPPP_FRAGMENT_FIRST;
+    r->next_seq = head->seq + 1;
+    if (!in_order) {
+        // the rest of the buffered message or the beginning of this one has been lost
+        if (r->fill > 0 || !first) {
+            ESP_LOGD(TAG, "Fragment out of order (seq=%u), dropping %u bytes", head->seq, (unsigned)r->fill);
+            EPPP_STATS_ADD(h->stats.rx_dropped, 1);
+        }
+        r->fill = 0;
+        r->discard = true;
+    }
+    if (head->flags & EPPP_FRAGMENT_CHANNEL) {
+        // sent in one piece, might come between the fragments of a message, which stays buffered
+        if (head->flags & EPPP_FRAGMENT_MORE) {
+            h->stats.rx_errors++;
+            return;
+        }
+        eppp_channel_deliver(h, data, head->len);
+        return;
+    }
+    if (first) {
+        r->discard = false;
+    }
+    if (r->discard) {
+        // middle or last fragment of a message whose beginning has been lost
+        return;
+    }
+    bool last = !(head->flags & EPPP_FRAGMENT_MORE);
+    if (r->fill == 0 && last) {
+        eppp_deliver(h, data, head->len);
+        return;
+    }
+    if (r->fill + head->len > sizeof(r->buffer)) {
+        eppp_deliver(h, r->buffer, r->fill);
+        r->fill = 0;
+    }
+    memcpy(r->buffer + r->fill, data, head->len);
+    r->fill += head->len;
+    if (last) {
+        eppp_deliver(h, r->buffer, r->fill);
+        r->fill = 0;
+    }
+}
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "eppp_frame.h"
+
+static const char *TAG = "eppp_frame";
+
+static size_t encode(uint16_t magic, const void *packet, size_t len, uint8_t *out)
+{
+    struct eppp_frame_header head = { .magic = magic, .len = len };
+    memcpy(out, &head, sizeof(head));
+    memcpy(out + sizeof(head), packet, len);
+    uint32_t crc = esp_rom_crc32_le(0, out, sizeof(head) + len);
+    memcpy(out + sizeof(head) + len, &crc, sizeof(crc));
+    return len + EPPP_FRAME_OVERHEAD;
+}
+
+size_t eppp_frame_encode(const void *packet, size_t len, uint8_t *out)
+{
+    if (len > EPPP_FRAME_MTU) {
+        return 0;
+    }
+    return encode(EPPP_FRAME_MAGIC, packet, len, out);
+}
+
+size_t eppp_frame_encode_channel(const void *message, size_t len, uint8_t *out)
+{
+    if (len > EPPP_CHANNEL_MAX_SIZE) {
+        return 0;
+    }
+    return encode(EPPP_FRAME_MAGIC_CHANNEL, message, len, out);
+}
+
+void eppp_frame_decoder_init(struct eppp_frame_decoder *d, eppp_frame_cb_t cb, void *ctx)
+{
+    d->cb = cb;
+    d->ctx = ctx;
+    d->channel_cb = NULL;
+    d->channel_ctx = NULL;
+    d->errors = 0;
+    d->fill = 0;
+}
+
+static size_t skip_byte(struct eppp_frame_decoder *d, bool *in_sync)
+{
+    if (*in_sync) {
+        d->errors++;    // count the garbage once, not every skipped byte
+        *in_sync = false;
+    }
+    return 1;
+}
+
+// Returns number of consumed bytes, 0 if the frame is not complete yet
+static size_t parse(struct eppp_frame_decoder *d, uint8_t *data, size_t len, bool *in_sync)
+{
+    struct eppp_frame_header head;
+    if (len < sizeof(head)) {
+        return 0;
+    }
+    memcpy(&head, data, sizeof(head));
+    bool channel = head.magic == EPPP_FRAME_MAGIC_CHANNEL;
+    size_t max_len = channel ? EPPP_CHANNEL_MAX_SIZE : EPPP_FRAME_MTU;
+    if ((head.magic != EPPP_FRAME_MAGIC && !channel) || head.len > max_len) {
+        return skip_byte(d, in_sync);
+    }
+    size_t total = head.len + EPPP_FRAME_OVERHEAD;
+    if (len < total) {
+        return 0;
+    }
+    uint32_t crc;
+    memcpy(&crc, data + sizeof(head) + head.len, sizeof(crc));
+    if (crc != esp_rom_crc32_le(0, data, sizeof(head) + head.len)) {
+        return skip_byte(d, in_sync);
+    }
+    *in_sync = true;
+    if (!channel) {
+        d->cb(d->ctx, data + sizeof(head), head.len);
+    } else if (d->channel_cb) {
+        d->channel_cb(d->channel_ctx, data + sizeof(head), head.len);
+    }
+    return total;
+}
+
+void eppp_frame_decode(struct eppp_frame_decoder *d, uint8_t *data, size_t len)
+{
+    bool in_sync = true;
+    size_t used;
+    while (len > 0) {
+        if (d->fill == 0) {
+            // nothing buffered: pass complete frames directly from the chunk
+            while ((used = parse(d, data, len, &in_sync)) > 0) {
+                data += used;
+                len -= used;
+            }
+            memcpy(d->buffer, data, len);   // less than one frame
+            d->fill = len;
+            return;
+        }
+        size_t copy = sizeof(d->buffer) - d->fill;
+        if (copy > len) {
+            copy = len;
+        }
+        memcpy(d->buffer + d->fill, data, copy);
+        d->fill += copy;
+        data += copy;
+        len -= copy;
+        size_t offset = 0;
+        while ((used = parse(d, d->buffer + offset, d->fill - offset, &in_sync)) > 0) {
+            offset += used;
+        }
+        memmove(d->buffer, d->buffer + offset, d->fill - offset);
+        d->fill -= offset;
+    }
+}
+
+static void raw_link_channel(void *ctx, uint8_t *message, size_t len)
+{
+    eppp_channel_deliver(ctx, message, len);
+}
+
+static esp_err_t raw_link_receive(struct eppp_handle *h, void *buffer, size_t len)
+{
+    eppp_frame_decode(&h->raw->decoder, buffer, len);
+    return ESP_OK;
+}
+
+esp_err_t eppp_raw_link_init(struct eppp_handle *h, eppp_frame_cb_t deliver, void *ctx)
+{
+    h->raw = calloc(1, sizeof(struct eppp_raw_link));
+    if (h->raw == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate raw IP link");
+        return ESP_ERR_NO_MEM;
+    }
+    eppp_frame_decoder_init(&h->raw->decoder, deliver, ctx);
+    h->raw->decoder.channel_cb = raw_link_channel;
+    h->raw->decoder.channel_ctx = h;
+    h->raw_ip = true;
+    h->receive = raw_link_receive;
+    return ESP_OK;
+}
+
+void eppp_raw_link_deinit(struct eppp_handle *h)
+{
+    free(h->raw);
+    h->raw = NULL;
+}
+
+esp_err_t eppp_raw_link_transmit(void *handle, void *packet, size_t len)
+{
+    struct eppp_handle *h = handle;
+    size_t frame_len = eppp_frame_encode(packet, len, h->raw->tx_frame);
+    if (frame_len == 0) {
+        ESP_LOGE(TAG, "Packet of %u bytes exceeds MTU", (unsigned)len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return h->ops->transmit(h, h->raw->tx_frame, frame_len);
+}
+
+esp_err_t eppp_raw_link_transmit_channel(struct eppp_handle *h, const void *message, size_t len)
+{
+    size_t frame_len = eppp_frame_encode_channel(message, len, h->raw->channel_frame);
+    if (frame_len == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return h->ops->transmit(h, h->raw->channel_frame, frame_len);
+}
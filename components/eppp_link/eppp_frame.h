@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "eppp_transport.h"
+
+/*
+ * Raw IP framing: every IP packet is sent as
+ *   | magic (2) | length (2) | IP packet (length) | CRC32 of the header and the packet (4) |
+ * with no byte stuffing, so the overhead is constant. The magic is used to resynchronize
+ * the byte stream after an error. Messages of the control channel are framed the same way,
+ * with their own magic.
+ */
+#define EPPP_FRAME_MAGIC        0x9EE9
+#define EPPP_FRAME_MAGIC_CHANNEL 0x9EEA
+#define EPPP_FRAME_MTU          CONFIG_EPPP_LINK_MTU
+#define EPPP_FRAME_OVERHEAD     (sizeof(struct eppp_frame_header) + sizeof(uint32_t))
+#define EPPP_FRAME_MAX_SIZE     (EPPP_FRAME_MTU + EPPP_FRAME_OVERHEAD)
+
+struct eppp_frame_header {
+    uint16_t magic;
+    uint16_t len;
+} __attribute__((packed));
+
+_Static_assert(EPPP_FRAME_MAX_SIZE == EPPP_MAX_MESSAGE, "Transports reassemble whole raw IP frames");
+
+/**
+ * @brief Called for every received and verified IP packet
+ */
+typedef void (*eppp_frame_cb_t)(void *ctx, uint8_t *packet, size_t len);
+
+struct eppp_frame_decoder {
+    eppp_frame_cb_t cb;
+    void *ctx;
+    eppp_frame_cb_t channel_cb;             // called with messages of the control channel, NULL to drop them
+    void *channel_ctx;
+    uint32_t errors;                        // number of dropped frames or garbage chunks
+    size_t fill;
+    uint8_t buffer[EPPP_FRAME_MAX_SIZE];    // partial frame, if the transport splits them
+};
+
+/**
+ * @brief Encodes one IP packet
+ *
+ * @param out Buffer of at least len + EPPP_FRAME_OVERHEAD bytes
+ * @return Size of the frame, 0 if the packet is too big
+ */
+size_t eppp_frame_encode(const void *packet, size_t len, uint8_t *out);
+
+/**
+ * @brief Encodes one message of the control channel
+ *
+ * @param out Buffer of at least len + EPPP_FRAME_OVERHEAD bytes
+ * @return Size of the frame, 0 if the message is too big
+ */
+size_t eppp_frame_encode_channel(const void *message, size_t len, uint8_t *out);
+
+void eppp_frame_decoder_init(struct eppp_frame_decoder *d, eppp_frame_cb_t cb, void *ctx);
+
+/**
+ * @brief Decodes the received chunk of the stream and passes complete packets to the callback
+ *
+ * Complete frames are passed directly from the chunk, only partial frames are buffered.
+ */
+void eppp_frame_decode(struct eppp_frame_decoder *d, uint8_t *data, size_t len);
+
+/**
+ * @brief Raw IP mode of one link: frames outgoing packets and decodes incoming ones
+ */
+struct eppp_raw_link {
+    struct eppp_frame_decoder decoder;
+    uint8_t tx_frame[EPPP_FRAME_MAX_SIZE];
+    uint8_t channel_frame[EPPP_CHANNEL_MAX_SIZE + EPPP_FRAME_OVERHEAD];   // the channel is sent from another task
+};
+
+/**
+ * @brief Switches the transport handle to raw IP mode
+ *
+ * @param deliver Called with every received IP packet
+ */
+esp_err_t eppp_raw_link_init(struct eppp_handle *h, eppp_frame_cb_t deliver, void *ctx);
+
+void eppp_raw_link_deinit(struct eppp_handle *h);
+
+/**
+ * @brief Frames and transmits one IP packet (esp_netif driver's transmit in raw IP mode)
+ */
+esp_err_t eppp_raw_link_transmit(void *h, void *packet, size_t len);
+
+/**
+ * @brief Frames and transmits one message of the control channel
+ *
+ * Not thread safe, the channel is used from one task.
+ */
+esp_err_t eppp_raw_link_transmit_channel(struct eppp_handle *h, const void *message, size_t len);
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_netif_net_stack.h"
+#include "lwip/esp_netif_net_stack.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "eppp_transport.h"
+#include "eppp_frame.h"
+
+#if CONFIG_EPPP_LINK_USES_RAW_IP
+
+static const char *TAG = "eppp_raw_ip";
+
+static void raw_input(void *h, void *buffer, size_t len, void *eb)
+{
+    struct netif *netif = h;
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+    if (p == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate pbuf");
+        return;
+    }
+    memcpy(p->payload, buffer, len);
+    if (netif->input(p, netif) != ERR_OK) {
+        pbuf_free(p);
+    }
+}
+
+static err_t raw_output(struct netif *netif, struct pbuf *p)
+{
+    esp_err_t ret;
+    if (p->next == NULL) {
+        ret = esp_netif_transmit(netif->state, p->payload, p->len);
+    } else {
+        uint8_t *packet = malloc(p->tot_len);
+        if (packet == NULL) {
+            return ERR_MEM;
+        }
+        pbuf_copy_partial(p, packet, p->tot_len, 0);
+        ret = esp_netif_transmit(netif->state, packet, p->tot_len);
+        free(packet);
+    }
+    return ret == ESP_OK ? ERR_OK : ERR_IF;
+}
+
+static err_t raw_output_v4(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    return raw_output(netif, p);
+}
+
+#if LWIP_IPV6
+static err_t raw_output_v6(struct netif *netif, struct pbuf *p, const ip6_addr_t *ipaddr)
+{
+    return raw_output(netif, p);
+}
+#endif
+
+static err_t raw_init(struct netif *netif)
+{
+    netif->name[0] = 'r';
+    netif->name[1] = 'w';
+    netif->output = raw_output_v4;
+#if LWIP_IPV6
+    netif->output_ip6 = raw_output_v6;
+#endif
+    netif->mtu = EPPP_FRAME_MTU;
+    // point to point: no broadcast, so that lwIP routes to the peer (the gateway) directly
+    netif->flags = NETIF_FLAG_LINK_UP;
+    return ERR_OK;
+}
+
+static const struct esp_netif_netstack_config s_netstack_raw_ip = {
+    .lwip = {
+        .init_fn = raw_init,
+        .input_fn = raw_input,
+    }
+};
+
+const esp_netif_netstack_config_t *eppp_netstack_raw_ip = &s_netstack_raw_ip;
+
+#endif // CONFIG_EPPP_LINK_USES_RAW_IP
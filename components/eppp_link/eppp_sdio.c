@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "eppp_sdio.h"
+
+#if EPPP_HAS_SDIO
+
+esp_err_t eppp_sdio_host_tx(const struct eppp_fragment_header *head, const void *data);
+esp_err_t eppp_sdio_host_rx(struct eppp_handle *h, struct eppp_reassembly *r);
+esp_err_t eppp_sdio_slave_rx(struct eppp_handle *h, struct eppp_reassembly *r);
+esp_err_t eppp_sdio_slave_tx(const struct eppp_fragment_header *head, const void *data);
+esp_err_t eppp_sdio_host_init(struct eppp_config_sdio_s *config);
+esp_err_t eppp_sdio_slave_init(void);
+void eppp_sdio_slave_deinit(void);
+void eppp_sdio_host_deinit(void);
+
+static const char *TAG = "eppp_sdio";
+
+_Static_assert(EPPP_CHANNEL_MAX_SIZE <= MAX_SDIO_FRAGMENT, "Messages of the control channel are sent in one fragment");
+
+struct eppp_sdio {
+    struct eppp_handle parent;
+    SemaphoreHandle_t tx_lock;  // the netif and the control channel transmit from different tasks
+    uint8_t tx_seq;
+    struct eppp_reassembly rx;
+};
+
+static esp_err_t send_message(struct eppp_sdio *h, const uint8_t *data, size_t len, uint8_t flags)
+{
+    size_t remaining = len;
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(h->tx_lock, portMAX_DELAY);
+    do {    // fragments only if the message is bigger than one SDIO packet
+        size_t batch = remaining > MAX_SDIO_FRAGMENT ? MAX_SDIO_FRAGMENT : remaining;
+        uint8_t first = remaining == len ? EPPP_FRAGMENT_FIRST : 0;
+        remaining -= batch;
+        // the sequence number is used even if the fragment fails, so the peer drops the incomplete message
+        struct eppp_fragment_header head = { .len = batch, .seq = h->tx_seq++, .flags = flags | first | (remaining ? EPPP_FRAGMENT_MORE : 0) };
+        ret = h->parent.role == EPPP_CLIENT ? eppp_sdio_host_tx(&head, data) : eppp_sdio_slave_tx(&head, data);
+        data += batch;
+    } while (ret == ESP_OK && remaining > 0);
+    xSemaphoreGive(h->tx_lock);
+    return ret;
+}
+
+static esp_err_t transmit(void *handle, void *buffer, size_t len)
+{
+    struct eppp_sdio *h = handle;
+    esp_err_t ret = send_message(h, buffer, len, 0);
+    if (ret != ESP_OK) {
+        EPPP_STATS_ADD(h->parent.stats.tx_dropped, 1);
+        return ret;
+    }
+    EPPP_STATS_ADD(h->parent.stats.tx_packets, 1);
+    EPPP_STATS_ADD(h->parent.stats.tx_bytes, len);
+    return ESP_OK;
+}
+
+static esp_err_t transmit_channel(struct eppp_handle *handle, const void *buffer, size_t len)
+{
+    return send_message(__containerof(handle, struct eppp_sdio, parent), buffer, len, EPPP_FRAGMENT_CHANNEL);
+}
+
+static esp_err_t perform(struct eppp_handle *handle)
+{
+    struct eppp_sdio *h = __containerof(handle, struct eppp_sdio, parent);
+    if (handle->stop) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (handle->role == EPPP_SERVER) {
+        return eppp_sdio_slave_rx(handle, &h->rx);
+    } else {
+        return eppp_sdio_host_rx(handle, &h->rx);
+    }
+}
+
+static void destroy(struct eppp_handle *handle)
+{
+    struct eppp_sdio *h = __containerof(handle, struct eppp_sdio, parent);
+    if (handle->role == EPPP_CLIENT) {
+        eppp_sdio_host_deinit();
+    } else {
+        eppp_sdio_slave_deinit();
+    }
+    vSemaphoreDelete(h->tx_lock);
+    free(h);
+}
+
+static struct eppp_handle *create(eppp_type_t role, eppp_config_t *config)
+{
+    struct eppp_sdio *h = calloc(1, sizeof(struct eppp_sdio));
+    if (!h) {
+        ESP_LOGE(TAG, "Failed to allocate eppp_sdio");
+        return NULL;
+    }
+    h->parent.role = role;
+    h->tx_lock = xSemaphoreCreateMutex();
+    if (!h->tx_lock) {
+        ESP_LOGE(TAG, "Failed to create the transmit lock");
+        free(h);
+        return NULL;
+    }
+    esp_err_t ret;
+    if (role == EPPP_SERVER) {
+        ret = eppp_sdio_slave_init();
+    } else {
+        ret = eppp_sdio_host_init(&config->sdio);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize SDIO %d", ret);
+        vSemaphoreDelete(h->tx_lock);
+        free(h);
+        return NULL;
+    }
+    return &h->parent;
+}
+
+const struct eppp_transport_ops eppp_transport_sdio = {
+    .name = "SDIO",
+    .create = create,
+    .destroy = destroy,
+    .transmit = transmit,
+    .perform = perform,
+    .transmit_channel = transmit_channel,
+};
+
+#endif // EPPP_HAS_SDIO
@@ -5,7 +5,11 @@
  */
 #pragma once
 
-#define MAX_SDIO_PAYLOAD 1500
+#include "eppp_transport.h"
+
+#define MAX_SDIO_FRAGMENT 1500
+// every SDIO packet carries one fragment of the message, bigger messages (jumbo MTU) are sent in several packets
+#define MAX_SDIO_PAYLOAD (MAX_SDIO_FRAGMENT + sizeof(struct eppp_fragment_header))
 #define SDIO_ALIGN(size) (((size) + 3U) & ~(3U))
 #define SDIO_PAYLOAD SDIO_ALIGN(MAX_SDIO_PAYLOAD)
 #define PPP_SOF 0x7E
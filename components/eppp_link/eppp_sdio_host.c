@@ -31,14 +31,16 @@ static sdmmc_card_t *s_card = NULL;
 static DRAM_DMA_ALIGNED_ATTR uint8_t send_buffer[SDIO_PAYLOAD];
 static DMA_ATTR uint8_t rcv_buffer[SDIO_PAYLOAD];
 
-esp_err_t eppp_sdio_host_tx(void *h, void *buffer, size_t len)
+esp_err_t eppp_sdio_host_tx(const struct eppp_fragment_header *head, const void *data)
 {
     if (s_essl == NULL || s_essl_mutex == NULL) {
         // silently skip the Tx if the SDIO not fully initialized
         return ESP_OK;
     }
 
-    memcpy(send_buffer, buffer, len);
+    size_t len = sizeof(*head) + head->len;
+    memcpy(send_buffer, head, sizeof(*head));
+    memcpy(send_buffer + sizeof(*head), data, head->len);
     size_t send_len = SDIO_ALIGN(len);
     if (send_len > len) {
         // pad with SOF's
@@ -124,7 +126,21 @@ err:
     return ret;
 }
 
-esp_err_t eppp_sdio_host_rx(esp_netif_t *netif)
+static esp_err_t receive_fragment(struct eppp_handle *h, struct eppp_reassembly *r, uint8_t *buffer, size_t len)
+{
+    struct eppp_fragment_header head;
+    if (len < sizeof(head)) {
+        return ESP_FAIL;
+    }
+    memcpy(&head, buffer, sizeof(head));
+    if (head.len > len - sizeof(head)) {
+        return ESP_FAIL;
+    }
+    eppp_reassemble(h, r, &head, buffer + sizeof(head));
+    return ESP_OK;
+}
+
+esp_err_t eppp_sdio_host_rx(struct eppp_handle *h, struct eppp_reassembly *r)
 {
     uint32_t intr;
     esp_err_t err = essl_wait_int(s_essl, TIMEOUT_MAX);
@@ -153,7 +169,9 @@ esp_err_t eppp_sdio_host_rx(esp_netif_t *netif)
             } else if (ret == ESP_OK) {
                 ESP_LOGD(TAG, "receive data, size: %d", size_read);
                 ESP_LOG_BUFFER_HEXDUMP(TAG, rcv_buffer, size_read, ESP_LOG_VERBOSE);
-                esp_netif_receive(netif, rcv_buffer, size_read, NULL);
+                if (receive_fragment(h, r, rcv_buffer, size_read) != ESP_OK) {
+                    ESP_LOGE(TAG, "Malformed packet of %d bytes", size_read);
+                }
                 break;
             } else {
                 ESP_LOGE(TAG, "rx packet error: %08X", ret);
@@ -179,12 +197,12 @@ void eppp_sdio_host_deinit(void)
 
 #else // SDMMC_HOST NOT-SUPPORTED
 
-esp_err_t eppp_sdio_host_tx(void *handle, void *buffer, size_t len)
+esp_err_t eppp_sdio_host_tx(const struct eppp_fragment_header *head, const void *data)
 {
     return ESP_ERR_NOT_SUPPORTED;
 }
 
-esp_err_t eppp_sdio_host_rx(esp_netif_t *netif)
+esp_err_t eppp_sdio_host_rx(struct eppp_handle *h, struct eppp_reassembly *r)
 {
     return ESP_ERR_NOT_SUPPORTED;
 }
@@ -20,13 +20,15 @@ static DMA_ATTR uint8_t sdio_slave_rx_buffer[BUFFER_NUM][BUFFER_SIZE];
 static DMA_ATTR uint8_t sdio_slave_tx_buffer[SDIO_PAYLOAD];
 static int s_slave_request = 0;
 
-esp_err_t eppp_sdio_slave_tx(void *h, void *buffer, size_t len)
+esp_err_t eppp_sdio_slave_tx(const struct eppp_fragment_header *head, const void *data)
 {
     if (s_slave_request != REQ_INIT) {
         // silently skip the Tx if the SDIO not fully initialized
         return ESP_OK;
     }
-    memcpy(sdio_slave_tx_buffer, buffer, len);
+    size_t len = sizeof(*head) + head->len;
+    memcpy(sdio_slave_tx_buffer, head, sizeof(*head));
+    memcpy(sdio_slave_tx_buffer + sizeof(*head), data, head->len);
     size_t send_len = SDIO_ALIGN(len);
     if (send_len > len) {
         // pad with SOF's if the size is not 4 bytes aligned
@@ -64,7 +66,22 @@ err:
     return ret;
 }
 
-esp_err_t eppp_sdio_slave_rx(esp_netif_t *netif)
+static void receive_fragment(struct eppp_handle *h, struct eppp_reassembly *r, uint8_t *buffer, size_t len)
+{
+    struct eppp_fragment_header head;
+    if (len < sizeof(head)) {
+        ESP_LOGE(TAG, "Malformed packet of %d bytes", len);
+        return;
+    }
+    memcpy(&head, buffer, sizeof(head));
+    if (head.len > len - sizeof(head)) {
+        ESP_LOGE(TAG, "Malformed packet of %d bytes", len);
+        return;
+    }
+    eppp_reassemble(h, r, &head, buffer + sizeof(head));
+}
+
+esp_err_t eppp_sdio_slave_rx(struct eppp_handle *h, struct eppp_reassembly *r)
 {
     if (s_slave_request == REQ_RESET) {
         ESP_LOGD(TAG, "request: %x", s_slave_request);
@@ -81,7 +98,7 @@ esp_err_t eppp_sdio_slave_rx(esp_netif_t *netif)
     if (ret == ESP_ERR_NOT_FINISHED || ret == ESP_OK) {
 again:
         ptr = sdio_slave_recv_get_buf(handle, &length);
-        esp_netif_receive(netif, ptr, length, NULL);
+        receive_fragment(h, r, ptr, length);
         if (sdio_slave_recv_load_buf(handle) != ESP_OK) {
             ESP_LOGE(TAG, "Failed to recycle packet buffer");
             return ESP_FAIL;
@@ -153,11 +170,11 @@ void eppp_sdio_slave_deinit(void)
 
 #else // SOC_SDIO_SLAVE NOT-SUPPORTED
 
-esp_err_t eppp_sdio_slave_tx(void *h, void *buffer, size_t len)
+esp_err_t eppp_sdio_slave_tx(const struct eppp_fragment_header *head, const void *data)
 {
     return ESP_ERR_NOT_SUPPORTED;
 }
-esp_err_t eppp_sdio_slave_rx(esp_netif_t *netif)
+esp_err_t eppp_sdio_slave_rx(struct eppp_handle *h, struct eppp_reassembly *r)
 {
     return ESP_ERR_NOT_SUPPORTED;
 }
@@ -0,0 +1,550 @@
+/*
+ * SPDX-FileCopyrightText: 2019-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_rom_crc.h"
+#include "esp_heap_caps.h"
+#include "eppp_spi.h"
+
+#if EPPP_HAS_SPI
+
+#define NEXT_TRANSACTION_SIZE(a,b) (((a)>(b))?(a):(b)) /* next transaction: whichever is bigger */
+
+#if CONFIG_EPPP_LINK_TX_PRIORITY
+#define TX_PRIO_QUEUE_SIZE CONFIG_EPPP_LINK_TX_PRIO_QUEUE_SIZE
+#define TX_RESERVED_BUFFERS 2   /* for the priority classes */
+#else
+#define TX_PRIO_QUEUE_SIZE 0
+#define TX_RESERVED_BUFFERS 0
+#endif
+
+// at least the fragments of one packet of the configured MTU, so that it could always be sent
+#define MIN_TX_BUFFERS (MAX_FRAGMENTS + TX_RESERVED_BUFFERS)
+#define TX_BUFFERS (CONFIG_EPPP_LINK_SPI_TX_BUFFERS > MIN_TX_BUFFERS ? CONFIG_EPPP_LINK_SPI_TX_BUFFERS : MIN_TX_BUFFERS)
+_Static_assert(EPPP_CHANNEL_MAX_SIZE <= MAX_PAYLOAD, "Messages of the control channel are sent in one fragment");
+
+static const char *TAG = "eppp_spi";
+
+static void release_buffer(struct eppp_spi *h, uint8_t *buffer)
+{
+    xQueueSend(h->tx_free, &buffer, 0);
+}
+
+/*
+ * Called with tx_lock held. The producers are serialized by the lock and the consumer only releases
+ * buffers and frees queue slots, so the space checked up front cannot shrink while queueing.
+ */
+static esp_err_t queue_packet(struct eppp_spi *h, eppp_tx_class_t cls, const uint8_t *buffer, size_t len, bool frame_end, bool channel)
+{
+    struct packet buf = { .channel = channel };
+    uint8_t *slots[MAX_FRAGMENTS];
+    size_t remaining = len;
+    size_t fragments = len > MAX_PAYLOAD ? (len + MAX_PAYLOAD - 1) / MAX_PAYLOAD : 1;
+    // the whole message is queued or nothing, so that the peer never receives a part of it
+    // (bulk data cannot take the last few buffers, so that the control packets could still pass)
+    size_t reserved = cls == EPPP_TX_CLASS_BULK ? TX_RESERVED_BUFFERS : 0;
+    if (fragments > MAX_FRAGMENTS || uxQueueMessagesWaiting(h->tx_free) < fragments + reserved ||
+            h->out_queue[cls] == NULL || uxQueueSpacesAvailable(h->out_queue[cls]) < fragments) {
+        return ESP_ERR_NO_MEM;
+    }
+    // reserve all buffers first, so nothing is queued if any of them is missing
+    for (size_t i = 0; i < fragments; ++i) {
+        if (xQueueReceive(h->tx_free, &slots[i], 0) != pdTRUE) {
+            ESP_LOGE(TAG, "No free transmit buffer");
+            while (i > 0) {
+                release_buffer(h, slots[--i]);
+            }
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    for (size_t i = 0; i < fragments; ++i) {    // more than one only if the message is bigger than MAX_PAYLOAD (jumbo MTU or PPP stream)
+        size_t batch = remaining > MAX_PAYLOAD ? MAX_PAYLOAD : remaining;
+        buf.data = slots[i];
+        buf.len = PACKET_PREFIX + batch;
+        remaining -= batch;
+        buf.frame_end = frame_end && remaining == 0;
+        // leave room for the header, so the buffer could be transferred in place
+        struct eppp_fragment_header prefix = { .len = batch, .flags = (i == 0 ? EPPP_FRAGMENT_FIRST : 0) | (remaining ? EPPP_FRAGMENT_MORE : 0) |
+                                               (channel ? EPPP_FRAGMENT_CHANNEL : 0)
+                                             };
+        memcpy(buf.data + sizeof(struct header), &prefix, PACKET_PREFIX);
+        memcpy(buf.data + sizeof(struct header) + PACKET_PREFIX, buffer, batch);
+        buffer += batch;
+        // cannot fail, the queue had enough space for all fragments
+        xQueueSend(h->out_queue[cls], &buf, 0);
+    }
+    return ESP_OK;
+}
+
+static void wake_up(struct eppp_spi *h)
+{
+    if (h->parent.role == EPPP_SERVER && h->blocked == SLAVE_BLOCKED) {
+        h->bus->set_intr(h, 0);
+    }
+    if (h->out_ready) {
+        xSemaphoreGive(h->out_ready);
+    }
+}
+
+static esp_err_t transmit(void *handle, void *buffer, size_t len)
+{
+    struct eppp_spi *h = handle;
+    bool frame_end = eppp_tx_frame_end(buffer, len, h->parent.raw_ip);
+    xSemaphoreTake(h->tx_lock, portMAX_DELAY);
+    // all chunks of one frame go to the same class, so they stay in order
+    if (!h->tx_mid_frame) {
+        h->tx_class = eppp_tx_classify(buffer, len, h->parent.raw_ip);
+        h->tx_drop_frame = false;
+    }
+    eppp_tx_class_t cls = h->tx_class;
+    esp_err_t ret = h->tx_drop_frame ? ESP_ERR_NO_MEM : queue_packet(h, cls, buffer, len, frame_end, false);
+    if (ret == ESP_OK) {
+        h->parent.tx_class[cls].queued++;
+        EPPP_STATS_ADD(h->parent.stats.tx_packets, 1);
+        EPPP_STATS_ADD(h->parent.stats.tx_bytes, len);
+        uint32_t in_use = TX_BUFFERS - uxQueueMessagesWaiting(h->tx_free);
+        if (in_use > h->parent.stats.tx_queue_max) {
+            h->parent.stats.tx_queue_max = in_use;
+        }
+    } else {
+        h->parent.tx_class[cls].dropped++;
+        EPPP_STATS_ADD(h->parent.stats.tx_dropped, 1);
+        h->tx_drop_frame = true;
+    }
+    h->tx_mid_frame = !frame_end;
+    xSemaphoreGive(h->tx_lock);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    wake_up(h);
+    return ESP_OK;
+}
+
+static esp_err_t transmit_channel(struct eppp_handle *handle, const void *buffer, size_t len)
+{
+    struct eppp_spi *h = __containerof(handle, struct eppp_spi, parent);
+    // sent with the control traffic, but outside of the PPP stream, so it doesn't touch its frame state
+    eppp_tx_class_t cls = h->out_queue[EPPP_TX_CLASS_CONTROL] ? EPPP_TX_CLASS_CONTROL : EPPP_TX_CLASS_BULK;
+    xSemaphoreTake(h->tx_lock, portMAX_DELAY);
+    esp_err_t ret = queue_packet(h, cls, buffer, len, true, true);
+    xSemaphoreGive(h->tx_lock);
+    if (ret != ESP_OK) {
+        h->parent.tx_class[cls].dropped++;
+        return ret;
+    }
+    h->parent.tx_class[cls].queued++;
+    wake_up(h);
+    return ESP_OK;
+}
+
+void IRAM_ATTR eppp_spi_handshake_edge(struct eppp_spi *h, int level)
+{
+    BaseType_t yield = false;
+
+    // Positive edge means SPI slave prepared the data
+    if (level == 1) {
+        h->ready_us = eppp_time_us();
+        xSemaphoreGiveFromISR(h->ready_semaphore, &yield);
+        if (yield) {
+            portYIELD_FROM_ISR();
+        }
+        return;
+    }
+
+    // Negative edge (when master blocked) means that slave wants to transmit
+    if (h->blocked == MASTER_BLOCKED) {
+        h->slave_signal = true;
+        xSemaphoreGiveFromISR(h->out_ready, &yield);
+        if (yield) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+void eppp_spi_handshake_ready(struct eppp_spi *h)
+{
+    h->ready_us = eppp_time_us();
+    xSemaphoreGive(h->ready_semaphore);
+}
+
+void eppp_spi_handshake_request(struct eppp_spi *h)
+{
+    // latched like a pending interrupt, so the request isn't lost if the master hasn't blocked yet
+    h->slave_signal = true;
+    xSemaphoreGive(h->out_ready);
+}
+
+bool IRAM_ATTR eppp_spi_slave_post_setup(struct eppp_spi *h)
+{
+    h->bus->set_intr(h, 1);
+    if (h->transaction_size == 0) { // If no transaction planned:
+        if (h->outbound.len == 0) { // we're blocked if we don't have any data
+            h->blocked = SLAVE_BLOCKED;
+        } else {
+            h->blocked = SLAVE_WANTS_WRITE; // we notify the master that we want to write
+            return true;
+        }
+    }
+    return false;
+}
+
+void IRAM_ATTR eppp_spi_slave_post_trans(struct eppp_spi *h)
+{
+    h->blocked = NONE;
+    h->bus->set_intr(h, 0);
+}
+
+/*
+ * Takes the next packet in the order of class priority. Chunks of one frame are always taken
+ * together, so that a higher priority frame doesn't interrupt them.
+ */
+static bool take_packet(struct eppp_spi *h, struct packet *p)
+{
+    if (h->locked_class >= 0) {
+        // under the lock, so the queue and the frame state of transmit() are consistent
+        xSemaphoreTake(h->tx_lock, portMAX_DELAY);
+        bool mid_frame = h->tx_mid_frame;
+        bool taken = xQueueReceive(h->out_queue[h->locked_class], p, 0) == pdTRUE;
+        xSemaphoreGive(h->tx_lock);
+        if (taken) {
+            if (p->frame_end && !p->channel) {
+                h->locked_class = -1;
+            }
+            return true;
+        }
+        if (mid_frame) {
+            return false;   // the rest of the frame is on its way
+        }
+        h->locked_class = -1; // the rest of the frame has been dropped
+    }
+    for (int cls = 0; cls < EPPP_TX_CLASS_MAX; ++cls) {
+        if (h->out_queue[cls] && xQueueReceive(h->out_queue[cls], p, 0) == pdTRUE) {
+            if (!p->frame_end) {
+                h->locked_class = cls;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool dequeue(struct eppp_spi *h, struct packet *p)
+{
+    if (!take_packet(h, p)) {
+        return false;
+    }
+    // numbered in the order of sending, the classes reorder the packets after queueing
+    struct eppp_fragment_header *prefix = (void *)(p->data + sizeof(struct header));
+    prefix->seq = h->tx_seq++;
+    return true;
+}
+
+/*
+ * Appends the queued packets to outbound up to the limit, so that one transaction carries as many
+ * packets as the queues hold. The first packet which doesn't fit is kept as pending for the next one.
+ */
+static void aggregate(struct eppp_spi *h, size_t limit)
+{
+    struct packet next;
+    while (h->outbound.data && h->pending.data == NULL && h->outbound.len < limit) {
+        if (!dequeue(h, &next)) {
+            return;
+        }
+        if (h->outbound.len + next.len > limit) {
+            h->pending = next;
+            return;
+        }
+        memcpy(h->outbound.data + sizeof(struct header) + h->outbound.len, next.data + sizeof(struct header), next.len);
+        h->outbound.len += next.len;
+        release_buffer(h, next.data);
+    }
+}
+
+static void fetch_outbound(struct eppp_spi *h)
+{
+    if (h->pending.data) {
+        h->outbound = h->pending;
+        h->pending.data = NULL;
+        h->pending.len = 0;
+    } else {
+        dequeue(h, &h->outbound);
+    }
+    // the size of the next transaction is announced now, so it grows with the queue depth
+    aggregate(h, MAX_TRANSACTION_PAYLOAD);
+}
+
+static esp_err_t receive_packets(struct eppp_spi *h, uint8_t *payload, size_t size)
+{
+    size_t offset = 0;
+    while (offset < size) {
+        struct eppp_fragment_header prefix;
+        if (size - offset < PACKET_PREFIX) {
+            return ESP_FAIL;
+        }
+        memcpy(&prefix, payload + offset, PACKET_PREFIX);
+        offset += PACKET_PREFIX;
+        if (prefix.len > size - offset) {
+            return ESP_FAIL;
+        }
+        eppp_reassemble(&h->parent, h->rx, &prefix, payload + offset);
+        offset += prefix.len;
+    }
+    return ESP_OK;
+}
+
+static void transaction_error(struct eppp_spi *h, uint16_t size, uint16_t tx_len)
+{
+    h->parent.stats.rx_errors++;
+    eppp_trace_record(&h->parent, EPPP_TRACE_ERROR, size, tx_len, 0, 0);
+}
+
+static void count_transaction(struct eppp_spi *h, uint16_t size, uint16_t tx_len, uint16_t rx_len, uint32_t latency_us)
+{
+    eppp_stats_t *stats = &h->parent.stats;
+    stats->transactions++;
+    if (size == 0) {
+        stats->empty_transactions++;
+    }
+    stats->transaction_bytes += size;
+    if (size > stats->transaction_max) {
+        stats->transaction_max = size;
+    }
+    stats->tx_queue_depth = TX_BUFFERS - uxQueueMessagesWaiting(h->tx_free);
+    if (latency_us) {
+        stats->latency_samples++;
+        stats->latency_sum_us += latency_us;
+        if (latency_us > stats->latency_max_us) {
+            stats->latency_max_us = latency_us;
+        }
+    }
+    eppp_trace_record(&h->parent, EPPP_TRACE_TRANSACTION, size, tx_len, rx_len, latency_us);
+}
+
+static esp_err_t perform(struct eppp_handle *handle)
+{
+    struct eppp_spi *h = __containerof(handle, struct eppp_spi, parent);
+    uint8_t *out_buf = h->out_buf;  // header only, unless the outbound packet is sent from its own buffer
+    uint8_t *in_buf = h->in_buf;
+    uint8_t *sent = NULL;
+
+    if (handle->stop) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    bool allow_test_tx = false;
+    uint16_t next_tx_size = 0;
+    if (handle->role == EPPP_CLIENT) {
+        // SPI MASTER only code
+        if (xSemaphoreTake(h->ready_semaphore, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            // slave might not be ready, but maybe we just missed an interrupt
+            allow_test_tx = true;
+        }
+        if (h->outbound.len == 0 && h->transaction_size == 0 && h->blocked == NONE) {
+            h->blocked = MASTER_BLOCKED;
+            while (!dequeue(h, &h->outbound) && !h->slave_signal) {
+                if (handle->stop) {
+                    h->blocked = NONE;
+                    return ESP_ERR_TIMEOUT;
+                }
+                // not forever, so that the I/O task notices the stop request
+                xSemaphoreTake(h->out_ready, pdMS_TO_TICKS(100));
+            }
+            h->blocked = NONE;
+            h->slave_signal = false;
+            h->ready_us = 0;    // we were idle, not late
+            if (h->outbound.data == NULL) {
+                h->blocked = MASTER_WANTS_READ;
+                handle->stats.master_wants_read++;
+            } else {
+                aggregate(h, MAX_TRANSACTION_PAYLOAD);
+            }
+        } else if (h->blocked == MASTER_WANTS_READ) {
+            h->blocked = NONE;
+        }
+    }
+    struct header *head;
+    if (h->outbound.len <= h->transaction_size && allow_test_tx == false) {
+        // sending outbound, with whatever else fits into this transaction
+        aggregate(h, h->transaction_size);
+        if (h->outbound.data) {
+            sent = out_buf = h->outbound.data;
+            ESP_LOG_BUFFER_HEXDUMP(TAG, out_buf + sizeof(struct header), h->outbound.len, ESP_LOG_VERBOSE);
+        }
+        head = (void *)out_buf;
+        head->size = h->outbound.len;
+        h->outbound.data = NULL;
+        h->outbound.len = 0;
+        fetch_outbound(h);
+    } else {
+        // outbound is bigger, need to transmit in another transaction (keep this empty)
+        head = (void *)out_buf;
+        head->size = 0;
+    }
+    next_tx_size = head->next_size = h->outbound.len;
+    head->magic = SPI_HEADER_MAGIC;
+    head->check = esp_rom_crc16_le(0, out_buf, sizeof(struct header) - sizeof(uint16_t));
+    uint16_t size = h->transaction_size;
+    uint16_t tx_len = head->size;
+    uint32_t latency_us = 0;
+    if (handle->role == EPPP_CLIENT && h->ready_us != 0) {
+        latency_us = eppp_time_us() - h->ready_us;
+        h->ready_us = 0;
+    }
+    esp_err_t ret = h->bus->transaction(h, sizeof(struct header) + h->transaction_size, out_buf, in_buf);
+    if (sent) {
+        release_buffer(h, sent);
+    }
+    if (ret == ESP_ERR_TIMEOUT && handle->stop) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "spi_device_transmit failed");
+        h->transaction_size = 0; // need to start with HEADER only transaction
+        return ESP_FAIL;
+    }
+    head = (void *)in_buf;
+    uint16_t check = esp_rom_crc16_le(0, in_buf, sizeof(struct header) - sizeof(uint16_t));
+    if (check != head->check || head->magic != SPI_HEADER_MAGIC) {
+        h->transaction_size = 0; // need to start with HEADER only transaction
+        if (allow_test_tx) {
+            return ESP_OK;
+        }
+        ESP_LOGE(TAG, "Wrong checksum or magic");
+        transaction_error(h, size, tx_len);
+        return ESP_FAIL;
+    }
+    if (head->size > MAX_TRANSACTION_PAYLOAD || head->next_size > MAX_TRANSACTION_PAYLOAD) {
+        h->transaction_size = 0;
+        ESP_LOGE(TAG, "Invalid transaction size");
+        transaction_error(h, size, tx_len);
+        return ESP_FAIL;
+    }
+    if (head->size > 0) {
+        ESP_LOG_BUFFER_HEXDUMP(TAG, in_buf + sizeof(struct header), head->size, ESP_LOG_VERBOSE);
+        if (receive_packets(h, in_buf + sizeof(struct header), head->size) != ESP_OK) {
+            h->transaction_size = 0;
+            ESP_LOGE(TAG, "Malformed packets in the transaction");
+            transaction_error(h, size, tx_len);
+            return ESP_FAIL;
+        }
+    }
+    h->transaction_size = NEXT_TRANSACTION_SIZE(next_tx_size, head->next_size);
+    count_transaction(h, size, tx_len, head->size, latency_us);
+    return ESP_OK;
+}
+
+static void delete_queues(struct eppp_spi *h)
+{
+    for (int cls = 0; cls < EPPP_TX_CLASS_MAX; ++cls) {
+        if (h->out_queue[cls]) {
+            vQueueDelete(h->out_queue[cls]);
+        }
+    }
+    if (h->tx_free) {
+        vQueueDelete(h->tx_free);
+    }
+    if (h->out_ready) {
+        vSemaphoreDelete(h->out_ready);
+    }
+    if (h->tx_lock) {
+        vSemaphoreDelete(h->tx_lock);
+    }
+}
+
+static void destroy(struct eppp_handle *handle)
+{
+    struct eppp_spi *h = __containerof(handle, struct eppp_spi, parent);
+    h->bus->deinit(h);
+    delete_queues(h);
+    heap_caps_free(h->tx_buffers);
+    free(h->rx);
+    eppp_trace_deinit(&h->parent);
+    if (h->ready_semaphore) {
+        vSemaphoreDelete(h->ready_semaphore);
+    }
+    heap_caps_free(h);
+}
+
+static struct eppp_handle *create(eppp_type_t role, eppp_config_t *config)
+{
+    // the context holds the transaction buffers, so it has to be DMA capable
+    struct eppp_spi *h = heap_caps_calloc(1, sizeof(struct eppp_spi), MALLOC_CAP_DMA);
+    if (!h) {
+        ESP_LOGE(TAG, "Failed to allocate eppp_spi");
+        return NULL;
+    }
+    h->parent.role = role;
+    h->bus = &eppp_spi_bus;
+    h->locked_class = -1;
+    for (int cls = 0; cls < EPPP_TX_CLASS_MAX; ++cls) {
+        int size = cls == EPPP_TX_CLASS_BULK ? CONFIG_EPPP_LINK_PACKET_QUEUE_SIZE : TX_PRIO_QUEUE_SIZE;
+        if (size == 0) {
+            continue;   // priority classes are disabled
+        }
+        h->out_queue[cls] = xQueueCreate(size, sizeof(struct packet));
+        if (!h->out_queue[cls]) {
+            ESP_LOGE(TAG, "Failed to create the packet queue");
+            goto err;
+        }
+    }
+    // outgoing packets are written directly to these buffers and transferred from there
+    h->tx_buffers = heap_caps_malloc(TX_BUFFERS * TRANSFER_SIZE, MALLOC_CAP_DMA);
+    h->tx_free = xQueueCreate(TX_BUFFERS, sizeof(uint8_t *));
+    h->tx_lock = xSemaphoreCreateMutex();
+    if (!h->tx_buffers || !h->tx_free || !h->tx_lock) {
+        ESP_LOGE(TAG, "Failed to allocate transmit buffers");
+        goto err;
+    }
+    for (int i = 0; i < TX_BUFFERS; ++i) {
+        release_buffer(h, h->tx_buffers + i * TRANSFER_SIZE);
+    }
+    // reassembled messages don't need DMA capable memory
+    h->rx = calloc(1, sizeof(struct eppp_reassembly));
+    if (!h->rx) {
+        ESP_LOGE(TAG, "Failed to allocate reassembly buffer");
+        goto err;
+    }
+    if (eppp_trace_init(&h->parent) != ESP_OK) {
+        goto err;
+    }
+    if (role == EPPP_CLIENT) {
+        h->ready_semaphore = xSemaphoreCreateBinary();
+        h->out_ready = xSemaphoreCreateBinary();
+        if (!h->ready_semaphore || !h->out_ready) {
+            ESP_LOGE(TAG, "Failed to create the semaphores");
+            goto err;
+        }
+    }
+    if (h->bus->init(h, &config->spi) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize SPI bus");
+        goto err;
+    }
+    return &h->parent;
+err:
+    delete_queues(h);
+    heap_caps_free(h->tx_buffers);
+    free(h->rx);
+    eppp_trace_deinit(&h->parent);
+    if (h->ready_semaphore) {
+        vSemaphoreDelete(h->ready_semaphore);
+    }
+    heap_caps_free(h);
+    return NULL;
+}
+
+const struct eppp_transport_ops eppp_transport_spi = {
+    .name = "SPI",
+    .create = create,
+    .destroy = destroy,
+    .transmit = transmit,
+    .perform = perform,
+    .transmit_channel = transmit_channel,
+};
+
+#endif // EPPP_HAS_SPI
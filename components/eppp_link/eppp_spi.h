@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "eppp_transport.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "driver/spi_master.h"
+#include "esp_timer.h"
+#endif
+
+#define MAX_PAYLOAD 1500
+#define MIN_TRIGGER_US 20
+#define SPI_HEADER_MAGIC 0x1236         // payload is a sequence of packets, each prefixed with struct eppp_fragment_header
+#define SPI_ALIGN(size) (((size) + 3U) & ~(3U))
+#define PACKET_PREFIX sizeof(struct eppp_fragment_header)
+#define MAX_FRAGMENTS ((EPPP_MAX_MESSAGE + MAX_PAYLOAD - 1) / MAX_PAYLOAD)
+#define MAX_TRANSACTION_PAYLOAD (MAX_PAYLOAD + PACKET_PREFIX)
+#define TRANSFER_SIZE SPI_ALIGN((MAX_TRANSACTION_PAYLOAD + sizeof(struct header)))
+
+struct packet {
+    size_t len;     // including the length prefixes of all packets
+    uint8_t *data;  // TX buffer slot: struct header followed by len bytes of prefixed packets
+    bool frame_end; // the (last) packet completes a PPP frame
+    bool channel;   // message of the control channel, might come between the chunks of a PPP frame
+};
+
+struct header {
+    uint16_t magic;
+    uint16_t size;
+    uint16_t next_size;
+    uint16_t check;
+} __attribute__((packed));
+
+enum blocked_status {
+    NONE,
+    MASTER_BLOCKED,
+    MASTER_WANTS_READ,
+    SLAVE_BLOCKED,
+    SLAVE_WANTS_WRITE,
+};
+
+struct eppp_spi;
+
+/**
+ * @brief Physical SPI bus with the handshake line
+ *
+ * Implemented by the SPI master/slave drivers on chips and by a socketpair simulation on linux target
+ */
+struct eppp_spi_bus_ops {
+    esp_err_t (*init)(struct eppp_spi *h, struct eppp_config_spi_s *config);
+    void (*deinit)(struct eppp_spi *h);
+    /* Full duplex transaction of len bytes, blocks until the transaction is done */
+    esp_err_t (*transaction)(struct eppp_spi *h, size_t len, const void *tx_buffer, void *rx_buffer);
+    /* Sets the handshake line level (slave only) */
+    void (*set_intr)(struct eppp_spi *h, int level);
+};
+
+struct eppp_spi {
+    struct eppp_handle parent;
+    const struct eppp_spi_bus_ops *bus;
+    QueueHandle_t out_queue[EPPP_TX_CLASS_MAX];
+    SemaphoreHandle_t out_ready;    // master: outgoing packet queued or slave wants to write
+    bool slave_signal;              // master: slave wants to write
+    SemaphoreHandle_t ready_semaphore;
+    int64_t ready_us;               // master: time of the slave's ready signal, 0 if already used
+    uint16_t transaction_size;
+    struct packet outbound;         // packets to send in the next transaction, aggregated in one slot
+    struct packet pending;          // dequeued packet which didn't fit to outbound
+    int locked_class;               // class of a partially dequeued frame, or -1
+    SemaphoreHandle_t tx_lock;      // serializes the producers, guards the frame state below
+    eppp_tx_class_t tx_class;       // class of the frame being transmitted
+    bool tx_mid_frame;              // transmit() received only a part of the current frame
+    bool tx_drop_frame;             // part of the current frame was dropped, so drop the rest as well
+    enum blocked_status blocked;
+    uint8_t *tx_buffers;            // CONFIG_EPPP_LINK_SPI_TX_BUFFERS slots of TRANSFER_SIZE, DMA capable
+    QueueHandle_t tx_free;          // slots available to transmit()
+    uint8_t tx_seq;                 // sequence number of the next dequeued fragment
+    struct eppp_reassembly *rx;     // fragments of the received message
+#if CONFIG_IDF_TARGET_LINUX
+    int fd;                         // our end of the socketpair simulating the bus
+    SemaphoreHandle_t reply;        // master: slave's half of the transaction has arrived
+    void *reply_buffer;
+    size_t reply_len;
+    TaskHandle_t bus_task;
+    SemaphoreHandle_t bus_exit;     // master: given by the bus task as it exits
+#else
+    spi_device_handle_t spi_device;
+    spi_host_device_t spi_host;
+    int gpio_intr;
+    uint32_t slave_last_edge;
+    esp_timer_handle_t timer;
+#endif
+    WORD_ALIGNED_ATTR uint8_t out_buf[TRANSFER_SIZE];
+    WORD_ALIGNED_ATTR uint8_t in_buf[TRANSFER_SIZE];
+};
+
+extern const struct eppp_spi_bus_ops eppp_spi_bus;
+
+/**
+ * @brief Master: Processes an edge of the handshake line, could be called from ISR
+ */
+void eppp_spi_handshake_edge(struct eppp_spi *h, int level);
+
+/**
+ * @brief Master: Task context variant of the positive edge, slave is ready for the transaction
+ */
+void eppp_spi_handshake_ready(struct eppp_spi *h);
+
+/**
+ * @brief Master: Task context variant of the negative edge, slave wants to write
+ *
+ * Unlike the edge, the request is kept until the master blocks, so it's never missed
+ */
+void eppp_spi_handshake_request(struct eppp_spi *h);
+
+/**
+ * @brief Slave: Called when the transaction has been queued to the bus
+ *
+ * @return true if the handshake line needs to be pulled down shortly to wake up the master
+ */
+bool eppp_spi_slave_post_setup(struct eppp_spi *h);
+
+/**
+ * @brief Slave: Called when the transaction has finished
+ */
+void eppp_spi_slave_post_trans(struct eppp_spi *h);
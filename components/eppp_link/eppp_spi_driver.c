@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: 2019-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <stdint.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "driver/spi_master.h"
+#include "driver/spi_slave.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "eppp_spi.h"
+
+#if EPPP_HAS_SPI
+
+static const char *TAG = "eppp_spi_driver";
+
+static void IRAM_ATTR timer_callback(void *arg)
+{
+    struct eppp_spi *h = arg;
+    if (h->blocked == SLAVE_WANTS_WRITE) {
+        gpio_set_level(h->gpio_intr, 0);
+    }
+}
+
+static void IRAM_ATTR gpio_isr_handler(void *arg)
+{
+    static uint32_t s_last_time;
+    uint32_t now = esp_timer_get_time();
+    uint32_t diff = now - s_last_time;
+    if (diff < MIN_TRIGGER_US) { // debounce
+        return;
+    }
+    s_last_time = now;
+    struct eppp_spi *h = arg;
+    eppp_spi_handshake_edge(h, gpio_get_level(h->gpio_intr));
+}
+
+static void IRAM_ATTR set_intr(struct eppp_spi *h, int level)
+{
+    if (level == 1) {
+        h->slave_last_edge = esp_timer_get_time();
+    } else if (h->blocked == SLAVE_BLOCKED) {
+        // make sure the master doesn't debounce the falling edge
+        uint32_t now = esp_timer_get_time();
+        uint32_t diff = now - h->slave_last_edge;
+        if (diff < MIN_TRIGGER_US) {
+            esp_rom_delay_us(MIN_TRIGGER_US - diff);
+        }
+    }
+    gpio_set_level(h->gpio_intr, level);
+}
+
+static esp_err_t deinit_master(struct eppp_spi *h)
+{
+    gpio_isr_handler_remove(h->gpio_intr);
+    ESP_RETURN_ON_ERROR(spi_bus_remove_device(h->spi_device), TAG, "Failed to remove SPI bus");
+    ESP_RETURN_ON_ERROR(spi_bus_free(h->spi_host), TAG, "Failed to free SPI bus");
+    return ESP_OK;
+}
+
+static esp_err_t init_master(struct eppp_spi *h, struct eppp_config_spi_s *config)
+{
+    h->spi_host = config->host;
+    h->gpio_intr = config->intr;
+    spi_bus_config_t bus_cfg = {};
+    bus_cfg.mosi_io_num = config->mosi;
+    bus_cfg.miso_io_num = config->miso;
+    bus_cfg.sclk_io_num = config->sclk;
+    bus_cfg.quadwp_io_num = -1;
+    bus_cfg.quadhd_io_num = -1;
+    bus_cfg.max_transfer_sz = TRANSFER_SIZE;
+    bus_cfg.flags = 0;
+    bus_cfg.intr_flags = 0;
+
+    // TODO: Init and deinit SPI bus separately (per Kconfig?)
+    if (spi_bus_initialize(config->host, &bus_cfg, SPI_DMA_CH_AUTO) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    spi_device_interface_config_t dev_cfg = {};
+    dev_cfg.clock_speed_hz = config->freq;
+    dev_cfg.mode = 0;
+    dev_cfg.spics_io_num = config->cs;
+    dev_cfg.cs_ena_pretrans = config->cs_ena_pretrans;
+    dev_cfg.cs_ena_posttrans = config->cs_ena_posttrans;
+    dev_cfg.duty_cycle_pos = 128;
+    dev_cfg.input_delay_ns = config->input_delay_ns;
+    dev_cfg.pre_cb = NULL;
+    dev_cfg.post_cb = NULL;
+    dev_cfg.queue_size = 3;
+
+    if (spi_bus_add_device(config->host, &dev_cfg, &h->spi_device) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    //GPIO config for the handshake line.
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_ANYEDGE,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = 1,
+        .pin_bit_mask = BIT64(config->intr),
+    };
+
+    gpio_config(&io_conf);
+    gpio_install_isr_service(0);
+    gpio_set_intr_type(config->intr, GPIO_INTR_ANYEDGE);
+    gpio_isr_handler_add(config->intr, gpio_isr_handler, h);
+    return ESP_OK;
+}
+
+static void post_setup(spi_slave_transaction_t *trans)
+{
+    struct eppp_spi *h = trans->user;
+    if (eppp_spi_slave_post_setup(h)) {
+        esp_timer_start_once(h->timer, MIN_TRIGGER_US);
+    }
+}
+
+static void post_trans(spi_slave_transaction_t *trans)
+{
+    eppp_spi_slave_post_trans(trans->user);
+}
+
+static esp_err_t deinit_slave(struct eppp_spi *h)
+{
+    esp_timer_stop(h->timer);
+    esp_timer_delete(h->timer);
+    ESP_RETURN_ON_ERROR(spi_slave_free(h->spi_host), TAG, "Failed to free SPI slave host");
+    return ESP_OK;
+}
+
+static esp_err_t init_slave(struct eppp_spi *h, struct eppp_config_spi_s *config)
+{
+    h->spi_host = config->host;
+    h->gpio_intr = config->intr;
+    esp_timer_create_args_t args = {
+        .callback = &timer_callback,
+        .arg = h,
+        .name = "timer"
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&args, &h->timer), TAG, "Failed to create the timer");
+
+    spi_bus_config_t bus_cfg = {};
+    bus_cfg.mosi_io_num = config->mosi;
+    bus_cfg.miso_io_num = config->miso;
+    bus_cfg.sclk_io_num = config->sclk;
+    bus_cfg.quadwp_io_num = -1;
+    bus_cfg.quadhd_io_num = -1;
+    bus_cfg.flags = 0;
+    bus_cfg.intr_flags = 0;
+
+    //Configuration for the SPI slave interface
+    spi_slave_interface_config_t slvcfg = {
+        .mode = 0,
+        .spics_io_num = config->cs,
+        .queue_size = 3,
+        .flags = 0,
+        .post_setup_cb = post_setup,
+        .post_trans_cb = post_trans,
+    };
+
+    //Configuration for the handshake line
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = GPIO_MODE_OUTPUT,
+        .pin_bit_mask = BIT64(config->intr),
+    };
+
+    gpio_config(&io_conf);
+    gpio_set_pull_mode(config->mosi, GPIO_PULLUP_ONLY);
+    gpio_set_pull_mode(config->sclk, GPIO_PULLUP_ONLY);
+    gpio_set_pull_mode(config->cs, GPIO_PULLUP_ONLY);
+
+    //Initialize SPI slave interface
+    if (spi_slave_initialize(config->host, &bus_cfg, &slvcfg, SPI_DMA_CH_AUTO) != ESP_OK) {
+        esp_timer_delete(h->timer);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t init(struct eppp_spi *h, struct eppp_config_spi_s *config)
+{
+    return h->parent.role == EPPP_CLIENT ? init_master(h, config) : init_slave(h, config);
+}
+
+static void deinit(struct eppp_spi *h)
+{
+    if (h->parent.role == EPPP_CLIENT) {
+        deinit_master(h);
+    } else {
+        deinit_slave(h);
+    }
+}
+
+static esp_err_t perform_transaction_master(struct eppp_spi *h, size_t len, const void *tx_buffer, void *rx_buffer)
+{
+    spi_transaction_t t = {};
+    t.length = len * 8;
+    t.tx_buffer = tx_buffer;
+    t.rx_buffer = rx_buffer;
+    return spi_device_transmit(h->spi_device, &t);
+}
+
+static esp_err_t perform_transaction_slave(struct eppp_spi *h, size_t len, const void *tx_buffer, void *rx_buffer)
+{
+    spi_slave_transaction_t t = {};
+    t.user = h;
+    t.length = len * 8;
+    t.tx_buffer = tx_buffer;
+    t.rx_buffer = rx_buffer;
+    return spi_slave_transmit(h->spi_host, &t, portMAX_DELAY);
+}
+
+static esp_err_t transaction(struct eppp_spi *h, size_t len, const void *tx_buffer, void *rx_buffer)
+{
+    return h->parent.role == EPPP_CLIENT ? perform_transaction_master(h, len, tx_buffer, rx_buffer)
+           : perform_transaction_slave(h, len, tx_buffer, rx_buffer);
+}
+
+const struct eppp_spi_bus_ops eppp_spi_bus = {
+    .init = init,
+    .deinit = deinit,
+    .transaction = transaction,
+    .set_intr = set_intr,
+};
+
+#endif // EPPP_HAS_SPI
@@ -0,0 +1,217 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * SPI bus simulation for linux target
+ *
+ * Master and slave are connected with a SOCK_SEQPACKET socketpair, each message starts with its type:
+ *  - SIM_INTR  (slave->master): level of the handshake line
+ *  - SIM_WAKE  (slave->master): falling edge requesting a write, latched by the master, sent when the slave has
+ *                                 data in its next transaction, or data queued while it waits in an empty one
+ *  - SIM_XFER  (master->slave): master's half of a full duplex transaction
+ *  - SIM_REPLY (slave->master): slave's half of the same transaction
+ * The slave blocks in a transaction until the master clocks it, just like spi_slave_transmit() does.
+ */
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "freertos/task.h"
+#include "eppp_spi.h"
+
+#if EPPP_HAS_SPI
+
+#define SIM_INTR  1
+#define SIM_XFER  2
+#define SIM_REPLY 3
+#define SIM_WAKE  4
+
+#define SIM_TIMEOUT_MS 1000
+#define SIM_POLL_MS    100  // the blocked slave checks the stop request
+
+static const char *TAG = "eppp_spi_sim";
+
+static esp_err_t sim_send(struct eppp_spi *h, uint8_t type, const void *data, size_t len)
+{
+    struct iovec iov[2] = {
+        { .iov_base = &type, .iov_len = 1 },
+        { .iov_base = (void *)data, .iov_len = len },
+    };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+    if (sendmsg(h->fd, &msg, MSG_NOSIGNAL) < 0) {
+        if (errno == EPIPE) {
+            // the other end has closed the bus, which is how the link shuts down
+            ESP_LOGD(TAG, "Bus closed by the peer");
+        } else {
+            ESP_LOGE(TAG, "Failed to send to the bus: errno=%d", errno);
+        }
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// Receives one message, returns its length (including type), 0 if the bus has been closed, -1 on timeout or error
+static int sim_recv(struct eppp_spi *h, uint8_t *buffer, size_t size, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = h->fd, .events = POLLIN };
+    int ret = poll(&pfd, 1, timeout_ms);
+    if (ret <= 0) {
+        return -1;
+    }
+    return recv(h->fd, buffer, size, 0);
+}
+
+static void master_bus_task(void *arg)
+{
+    struct eppp_spi *h = arg;
+    uint8_t msg[1 + TRANSFER_SIZE];
+    int len;
+    while ((len = sim_recv(h, msg, sizeof(msg), 100)) != 0) {
+        if (len < 0) {
+            continue;
+        }
+        if (msg[0] == SIM_INTR && len == 2) {
+            if (msg[1]) {
+                eppp_spi_handshake_ready(h);
+            }
+        } else if (msg[0] == SIM_WAKE) {
+            eppp_spi_handshake_request(h);
+        } else if (msg[0] == SIM_REPLY && h->reply_buffer) {
+            size_t copy = len - 1 < h->reply_len ? len - 1 : h->reply_len;
+            memcpy(h->reply_buffer, msg + 1, copy);
+            memset((uint8_t *)h->reply_buffer + copy, 0, h->reply_len - copy);
+            h->reply_buffer = NULL;
+            xSemaphoreGive(h->reply);
+        }
+    }
+    // h is freed once deinit() gets this, so it's the last access
+    xSemaphoreGive(h->bus_exit);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t master_transaction(struct eppp_spi *h, size_t len, const void *tx_buffer, void *rx_buffer)
+{
+    h->reply_len = len;
+    h->reply_buffer = rx_buffer;
+    ESP_RETURN_ON_ERROR(sim_send(h, SIM_XFER, tx_buffer, len), TAG, "Failed to clock the slave");
+    if (xSemaphoreTake(h->reply, pdMS_TO_TICKS(SIM_TIMEOUT_MS)) != pdTRUE) {
+        h->reply_buffer = NULL;
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t slave_transaction(struct eppp_spi *h, size_t len, const void *tx_buffer, void *rx_buffer)
+{
+    uint8_t msg[1 + TRANSFER_SIZE];
+    if (eppp_spi_slave_post_setup(h)) {
+        // pulse the handshake line like the slave's timer does
+        usleep(MIN_TRIGGER_US);
+        if (h->blocked == SLAVE_WANTS_WRITE) {
+            sim_send(h, SIM_WAKE, NULL, 0);
+        }
+    }
+    int ret;
+    for (;;) {
+        ret = sim_recv(h, msg, sizeof(msg), SIM_POLL_MS);
+        if (ret < 0) {
+            if (h->parent.stop) {
+                return ESP_ERR_TIMEOUT;
+            }
+            continue;
+        }
+        if (ret == 0) {
+            ESP_LOGE(TAG, "SPI bus closed");
+            return ESP_FAIL;
+        }
+        if (msg[0] == SIM_XFER) {
+            break;
+        }
+    }
+    size_t master_len = ret - 1;
+    size_t copy = master_len < len ? master_len : len;
+    memcpy(rx_buffer, msg + 1, copy);
+    // the master clocks the transaction, so it determines its length
+    esp_err_t err = sim_send(h, SIM_REPLY, tx_buffer, copy);
+    eppp_spi_slave_post_trans(h);
+    return err;
+}
+
+static esp_err_t transaction(struct eppp_spi *h, size_t len, const void *tx_buffer, void *rx_buffer)
+{
+    return h->parent.role == EPPP_CLIENT ? master_transaction(h, len, tx_buffer, rx_buffer)
+           : slave_transaction(h, len, tx_buffer, rx_buffer);
+}
+
+static void set_intr(struct eppp_spi *h, int level)
+{
+    if (level == 0 && h->blocked == SLAVE_BLOCKED) {
+        // data queued while the slave waits in an empty transaction (wake_up()): on chips the master sees
+        // the edge if it's blocked, here the request is latched, so it also works if the master isn't blocked yet
+        sim_send(h, SIM_WAKE, NULL, 0);
+        return;
+    }
+    uint8_t data = level;
+    sim_send(h, SIM_INTR, &data, sizeof(data));
+}
+
+static void deinit(struct eppp_spi *h)
+{
+    // wakes up the bus task and the blocked slave transaction
+    shutdown(h->fd, SHUT_RDWR);
+    if (h->bus_task) {
+        xSemaphoreTake(h->bus_exit, portMAX_DELAY);
+        h->bus_task = NULL;
+    }
+    if (h->bus_exit) {
+        vSemaphoreDelete(h->bus_exit);
+    }
+    if (h->reply) {
+        vSemaphoreDelete(h->reply);
+    }
+}
+
+static esp_err_t init(struct eppp_spi *h, struct eppp_config_spi_s *config)
+{
+    h->fd = config->host;
+    if (h->parent.role == EPPP_SERVER) {
+        return ESP_OK;
+    }
+    h->reply = xSemaphoreCreateBinary();
+    h->bus_exit = xSemaphoreCreateBinary();
+    if (h->reply == NULL || h->bus_exit == NULL) {
+        ESP_LOGE(TAG, "Failed to create the bus semaphores");
+        goto err;
+    }
+    if (xTaskCreate(master_bus_task, "eppp_spi_sim", 4096, h, configMAX_PRIORITIES - 1, &h->bus_task) != pdTRUE) {
+        h->bus_task = NULL;
+        ESP_LOGE(TAG, "Failed to create the bus task");
+        goto err;
+    }
+    return ESP_OK;
+err:
+    if (h->reply) {
+        vSemaphoreDelete(h->reply);
+        h->reply = NULL;
+    }
+    if (h->bus_exit) {
+        vSemaphoreDelete(h->bus_exit);
+        h->bus_exit = NULL;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+const struct eppp_spi_bus_ops eppp_spi_bus = {
+    .init = init,
+    .deinit = deinit,
+    .transaction = transaction,
+    .set_intr = set_intr,
+};
+
+#endif // EPPP_HAS_SPI
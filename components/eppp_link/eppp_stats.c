@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "eppp_transport.h"
+#include "eppp_frame.h"
+
+// ring arithmetic stays valid when the trace is disabled, no entries are recorded then
+#define TRACE_RING_SIZE (CONFIG_EPPP_LINK_TRACE_ENTRIES > 0 ? CONFIG_EPPP_LINK_TRACE_ENTRIES : 1)
+
+#if CONFIG_EPPP_LINK_TRACE_ENTRIES > 0
+static const char *TAG = "eppp_stats";
+#endif
+
+esp_err_t eppp_trace_init(struct eppp_handle *h)
+{
+#if CONFIG_EPPP_LINK_TRACE_ENTRIES > 0
+    h->trace = calloc(1, sizeof(struct eppp_trace) + CONFIG_EPPP_LINK_TRACE_ENTRIES * sizeof(eppp_trace_entry_t));
+    if (h->trace == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate the trace of %d entries", CONFIG_EPPP_LINK_TRACE_ENTRIES);
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+    return ESP_OK;
+}
+
+void eppp_trace_deinit(struct eppp_handle *h)
+{
+    free(h->trace);
+    h->trace = NULL;
+}
+
+void eppp_trace_record(struct eppp_handle *h, eppp_trace_event_t event, uint16_t size, uint16_t tx_len, uint16_t rx_len, uint32_t latency_us)
+{
+    struct eppp_trace *t = h->trace;
+    if (t == NULL) {
+        return;
+    }
+    eppp_trace_entry_t *e = &t->entries[t->next];
+    e->timestamp_us = eppp_time_us();
+    e->event = event;
+    e->size = size;
+    e->tx_len = tx_len;
+    e->rx_len = rx_len;
+    e->latency_us = latency_us;
+    t->next = (t->next + 1) % TRACE_RING_SIZE;
+    if (t->count < TRACE_RING_SIZE) {
+        t->count++;
+    }
+}
+
+size_t eppp_trace_read(struct eppp_handle *h, eppp_trace_entry_t *entries, size_t max_entries)
+{
+    struct eppp_trace *t = h->trace;
+    if (t == NULL) {
+        return 0;
+    }
+    size_t count = t->count;    // the I/O task keeps writing, take one snapshot of the indices
+    size_t next = t->next;
+    if (count > max_entries) {
+        count = max_entries;    // the most recent ones
+    }
+    size_t first = (next + TRACE_RING_SIZE - count) % TRACE_RING_SIZE;
+    for (size_t i = 0; i < count; ++i) {
+        entries[i] = t->entries[(first + i) % TRACE_RING_SIZE];
+    }
+    return count;
+}
+
+void eppp_stats_read(struct eppp_handle *h, eppp_stats_t *stats)
+{
+    *stats = h->stats;
+    // 64-bit counters could be torn by a concurrent update on 32-bit targets
+    stats->tx_bytes = __atomic_load_n(&h->stats.tx_bytes, __ATOMIC_RELAXED);
+    stats->rx_bytes = __atomic_load_n(&h->stats.rx_bytes, __ATOMIC_RELAXED);
+    if (h->raw) {
+        stats->rx_errors += h->raw->decoder.errors;
+    }
+}
+
+void eppp_stats_reset(struct eppp_handle *h)
+{
+    memset(&h->stats, 0, sizeof(h->stats));
+    memset(h->tx_class, 0, sizeof(h->tx_class));
+    if (h->raw) {
+        h->raw->decoder.errors = 0;
+    }
+    if (h->trace) {
+        h->trace->count = 0;
+    }
+}
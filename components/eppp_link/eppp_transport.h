@@ -0,0 +1,235 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "eppp_link.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#else
+#include "esp_timer.h"
+#endif
+
+// Linux target builds all the host backends, so they could be exercised and compared in one application
+#if CONFIG_IDF_TARGET_LINUX
+#define EPPP_HAS_UART 1
+#define EPPP_HAS_SPI  1
+#define EPPP_HAS_SDIO 0
+#else
+#define EPPP_HAS_UART CONFIG_EPPP_LINK_DEVICE_UART
+#define EPPP_HAS_SPI  CONFIG_EPPP_LINK_DEVICE_SPI
+#define EPPP_HAS_SDIO CONFIG_EPPP_LINK_DEVICE_SDIO
+#endif
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+#ifndef CONFIG_EPPP_LINK_MTU
+#define CONFIG_EPPP_LINK_MTU 1500   // only configurable in raw IP mode
+#endif
+
+// Largest message reassembled from fragments: raw IP frame of the MTU size (bigger chunks of PPP stream are passed in parts)
+#define EPPP_MAX_MESSAGE (CONFIG_EPPP_LINK_MTU + 8)
+
+#define EPPP_FRAGMENT_MORE 0x01     // more fragments of the message follow
+#define EPPP_FRAGMENT_CHANNEL 0x02  // message of the control channel, never fragmented
+#define EPPP_FRAGMENT_FIRST 0x04    // first fragment of the message (set also if it's not fragmented)
+
+#ifndef CONFIG_EPPP_LINK_TRACE_ENTRIES
+#define CONFIG_EPPP_LINK_TRACE_ENTRIES 0
+#endif
+
+struct eppp_handle;
+struct eppp_raw_link;
+
+/**
+ * @brief Prefix of every fragment of a message (one transmit() call) on the packet based transports (SPI, SDIO)
+ */
+struct eppp_fragment_header {
+    uint16_t len;       // size of the fragment, following this header
+    uint8_t seq;        // incremented with every fragment sent over the link, a gap means a lost fragment
+    uint8_t flags;      // EPPP_FRAGMENT_FIRST, EPPP_FRAGMENT_MORE, EPPP_FRAGMENT_CHANNEL
+} __attribute__((packed));
+
+/**
+ * @brief Receiver's state of the fragmented messages
+ */
+struct eppp_reassembly {
+    uint8_t next_seq;
+    bool discard;       // a fragment has been lost, discard the rest of its message
+    size_t fill;
+    uint8_t buffer[EPPP_MAX_MESSAGE];
+};
+
+/**
+ * @brief Passes one received chunk of the PPP stream to the upper layer
+ */
+typedef esp_err_t (*eppp_receive_t)(struct eppp_handle *h, void *buffer, size_t len);
+
+/**
+ * @brief Operations of one physical link (transport)
+ *
+ * Every transport allocates its own context, which embeds the common struct eppp_handle
+ * as the first member, so the handle could be used as esp_netif's driver handle.
+ */
+struct eppp_transport_ops {
+    const char *name;
+    /* Allocates the transport context and initializes the peripheral */
+    struct eppp_handle *(*create)(eppp_type_t role, eppp_config_t *config);
+    /* Deinitializes the peripheral and frees the context */
+    void (*destroy)(struct eppp_handle *h);
+    /* esp_netif driver's transmit */
+    esp_err_t (*transmit)(void *h, void *buffer, size_t len);
+    /* Performs one iteration of the I/O loop, passes received data to h->receive */
+    esp_err_t (*perform)(struct eppp_handle *h);
+    /* Sends one message of the control channel, NULL if the transport doesn't delimit messages */
+    esp_err_t (*transmit_channel)(struct eppp_handle *h, const void *buffer, size_t len);
+};
+
+struct eppp_handle {
+    const struct eppp_transport_ops *ops;
+    eppp_receive_t receive;
+    esp_netif_t *netif;
+    eppp_type_t role;
+    bool raw_ip;                // transmitted data are raw IP frames, not PPP stream
+    struct eppp_raw_link *raw;  // framing state in raw IP mode
+    bool stop;
+    bool exited;
+    bool netif_stop;
+    eppp_tx_class_stats_t tx_class[EPPP_TX_CLASS_MAX];
+    eppp_stats_t stats;
+    struct eppp_trace *trace;   // transaction trace, NULL if disabled (CONFIG_EPPP_LINK_TRACE_ENTRIES)
+    SemaphoreHandle_t channel_lock; // guards the receiver below, NULL if the handle has no netif to register it
+    eppp_channel_rx_t channel_rx;   // receiver of the control channel, NULL if not registered
+    void *channel_ctx;
+};
+
+/**
+ * @brief Ring buffer of the last transactions, written only from the perform() task
+ */
+struct eppp_trace {
+    size_t next;        // slot of the next entry
+    size_t count;       // number of valid entries, up to CONFIG_EPPP_LINK_TRACE_ENTRIES
+    eppp_trace_entry_t entries[];
+};
+
+#if EPPP_HAS_UART
+extern const struct eppp_transport_ops eppp_transport_uart;
+#endif
+#if EPPP_HAS_SPI
+extern const struct eppp_transport_ops eppp_transport_spi;
+#endif
+#if EPPP_HAS_SDIO
+extern const struct eppp_transport_ops eppp_transport_sdio;
+#endif
+
+/**
+ * @brief Classifies an outgoing chunk of the stream, which starts a new frame
+ *
+ * @param raw_ip The chunk is a raw IP frame (eppp_frame.h) rather than a part of PPP stream
+ * @return EPPP_TX_CLASS_BULK if CONFIG_EPPP_LINK_TX_PRIORITY is disabled
+ */
+eppp_tx_class_t eppp_tx_classify(const uint8_t *chunk, size_t len, bool raw_ip);
+
+/**
+ * @brief Checks whether the outgoing chunk of the stream completes a frame
+ */
+bool eppp_tx_frame_end(const uint8_t *chunk, size_t len, bool raw_ip);
+
+/**
+ * @brief Returns the transport operations for the configured transport
+ *
+ * @return NULL if the transport is not enabled in this build
+ */
+const struct eppp_transport_ops *eppp_transport_get(eppp_transport_t transport);
+
+/**
+ * @brief Passes the received fragment to h->receive, complete messages in one piece
+ *
+ * Unfragmented messages are passed directly, without copying. Messages bigger than
+ * the reassembly buffer are passed in parts, as both PPP and raw IP framing are streams.
+ */
+void eppp_reassemble(struct eppp_handle *h, struct eppp_reassembly *r, const struct eppp_fragment_header *head, uint8_t *data);
+
+/**
+ * @brief Monotonic time in microseconds, safe to call from ISR
+ */
+static inline __attribute__((always_inline)) int64_t eppp_time_us(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+/**
+ * @brief Adds to a counter of eppp_stats_t, which is updated from more tasks (transmit and I/O)
+ */
+#define EPPP_STATS_ADD(counter, n) __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+
+/**
+ * @brief Counts the received chunk and passes it to h->receive
+ */
+static inline esp_err_t eppp_deliver(struct eppp_handle *h, void *buffer, size_t len)
+{
+    EPPP_STATS_ADD(h->stats.rx_packets, 1);
+    EPPP_STATS_ADD(h->stats.rx_bytes, len);
+    return h->receive(h, buffer, len);
+}
+
+/**
+ * @brief Passes the received message of the control channel to its receiver
+ */
+static inline void eppp_channel_deliver(struct eppp_handle *h, const void *data, size_t len)
+{
+    if (h->channel_lock == NULL) {
+        return;
+    }
+    // held during the call, so the receiver and its context are replaced together and never in use afterwards
+    xSemaphoreTake(h->channel_lock, portMAX_DELAY);
+    if (h->channel_rx) {
+        h->channel_rx(h->channel_ctx, data, len);
+    }
+    xSemaphoreGive(h->channel_lock);
+}
+
+/**
+ * @brief Allocates the trace buffer, if enabled in Kconfig
+ */
+esp_err_t eppp_trace_init(struct eppp_handle *h);
+
+void eppp_trace_deinit(struct eppp_handle *h);
+
+/**
+ * @brief Appends one entry to the trace ring, overwriting the oldest one (no-op if the trace is disabled)
+ */
+void eppp_trace_record(struct eppp_handle *h, eppp_trace_event_t event, uint16_t size, uint16_t tx_len, uint16_t rx_len, uint32_t latency_us);
+
+/**
+ * @brief Copies the counters of the link, including the raw IP framing errors
+ */
+void eppp_stats_read(struct eppp_handle *h, eppp_stats_t *stats);
+
+void eppp_stats_reset(struct eppp_handle *h);
+
+/**
+ * @brief Copies up to max_entries of the trace, the oldest first
+ *
+ * @return Number of copied entries
+ */
+size_t eppp_trace_read(struct eppp_handle *h, eppp_trace_entry_t *entries, size_t max_entries);
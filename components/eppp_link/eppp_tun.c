@@ -0,0 +1,182 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Linux target: bridges the link in raw IP mode to a TUN interface, so that the host
+ * talks to the peer directly through the kernel network stack (no lwIP, no pppd)
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/if_tun.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "eppp_transport.h"
+#include "eppp_frame.h"
+
+#define TUN_DEVICE "/dev/net/tun"
+
+static const char *TAG = "eppp_tun";
+
+struct eppp_tun {
+    struct eppp_handle *h;
+    int fd;
+    bool stop;
+    int tasks;                  // number of running tasks
+    SemaphoreHandle_t exited;   // given by each task just before it exits
+    uint8_t buffer[EPPP_FRAME_MTU];
+};
+
+static void tun_deliver(void *ctx, uint8_t *packet, size_t len)
+{
+    struct eppp_tun *tun = ctx;
+    if (write(tun->fd, packet, len) < 0) {
+        ESP_LOGW(TAG, "Failed to write to TUN: errno=%d", errno);
+    }
+}
+
+static void perform_task(void *arg)
+{
+    struct eppp_tun *tun = arg;
+    while (tun->h->ops->perform(tun->h) != ESP_ERR_TIMEOUT) {}
+    xSemaphoreGive(tun->exited);
+    vTaskDelete(NULL);
+}
+
+static void read_task(void *arg)
+{
+    struct eppp_tun *tun = arg;
+    struct pollfd pfd = { .fd = tun->fd, .events = POLLIN };
+    while (!tun->stop) {
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t len = read(tun->fd, tun->buffer, sizeof(tun->buffer));
+        if (len > 0) {
+            eppp_raw_link_transmit(tun->h, tun->buffer, len);
+        }
+    }
+    xSemaphoreGive(tun->exited);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t set_address(int sock, struct ifreq *ifr, unsigned long request, uint32_t addr)
+{
+    struct sockaddr_in *sin = (struct sockaddr_in *)&ifr->ifr_addr;
+    memset(sin, 0, sizeof(*sin));
+    sin->sin_family = AF_INET;
+    sin->sin_addr.s_addr = addr;
+    return ioctl(sock, request, ifr) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t tun_configure(struct eppp_tun *tun, const char *if_name, eppp_config_t *config)
+{
+    struct ifreq ifr = { .ifr_flags = IFF_TUN | IFF_NO_PI };
+    strncpy(ifr.ifr_name, if_name, IFNAMSIZ - 1);
+    tun->fd = open(TUN_DEVICE, O_RDWR);
+    ESP_RETURN_ON_FALSE(tun->fd >= 0, ESP_FAIL, TAG, "Cannot open %s: errno=%d", TUN_DEVICE, errno);
+    ESP_RETURN_ON_FALSE(ioctl(tun->fd, TUNSETIFF, &ifr) == 0, ESP_FAIL, TAG, "Cannot create %s: errno=%d", if_name, errno);
+
+    // point to point interface: our address, the peer's address and the MTU of the raw IP link
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    ESP_RETURN_ON_FALSE(sock >= 0, ESP_FAIL, TAG, "Cannot create socket: errno=%d", errno);
+    esp_err_t ret = ESP_FAIL;
+    ESP_GOTO_ON_ERROR(set_address(sock, &ifr, SIOCSIFADDR, config->ppp.our_ip4_addr.addr), err, TAG, "Cannot set address");
+    ESP_GOTO_ON_ERROR(set_address(sock, &ifr, SIOCSIFDSTADDR, config->ppp.their_ip4_addr.addr), err, TAG, "Cannot set peer address");
+    ifr.ifr_mtu = EPPP_FRAME_MTU;
+    ESP_GOTO_ON_FALSE(ioctl(sock, SIOCSIFMTU, &ifr) == 0, ESP_FAIL, err, TAG, "Cannot set MTU");
+    ESP_GOTO_ON_FALSE(ioctl(sock, SIOCGIFFLAGS, &ifr) == 0, ESP_FAIL, err, TAG, "Cannot get flags");
+    ifr.ifr_flags |= IFF_UP | IFF_RUNNING | IFF_POINTOPOINT;
+    ESP_GOTO_ON_FALSE(ioctl(sock, SIOCSIFFLAGS, &ifr) == 0, ESP_FAIL, err, TAG, "Cannot bring %s up", if_name);
+    ret = ESP_OK;
+err:
+    close(sock);
+    return ret;
+}
+
+void eppp_tun_close(struct eppp_tun *tun)
+{
+    if (tun == NULL) {
+        return;
+    }
+    tun->stop = true;
+    if (tun->h) {
+        tun->h->stop = true;
+    }
+    // both tasks use the link and the TUN device, so they have to exit before anything is freed
+    // (the transport's perform() returns regularly to check the stop flag)
+    for (; tun->tasks > 0; tun->tasks--) {
+        xSemaphoreTake(tun->exited, portMAX_DELAY);
+    }
+    if (tun->exited) {
+        vSemaphoreDelete(tun->exited);
+    }
+    if (tun->h) {
+        eppp_raw_link_deinit(tun->h);
+        tun->h->ops->destroy(tun->h);
+    }
+    if (tun->fd >= 0) {
+        close(tun->fd);
+    }
+    free(tun);
+}
+
+struct eppp_tun *eppp_tun_open(eppp_type_t role, eppp_config_t *config, const char *if_name)
+{
+    const struct eppp_transport_ops *ops = eppp_transport_get(config->transport);
+    if (ops == NULL) {
+        ESP_LOGE(TAG, "Invalid transport: %d", config->transport);
+        return NULL;
+    }
+    struct eppp_tun *tun = calloc(1, sizeof(struct eppp_tun));
+    if (tun == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate eppp_tun");
+        return NULL;
+    }
+    tun->fd = -1;
+    tun->exited = xSemaphoreCreateCounting(2, 0);
+    if (tun->exited == NULL) {
+        ESP_LOGE(TAG, "Failed to create the exit semaphore");
+        goto err;
+    }
+    if (tun_configure(tun, if_name, config) != ESP_OK) {
+        goto err;
+    }
+    tun->h = ops->create(role, config);
+    if (tun->h == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize %s transport", ops->name);
+        goto err;
+    }
+    tun->h->ops = ops;
+    tun->h->role = role;
+    if (eppp_raw_link_init(tun->h, tun_deliver, tun) != ESP_OK) {
+        goto err;
+    }
+    if (xTaskCreate(perform_task, "eppp_tun", config->task.stack_size, tun, config->task.priority, NULL) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to create the perform task");
+        goto err;
+    }
+    tun->tasks++;
+    if (xTaskCreate(read_task, "eppp_tun_read", config->task.stack_size, tun, config->task.priority, NULL) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to create the TUN read task");
+        goto err;
+    }
+    tun->tasks++;
+    ESP_LOGI(TAG, "Interface %s is up", if_name);
+    return tun;
+err:
+    eppp_tun_close(tun);
+    return NULL;
+}
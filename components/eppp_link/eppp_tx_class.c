@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include "eppp_transport.h"
+#include "eppp_frame.h"
+
+#define PPP_FLAG        0x7E
+#define PPP_ESCAPE      0x7D
+#define PPP_TRANS       0x20
+#define PPP_ALLSTATIONS 0xFF
+#define PPP_UI          0x03
+
+#define PPP_IP          0x0021
+#define PPP_IPV6        0x0057
+#define PPP_CONTROL     0x8000  // network and link control protocols (IPCP, LCP, ...)
+
+#define IP_PROTO_TCP    6
+#define IP_PROTO_UDP    17
+#define TCP_FLAG_FIN    0x01
+#define TCP_FLAG_SYN    0x02
+#define TCP_FLAG_RST    0x04
+#define TCP_FLAG_ACK    0x10
+#define DNS_PORT        53
+
+// enough for PPP header, IPv4 header with options or IPv6 header, and TCP header
+#define CLASSIFY_BYTES  96
+
+#if CONFIG_EPPP_LINK_TX_PRIORITY
+
+static uint16_t get_be16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static size_t unescape(const uint8_t *frame, size_t len, uint8_t *out, size_t size)
+{
+    size_t n = 0;
+    bool escaped = false;
+    for (size_t i = 0; i < len && n < size; ++i) {
+        if (frame[i] == PPP_FLAG) {
+            if (n > 0) {
+                break;  // end of the frame
+            }
+            continue;
+        }
+        if (frame[i] == PPP_ESCAPE) {
+            escaped = true;
+            continue;
+        }
+        out[n++] = escaped ? frame[i] ^ PPP_TRANS : frame[i];
+        escaped = false;
+    }
+    return n;
+}
+
+static eppp_tx_class_t classify_transport(int proto, const uint8_t *l4, size_t len, size_t payload_len)
+{
+    if (len < 4) {
+        return EPPP_TX_CLASS_BULK;
+    }
+    uint16_t src = get_be16(l4);
+    uint16_t dst = get_be16(l4 + 2);
+    if (src == CONFIG_EPPP_LINK_TX_PRIO_RPC_PORT || dst == CONFIG_EPPP_LINK_TX_PRIO_RPC_PORT) {
+        return EPPP_TX_CLASS_CONTROL;
+    }
+    if (proto == IP_PROTO_UDP) {
+        return src == DNS_PORT || dst == DNS_PORT ? EPPP_TX_CLASS_DNS : EPPP_TX_CLASS_BULK;
+    }
+    if (proto == IP_PROTO_TCP && len >= 14) {
+        size_t header_len = (l4[12] >> 4) * 4;
+        uint8_t flags = l4[13];
+        // pure ACK: no data and no connection control
+        if ((flags & TCP_FLAG_ACK) && !(flags & (TCP_FLAG_SYN | TCP_FLAG_FIN | TCP_FLAG_RST)) &&
+                payload_len == header_len) {
+            return EPPP_TX_CLASS_ACK;
+        }
+    }
+    return EPPP_TX_CLASS_BULK;
+}
+
+static eppp_tx_class_t classify_ipv4(const uint8_t *p, size_t n)
+{
+    if (n < 20) {
+        return EPPP_TX_CLASS_BULK;
+    }
+    size_t header_len = (p[0] & 0x0F) * 4;
+    uint16_t fragment_offset = get_be16(p + 6) & 0x1FFF;
+    if (fragment_offset != 0 || header_len < 20 || n < header_len) {
+        return EPPP_TX_CLASS_BULK;
+    }
+    return classify_transport(p[9], p + header_len, n - header_len, get_be16(p + 2) - header_len);
+}
+
+static eppp_tx_class_t classify_ipv6(const uint8_t *p, size_t n)
+{
+    if (n < 40) {
+        return EPPP_TX_CLASS_BULK;
+    }
+    return classify_transport(p[6], p + 40, n - 40, get_be16(p + 4));
+}
+
+static eppp_tx_class_t classify_ppp(const uint8_t *frame, size_t len)
+{
+    uint8_t buf[CLASSIFY_BYTES];
+    size_t n = unescape(frame, len, buf, sizeof(buf));
+    const uint8_t *p = buf;
+    if (n >= 2 && p[0] == PPP_ALLSTATIONS && p[1] == PPP_UI) {
+        p += 2;
+        n -= 2;
+    }
+    if (n < 1) {
+        return EPPP_TX_CLASS_BULK;
+    }
+    uint16_t protocol;
+    if (p[0] & 1) { // compressed protocol field
+        protocol = p[0];
+        p += 1;
+        n -= 1;
+    } else if (n >= 2) {
+        protocol = get_be16(p);
+        p += 2;
+        n -= 2;
+    } else {
+        return EPPP_TX_CLASS_BULK;
+    }
+    if (protocol >= PPP_CONTROL) {
+        return EPPP_TX_CLASS_CONTROL;
+    }
+    if (protocol == PPP_IP) {
+        return classify_ipv4(p, n);
+    }
+    if (protocol == PPP_IPV6) {
+        return classify_ipv6(p, n);
+    }
+    return EPPP_TX_CLASS_BULK;
+}
+
+static eppp_tx_class_t classify_raw(const uint8_t *frame, size_t len)
+{
+    if (len <= sizeof(struct eppp_frame_header)) {
+        return EPPP_TX_CLASS_BULK;
+    }
+    const uint8_t *p = frame + sizeof(struct eppp_frame_header);
+    size_t n = len - sizeof(struct eppp_frame_header);
+    switch (p[0] >> 4) {
+    case 4:
+        return classify_ipv4(p, n);
+    case 6:
+        return classify_ipv6(p, n);
+    default:
+        return EPPP_TX_CLASS_BULK;
+    }
+}
+
+#endif // CONFIG_EPPP_LINK_TX_PRIORITY
+
+eppp_tx_class_t eppp_tx_classify(const uint8_t *chunk, size_t len, bool raw_ip)
+{
+#if CONFIG_EPPP_LINK_TX_PRIORITY
+    return raw_ip ? classify_raw(chunk, len) : classify_ppp(chunk, len);
+#else
+    return EPPP_TX_CLASS_BULK;
+#endif
+}
+
+bool eppp_tx_frame_end(const uint8_t *chunk, size_t len, bool raw_ip)
+{
+    // raw IP frames are always transmitted whole
+    return raw_ip || (len > 0 && chunk[len - 1] == PPP_FLAG);
+}
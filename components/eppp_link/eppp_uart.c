@@ -0,0 +1,382 @@
+/*
+ * SPDX-FileCopyrightText: 2019-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "eppp_transport.h"
+
+#if EPPP_HAS_UART
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#else
+#include "driver/uart.h"
+#endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define BUF_SIZE (1024)
+
+#if CONFIG_EPPP_LINK_TX_PRIORITY
+struct chunk {
+    uint8_t *data;
+    size_t len;
+    bool frame_end;
+};
+#endif
+
+static const char *TAG = "eppp_uart";
+
+struct eppp_uart {
+    struct eppp_handle parent;
+#if CONFIG_IDF_TARGET_LINUX
+    int fd;
+#else
+    QueueHandle_t uart_event_queue;
+    uart_port_t uart_port;
+#endif
+#if CONFIG_EPPP_LINK_TX_PRIORITY
+    QueueHandle_t out_queue[EPPP_TX_CLASS_MAX];
+    SemaphoreHandle_t out_ready;    // chunk queued or the writer should stop
+    SemaphoreHandle_t writer_exit;  // given by the writer task just before it exits
+    SemaphoreHandle_t tx_lock;      // serializes transmit(), guards the frame state below
+    eppp_tx_class_t tx_class;       // class of the frame being transmitted
+    bool tx_mid_frame;              // transmit() received only a part of the current frame
+    bool tx_drop_frame;             // part of the current frame was dropped, so drop the rest as well
+    int locked_class;               // writer: class of a partially written frame, or -1
+    bool writer_stop;
+#endif
+    uint8_t buffer[BUF_SIZE];
+};
+
+#if CONFIG_IDF_TARGET_LINUX
+
+static esp_err_t init_uart(struct eppp_uart *h, eppp_config_t *config)
+{
+    // uart.port is a file descriptor of an open serial device or pty on linux
+    h->fd = config->uart.port;
+    ESP_RETURN_ON_FALSE(h->fd >= 0, ESP_ERR_INVALID_ARG, TAG, "Invalid file descriptor");
+    return ESP_OK;
+}
+
+static void deinit_uart(struct eppp_uart *h)
+{
+}
+
+static esp_err_t write_bytes(struct eppp_uart *h, const uint8_t *data, size_t len)
+{
+    ESP_LOG_BUFFER_HEXDUMP("ppp_uart_send", data, len, ESP_LOG_VERBOSE);
+    size_t remaining = len;
+    while (remaining > 0) {
+        ssize_t written = write(h->fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            ESP_LOGE(TAG, "Failed to write to the serial line: errno=%d", errno);
+            return ESP_FAIL;
+        }
+        data += written;
+        remaining -= written;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t perform(struct eppp_handle *handle)
+{
+    struct eppp_uart *h = __containerof(handle, struct eppp_uart, parent);
+    if (handle->stop) {
+        return ESP_ERR_TIMEOUT;
+    }
+    struct pollfd pfd = { .fd = h->fd, .events = POLLIN };
+    if (poll(&pfd, 1, 100) <= 0) {
+        return ESP_OK;
+    }
+    ssize_t len = read(h->fd, h->buffer, BUF_SIZE);
+    if (len > 0) {
+        ESP_LOG_BUFFER_HEXDUMP("ppp_uart_recv", h->buffer, len, ESP_LOG_VERBOSE);
+        eppp_deliver(handle, h->buffer, len);
+    } else if (len == 0 || (errno != EINTR && errno != EAGAIN)) {
+        ESP_LOGE(TAG, "Failed to read from the serial line: errno=%d", errno);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+#else // target UART driver
+
+static esp_err_t init_uart(struct eppp_uart *h, eppp_config_t *config)
+{
+    h->uart_port = config->uart.port;
+    uart_config_t uart_config = {};
+    uart_config.baud_rate = config->uart.baud;
+    uart_config.data_bits = UART_DATA_8_BITS;
+    uart_config.parity    = UART_PARITY_DISABLE;
+    uart_config.stop_bits = UART_STOP_BITS_1;
+    uart_config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    uart_config.source_clk = UART_SCLK_DEFAULT;
+
+    ESP_RETURN_ON_ERROR(uart_driver_install(h->uart_port, config->uart.rx_buffer_size, 0, config->uart.queue_size, &h->uart_event_queue, 0), TAG, "Failed to install UART");
+    ESP_RETURN_ON_ERROR(uart_param_config(h->uart_port, &uart_config), TAG, "Failed to set params");
+    ESP_RETURN_ON_ERROR(uart_set_pin(h->uart_port, config->uart.tx_io, config->uart.rx_io, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE), TAG, "Failed to set UART pins");
+    ESP_RETURN_ON_ERROR(uart_set_rx_timeout(h->uart_port, 1), TAG, "Failed to set UART Rx timeout");
+    return ESP_OK;
+}
+
+static void deinit_uart(struct eppp_uart *h)
+{
+    uart_driver_delete(h->uart_port);
+}
+
+static esp_err_t write_bytes(struct eppp_uart *h, const uint8_t *data, size_t len)
+{
+    ESP_LOG_BUFFER_HEXDUMP("ppp_uart_send", data, len, ESP_LOG_VERBOSE);
+    if (uart_write_bytes(h->uart_port, data, len) < 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t perform(struct eppp_handle *handle)
+{
+    struct eppp_uart *h = __containerof(handle, struct eppp_uart, parent);
+    uart_event_t event = {};
+    if (handle->stop) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (xQueueReceive(h->uart_event_queue, &event, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_OK;
+    }
+    if (event.type == UART_DATA) {
+        size_t len;
+        uart_get_buffered_data_len(h->uart_port, &len);
+        if (len) {
+            len = uart_read_bytes(h->uart_port, h->buffer, BUF_SIZE, 0);
+            ESP_LOG_BUFFER_HEXDUMP("ppp_uart_recv", h->buffer, len, ESP_LOG_VERBOSE);
+            eppp_deliver(handle, h->buffer, len);
+        }
+    } else {
+        ESP_LOGW(TAG, "Received UART event: %d", event.type);
+    }
+    return ESP_OK;
+}
+
+#endif // CONFIG_IDF_TARGET_LINUX
+
+#if CONFIG_EPPP_LINK_TX_PRIORITY
+
+/*
+ * Outgoing chunks are queued by class and written by a separate task in the order of class priority,
+ * so that control packets don't wait behind the bulk data in the UART driver.
+ */
+static esp_err_t queue_chunk(struct eppp_uart *h, eppp_tx_class_t cls, const void *buffer, size_t len, bool frame_end)
+{
+    struct chunk c = { .len = len, .frame_end = frame_end };
+    if (uxQueueSpacesAvailable(h->out_queue[cls]) == 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    c.data = malloc(len);
+    if (c.data == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(c.data, buffer, len);
+    // cannot fail, transmit() is the only producer and holds the lock
+    xQueueSend(h->out_queue[cls], &c, 0);
+    return ESP_OK;
+}
+
+static esp_err_t transmit(void *handle, void *buffer, size_t len)
+{
+    struct eppp_uart *h = handle;
+    bool frame_end = eppp_tx_frame_end(buffer, len, h->parent.raw_ip);
+    xSemaphoreTake(h->tx_lock, portMAX_DELAY);
+    // all chunks of one frame go to the same class, so they stay in order
+    if (!h->tx_mid_frame) {
+        h->tx_class = eppp_tx_classify(buffer, len, h->parent.raw_ip);
+        h->tx_drop_frame = false;
+    }
+    eppp_tx_class_t cls = h->tx_class;
+    esp_err_t ret = h->tx_drop_frame ? ESP_ERR_NO_MEM : queue_chunk(h, cls, buffer, len, frame_end);
+    if (ret == ESP_OK) {
+        h->parent.tx_class[cls].queued++;
+        EPPP_STATS_ADD(h->parent.stats.tx_packets, 1);
+        EPPP_STATS_ADD(h->parent.stats.tx_bytes, len);
+    } else {
+        h->parent.tx_class[cls].dropped++;
+        EPPP_STATS_ADD(h->parent.stats.tx_dropped, 1);
+        h->tx_drop_frame = true;
+    }
+    h->tx_mid_frame = !frame_end;
+    xSemaphoreGive(h->tx_lock);
+    if (ret == ESP_OK) {
+        xSemaphoreGive(h->out_ready);
+    }
+    return ret;
+}
+
+/*
+ * Takes the next chunk in the order of class priority. Chunks of one frame are always taken
+ * together, so that a higher priority frame doesn't interrupt them.
+ */
+static bool take_chunk(struct eppp_uart *h, struct chunk *c)
+{
+    if (h->locked_class >= 0) {
+        // under the lock, so the queue and the frame state of transmit() are consistent
+        xSemaphoreTake(h->tx_lock, portMAX_DELAY);
+        bool mid_frame = h->tx_mid_frame;
+        bool taken = xQueueReceive(h->out_queue[h->locked_class], c, 0) == pdTRUE;
+        xSemaphoreGive(h->tx_lock);
+        if (taken) {
+            if (c->frame_end) {
+                h->locked_class = -1;
+            }
+            return true;
+        }
+        if (mid_frame) {
+            return false;   // the rest of the frame is on its way
+        }
+        h->locked_class = -1; // the rest of the frame has been dropped
+    }
+    for (int cls = 0; cls < EPPP_TX_CLASS_MAX; ++cls) {
+        if (xQueueReceive(h->out_queue[cls], c, 0) == pdTRUE) {
+            if (!c->frame_end) {
+                h->locked_class = cls;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static void writer_task(void *arg)
+{
+    struct eppp_uart *h = arg;
+    struct chunk c;
+    while (!h->writer_stop) {
+        xSemaphoreTake(h->out_ready, pdMS_TO_TICKS(100));
+        while (!h->writer_stop && take_chunk(h, &c)) {
+            if (write_bytes(h, c.data, c.len) != ESP_OK) {
+                EPPP_STATS_ADD(h->parent.stats.tx_dropped, 1);
+            }
+            free(c.data);
+        }
+    }
+    xSemaphoreGive(h->writer_exit);
+    vTaskDelete(NULL);
+}
+
+static void delete_writer(struct eppp_uart *h)
+{
+    for (int cls = 0; cls < EPPP_TX_CLASS_MAX; ++cls) {
+        if (h->out_queue[cls]) {
+            struct chunk c;
+            while (xQueueReceive(h->out_queue[cls], &c, 0) == pdTRUE) {
+                free(c.data);
+            }
+            vQueueDelete(h->out_queue[cls]);
+        }
+    }
+    if (h->out_ready) {
+        vSemaphoreDelete(h->out_ready);
+    }
+    if (h->writer_exit) {
+        vSemaphoreDelete(h->writer_exit);
+    }
+    if (h->tx_lock) {
+        vSemaphoreDelete(h->tx_lock);
+    }
+}
+
+static esp_err_t create_writer(struct eppp_uart *h, eppp_config_t *config)
+{
+    h->locked_class = -1;
+    for (int cls = 0; cls < EPPP_TX_CLASS_MAX; ++cls) {
+        int size = cls == EPPP_TX_CLASS_BULK ? CONFIG_EPPP_LINK_PACKET_QUEUE_SIZE : CONFIG_EPPP_LINK_TX_PRIO_QUEUE_SIZE;
+        h->out_queue[cls] = xQueueCreate(size, sizeof(struct chunk));
+        ESP_RETURN_ON_FALSE(h->out_queue[cls], ESP_ERR_NO_MEM, TAG, "Failed to create the chunk queue");
+    }
+    h->out_ready = xSemaphoreCreateBinary();
+    h->writer_exit = xSemaphoreCreateBinary();
+    h->tx_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(h->out_ready && h->writer_exit && h->tx_lock, ESP_ERR_NO_MEM, TAG, "Failed to create the semaphores");
+    ESP_RETURN_ON_FALSE(xTaskCreate(writer_task, "eppp_uart_tx", config->task.stack_size, h, config->task.priority, NULL) == pdTRUE,
+                        ESP_FAIL, TAG, "Failed to create the writer task");
+    return ESP_OK;
+}
+
+static void destroy_writer(struct eppp_uart *h)
+{
+    h->writer_stop = true;
+    xSemaphoreGive(h->out_ready);
+    xSemaphoreTake(h->writer_exit, portMAX_DELAY);
+    delete_writer(h);
+}
+
+#else
+
+static esp_err_t transmit(void *handle, void *buffer, size_t len)
+{
+    struct eppp_uart *h = handle;
+    if (write_bytes(h, buffer, len) != ESP_OK) {
+        EPPP_STATS_ADD(h->parent.stats.tx_dropped, 1);
+        return ESP_FAIL;
+    }
+    EPPP_STATS_ADD(h->parent.stats.tx_packets, 1);
+    EPPP_STATS_ADD(h->parent.stats.tx_bytes, len);
+    return ESP_OK;
+}
+
+#endif // CONFIG_EPPP_LINK_TX_PRIORITY
+
+static void destroy(struct eppp_handle *handle)
+{
+    struct eppp_uart *h = __containerof(handle, struct eppp_uart, parent);
+#if CONFIG_EPPP_LINK_TX_PRIORITY
+    destroy_writer(h);
+#endif
+    deinit_uart(h);
+    free(h);
+}
+
+static struct eppp_handle *create(eppp_type_t role, eppp_config_t *config)
+{
+    struct eppp_uart *h = calloc(1, sizeof(struct eppp_uart));
+    if (!h) {
+        ESP_LOGE(TAG, "Failed to allocate eppp_uart");
+        return NULL;
+    }
+    h->parent.role = role;
+    if (init_uart(h, config) != ESP_OK) {
+        free(h);
+        return NULL;
+    }
+#if CONFIG_EPPP_LINK_TX_PRIORITY
+    if (create_writer(h, config) != ESP_OK) {
+        delete_writer(h);
+        deinit_uart(h);
+        free(h);
+        return NULL;
+    }
+#endif
+    return &h->parent;
+}
+
+const struct eppp_transport_ops eppp_transport_uart = {
+    .name = "UART",
+    .create = create,
+    .destroy = destroy,
+    .transmit = transmit,
+    .perform = perform,
+};
+
+#endif // EPPP_HAS_UART
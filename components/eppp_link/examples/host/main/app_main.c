@@ -142,6 +142,8 @@ void app_main(void)
 
     // Register the ping command
     ESP_ERROR_CHECK(console_cmd_ping_register());
+    // Register the eppp command (link statistics)
+    ESP_ERROR_CHECK(eppp_console_cmd_register());
     // start console REPL
     ESP_ERROR_CHECK(console_cmd_start());
 
@@ -0,0 +1,751 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <pty.h>
+#include <termios.h>
+#include <sys/socket.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "eppp_link.h"
+#include "eppp_transport.h"
+#include "eppp_frame.h"
+
+#define RESPONSE_TIMEOUT_MS     5000
+#define LATENCY_FRAME_SIZE      64
+#define MAX_FRAME_SIZE          1500
+#define MAX_FRAMES_PER_RUN      50000
+#define MIN_FRAMES_PER_RUN      100
+#define FRAMES_IN_FLIGHT        32
+#define PERFORM_TASK_PRIO       5
+#define PERFORM_TASK_STACK      8192
+#define PPP_FLAG                0x7E
+#define LOAD_SETTLE_MS          50
+#define PPP_ESCAPE              0x7D
+#define PPP_TRANS               0x20
+#define PPP_FCS_INIT            0xFFFF
+#define PPP_FCS_GOOD            0xF0B8
+#define PPP_HEADER_SIZE         4       /* address, control and IPv4 protocol */
+#define PPP_FCS_SIZE            2
+#define FRAMING_PACKET_SIZE     1500
+#define LINKUP_SAMPLES          20
+#define PPP_IP                  0x0021
+#define PPP_IPCP                0x8021
+#define PPP_LCP                 0xC021
+#define PPP_CONF_REQ            1
+#define PPP_CONF_ACK            2
+#define PPP_CONTROL_MAX_SIZE    16
+
+/* PPP frame with a pure TCP ACK, classified as EPPP_TX_CLASS_ACK (FCS is not checked by the benchmark) */
+static const uint8_t s_ack_frame[] = {
+    PPP_FLAG, 0xFF, 0x03, 0x00, 0x21,
+    0x45, 0x00, 0x00, 0x28, 0x00, 0x01, 0x40, 0x00, 0x40, 0x06, 0x00, 0x00,     // IPv4, TCP
+    0xC0, 0xA8, 0x0B, 0x02, 0xC0, 0xA8, 0x0B, 0x01,
+    0xC0, 0x00, 0x00, 0x50, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x20, 0x00,     // ports 49152 -> 80
+    0x50, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,                             // ACK only, no data
+    0x00, 0x00, PPP_FLAG
+};
+
+/* IPv4 + UDP header of the framing test packets, ports 49152 -> 5001 (bulk class), lengths are filled in */
+static const uint8_t s_udp_header[] = {
+    0x45, 0x00, 0x00, 0x00, 0x00, 0x01, 0x40, 0x00, 0x40, 0x11, 0x00, 0x00,
+    0xC0, 0xA8, 0x0B, 0x02, 0xC0, 0xA8, 0x0B, 0x01,
+    0xC0, 0x00, 0x13, 0x89, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* MTUs of the raw IP bulk runs, up to CONFIG_EPPP_LINK_MTU */
+static const int s_mtus[] = { 1500, 3000, 4500, 6000, 9000 };
+
+static const char *TAG = "eppp_benchmark";
+
+static const int s_frame_sizes[] = { 64, 512, 1500 };
+
+/* Configure-Requests of the shortest PPP negotiation: LCP with ACCM and magic number, IPCP with the address */
+static const uint8_t s_lcp_request[] = {
+    PPP_CONF_REQ, 0x01, 0x00, 0x0E, 0x02, 0x06, 0x00, 0x00, 0x00, 0x00, 0x05, 0x06, 0x12, 0x34, 0x56, 0x78
+};
+static const uint8_t s_ipcp_request[][10] = {
+    { PPP_CONF_REQ, 0x01, 0x00, 0x0A, 0x03, 0x06, 0xC0, 0xA8, 0x0B, 0x01 },     // server
+    { PPP_CONF_REQ, 0x01, 0x00, 0x0A, 0x03, 0x06, 0xC0, 0xA8, 0x0B, 0x02 },     // client
+};
+
+typedef struct {
+    const char          *name;
+    eppp_transport_t    transport;
+    int                 fds[2];     /*!< [0] server (SPI slave) end, [1] client (SPI master) end */
+    struct eppp_handle  *server;
+    struct eppp_handle  *client;
+} bench_link_t;
+
+static struct {
+    SemaphoreHandle_t   done;
+    SemaphoreHandle_t   credits;        /*!< Frames which could be sent before the server receives the previous ones */
+    int                 frame_credits;  /*!< Credits taken by one frame, framing tests send frames longer than one packet */
+    uint8_t             frame[MAX_FRAME_SIZE];
+    size_t              frame_size;     /*!< UART delivers a byte stream, so frames are counted by their size */
+    bool                echo;           /*!< Server echoes every frame back to the client */
+    bool                loaded;         /*!< Server echoes only ACK frames, while the client floods it with bulk frames */
+    volatile bool       flood;
+    volatile bool       flood_exited;
+    volatile size_t     server_bytes;   /*!< Received by the server in the current run */
+    size_t              expected_bytes;
+    size_t              client_bytes;   /*!< Received by the client in the current frame */
+} s_bench;
+
+/* HDLC decoder of one direction, the negotiation sends frames both ways */
+typedef struct {
+    uint8_t             decoded[PPP_HEADER_SIZE + FRAMING_PACKET_SIZE + PPP_FCS_SIZE];
+    size_t              decoded_len;
+    uint16_t            fcs;
+    bool                escaped;
+} hdlc_decoder_t;
+
+/* IP packets framed by PPP (HDLC-like, RFC 1662) or by eppp raw IP framing */
+static struct {
+    uint8_t             packet[EPPP_FRAME_MTU];
+    size_t              size;
+    uint8_t             encoded[2 * (PPP_HEADER_SIZE + FRAMING_PACKET_SIZE + PPP_FCS_SIZE) + 2];
+    hdlc_decoder_t      rx[2];          /*!< [0] received by the server, [1] by the client */
+    uint32_t            errors;
+    uint16_t            fcs_table[256];
+} s_framing;
+
+static FILE *s_output;
+static int s_results;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void count_received(size_t len, size_t frames)
+{
+    size_t before = s_bench.server_bytes;
+    s_bench.server_bytes = before + len;
+    for (size_t i = 0; i < frames * s_bench.frame_credits; ++i) {
+        xSemaphoreGive(s_bench.credits);
+    }
+    if (before < s_bench.expected_bytes && before + len >= s_bench.expected_bytes) {
+        xSemaphoreGive(s_bench.done);
+    }
+}
+
+static esp_err_t server_receive(struct eppp_handle *h, void *buffer, size_t len)
+{
+    if (s_bench.loaded) {
+        // SPI transport keeps the frame boundaries, so the ACK frames are easy to spot
+        if (len == sizeof(s_ack_frame) && memcmp(buffer, s_ack_frame, len) == 0) {
+            h->ops->transmit(h, (void *)s_ack_frame, len);
+        }
+        return ESP_OK;
+    }
+    size_t frames = (s_bench.server_bytes + len) / s_bench.frame_size - s_bench.server_bytes / s_bench.frame_size;
+    if (s_bench.echo) {
+        s_bench.server_bytes += len;
+        while (frames--) {
+            h->ops->transmit(h, s_bench.frame, s_bench.frame_size);
+        }
+        return ESP_OK;
+    }
+    count_received(len, frames);
+    return ESP_OK;
+}
+
+static esp_err_t client_receive(struct eppp_handle *h, void *buffer, size_t len)
+{
+    s_bench.client_bytes += len;
+    while (s_bench.client_bytes >= s_bench.frame_size) {
+        s_bench.client_bytes -= s_bench.frame_size;
+        xSemaphoreGive(s_bench.done);
+    }
+    return ESP_OK;
+}
+
+static void perform_task(void *arg)
+{
+    struct eppp_handle *h = arg;
+    while (h->ops->perform(h) != ESP_ERR_TIMEOUT) {}
+    h->exited = true;
+    vTaskDelete(NULL);
+}
+
+static void flood_task(void *arg)
+{
+    struct eppp_handle *client = arg;
+    while (s_bench.flood) {
+        if (client->ops->transmit(client, s_bench.frame, MAX_FRAME_SIZE) != ESP_OK) {
+            vTaskDelay(1);  // queue is full
+        }
+    }
+    s_bench.flood_exited = true;
+    vTaskDelete(NULL);
+}
+
+static void reset_run(size_t frame_size, bool echo, size_t expected_bytes)
+{
+    while (xSemaphoreTake(s_bench.done, 0) == pdTRUE) {
+    }
+    while (xSemaphoreGive(s_bench.credits) == pdTRUE) {
+    }
+    s_bench.frame_size = frame_size;
+    s_bench.frame_credits = 1;
+    s_bench.echo = echo;
+    s_bench.loaded = false;
+    s_bench.server_bytes = 0;
+    s_bench.client_bytes = 0;
+    s_bench.expected_bytes = expected_bytes;
+}
+
+static struct eppp_handle *endpoint_create(eppp_transport_t transport, eppp_type_t role, int fd, eppp_receive_t receive)
+{
+    const struct eppp_transport_ops *ops = eppp_transport_get(transport);
+    eppp_config_t config = EPPP_DEFAULT_SERVER_CONFIG();
+    config.transport = transport;
+    config.uart.port = fd;
+    config.spi.host = fd;
+    struct eppp_handle *h = ops->create(role, &config);
+    if (h == NULL) {
+        return NULL;
+    }
+    h->ops = ops;
+    h->receive = receive;
+    if (xTaskCreate(perform_task, "eppp_perform", PERFORM_TASK_STACK, h, PERFORM_TASK_PRIO, NULL) != pdTRUE) {
+        ops->destroy(h);
+        return NULL;
+    }
+    return h;
+}
+
+static bool endpoint_stopped(struct eppp_handle *h)
+{
+    for (int wait = 0; wait < 200 && !h->exited; wait++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (!h->exited) {
+        ESP_LOGE(TAG, "Cannot stop the perform task");
+        return false;
+    }
+    h->ops->destroy(h);
+    return true;
+}
+
+static esp_err_t link_open(bench_link_t *link)
+{
+    if (link->transport == EPPP_TRANSPORT_UART) {
+        // pty pair in raw mode, so the PPP stream passes unchanged
+        struct termios tio;
+        if (openpty(&link->fds[0], &link->fds[1], NULL, NULL, NULL) != 0) {
+            ESP_LOGE(TAG, "Failed to open pty");
+            return ESP_FAIL;
+        }
+        tcgetattr(link->fds[1], &tio);
+        cfmakeraw(&tio);
+        tcsetattr(link->fds[1], TCSANOW, &tio);
+    } else if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, link->fds) != 0) {
+        ESP_LOGE(TAG, "Failed to create socketpair");
+        return ESP_FAIL;
+    }
+    link->server = endpoint_create(link->transport, EPPP_SERVER, link->fds[0], server_receive);
+    link->client = endpoint_create(link->transport, EPPP_CLIENT, link->fds[1], client_receive);
+    if (link->server == NULL || link->client == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s endpoints", link->name);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void link_close(bench_link_t *link)
+{
+    if (link->server) {
+        link->server->stop = true;
+    }
+    if (link->client) {
+        link->client->stop = true;
+        // SPI master might be blocked waiting for outbound data
+        link->client->ops->transmit(link->client, s_bench.frame, 1);
+        // destroying the client closes the bus, which unblocks the server
+        endpoint_stopped(link->client);
+    }
+    if (link->server) {
+        endpoint_stopped(link->server);
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (link->fds[i] >= 0) {
+            close(link->fds[i]);
+        }
+    }
+}
+
+static int compare_int64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void begin_result(const char *transport, const char *test)
+{
+    fprintf(s_output, "%s\n  {\"test\": \"%s\", \"transport\": \"%s\"", s_results++ ? "," : "", test, transport);
+}
+
+static void bench_latency(bench_link_t *link, bool loaded)
+{
+    static int64_t samples[CONFIG_EPPP_BENCHMARK_LATENCY_SAMPLES];
+    const char *test = loaded ? "rtt_loaded" : "rtt";
+    const uint8_t *frame = loaded ? s_ack_frame : s_bench.frame;
+    size_t size = loaded ? sizeof(s_ack_frame) : LATENCY_FRAME_SIZE;
+    int count = 0;
+
+    reset_run(size, !loaded, 0);
+    if (loaded) {
+        // saturate the link with bulk frames, ACK frames should still pass quickly
+        s_bench.loaded = true;
+        s_bench.flood = true;
+        s_bench.flood_exited = false;
+        if (xTaskCreate(flood_task, "flood", PERFORM_TASK_STACK, link->client, PERFORM_TASK_PRIO - 1, NULL) != pdTRUE) {
+            ESP_LOGE(TAG, "Failed to create the flood task");
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOAD_SETTLE_MS));
+    }
+    for (int i = 0; i < CONFIG_EPPP_BENCHMARK_LATENCY_SAMPLES; ++i) {
+        int64_t start = now_us();
+        if (link->client->ops->transmit(link->client, (void *)frame, size) != ESP_OK ||
+                xSemaphoreTake(s_bench.done, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "Latency test failed after %d samples", count);
+            break;
+        }
+        samples[count++] = now_us() - start;
+    }
+    if (loaded) {
+        s_bench.flood = false;
+        while (!s_bench.flood_exited) {
+            vTaskDelay(1);
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+    qsort(samples, count, sizeof(int64_t), compare_int64);
+    int64_t p50 = samples[count * 50 / 100];
+    int64_t p90 = samples[count * 90 / 100];
+    int64_t p99 = samples[count * 99 / 100];
+    int64_t max = samples[count - 1];
+
+    ESP_LOGI(TAG, "%-4s %-10s samples=%d p50=%" PRId64 " us p90=%" PRId64 " us p99=%" PRId64 " us max=%" PRId64 " us",
+             link->name, test, count, p50, p90, p99, max);
+    begin_result(link->name, test);
+    fprintf(s_output, ", \"size\": %zu, \"samples\": %d, \"p50_us\": %" PRId64 ", \"p90_us\": %" PRId64 ", \"p99_us\": %" PRId64 ", \"max_us\": %" PRId64 "}",
+            size, count, p50, p90, p99, max);
+}
+
+/* SPI transaction counters of the master (client) side, which show how the traffic was packed into transactions */
+static void print_link_stats(bench_link_t *link)
+{
+    eppp_stats_t stats;
+    eppp_stats_read(link->client, &stats);
+    if (stats.transactions == 0) {
+        return;
+    }
+    uint32_t avg_size = stats.transaction_bytes / stats.transactions;
+    uint32_t avg_latency = stats.latency_samples ? stats.latency_sum_us / stats.latency_samples : 0;
+    ESP_LOGI(TAG, "%-4s link       transactions=%" PRIu32 " avg_size=%" PRIu32 " latency avg=%" PRIu32 " us max=%" PRIu32 " us tx_buffers_max=%" PRIu32,
+             link->name, stats.transactions, avg_size, avg_latency, stats.latency_max_us, stats.tx_queue_max);
+    fprintf(s_output, ", \"transactions\": %" PRIu32 ", \"avg_transaction_size\": %" PRIu32 ", \"avg_latency_us\": %" PRIu32
+            ", \"max_latency_us\": %" PRIu32 ", \"tx_buffers_max\": %" PRIu32 ", \"rx_errors\": %" PRIu32,
+            stats.transactions, avg_size, avg_latency, stats.latency_max_us, stats.tx_queue_max, stats.rx_errors);
+}
+
+static void bench_goodput(bench_link_t *link, int size)
+{
+    int frames = CONFIG_EPPP_BENCHMARK_BYTES_PER_RUN / size;
+    if (frames > MAX_FRAMES_PER_RUN) {
+        frames = MAX_FRAMES_PER_RUN;
+    } else if (frames < MIN_FRAMES_PER_RUN) {
+        frames = MIN_FRAMES_PER_RUN;
+    }
+
+    reset_run(size, false, (size_t)frames * size);
+    eppp_stats_reset(link->client);
+    int64_t start = now_us();
+    for (int i = 0; i < frames; ++i) {
+        // limit frames in flight, so the SPI transmit buffers (CONFIG_EPPP_LINK_SPI_TX_BUFFERS) never run out
+        if (xSemaphoreTake(s_bench.credits, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "Frame %d not received", i - FRAMES_IN_FLIGHT);
+            return;
+        }
+        if (link->client->ops->transmit(link->client, s_bench.frame, size) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to send frame %d", i);
+            return;
+        }
+    }
+    if (xSemaphoreTake(s_bench.done, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Goodput test timed out, received %zu of %zu bytes", s_bench.server_bytes, s_bench.expected_bytes);
+        return;
+    }
+    double seconds = (now_us() - start) / 1e6;
+    double frames_per_sec = frames / seconds;
+    double mbit_per_sec = (double)frames * size * 8 / seconds / 1e6;
+
+    ESP_LOGI(TAG, "%-4s goodput    size=%-5d frames=%-6d %10.1f frames/s %9.3f Mbit/s",
+             link->name, size, frames, frames_per_sec, mbit_per_sec);
+    begin_result(link->name, "goodput");
+    fprintf(s_output, ", \"size\": %d, \"frames\": %d, \"frames_per_sec\": %.1f, \"mbit_per_sec\": %.3f",
+            size, frames, frames_per_sec, mbit_per_sec);
+    print_link_stats(link);
+    fprintf(s_output, "}");
+}
+
+static void fcs_init(void)
+{
+    for (int i = 0; i < 256; ++i) {
+        uint16_t fcs = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            fcs = (fcs & 1) ? (fcs >> 1) ^ 0x8408 : fcs >> 1;
+        }
+        s_framing.fcs_table[i] = fcs;
+    }
+}
+
+static uint16_t fcs_update(uint16_t fcs, uint8_t byte)
+{
+    return (fcs >> 8) ^ s_framing.fcs_table[(fcs ^ byte) & 0xFF];
+}
+
+static size_t hdlc_put(uint8_t *out, uint8_t byte, bool escape_control)
+{
+    // the peer asks for no control characters escaped (ACCM 0), as lwIP does by default, LCP frames escape them always
+    if (byte == PPP_FLAG || byte == PPP_ESCAPE || (escape_control && byte < PPP_TRANS)) {
+        out[0] = PPP_ESCAPE;
+        out[1] = byte ^ PPP_TRANS;
+        return 2;
+    }
+    out[0] = byte;
+    return 1;
+}
+
+static size_t hdlc_encode(uint16_t protocol, const uint8_t *packet, size_t len, uint8_t *out)
+{
+    const uint8_t header[PPP_HEADER_SIZE] = { 0xFF, 0x03, protocol >> 8, protocol & 0xFF };
+    bool escape_control = protocol == PPP_LCP;
+    uint16_t fcs = PPP_FCS_INIT;
+    size_t n = 0;
+    out[n++] = PPP_FLAG;
+    for (int i = 0; i < PPP_HEADER_SIZE; ++i) {
+        fcs = fcs_update(fcs, header[i]);
+        n += hdlc_put(out + n, header[i], escape_control);
+    }
+    for (size_t i = 0; i < len; ++i) {
+        fcs = fcs_update(fcs, packet[i]);
+        n += hdlc_put(out + n, packet[i], escape_control);
+    }
+    fcs ^= 0xFFFF;
+    n += hdlc_put(out + n, fcs & 0xFF, escape_control);
+    n += hdlc_put(out + n, fcs >> 8, escape_control);
+    out[n++] = PPP_FLAG;
+    return n;
+}
+
+static void hdlc_decoder_reset(hdlc_decoder_t *rx)
+{
+    rx->decoded_len = 0;
+    rx->fcs = PPP_FCS_INIT;
+    rx->escaped = false;
+}
+
+static esp_err_t ppp_control_send(struct eppp_handle *h, uint16_t protocol, const uint8_t *packet, size_t len, uint8_t code)
+{
+    uint8_t control[PPP_CONTROL_MAX_SIZE];
+    uint8_t encoded[2 * (PPP_HEADER_SIZE + PPP_CONTROL_MAX_SIZE + PPP_FCS_SIZE) + 2];
+    memcpy(control, packet, len);
+    control[0] = code;
+    return h->ops->transmit(h, encoded, hdlc_encode(protocol, control, len, encoded));
+}
+
+/* Shortest negotiation, without lwIP: both ends acknowledge any Configure-Request, the client answers the one of
+ * the server with its IPCP request after LCP and with the first IP packet after IPCP */
+static void ppp_negotiate(struct eppp_handle *h, uint16_t protocol, const uint8_t *packet, size_t len)
+{
+    bool server = h->role == EPPP_SERVER;
+    if (len < 4 || packet[0] != PPP_CONF_REQ || len > PPP_CONTROL_MAX_SIZE) {
+        return;     // the acknowledgements just pass
+    }
+    ppp_control_send(h, protocol, packet, len, PPP_CONF_ACK);
+    if (server) {
+        if (protocol == PPP_LCP) {
+            ppp_control_send(h, protocol, s_lcp_request, sizeof(s_lcp_request), PPP_CONF_REQ);
+        } else {
+            ppp_control_send(h, protocol, s_ipcp_request[0], sizeof(s_ipcp_request[0]), PPP_CONF_REQ);
+        }
+    } else if (protocol == PPP_LCP) {
+        ppp_control_send(h, PPP_IPCP, s_ipcp_request[1], sizeof(s_ipcp_request[1]), PPP_CONF_REQ);
+    } else {
+        uint8_t encoded[2 * (PPP_HEADER_SIZE + LATENCY_FRAME_SIZE + PPP_FCS_SIZE) + 2];
+        h->ops->transmit(h, encoded, hdlc_encode(PPP_IP, s_framing.packet, s_framing.size, encoded));
+    }
+}
+
+static void framing_deliver(void *ctx, uint8_t *packet, size_t len)
+{
+    if (len != s_framing.size || memcmp(packet, s_framing.packet, len) != 0) {
+        s_framing.errors++;
+        return;
+    }
+    count_received(len, 1);
+}
+
+static esp_err_t hdlc_receive(struct eppp_handle *h, void *buffer, size_t len)
+{
+    hdlc_decoder_t *rx = &s_framing.rx[h->role == EPPP_SERVER ? 0 : 1];
+    const uint8_t *data = buffer;
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t byte = data[i];
+        if (byte == PPP_FLAG) {
+            if (rx->decoded_len >= PPP_HEADER_SIZE + PPP_FCS_SIZE && rx->fcs == PPP_FCS_GOOD) {
+                uint16_t protocol = rx->decoded[2] << 8 | rx->decoded[3];
+                uint8_t *packet = rx->decoded + PPP_HEADER_SIZE;
+                size_t packet_len = rx->decoded_len - PPP_HEADER_SIZE - PPP_FCS_SIZE;
+                if (protocol == PPP_IP) {
+                    framing_deliver(NULL, packet, packet_len);
+                } else {
+                    ppp_negotiate(h, protocol, packet, packet_len);
+                }
+            } else if (rx->decoded_len > 0) {
+                s_framing.errors++;
+            }
+            hdlc_decoder_reset(rx);
+            continue;
+        }
+        if (byte == PPP_ESCAPE) {
+            rx->escaped = true;
+            continue;
+        }
+        if (rx->escaped) {
+            byte ^= PPP_TRANS;
+            rx->escaped = false;
+        }
+        if (rx->decoded_len < sizeof(rx->decoded)) {
+            rx->decoded[rx->decoded_len++] = byte;
+            rx->fcs = fcs_update(rx->fcs, byte);
+        }
+    }
+    return ESP_OK;
+}
+
+static void framing_packet_init(int size, bool worst_case)
+{
+    memcpy(s_framing.packet, s_udp_header, sizeof(s_udp_header));
+    s_framing.packet[2] = size >> 8;
+    s_framing.packet[3] = size & 0xFF;
+    s_framing.packet[24] = (size - 20) >> 8;
+    s_framing.packet[25] = (size - 20) & 0xFF;
+    for (int i = sizeof(s_udp_header); i < size; ++i) {
+        s_framing.packet[i] = worst_case ? PPP_FLAG : rand();
+    }
+    s_framing.size = size;
+    hdlc_decoder_reset(&s_framing.rx[0]);
+    hdlc_decoder_reset(&s_framing.rx[1]);
+    s_framing.errors = 0;
+}
+
+/* Switches both ends back to the plain byte counting, and lets the perform tasks leave the decoder */
+static void framing_restore(bench_link_t *link)
+{
+    link->server->receive = server_receive;
+    link->client->receive = client_receive;
+    link->server->raw_ip = link->client->raw_ip = false;
+    vTaskDelay(pdMS_TO_TICKS(LOAD_SETTLE_MS));
+    eppp_raw_link_deinit(link->server);
+    eppp_raw_link_deinit(link->client);
+}
+
+/* Sends IP packets of the given size in PPP framing (only FRAMING_PACKET_SIZE) or in raw IP framing
+ * (CONFIG_EPPP_LINK_USES_RAW_IP), with random payload or with the worst case for PPP: payload of flags,
+ * all of them escaped */
+static void bench_framing(bench_link_t *link, const char *test, bool raw, bool worst_case, int size)
+{
+    const char *framing = raw ? "raw_ip" : "ppp";
+    const char *payload = worst_case ? "worst" : "random";
+    int packets = CONFIG_EPPP_BENCHMARK_BYTES_PER_RUN / size;
+    if (packets < MIN_FRAMES_PER_RUN) {
+        packets = MIN_FRAMES_PER_RUN;
+    }
+
+    framing_packet_init(size, worst_case);
+    size_t wire_size = raw ? size + EPPP_FRAME_OVERHEAD : hdlc_encode(PPP_IP, s_framing.packet, size, s_framing.encoded);
+    reset_run(size, false, (size_t)packets * size);
+    // long frames are split into several transport packets, all of them take a transmit buffer
+    s_bench.frame_credits = (wire_size + MAX_FRAME_SIZE - 1) / MAX_FRAME_SIZE;
+    if (raw) {
+        if (eppp_raw_link_init(link->server, framing_deliver, NULL) != ESP_OK ||
+                eppp_raw_link_init(link->client, framing_deliver, NULL) != ESP_OK) {
+            goto restore;
+        }
+    } else {
+        link->server->receive = hdlc_receive;
+    }
+
+    int64_t start = now_us();
+    for (int i = 0; i < packets; ++i) {
+        for (int credit = 0; credit < s_bench.frame_credits; ++credit) {
+            if (xSemaphoreTake(s_bench.credits, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
+                ESP_LOGE(TAG, "Packet %d not received", i - FRAMES_IN_FLIGHT / s_bench.frame_credits);
+                goto restore;
+            }
+        }
+        // every packet is encoded again, the framing cost is a part of the measurement
+        esp_err_t ret = raw ? eppp_raw_link_transmit(link->client, s_framing.packet, size) :
+                        link->client->ops->transmit(link->client, s_framing.encoded,
+                                                    hdlc_encode(PPP_IP, s_framing.packet, size, s_framing.encoded));
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to send packet %d", i);
+            goto restore;
+        }
+    }
+    if (xSemaphoreTake(s_bench.done, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Framing test timed out, received %zu of %zu bytes", s_bench.server_bytes, s_bench.expected_bytes);
+        goto restore;
+    }
+    double seconds = (now_us() - start) / 1e6;
+    double packets_per_sec = packets / seconds;
+    double mbit_per_sec = (double)packets * size * 8 / seconds / 1e6;
+    uint32_t errors = s_framing.errors + (raw ? link->server->raw->decoder.errors : 0);
+
+    ESP_LOGI(TAG, "%-4s %-7s %-6s %-6s size=%-5d wire=%-5zu %10.1f packets/s %9.3f Mbit/s errors=%" PRIu32,
+             link->name, test, framing, payload, size, wire_size, packets_per_sec, mbit_per_sec, errors);
+    begin_result(link->name, test);
+    fprintf(s_output, ", \"framing\": \"%s\", \"payload\": \"%s\", \"size\": %d, \"wire_size\": %zu, \"packets\": %d, "
+            "\"packets_per_sec\": %.1f, \"mbit_per_sec\": %.3f, \"errors\": %" PRIu32 "}",
+            framing, payload, size, wire_size, packets, packets_per_sec, mbit_per_sec, errors);
+
+restore:
+    framing_restore(link);
+}
+
+/* Time from creating the transports to the first IP packet delivered to the server. Raw IP sends the packet
+ * right away, PPP runs the shortest LCP and IPCP negotiation first (ppp_negotiate()). lwIP isn't a part of this
+ * host build, so its processing and timers are not included, the PPP result is the lower bound set by the link */
+static void bench_linkup(bench_link_t *link, bool raw)
+{
+    static int64_t samples[LINKUP_SAMPLES];
+    const char *framing = raw ? "raw_ip" : "ppp";
+    int count = 0;
+
+    framing_packet_init(LATENCY_FRAME_SIZE, false);
+    for (int i = 0; i < LINKUP_SAMPLES; ++i) {
+        bench_link_t up = { .name = link->name, .transport = link->transport, .fds = { -1, -1 } };
+        bool delivered = false;
+        reset_run(LATENCY_FRAME_SIZE, false, LATENCY_FRAME_SIZE);
+        hdlc_decoder_reset(&s_framing.rx[0]);
+        hdlc_decoder_reset(&s_framing.rx[1]);
+        int64_t start = now_us();
+        if (link_open(&up) == ESP_OK) {
+            esp_err_t ret;
+            if (raw) {
+                ret = eppp_raw_link_init(up.server, framing_deliver, NULL);
+                if (ret == ESP_OK && (ret = eppp_raw_link_init(up.client, framing_deliver, NULL)) == ESP_OK) {
+                    ret = eppp_raw_link_transmit(up.client, s_framing.packet, s_framing.size);
+                }
+            } else {
+                up.server->receive = hdlc_receive;
+                up.client->receive = hdlc_receive;
+                ret = ppp_control_send(up.client, PPP_LCP, s_lcp_request, sizeof(s_lcp_request), PPP_CONF_REQ);
+            }
+            delivered = ret == ESP_OK && xSemaphoreTake(s_bench.done, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) == pdTRUE;
+            if (delivered) {
+                samples[count++] = now_us() - start;
+            }
+            framing_restore(&up);
+        }
+        link_close(&up);
+        if (!delivered) {
+            ESP_LOGE(TAG, "Link-up test failed after %d samples", count);
+            break;
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+    qsort(samples, count, sizeof(int64_t), compare_int64);
+    int64_t p50 = samples[count * 50 / 100];
+    int64_t max = samples[count - 1];
+
+    ESP_LOGI(TAG, "%-4s linkup  %-6s samples=%d p50=%" PRId64 " us max=%" PRId64 " us errors=%" PRIu32,
+             link->name, framing, count, p50, max, s_framing.errors);
+    begin_result(link->name, "linkup");
+    fprintf(s_output, ", \"framing\": \"%s\", \"samples\": %d, \"p50_us\": %" PRId64 ", \"max_us\": %" PRId64 ", \"errors\": %" PRIu32 "}",
+            framing, count, p50, max, s_framing.errors);
+}
+
+void app_main(void)
+{
+    bench_link_t links[] = {
+        { .name = "UART", .transport = EPPP_TRANSPORT_UART, .fds = { -1, -1 } },
+        { .name = "SPI", .transport = EPPP_TRANSPORT_SPI, .fds = { -1, -1 } },
+    };
+
+    s_bench.done = xSemaphoreCreateBinary();
+    s_bench.credits = xSemaphoreCreateCounting(FRAMES_IN_FLIGHT, FRAMES_IN_FLIGHT);
+    s_output = fopen(CONFIG_EPPP_BENCHMARK_OUTPUT_FILE, "w");
+    if (s_bench.done == NULL || s_bench.credits == NULL || s_output == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize the benchmark");
+        exit(1);
+    }
+    // PPP-like frames of all the tested sizes: no escape characters, ending with the flag
+    for (int i = 0; i < sizeof(s_bench.frame); ++i) {
+        s_bench.frame[i] = i % (PPP_FLAG - 1);
+    }
+    s_bench.frame[LATENCY_FRAME_SIZE - 1] = PPP_FLAG;
+    for (int i = 0; i < sizeof(s_frame_sizes) / sizeof(s_frame_sizes[0]); ++i) {
+        s_bench.frame[s_frame_sizes[i] - 1] = PPP_FLAG;
+    }
+    fcs_init();
+    esp_log_level_set("eppp_spi", ESP_LOG_WARN);
+
+    fprintf(s_output, "[");
+    int ret = 0;
+    for (int i = 0; i < sizeof(links) / sizeof(links[0]); ++i) {
+        bench_link_t *link = &links[i];
+        for (int raw = 0; raw < 2; ++raw) {
+            bench_linkup(link, raw);
+        }
+        if (link_open(link) != ESP_OK) {
+            ret = 1;
+        } else {
+            bench_latency(link, false);
+            for (int j = 0; j < sizeof(s_frame_sizes) / sizeof(s_frame_sizes[0]); ++j) {
+                bench_goodput(link, s_frame_sizes[j]);
+            }
+            for (int worst_case = 0; worst_case < 2; ++worst_case) {
+                bench_framing(link, "framing", false, worst_case, FRAMING_PACKET_SIZE);
+                bench_framing(link, "framing", true, worst_case, FRAMING_PACKET_SIZE);
+            }
+            for (int j = 0; j < sizeof(s_mtus) / sizeof(s_mtus[0]) && s_mtus[j] <= EPPP_FRAME_MTU; ++j) {
+                bench_framing(link, "mtu", true, false, s_mtus[j]);
+            }
+            if (link->transport == EPPP_TRANSPORT_SPI) {
+                // UART queues per class too, but only SPI keeps the frame boundaries, which the server needs to spot the ACKs
+                bench_latency(link, true);
+            }
+        }
+        link_close(link);
+    }
+    fprintf(s_output, "\n]\n");
+    fclose(s_output);
+    ESP_LOGI(TAG, "Results written to %s", CONFIG_EPPP_BENCHMARK_OUTPUT_FILE);
+    exit(ret);
+}
@@ -3,6 +3,7 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#pragma once
 
 #define EPPP_DEFAULT_SERVER_IP() ESP_IP4TOADDR(192, 168, 11, 1)
 #define EPPP_DEFAULT_CLIENT_IP() ESP_IP4TOADDR(192, 168, 11, 2)
@@ -65,12 +66,70 @@ typedef enum eppp_transport {
     EPPP_TRANSPORT_SDIO,
 } eppp_transport_t;
 
+/**
+ * @brief Classes of outgoing traffic, in the order of their transmit priority
+ */
+typedef enum eppp_tx_class {
+    EPPP_TX_CLASS_CONTROL,  // PPP link control and RPC traffic (CONFIG_EPPP_LINK_TX_PRIO_RPC_PORT)
+    EPPP_TX_CLASS_ACK,      // TCP acknowledgments without data
+    EPPP_TX_CLASS_DNS,
+    EPPP_TX_CLASS_BULK,     // everything else
+    EPPP_TX_CLASS_MAX,
+} eppp_tx_class_t;
+
+typedef struct eppp_tx_class_stats {
+    uint32_t queued;        // number of chunks queued for transmission
+    uint32_t dropped;       // number of chunks dropped, since the class queue or transmit buffers were full
+} eppp_tx_class_stats_t;
+
+/**
+ * @brief Counters of one link, to tune the transport (SPI clock, queue and buffer sizes) from data
+ *
+ * Transaction counters and latencies are maintained only by the SPI transport, other transports
+ * leave them at zero.
+ */
+typedef struct eppp_stats {
+    uint32_t tx_packets;            // chunks of the stream (or raw IP frames) accepted by the transport
+    uint64_t tx_bytes;
+    uint32_t tx_dropped;            // chunks dropped, since the queues or transmit buffers were full
+    uint32_t rx_packets;            // chunks passed to the network interface
+    uint64_t rx_bytes;
+    uint32_t rx_dropped;            // messages which lost a fragment (SPI, SDIO)
+    uint32_t rx_errors;             // wrong checksum or magic, malformed transactions, raw IP framing errors
+    uint32_t transactions;          // SPI: completed transactions
+    uint32_t empty_transactions;    // SPI: header only transactions, which just announce the next size
+    uint32_t master_wants_read;     // SPI master: the slave signalled data while the master had nothing to send
+    uint32_t transaction_max;       // SPI: largest transaction payload in bytes
+    uint64_t transaction_bytes;     // SPI: payload of all transactions, average = transaction_bytes / transactions
+    uint32_t tx_queue_depth;        // SPI: transmit buffers in use after the last transaction
+    uint32_t tx_queue_max;          // SPI: most transmit buffers in use at once
+    uint32_t latency_max_us;        // SPI master: longest time from the slave's ready signal to the transaction
+    uint64_t latency_sum_us;        // SPI master: sum of these times
+    uint32_t latency_samples;       // SPI master: number of the measured times
+} eppp_stats_t;
+
+typedef enum eppp_trace_event {
+    EPPP_TRACE_TRANSACTION,         // completed SPI transaction
+    EPPP_TRACE_ERROR,               // SPI transaction with wrong checksum, magic, size or malformed payload
+} eppp_trace_event_t;
+
+/**
+ * @brief One entry of the transaction trace (CONFIG_EPPP_LINK_TRACE_ENTRIES)
+ */
+typedef struct eppp_trace_entry {
+    int64_t timestamp_us;           // start of the transaction
+    eppp_trace_event_t event;
+    uint16_t size;                  // payload size of the transaction, as announced by the previous one
+    uint16_t tx_len;                // bytes of packets sent in the transaction
+    uint16_t rx_len;                // bytes of packets received in the transaction
+    uint32_t latency_us;            // master: time from the slave's ready signal, 0 if not measured
+} eppp_trace_entry_t;
 
 typedef struct eppp_config_t {
     eppp_transport_t transport;
 
     struct eppp_config_spi_s {
-        int host;
+        int host;   // on linux target: one end of socketpair(AF_UNIX, SOCK_SEQPACKET) simulating the bus
         int mosi;
         int miso;
         int sclk;
@@ -83,7 +142,7 @@ typedef struct eppp_config_t {
     } spi;
 
     struct eppp_config_uart_s {
-        int port;
+        int port;   // on linux target: file descriptor of an open serial device or pty
         int baud;
         int tx_io;
         int rx_io;
@@ -133,3 +192,116 @@ esp_err_t eppp_netif_stop(esp_netif_t *netif, int stop_timeout_ms);
 esp_err_t eppp_netif_start(esp_netif_t *netif);
 
 esp_err_t eppp_perform(esp_netif_t *netif);
+
+/**
+ * @brief Reads transmit counters of all traffic classes
+ *
+ * The counters are updated by the transports, which queue the outgoing traffic per class: SPI
+ * (only the bulk class without CONFIG_EPPP_LINK_TX_PRIORITY) and UART with CONFIG_EPPP_LINK_TX_PRIORITY.
+ * SDIO, and UART without priority classes, send everything in order and leave these counters at zero.
+ *
+ * @param netif eppp network interface
+ * @param[out] stats array of EPPP_TX_CLASS_MAX counters
+ */
+esp_err_t eppp_get_tx_class_stats(esp_netif_t *netif, eppp_tx_class_stats_t stats[EPPP_TX_CLASS_MAX]);
+
+/**
+ * @brief Reads the counters of the link
+ *
+ * The packet and byte counters are updated atomically, as both the transmitting tasks and
+ * the I/O task update them. The snapshot of a busy link might still be slightly inconsistent
+ * across counters.
+ *
+ * @param netif eppp network interface
+ * @param[out] stats counters
+ */
+esp_err_t eppp_get_stats(esp_netif_t *netif, eppp_stats_t *stats);
+
+/**
+ * @brief Clears the counters of the link, including the traffic class counters and the trace
+ */
+esp_err_t eppp_reset_stats(esp_netif_t *netif);
+
+/**
+ * @brief Reads the transaction trace of the link, the oldest entry first
+ *
+ * The SPI transport records the last CONFIG_EPPP_LINK_TRACE_ENTRIES transactions (disabled by default).
+ *
+ * @param netif eppp network interface
+ * @param[out] entries buffer for the entries
+ * @param max_entries size of the buffer
+ * @return Number of copied entries, 0 if the trace is disabled
+ */
+size_t eppp_get_trace(esp_netif_t *netif, eppp_trace_entry_t *entries, size_t max_entries);
+
+/**
+ * @brief Registers the "eppp" console command, which prints the counters and the trace of eppp interfaces
+ *
+ * The interfaces are named as in the "ifconfig" command. Run "eppp help" for the list of options.
+ * Not available on linux target.
+ */
+esp_err_t eppp_console_cmd_register(void);
+
+/**
+ * @brief Largest message of the control channel
+ */
+#define EPPP_CHANNEL_MAX_SIZE 1400
+
+/**
+ * @brief Receives one message of the control channel, called from the I/O task of the link
+ */
+typedef void (*eppp_channel_rx_t)(void *ctx, const void *data, size_t len);
+
+/**
+ * @brief Registers the receiver of the control channel
+ *
+ * The control channel carries messages next to the IP traffic, in the framing of the transport,
+ * so that they bypass the IP stack of both ends. Messages are delivered whole, in order, but not
+ * reliably (a message might be dropped if the transmit buffers are full or a fragment is lost).
+ * Available on SPI and SDIO transports, and on UART in raw IP mode (CONFIG_EPPP_LINK_USES_RAW_IP).
+ *
+ * The receiver and its context are replaced together: once this returns, the previous receiver
+ * isn't running and won't be called again. Must not be called from the receiver.
+ *
+ * @param netif eppp network interface
+ * @param rx Receiver of the messages, NULL to unregister
+ * @param ctx Context passed to the receiver
+ */
+esp_err_t eppp_channel_register(esp_netif_t *netif, eppp_channel_rx_t rx, void *ctx);
+
+/**
+ * @brief Sends one message over the control channel
+ *
+ * The messages are sent with the highest priority (EPPP_TX_CLASS_CONTROL) on the SPI transport.
+ *
+ * @param netif eppp network interface
+ * @param data Message
+ * @param len Size of the message, up to EPPP_CHANNEL_MAX_SIZE
+ * @return ESP_ERR_NOT_SUPPORTED if the transport cannot multiplex the channel (UART in PPP mode)
+ */
+esp_err_t eppp_channel_send(esp_netif_t *netif, const void *data, size_t len);
+
+#if CONFIG_IDF_TARGET_LINUX
+struct eppp_tun;
+
+/**
+ * @brief Bridges the link to a TUN interface of the host (CONFIG_EPPP_LINK_USES_RAW_IP)
+ *
+ * The interface is created as a point to point link from config->ppp.our_ip4_addr to
+ * config->ppp.their_ip4_addr, IP packets are exchanged with the peer in raw IP framing.
+ * Needs CAP_NET_ADMIN.
+ *
+ * @param role Role of this end of the link (server or client)
+ * @param config Transport and addresses
+ * @param if_name Name of the TUN interface to create
+ * @return Handle of the bridge, NULL on failure
+ */
+struct eppp_tun *eppp_tun_open(eppp_type_t role, eppp_config_t *config, const char *if_name);
+
+/**
+ * @brief Stops the bridge and removes the TUN interface
+ *
+ * Blocks until both tasks of the bridge have exited
+ */
+void eppp_tun_close(struct eppp_tun *tun);
+#endif
@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pty.h>
+#include <termios.h>
+#include <sys/socket.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "eppp_link.h"
+#include "eppp_transport.h"
+
+#define IDLE_MS             300     /* long enough for the SPI master to block, waiting for outbound data */
+#define DELIVERY_TIMEOUT_MS 500     /* well below the SPI master's one second fallback transaction */
+#define SEND_TASK_PRIO      4
+#define PERFORM_TASK_PRIO   5
+#define TASK_STACK          8192
+#define FRAMES              5
+#define FRAME_SIZE          64
+#define PPP_FLAG            0x7E
+
+static const char *TAG = "eppp_host_test";
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                 \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            ESP_LOGE(TAG, "%s:%d: %s failed", __func__, __LINE__, #cond); \
+            s_failures++;                                           \
+        }                                                           \
+    } while (0)
+
+typedef struct {
+    const char          *name;
+    eppp_transport_t    transport;
+    int                 fds[2];     /*!< [0] server (SPI slave) end, [1] client (SPI master) end */
+    struct eppp_handle  *server;
+    struct eppp_handle  *client;
+} test_link_t;
+
+static struct {
+    SemaphoreHandle_t   received;       /*!< Client received a whole frame */
+    size_t              client_bytes;   /*!< UART delivers a byte stream, so frames are counted by their size */
+    uint8_t             frame[FRAME_SIZE];
+} s_test;
+
+static esp_err_t server_receive(struct eppp_handle *h, void *buffer, size_t len)
+{
+    return ESP_OK;
+}
+
+static esp_err_t client_receive(struct eppp_handle *h, void *buffer, size_t len)
+{
+    s_test.client_bytes += len;
+    while (s_test.client_bytes >= FRAME_SIZE) {
+        s_test.client_bytes -= FRAME_SIZE;
+        xSemaphoreGive(s_test.received);
+    }
+    return ESP_OK;
+}
+
+static void perform_task(void *arg)
+{
+    struct eppp_handle *h = arg;
+    while (h->ops->perform(h) != ESP_ERR_TIMEOUT) {}
+    h->exited = true;
+    vTaskDelete(NULL);
+}
+
+static struct eppp_handle *endpoint_create(eppp_transport_t transport, eppp_type_t role, int fd, eppp_receive_t receive)
+{
+    const struct eppp_transport_ops *ops = eppp_transport_get(transport);
+    eppp_config_t config = EPPP_DEFAULT_SERVER_CONFIG();
+    config.transport = transport;
+    config.uart.port = fd;
+    config.spi.host = fd;
+    struct eppp_handle *h = ops->create(role, &config);
+    if (h == NULL) {
+        return NULL;
+    }
+    h->ops = ops;
+    h->receive = receive;
+    if (xTaskCreate(perform_task, "eppp_perform", TASK_STACK, h, PERFORM_TASK_PRIO, NULL) != pdTRUE) {
+        ops->destroy(h);
+        return NULL;
+    }
+    return h;
+}
+
+static void endpoint_destroy(struct eppp_handle *h)
+{
+    for (int wait = 0; wait < 200 && !h->exited; wait++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    CHECK(h->exited);
+    if (h->exited) {
+        h->ops->destroy(h);
+    }
+}
+
+static bool link_open(test_link_t *link)
+{
+    if (link->transport == EPPP_TRANSPORT_UART) {
+        // pty pair in raw mode, so the PPP stream passes unchanged
+        struct termios tio;
+        if (openpty(&link->fds[0], &link->fds[1], NULL, NULL, NULL) != 0) {
+            return false;
+        }
+        tcgetattr(link->fds[1], &tio);
+        cfmakeraw(&tio);
+        tcsetattr(link->fds[1], TCSANOW, &tio);
+    } else if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, link->fds) != 0) {
+        return false;
+    }
+    link->server = endpoint_create(link->transport, EPPP_SERVER, link->fds[0], server_receive);
+    link->client = endpoint_create(link->transport, EPPP_CLIENT, link->fds[1], client_receive);
+    return link->server && link->client;
+}
+
+static void link_close(test_link_t *link)
+{
+    if (link->server) {
+        link->server->stop = true;
+    }
+    if (link->client) {
+        link->client->stop = true;
+        // destroying the client closes the bus, which unblocks the server
+        endpoint_destroy(link->client);
+    }
+    if (link->server) {
+        endpoint_destroy(link->server);
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (link->fds[i] >= 0) {
+            close(link->fds[i]);
+        }
+    }
+}
+
+static void send_task(void *arg)
+{
+    struct eppp_handle *server = arg;
+    CHECK(server->ops->transmit(server, s_test.frame, FRAME_SIZE) == ESP_OK);
+    vTaskDelete(NULL);
+}
+
+/*
+ * The server (SPI slave) sends from its own task, as the netif or the TUN bridge does, while the client
+ * (SPI master) has nothing to send, so it only learns about the data from the handshake line
+ */
+static void test_server_sends_to_idle_client(test_link_t *link)
+{
+    for (int i = 0; i < FRAMES; ++i) {
+        vTaskDelay(pdMS_TO_TICKS(IDLE_MS));
+        CHECK(xTaskCreate(send_task, "send", TASK_STACK, link->server, SEND_TASK_PRIO, NULL) == pdTRUE);
+        if (xSemaphoreTake(s_test.received, pdMS_TO_TICKS(DELIVERY_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "%s: frame %d not delivered to the idle client", link->name, i);
+            s_failures++;
+            return;
+        }
+    }
+}
+
+void app_main(void)
+{
+    test_link_t links[] = {
+        { .name = "UART", .transport = EPPP_TRANSPORT_UART, .fds = { -1, -1 } },
+        { .name = "SPI", .transport = EPPP_TRANSPORT_SPI, .fds = { -1, -1 } },
+    };
+
+    s_test.received = xSemaphoreCreateCounting(FRAMES, 0);
+    if (s_test.received == NULL) {
+        ESP_LOGE(TAG, "Failed to create the semaphore");
+        exit(1);
+    }
+    // PPP-like frame: no escape characters, ending with the flag
+    for (int i = 0; i < FRAME_SIZE; ++i) {
+        s_test.frame[i] = i % (PPP_FLAG - 1);
+    }
+    s_test.frame[FRAME_SIZE - 1] = PPP_FLAG;
+
+    for (int i = 0; i < sizeof(links) / sizeof(links[0]); ++i) {
+        test_link_t *link = &links[i];
+        s_test.client_bytes = 0;
+        if (!link_open(link)) {
+            ESP_LOGE(TAG, "Failed to open the %s link", link->name);
+            s_failures++;
+        } else {
+            test_server_sends_to_idle_client(link);
+        }
+        link_close(link);
+    }
+    if (s_failures) {
+        ESP_LOGE(TAG, "%d check(s) failed", s_failures);
+        exit(1);
+    }
+    ESP_LOGI(TAG, "All checks passed");
+    exit(0);
+}
@@ -20,8 +20,17 @@
 #include "esp_timer.h"
 #include "esp_tls_crypto.h"
 #include "esp_system.h"
+#include "esp_websocket_utf8.h"
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include "esp_random.h"
+#endif
 #include <errno.h>
 #include <arpa/inet.h>
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+#include <pthread.h>
+#include <sys/select.h>
+#include <unistd.h>
+#endif
 
 static const char *TAG = "websocket_client";
 
@@ -38,6 +47,9 @@ static const char *TAG = "websocket_client";
 #define WEBSOCKET_KEEP_ALIVE_IDLE       (5)
 #define WEBSOCKET_KEEP_ALIVE_INTERVAL   (5)
 #define WEBSOCKET_KEEP_ALIVE_COUNT      (3)
+#define WEBSOCKET_CLOSE_WAIT_MS         (1000)
+#define WEBSOCKET_CLOSE_INVALID_PAYLOAD (1007)  // RFC6455#section-7.4.1
+#define WEBSOCKET_SHARED_TASK_MAX_WAIT_MS (1000)
 
 #define ESP_WS_CLIENT_MEM_CHECK(TAG, a, action) if (!(a)) {                                         \
         ESP_LOGE(TAG,"%s(%d): %s", __FUNCTION__, __LINE__, "Memory exhausted");                     \
@@ -96,6 +108,8 @@ typedef struct {
     bool                        use_global_ca_store;
     bool                        skip_cert_common_name_check;
     esp_err_t                   (*crt_bundle_attach)(void *conf);
+    bool                        use_shared_task;
+    int                         reconnect_timeout_max_ms;
 } websocket_config_storage_t;
 
 typedef enum {
@@ -107,6 +121,15 @@ typedef enum {
     WEBSOCKET_STATE_CLOSING,
 } websocket_client_state_t;
 
+#ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
+typedef struct {
+    uint32_t                    allocations;
+    uint32_t                    releases;
+    size_t                      allocated;
+    size_t                      peak;
+} websocket_buffer_stats_t;
+#endif
+
 struct esp_websocket_client {
     esp_event_loop_handle_t     event_handle;
     TaskHandle_t                task_handle;
@@ -119,24 +142,47 @@ struct esp_websocket_client {
     uint64_t                    reconnect_tick_ms;
     uint64_t                    ping_tick_ms;
     uint64_t                    pingpong_tick_ms;
+    uint64_t                    close_tick_ms;
     int                         wait_timeout_ms;
+    int                         reconnect_delay_ms;     // current delay before reconnecting, wait_timeout_ms with backoff and jitter applied
+    int                         reconnect_attempts;     // failed connection attempts since the connection was lost
+    uint64_t                    disconnect_tick_ms;
+    int                         connect_time_ms;
     int                         auto_reconnect;
     bool                        run;
     bool                        wait_for_pong_resp;
     bool                        selected_for_destroying;
     EventGroupHandle_t          status_bits;
-    SemaphoreHandle_t            lock;
+    SemaphoreHandle_t            lock;       // serializes the state machine (connect, receive, close, abort)
+    SemaphoreHandle_t           tx_lock;    // serializes writes to the transport (and reads over TLS), never held while dispatching events
+    bool                        tls_transport;  // mbedtls doesn't support reading and writing one SSL context at the same time
     size_t                      errormsg_size;
     char                        *errormsg_buffer;
     char                        *rx_buffer;
     char                        *tx_buffer;
     int                         buffer_size;
+#ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
+    int                         rx_buffer_size;
+    int                         tx_buffer_size;
+    uint64_t                    rx_buffer_tick_ms;
+    uint64_t                    tx_buffer_tick_ms;  // protected by tx_lock, as the tx buffer
+    websocket_buffer_stats_t    rx_stats;           // updated by the client task
+    websocket_buffer_stats_t    tx_stats;           // updated under tx_lock
+#endif
     bool                        last_fin;
     ws_transport_opcodes_t      last_opcode;
     int                         payload_len;
     int                         payload_offset;
     esp_transport_keep_alive_t  keep_alive_cfg;
     struct ifreq                *if_name;
+#ifdef CONFIG_ESP_WS_CLIENT_UTF8_VALIDATION
+    bool                        rx_text;    // the message being received is a text message
+    esp_websocket_utf8_state_t  utf8_state;
+#endif
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+    struct esp_websocket_client *shared_next;
+    bool                        shared_read_pending;
+#endif
 };
 
 static uint64_t _tick_get_ms(void)
@@ -144,41 +190,125 @@ static uint64_t _tick_get_ms(void)
     return esp_timer_get_time() / 1000;
 }
 
-static esp_err_t esp_websocket_new_buf(esp_websocket_client_handle_t client, bool is_tx)
+static void esp_websocket_free_buf(esp_websocket_client_handle_t client, bool is_tx)
 {
 #ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
-    if (is_tx) {
-        if (client->tx_buffer) {
-            free(client->tx_buffer);
-        }
-
-        client->tx_buffer = calloc(1, client->buffer_size);
-        ESP_WS_CLIENT_MEM_CHECK(TAG, client->tx_buffer, return ESP_ERR_NO_MEM);
-    } else {
-        if (client->rx_buffer) {
-            free(client->rx_buffer);
-        }
+    char **buffer = is_tx ? &client->tx_buffer : &client->rx_buffer;
+    websocket_buffer_stats_t *stats = is_tx ? &client->tx_stats : &client->rx_stats;
+    if (*buffer) {
+        free(*buffer);
+        *buffer = NULL;
+        stats->releases++;
+        stats->allocated = 0;
+        ESP_LOGD(TAG, "Released %s buffer of %d bytes", is_tx ? "tx" : "rx", is_tx ? client->tx_buffer_size : client->rx_buffer_size);
+    }
+#endif
+}
 
-        client->rx_buffer = calloc(1, client->buffer_size);
-        ESP_WS_CLIENT_MEM_CHECK(TAG, client->rx_buffer, return ESP_ERR_NO_MEM);
+/**
+ * With dynamic buffers, the rx/tx buffers are allocated on first use and kept while the traffic is active,
+ * they're released only after CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_IDLE_MS without any send/receive.
+ * The buffers could grow up to CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_RX_MAX_SIZE and _TX_MAX_SIZE to transfer
+ * large messages in fewer reads and frames.
+ * The rx buffer is used by the client task only, the tx buffer only under tx_lock.
+ */
+static esp_err_t esp_websocket_new_buf(esp_websocket_client_handle_t client, bool is_tx, int size)
+{
+#ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
+    char **buffer = is_tx ? &client->tx_buffer : &client->rx_buffer;
+    int *buffer_size = is_tx ? &client->tx_buffer_size : &client->rx_buffer_size;
+    websocket_buffer_stats_t *stats = is_tx ? &client->tx_stats : &client->rx_stats;
+    if (*buffer && *buffer_size < size) {
+        esp_websocket_free_buf(client, is_tx);
+    }
+    if (*buffer == NULL) {
+        // no need to zero the buffer, it's always written before being used
+        *buffer = malloc(size);
+        ESP_WS_CLIENT_MEM_CHECK(TAG, *buffer, return ESP_ERR_NO_MEM);
+        *buffer_size = size;
+        stats->allocations++;
+        stats->allocated = size;
+        stats->peak = (size_t)size > stats->peak ? (size_t)size : stats->peak;
+        ESP_LOGD(TAG, "Allocated %s buffer of %d bytes", is_tx ? "tx" : "rx", size);
     }
 #endif
     return ESP_OK;
 }
 
-static void esp_websocket_free_buf(esp_websocket_client_handle_t client, bool is_tx)
+static int esp_websocket_rx_buffer_size(esp_websocket_client_handle_t client)
+{
+#ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
+    return client->rx_buffer_size;
+#else
+    return client->buffer_size;
+#endif
+}
+
+/**
+ * Marks the buffer as unused, it's released when idle for longer than the configured period
+ */
+static void esp_websocket_release_buf(esp_websocket_client_handle_t client, bool is_tx)
 {
 #ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
+#if CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_IDLE_MS > 0
     if (is_tx) {
-        if (client->tx_buffer) {
-            free(client->tx_buffer);
-            client->tx_buffer = NULL;
-        }
+        client->tx_buffer_tick_ms = _tick_get_ms();
+    } else {
+        client->rx_buffer_tick_ms = _tick_get_ms();
+    }
+#else
+    esp_websocket_free_buf(client, is_tx);
+#endif
+#endif
+}
+
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+/**
+ * Returns the number of milliseconds until the next idle buffer is due to be released, -1 if none
+ */
+static int esp_websocket_idle_buf_timeout_ms(esp_websocket_client_handle_t client, uint64_t now)
+{
+    int timeout_ms = -1;
+#if defined(CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER) && CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_IDLE_MS > 0
+    uint64_t ticks[] = { client->rx_buffer ? client->rx_buffer_tick_ms : UINT64_MAX, UINT64_MAX };
+    if (xSemaphoreTakeRecursive(client->tx_lock, 0) == pdPASS) {
+        ticks[1] = client->tx_buffer ? client->tx_buffer_tick_ms : UINT64_MAX;
+        xSemaphoreGiveRecursive(client->tx_lock);
     } else {
-        if (client->rx_buffer) {
-            free(client->rx_buffer);
-            client->rx_buffer = NULL;
+        // a send is in progress, the tx buffer is in use
+        ticks[1] = now;
+    }
+    for (int i = 0; i < sizeof(ticks) / sizeof(ticks[0]); ++i) {
+        if (ticks[i] == UINT64_MAX) {
+            continue;
+        }
+        uint64_t deadline = ticks[i] + CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_IDLE_MS;
+        int remaining = deadline > now ? (int)(deadline - now) : 0;
+        if (timeout_ms < 0 || remaining < timeout_ms) {
+            timeout_ms = remaining;
+        }
+    }
+#endif
+    return timeout_ms;
+}
+#endif // CONFIG_ESP_WS_CLIENT_SHARED_TASK
+
+/**
+ * Releases buffers which haven't been used for CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_IDLE_MS, called from the client task
+ */
+static void esp_websocket_trim_bufs(esp_websocket_client_handle_t client)
+{
+#if defined(CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER) && CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_IDLE_MS > 0
+    uint64_t now = _tick_get_ms();
+    if (client->rx_buffer && now - client->rx_buffer_tick_ms >= CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_IDLE_MS) {
+        esp_websocket_free_buf(client, false);
+    }
+    // tx buffer is owned by the sender, skip trimming if a send is in progress
+    if (xSemaphoreTakeRecursive(client->tx_lock, 0) == pdPASS) {
+        if (client->tx_buffer && now - client->tx_buffer_tick_ms >= CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_IDLE_MS) {
+            esp_websocket_free_buf(client, true);
         }
+        xSemaphoreGiveRecursive(client->tx_lock);
     }
 #endif
 }
@@ -209,6 +339,15 @@ static esp_err_t esp_websocket_client_dispatch_event(esp_websocket_client_handle
     event_data.error_handle.error_type = client->error_handle.error_type;
     event_data.error_handle.esp_ws_handshake_status_code = client->error_handle.esp_ws_handshake_status_code;
 
+    memset(&event_data.timing, 0, sizeof(event_data.timing));
+    if (event == WEBSOCKET_EVENT_CONNECTED || event == WEBSOCKET_EVENT_DISCONNECTED) {
+        event_data.timing.reconnect_attempts = client->reconnect_attempts;
+        event_data.timing.connect_time_ms = client->connect_time_ms;
+        event_data.timing.disconnected_time_ms = _tick_get_ms() - client->disconnect_tick_ms;
+        if (event == WEBSOCKET_EVENT_DISCONNECTED && client->config->auto_reconnect) {
+            event_data.timing.reconnect_delay_ms = client->reconnect_delay_ms;
+        }
+    }
 
     if ((err = esp_event_post_to(client->event_handle,
                                  WEBSOCKET_EVENTS, event,
@@ -220,18 +359,50 @@ static esp_err_t esp_websocket_client_dispatch_event(esp_websocket_client_handle
     return esp_event_loop_run(client->event_handle, 0);
 }
 
+/**
+ * Returns the delay before the next connection attempt. With `reconnect_timeout_max_ms` set, the reconnect timeout
+ * doubles with each failed attempt and the delay is randomly chosen between half and the full timeout, so that clients
+ * disconnected at the same time (e.g. by a server restart) don't reconnect all at once.
+ */
+static int esp_websocket_client_reconnect_delay(esp_websocket_client_handle_t client)
+{
+    int timeout_ms = client->wait_timeout_ms;
+    int max_timeout_ms = client->config->reconnect_timeout_max_ms;
+    if (max_timeout_ms <= 0) {
+        return timeout_ms;
+    }
+    for (int i = 0; i < client->reconnect_attempts && timeout_ms < max_timeout_ms; ++i) {
+        timeout_ms *= 2;
+    }
+    if (timeout_ms > max_timeout_ms) {
+        timeout_ms = max_timeout_ms;
+    }
+    return timeout_ms / 2 + esp_random() % (timeout_ms / 2 + 1);
+}
+
 static esp_err_t esp_websocket_client_abort_connection(esp_websocket_client_handle_t client, esp_websocket_error_type_t error_type)
 {
     ESP_WS_CLIENT_STATE_CHECK(TAG, client, return ESP_FAIL);
+    bool was_connected = client->state == WEBSOCKET_STATE_CONNECTED || client->state == WEBSOCKET_STATE_CLOSING;
+    // wait for a pending write to finish before closing the transport
+    xSemaphoreTakeRecursive(client->tx_lock, portMAX_DELAY);
     esp_transport_close(client->transport);
+    client->state = WEBSOCKET_STATE_WAIT_TIMEOUT;
+    xSemaphoreGiveRecursive(client->tx_lock);
 
+    if (was_connected) {
+        client->disconnect_tick_ms = _tick_get_ms();
+        client->reconnect_attempts = 0;
+    } else {
+        client->reconnect_attempts++;
+    }
     if (client->config->auto_reconnect) {
         client->reconnect_tick_ms = _tick_get_ms();
-        ESP_LOGI(TAG, "Reconnect after %d ms", client->wait_timeout_ms);
+        client->reconnect_delay_ms = esp_websocket_client_reconnect_delay(client);
+        ESP_LOGI(TAG, "Reconnect after %d ms", client->reconnect_delay_ms);
     }
 
     client->error_handle.error_type = error_type;
-    client->state = WEBSOCKET_STATE_WAIT_TIMEOUT;
     esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_DISCONNECTED, NULL, 0);
     return ESP_OK;
 }
@@ -364,6 +535,13 @@ static esp_err_t esp_websocket_client_set_config(esp_websocket_client_handle_t c
 
 
     cfg->user_context = config->user_context;
+    cfg->use_shared_task = config->use_shared_task;
+#ifndef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+    if (cfg->use_shared_task) {
+        ESP_LOGE(TAG, "use_shared_task configured but not enabled in menuconfig: Please enable ESP_WS_CLIENT_SHARED_TASK option");
+        cfg->use_shared_task = false;
+    }
+#endif
     cfg->auto_reconnect = true;
     if (config->disable_auto_reconnect) {
         cfg->auto_reconnect = false;
@@ -431,6 +609,9 @@ static void destroy_and_free_resources(esp_websocket_client_handle_t client)
         esp_transport_list_destroy(client->transport_list);
     }
     vQueueDelete(client->lock);
+    if (client->tx_lock) {
+        vQueueDelete(client->tx_lock);
+    }
     free(client->tx_buffer);
     free(client->rx_buffer);
     free(client->errormsg_buffer);
@@ -548,12 +729,57 @@ static esp_err_t esp_websocket_client_create_transport(esp_websocket_client_hand
     return ESP_OK;
 }
 
+static int esp_websocket_client_send_control(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode, const char *data, int len)
+{
+    xSemaphoreTakeRecursive(client->tx_lock, portMAX_DELAY);
+    int ret = esp_transport_ws_send_raw(client->transport, opcode | WS_TRANSPORT_OPCODES_FIN, data, len, client->config->network_timeout_ms);
+    xSemaphoreGiveRecursive(client->tx_lock);
+    return ret;
+}
+
+static int esp_websocket_client_transport_read(esp_websocket_client_handle_t client, char *buffer, int len, int timeout_ms)
+{
+    // over TLS, reads are serialized with writes, but the TX lock is still released before dispatching the data
+    if (client->tls_transport) {
+        xSemaphoreTakeRecursive(client->tx_lock, portMAX_DELAY);
+    }
+    int ret = esp_transport_read(client->transport, buffer, len, timeout_ms);
+    if (client->tls_transport) {
+        xSemaphoreGiveRecursive(client->tx_lock);
+    }
+    return ret;
+}
+
+static void esp_websocket_client_send_failed(esp_websocket_client_handle_t client, int ret, int sock_errno, TickType_t timeout)
+{
+    // Aborting is a state transition, so it's serialized with the client task (TX lock must not be held here)
+    if (xSemaphoreTakeRecursive(client->lock, timeout) != pdPASS) {
+        // the client task is busy, it aborts the connection itself once it fails to read from the broken transport
+        ESP_LOGE(TAG, "esp_transport_write() returned %d, errno=%d, could not lock ws-client to abort the connection", ret, sock_errno);
+        return;
+    }
+    esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->transport);
+    if (error_handle) {
+        esp_websocket_client_error(client, "esp_transport_write() returned %d, transport_error=%s, tls_error_code=%i, tls_flags=%i, errno=%d",
+                                   ret, esp_err_to_name(error_handle->last_error), error_handle->esp_tls_error_code,
+                                   error_handle->esp_tls_flags, sock_errno);
+    } else {
+        esp_websocket_client_error(client, "esp_transport_write() returned %d, errno=%d", ret, sock_errno);
+    }
+    // the client task could have already aborted the connection in the meantime
+    if (client->state == WEBSOCKET_STATE_CONNECTED) {
+        esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
+    }
+    xSemaphoreGiveRecursive(client->lock);
+}
+
 static int esp_websocket_client_send_with_exact_opcode(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode, const uint8_t *data, int len, TickType_t timeout)
 {
     int ret = -1;
     int need_write = len;
     int wlen = 0, widx = 0;
     bool contained_fin = opcode & WS_TRANSPORT_OPCODES_FIN;
+    TickType_t start = xTaskGetTickCount();
 
     if (client == NULL || len < 0 || (data == NULL && len > 0)) {
         ESP_LOGE(TAG, "Invalid arguments");
@@ -570,19 +796,35 @@ static int esp_websocket_client_send_with_exact_opcode(esp_websocket_client_hand
         return -1;
     }
 
-    if (xSemaphoreTakeRecursive(client->lock, timeout) != pdPASS) {
+    // Only the TX lock is taken, so sending is not blocked by the client task receiving and dispatching data
+    if (xSemaphoreTakeRecursive(client->tx_lock, timeout) != pdPASS) {
         ESP_LOGE(TAG, "Could not lock ws-client within %" PRIu32 " timeout", timeout);
         return -1;
     }
 
-    if (esp_websocket_new_buf(client, true) != ESP_OK) {
+    if (!esp_websocket_client_is_connected(client)) {
+        ESP_LOGE(TAG, "Websocket client is not connected");
+        goto unlock_and_return;
+    }
+
+    int frame_size = client->buffer_size;
+#if defined(CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER) && CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_TX_MAX_SIZE > 0
+    // grow the tx buffer to send bursts in fewer frames, but keep the already allocated larger buffer
+    if (len > frame_size) {
+        frame_size = len < CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_TX_MAX_SIZE ? len : CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_TX_MAX_SIZE;
+        if (client->tx_buffer && client->tx_buffer_size > frame_size) {
+            frame_size = client->tx_buffer_size;
+        }
+    }
+#endif
+    if (esp_websocket_new_buf(client, true, frame_size) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to setup tx buffer");
         goto unlock_and_return;
     }
 
     while (widx < len || opcode) {  // allow for sending "current_opcode" only message with len==0
-        if (need_write > client->buffer_size) {
-            need_write = client->buffer_size;
+        if (need_write > frame_size) {
+            need_write = frame_size;
             opcode = opcode & ~WS_TRANSPORT_OPCODES_FIN;
         } else if (contained_fin) {
             opcode = opcode | WS_TRANSPORT_OPCODES_FIN;
@@ -592,28 +834,24 @@ static int esp_websocket_client_send_with_exact_opcode(esp_websocket_client_hand
         wlen = esp_transport_ws_send_raw(client->transport, opcode, (char *)client->tx_buffer, need_write,
                                          (timeout == portMAX_DELAY) ? -1 : timeout * portTICK_PERIOD_MS);
         if (wlen < 0 || (wlen == 0 && need_write != 0)) {
+            int sock_errno = errno;
             ret = wlen;
-            esp_websocket_free_buf(client, true);
-            esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->transport);
-            if (error_handle) {
-                esp_websocket_client_error(client, "esp_transport_write() returned %d, transport_error=%s, tls_error_code=%i, tls_flags=%i, errno=%d",
-                                           ret, esp_err_to_name(error_handle->last_error), error_handle->esp_tls_error_code,
-                                           error_handle->esp_tls_flags, errno);
-            } else {
-                esp_websocket_client_error(client, "esp_transport_write() returned %d, errno=%d", ret, errno);
-            }
-            esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
-            goto unlock_and_return;
+            esp_websocket_release_buf(client, true);
+            xSemaphoreGiveRecursive(client->tx_lock);
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            esp_websocket_client_send_failed(client, ret, sock_errno,
+                                             timeout == portMAX_DELAY ? portMAX_DELAY : elapsed < timeout ? timeout - elapsed : 0);
+            return ret;
         }
         opcode = 0;
         widx += wlen;
         need_write = len - widx;
     }
-    esp_websocket_free_buf(client, true);
+    esp_websocket_release_buf(client, true);
     ret = widx;
 
 unlock_and_return:
-    xSemaphoreGiveRecursive(client->lock);
+    xSemaphoreGiveRecursive(client->tx_lock);
     return ret;
 }
 
@@ -649,6 +887,9 @@ esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_clie
     client->lock = xSemaphoreCreateRecursiveMutex();
     ESP_WS_CLIENT_MEM_CHECK(TAG, client->lock, goto _websocket_init_fail);
 
+    client->tx_lock = xSemaphoreCreateRecursiveMutex();
+    ESP_WS_CLIENT_MEM_CHECK(TAG, client->tx_lock, goto _websocket_init_fail);
+
     client->config = calloc(1, sizeof(websocket_config_storage_t));
     ESP_WS_CLIENT_MEM_CHECK(TAG, client->config, goto _websocket_init_fail);
 
@@ -666,6 +907,8 @@ esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_clie
     } else {
         client->wait_timeout_ms = config->reconnect_timeout_ms;
     }
+    client->config->reconnect_timeout_max_ms = config->reconnect_timeout_max_ms;
+    client->reconnect_delay_ms = client->wait_timeout_ms;
 
     // configure ssl related parameters
     client->config->use_global_ca_store = config->use_global_ca_store;
@@ -736,7 +979,10 @@ esp_err_t esp_websocket_client_destroy(esp_websocket_client_handle_t client)
         return ESP_ERR_INVALID_ARG;
     }
     if (client->run) {
-        esp_websocket_client_stop(client);
+        if (esp_websocket_client_stop(client) != ESP_OK && client->config->use_shared_task) {
+            // the client is still linked in the shared task (e.g. destroyed from an event handler)
+            return ESP_FAIL;
+        }
     }
     destroy_and_free_resources(client);
     return ESP_OK;
@@ -873,18 +1119,51 @@ esp_err_t esp_websocket_client_append_header(esp_websocket_client_handle_t clien
     return ESP_OK;
 }
 
+#ifdef CONFIG_ESP_WS_CLIENT_UTF8_VALIDATION
+/**
+ * Validates text messages incrementally, across the frames of a message and the reads of a frame.
+ * Invalid UTF-8 fails the connection with close code 1007 (RFC6455#section-8.1).
+ */
+static esp_err_t esp_websocket_client_check_utf8(esp_websocket_client_handle_t client, int rlen)
+{
+    if (client->last_opcode == WS_TRANSPORT_OPCODES_TEXT || client->last_opcode == WS_TRANSPORT_OPCODES_BINARY) {
+        if (client->payload_offset == 0) {
+            client->rx_text = client->last_opcode == WS_TRANSPORT_OPCODES_TEXT;
+            esp_websocket_utf8_init(&client->utf8_state);
+        }
+    } else if (client->last_opcode != WS_TRANSPORT_OPCODES_CONT) {
+        return ESP_OK;  // control frames could be interleaved with the fragments
+    }
+    if (!client->rx_text) {
+        return ESP_OK;
+    }
+    bool valid = esp_websocket_utf8_validate(&client->utf8_state, (const uint8_t *)client->rx_buffer, rlen);
+    if (valid && client->last_fin && client->payload_offset + rlen >= client->payload_len) {
+        valid = esp_websocket_utf8_is_complete(&client->utf8_state);
+        client->rx_text = false;
+    }
+    if (!valid) {
+        const char code[2] = { WEBSOCKET_CLOSE_INVALID_PAYLOAD >> 8, WEBSOCKET_CLOSE_INVALID_PAYLOAD & 0xFF };
+        esp_websocket_client_error(client, "Invalid UTF-8 in text message, closing with code %d", WEBSOCKET_CLOSE_INVALID_PAYLOAD);
+        esp_websocket_client_send_control(client, WS_TRANSPORT_OPCODES_CLOSE, code, sizeof(code));
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+#endif
+
 static esp_err_t esp_websocket_client_recv(esp_websocket_client_handle_t client)
 {
     int rlen;
     client->payload_offset = 0;
-    if (esp_websocket_new_buf(client, false) != ESP_OK) {
+    if (esp_websocket_new_buf(client, false, client->buffer_size) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to setup rx buffer");
         return ESP_FAIL;
     }
     do {
-        rlen = esp_transport_read(client->transport, client->rx_buffer, client->buffer_size, client->config->network_timeout_ms);
+        rlen = esp_websocket_client_transport_read(client, client->rx_buffer, esp_websocket_rx_buffer_size(client), client->config->network_timeout_ms);
         if (rlen < 0) {
-            esp_websocket_free_buf(client, false);
+            esp_websocket_release_buf(client, false);
             esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->transport);
             if (error_handle) {
                 esp_websocket_client_error(client, "esp_transport_read() failed with %d, transport_error=%s, tls_error_code=%i, tls_flags=%i, errno=%d",
@@ -901,41 +1180,56 @@ static esp_err_t esp_websocket_client_recv(esp_websocket_client_handle_t client)
 
         if (rlen == 0 && client->last_opcode == WS_TRANSPORT_OPCODES_NONE ) {
             ESP_LOGV(TAG, "esp_transport_read timeouts");
-            esp_websocket_free_buf(client, false);
+            esp_websocket_release_buf(client, false);
             return ESP_OK;
         }
 
+#ifdef CONFIG_ESP_WS_CLIENT_UTF8_VALIDATION
+        if (esp_websocket_client_check_utf8(client, rlen) != ESP_OK) {
+            esp_websocket_release_buf(client, false);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+#endif
         esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_DATA, client->rx_buffer, rlen);
 
         client->payload_offset += rlen;
+#if defined(CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER) && CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_RX_MAX_SIZE > 0
+        // grow the rx buffer to receive the rest of a large message in fewer reads (and DATA events)
+        int rest = client->payload_len - client->payload_offset;
+        if (rest > client->rx_buffer_size && client->rx_buffer_size < CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_RX_MAX_SIZE &&
+                esp_websocket_new_buf(client, false, rest < CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_RX_MAX_SIZE ?
+                                      rest : CONFIG_ESP_WS_CLIENT_DYNAMIC_BUFFER_RX_MAX_SIZE) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to grow rx buffer");
+            return ESP_FAIL;
+        }
+#endif
     } while (client->payload_offset < client->payload_len);
 
     // if a PING message received -> send out the PONG, this will not work for PING messages with payload longer than buffer len
     if (client->last_opcode == WS_TRANSPORT_OPCODES_PING) {
         const char *data = (client->payload_len == 0) ? NULL : client->rx_buffer;
         ESP_LOGD(TAG, "Sending PONG with payload len=%d", client->payload_len);
-        esp_transport_ws_send_raw(client->transport, WS_TRANSPORT_OPCODES_PONG | WS_TRANSPORT_OPCODES_FIN, data, client->payload_len,
-                                  client->config->network_timeout_ms);
+        esp_websocket_client_send_control(client, WS_TRANSPORT_OPCODES_PONG, data, client->payload_len);
     } else if (client->last_opcode == WS_TRANSPORT_OPCODES_PONG) {
         client->wait_for_pong_resp = false;
     } else if (client->last_opcode == WS_TRANSPORT_OPCODES_CLOSE) {
         ESP_LOGD(TAG, "Received close frame");
         client->state = WEBSOCKET_STATE_CLOSING;
+        client->close_tick_ms = _tick_get_ms();
     }
-    esp_websocket_free_buf(client, false);
+    esp_websocket_release_buf(client, false);
     return ESP_OK;
 }
 
 static int esp_websocket_client_send_close(esp_websocket_client_handle_t client, int code, const char *additional_data, int total_len, TickType_t timeout);
 
-static void esp_websocket_client_task(void *pv)
+static void esp_websocket_client_prepare_run(esp_websocket_client_handle_t client)
 {
-    const int lock_timeout = portMAX_DELAY;
-    esp_websocket_client_handle_t client = (esp_websocket_client_handle_t) pv;
     client->run = true;
 
     //get transport by scheme
     client->transport = esp_transport_list_get_transport(client->transport_list, client->config->scheme);
+    client->tls_transport = strcasecmp(client->config->scheme, WS_OVER_TLS_SCHEME) == 0;
 
     if (client->transport == NULL) {
         ESP_LOGE(TAG, "There are no transports valid, stop websocket client");
@@ -946,151 +1240,467 @@ static void esp_websocket_client_task(void *pv)
         client->config->port = esp_transport_get_default_port(client->transport);
     }
 
+    client->reconnect_attempts = 0;
+    client->disconnect_tick_ms = _tick_get_ms();
     client->state = WEBSOCKET_STATE_INIT;
     xEventGroupClearBits(client->status_bits, STOPPED_BIT | CLOSE_FRAME_SENT_BIT);
-    int read_select = 0;
-    while (client->run) {
-        if (xSemaphoreTakeRecursive(client->lock, lock_timeout) != pdPASS) {
-            ESP_LOGE(TAG, "Failed to lock ws-client tasks, exiting the task...");
+}
+
+/**
+ * Runs one iteration of the client state machine, read_select indicates that the transport has data to read
+ */
+static esp_err_t esp_websocket_client_run_once(esp_websocket_client_handle_t client, int read_select)
+{
+    if (xSemaphoreTakeRecursive(client->lock, portMAX_DELAY) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to lock ws-client tasks, exiting the task...");
+        return ESP_FAIL;
+    }
+    switch ((int)client->state) {
+    case WEBSOCKET_STATE_INIT:
+        if (client->transport == NULL) {
+            ESP_LOGE(TAG, "There are no transport");
+            client->run = false;
             break;
         }
-        switch ((int)client->state) {
-        case WEBSOCKET_STATE_INIT:
-            if (client->transport == NULL) {
-                ESP_LOGE(TAG, "There are no transport");
-                client->run = false;
-                break;
-            }
-            esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_BEFORE_CONNECT, NULL, 0);
-            int result = esp_transport_connect(client->transport,
-                                               client->config->host,
-                                               client->config->port,
-                                               client->config->network_timeout_ms);
-            if (result < 0) {
-                esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->transport);
-                client->error_handle.esp_ws_handshake_status_code  = esp_transport_ws_get_upgrade_request_status(client->transport);
-                if (error_handle) {
-                    esp_websocket_client_error(client, "esp_transport_connect() failed with %d, "
-                                               "transport_error=%s, tls_error_code=%i, tls_flags=%i, esp_ws_handshake_status_code=%d, errno=%d",
-                                               result, esp_err_to_name(error_handle->last_error), error_handle->esp_tls_error_code,
-                                               error_handle->esp_tls_flags, client->error_handle.esp_ws_handshake_status_code, errno);
-                } else {
-                    esp_websocket_client_error(client, "esp_transport_connect() failed with %d, esp_ws_handshake_status_code=%d, errno=%d",
-                                               result, client->error_handle.esp_ws_handshake_status_code, errno);
-                }
-                esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
-                break;
+        esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_BEFORE_CONNECT, NULL, 0);
+        uint64_t connect_tick_ms = _tick_get_ms();
+        int result = esp_transport_connect(client->transport,
+                                           client->config->host,
+                                           client->config->port,
+                                           client->config->network_timeout_ms);
+        client->connect_time_ms = _tick_get_ms() - connect_tick_ms;
+        if (result < 0) {
+            esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->transport);
+            client->error_handle.esp_ws_handshake_status_code  = esp_transport_ws_get_upgrade_request_status(client->transport);
+            if (error_handle) {
+                esp_websocket_client_error(client, "esp_transport_connect() failed with %d, "
+                                           "transport_error=%s, tls_error_code=%i, tls_flags=%i, esp_ws_handshake_status_code=%d, errno=%d",
+                                           result, esp_err_to_name(error_handle->last_error), error_handle->esp_tls_error_code,
+                                           error_handle->esp_tls_flags, client->error_handle.esp_ws_handshake_status_code, errno);
+            } else {
+                esp_websocket_client_error(client, "esp_transport_connect() failed with %d, esp_ws_handshake_status_code=%d, errno=%d",
+                                           result, client->error_handle.esp_ws_handshake_status_code, errno);
             }
-            ESP_LOGD(TAG, "Transport connected to %s://%s:%d", client->config->scheme, client->config->host, client->config->port);
-
-            client->state = WEBSOCKET_STATE_CONNECTED;
-            client->wait_for_pong_resp = false;
-            client->error_handle.error_type = WEBSOCKET_ERROR_TYPE_NONE;
-            esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_CONNECTED, NULL, 0);
+            esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
+            break;
+        }
+        ESP_LOGD(TAG, "Transport connected to %s://%s:%d in %d ms, after %d failed attempts", client->config->scheme, client->config->host,
+                 client->config->port, client->connect_time_ms, client->reconnect_attempts);
+
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+        if (client->config->use_shared_task && esp_transport_get_socket(client->transport) >= FD_SETSIZE) {
+            // the shared task waits for its sockets with select()
+            esp_websocket_client_error(client, "Socket %d of the shared task client exceeds FD_SETSIZE=%d",
+                                       esp_transport_get_socket(client->transport), FD_SETSIZE);
+            esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
             break;
-        case WEBSOCKET_STATE_CONNECTED:
-            if ((CLOSE_FRAME_SENT_BIT & xEventGroupGetBits(client->status_bits)) == 0) { // only send and check for PING
-                // if closing hasn't been initiated
-                if (_tick_get_ms() - client->ping_tick_ms > client->config->ping_interval_sec * 1000) {
-                    client->ping_tick_ms = _tick_get_ms();
-                    ESP_LOGD(TAG, "Sending PING...");
-                    esp_transport_ws_send_raw(client->transport, WS_TRANSPORT_OPCODES_PING | WS_TRANSPORT_OPCODES_FIN, NULL, 0, client->config->network_timeout_ms);
-
-                    if (!client->wait_for_pong_resp && client->config->pingpong_timeout_sec) {
-                        client->pingpong_tick_ms = _tick_get_ms();
-                        client->wait_for_pong_resp = true;
-                    }
+        }
+#endif
+        client->state = WEBSOCKET_STATE_CONNECTED;
+        client->wait_for_pong_resp = false;
+        client->error_handle.error_type = WEBSOCKET_ERROR_TYPE_NONE;
+        esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_CONNECTED, NULL, 0);
+        break;
+    case WEBSOCKET_STATE_CONNECTED:
+        if ((CLOSE_FRAME_SENT_BIT & xEventGroupGetBits(client->status_bits)) == 0) { // only send and check for PING
+            // if closing hasn't been initiated
+            if (_tick_get_ms() - client->ping_tick_ms > client->config->ping_interval_sec * 1000) {
+                client->ping_tick_ms = _tick_get_ms();
+                ESP_LOGD(TAG, "Sending PING...");
+                esp_websocket_client_send_control(client, WS_TRANSPORT_OPCODES_PING, NULL, 0);
+
+                if (!client->wait_for_pong_resp && client->config->pingpong_timeout_sec) {
+                    client->pingpong_tick_ms = _tick_get_ms();
+                    client->wait_for_pong_resp = true;
                 }
+            }
 
-                if ( _tick_get_ms() - client->pingpong_tick_ms > client->config->pingpong_timeout_sec * 1000 ) {
-                    if (client->wait_for_pong_resp) {
-                        esp_websocket_client_error(client, "Error, no PONG received for more than %d seconds after PING", client->config->pingpong_timeout_sec);
-                        esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_PONG_TIMEOUT);
-                        break;
-                    }
+            if ( _tick_get_ms() - client->pingpong_tick_ms > client->config->pingpong_timeout_sec * 1000 ) {
+                if (client->wait_for_pong_resp) {
+                    esp_websocket_client_error(client, "Error, no PONG received for more than %d seconds after PING", client->config->pingpong_timeout_sec);
+                    esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_PONG_TIMEOUT);
+                    break;
                 }
             }
+        }
 
 
-            if (read_select == 0) {
-                ESP_LOGV(TAG, "Read poll timeout: skipping esp_transport_read()...");
-                break;
-            }
-            client->ping_tick_ms = _tick_get_ms();
-
-            if (esp_websocket_client_recv(client) == ESP_FAIL) {
-                ESP_LOGE(TAG, "Error receive data");
-                esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
-                break;
-            }
+        if (read_select == 0) {
+            ESP_LOGV(TAG, "Read poll timeout: skipping esp_transport_read()...");
             break;
-        case WEBSOCKET_STATE_WAIT_TIMEOUT:
+        }
+        client->ping_tick_ms = _tick_get_ms();
 
-            if (!client->config->auto_reconnect) {
-                client->run = false;
-                break;
-            }
-            if (_tick_get_ms() - client->reconnect_tick_ms > client->wait_timeout_ms) {
-                client->state = WEBSOCKET_STATE_INIT;
-                client->reconnect_tick_ms = _tick_get_ms();
-                ESP_LOGD(TAG, "Reconnecting...");
-            }
+        esp_err_t recv_err = esp_websocket_client_recv(client);
+        if (recv_err == ESP_ERR_INVALID_RESPONSE) {
+            esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_INVALID_PAYLOAD);
             break;
-        case WEBSOCKET_STATE_CLOSING:
-            // if closing not initiated by the client echo the close message back
-            if ((CLOSE_FRAME_SENT_BIT & xEventGroupGetBits(client->status_bits)) == 0) {
-                ESP_LOGD(TAG, "Closing initiated by the server, sending close frame");
-                esp_transport_ws_send_raw(client->transport, WS_TRANSPORT_OPCODES_CLOSE | WS_TRANSPORT_OPCODES_FIN, NULL, 0, client->config->network_timeout_ms);
-                xEventGroupSetBits(client->status_bits, CLOSE_FRAME_SENT_BIT);
-            }
+        }
+        if (recv_err == ESP_FAIL) {
+            ESP_LOGE(TAG, "Error receive data");
+            esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
             break;
-        default:
-            ESP_LOGD(TAG, "Client run iteration in a default state: %d", client->state);
+        }
+        break;
+    case WEBSOCKET_STATE_WAIT_TIMEOUT:
+
+        if (!client->config->auto_reconnect) {
+            client->run = false;
+            break;
+        }
+        if (_tick_get_ms() - client->reconnect_tick_ms > client->reconnect_delay_ms) {
+            client->state = WEBSOCKET_STATE_INIT;
+            client->reconnect_tick_ms = _tick_get_ms();
+            ESP_LOGD(TAG, "Reconnecting...");
+        }
+        break;
+    case WEBSOCKET_STATE_CLOSING:
+        // if closing not initiated by the client echo the close message back
+        if ((CLOSE_FRAME_SENT_BIT & xEventGroupGetBits(client->status_bits)) == 0) {
+            ESP_LOGD(TAG, "Closing initiated by the server, sending close frame");
+            esp_websocket_client_send_control(client, WS_TRANSPORT_OPCODES_CLOSE, NULL, 0);
+            xEventGroupSetBits(client->status_bits, CLOSE_FRAME_SENT_BIT);
+            client->close_tick_ms = _tick_get_ms();
+        }
+        break;
+    default:
+        ESP_LOGD(TAG, "Client run iteration in a default state: %d", client->state);
+        break;
+    }
+    esp_websocket_trim_bufs(client);
+    xSemaphoreGiveRecursive(client->lock);
+    return ESP_OK;
+}
+
+static void esp_websocket_client_poll_failed(esp_websocket_client_handle_t client, int read_select)
+{
+    esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->transport);
+    if (error_handle) {
+        esp_websocket_client_error(client, "esp_transport_poll_read() returned %d, transport_error=%s, tls_error_code=%i, tls_flags=%i, errno=%d",
+                                   read_select, esp_err_to_name(error_handle->last_error), error_handle->esp_tls_error_code,
+                                   error_handle->esp_tls_flags, errno);
+    } else {
+        esp_websocket_client_error(client, "esp_transport_poll_read() returned %d, errno=%d", read_select, errno);
+    }
+    esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
+}
+
+static void esp_websocket_client_wait_closed(esp_websocket_client_handle_t client, int timeout_ms)
+{
+    ESP_LOGD(TAG, " Waiting for TCP connection to be closed by the server");
+    int ret = esp_transport_ws_poll_connection_closed(client->transport, timeout_ms);
+    if (ret == 0) {
+        ESP_LOGW(TAG, "Did not get TCP close within expected delay");
+
+    } else if (ret < 0) {
+        ESP_LOGW(TAG, "Connection terminated while waiting for clean TCP close");
+    }
+    client->run = false;
+    client->state = WEBSOCKET_STATE_UNKNOW;
+    esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_CLOSED, NULL, 0);
+}
+
+static void esp_websocket_client_finish_run(esp_websocket_client_handle_t client)
+{
+    xSemaphoreTakeRecursive(client->tx_lock, portMAX_DELAY);
+    esp_transport_close(client->transport);
+    esp_websocket_free_buf(client, true);
+    xSemaphoreGiveRecursive(client->tx_lock);
+    esp_websocket_free_buf(client, false);
+    xEventGroupSetBits(client->status_bits, STOPPED_BIT);
+    client->state = WEBSOCKET_STATE_UNKNOW;
+    if (client->selected_for_destroying == true) {
+        destroy_and_free_resources(client);
+    }
+}
+
+static void esp_websocket_client_task(void *pv)
+{
+    esp_websocket_client_handle_t client = (esp_websocket_client_handle_t) pv;
+    esp_websocket_client_prepare_run(client);
+
+    int read_select = 0;
+    while (client->run) {
+        if (esp_websocket_client_run_once(client, read_select) != ESP_OK) {
             break;
         }
-        xSemaphoreGiveRecursive(client->lock);
         if (WEBSOCKET_STATE_CONNECTED == client->state) {
             read_select = esp_transport_poll_read(client->transport, 1000); //Poll every 1000ms
             if (read_select < 0) {
-                esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->transport);
-                if (error_handle) {
-                    esp_websocket_client_error(client, "esp_transport_poll_read() returned %d, transport_error=%s, tls_error_code=%i, tls_flags=%i, errno=%d",
-                                               read_select, esp_err_to_name(error_handle->last_error), error_handle->esp_tls_error_code,
-                                               error_handle->esp_tls_flags, errno);
-                } else {
-                    esp_websocket_client_error(client, "esp_transport_poll_read() returned %d, errno=%d", read_select, errno);
-                }
-                esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
+                esp_websocket_client_poll_failed(client, read_select);
             }
         } else if (WEBSOCKET_STATE_WAIT_TIMEOUT == client->state) {
             // waiting for reconnecting...
-            vTaskDelay(client->wait_timeout_ms / 2 / portTICK_PERIOD_MS);
+            vTaskDelay(client->reconnect_delay_ms / 2 / portTICK_PERIOD_MS);
         } else if (WEBSOCKET_STATE_CLOSING == client->state &&
                    (CLOSE_FRAME_SENT_BIT & xEventGroupGetBits(client->status_bits))) {
-            ESP_LOGD(TAG, " Waiting for TCP connection to be closed by the server");
-            int ret = esp_transport_ws_poll_connection_closed(client->transport, 1000);
-            if (ret == 0) {
-                ESP_LOGW(TAG, "Did not get TCP close within expected delay");
-
-            } else if (ret < 0) {
-                ESP_LOGW(TAG, "Connection terminated while waiting for clean TCP close");
-            }
-            client->run = false;
-            client->state = WEBSOCKET_STATE_UNKNOW;
-            esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_CLOSED, NULL, 0);
+            esp_websocket_client_wait_closed(client, WEBSOCKET_CLOSE_WAIT_MS);
             break;
         }
     }
 
-    esp_transport_close(client->transport);
-    xEventGroupSetBits(client->status_bits, STOPPED_BIT);
-    client->state = WEBSOCKET_STATE_UNKNOW;
-    if (client->selected_for_destroying == true) {
-        destroy_and_free_resources(client);
+    esp_websocket_client_finish_run(client);
+    vTaskDelete(NULL);
+}
+
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+/**
+ * Shared task running the state machines of all clients configured with `use_shared_task`.
+ * The task waits for all connected sockets in one select() and wakes up for the nearest
+ * ping/pong/reconnect/close deadline. A loopback UDP socket is used to wake it up when
+ * a client is started or stopped; if it cannot be created, the changes are picked up
+ * within WEBSOCKET_SHARED_TASK_MAX_WAIT_MS.
+ */
+typedef struct {
+    SemaphoreHandle_t               lock;
+    TaskHandle_t                    task_handle;
+    esp_websocket_client_handle_t   clients;
+    int                             wakeup_fd;
+} websocket_shared_task_t;
+
+static websocket_shared_task_t s_shared_task = { .wakeup_fd = -1 };
+static pthread_once_t s_shared_task_once = PTHREAD_ONCE_INIT;
+
+static int esp_websocket_shared_task_wakeup_init(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addr_len = sizeof(addr);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        ESP_LOGW(TAG, "Failed to create shared task wakeup socket, errno=%d", errno);
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+            getsockname(fd, (struct sockaddr *)&addr, &addr_len) != 0 ||
+            connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGW(TAG, "Failed to setup shared task wakeup socket, errno=%d", errno);
+        close(fd);
+        return -1;
+    }
+    if (fd >= FD_SETSIZE) {
+        ESP_LOGW(TAG, "Shared task wakeup socket %d exceeds FD_SETSIZE", fd);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void esp_websocket_shared_task_init(void)
+{
+    s_shared_task.lock = xSemaphoreCreateRecursiveMutex();
+    if (s_shared_task.lock) {
+        s_shared_task.wakeup_fd = esp_websocket_shared_task_wakeup_init();
+    }
+}
+
+static void esp_websocket_shared_task_wakeup(void)
+{
+    if (s_shared_task.wakeup_fd >= 0) {
+        const char wakeup = 0;
+        send(s_shared_task.wakeup_fd, &wakeup, sizeof(wakeup), MSG_DONTWAIT);
+    }
+}
+
+static int esp_websocket_client_shared_sock(esp_websocket_client_handle_t client)
+{
+    if (client->state == WEBSOCKET_STATE_CONNECTED ||
+            (client->state == WEBSOCKET_STATE_CLOSING && (CLOSE_FRAME_SENT_BIT & xEventGroupGetBits(client->status_bits)))) {
+        return esp_transport_get_socket(client->transport);
+    }
+    return -1;
+}
+
+/**
+ * Returns the number of milliseconds until the client state machine has to run without any incoming data
+ */
+static int esp_websocket_client_next_timeout_ms(esp_websocket_client_handle_t client, uint64_t now)
+{
+    uint64_t deadline;
+    bool close_sent = CLOSE_FRAME_SENT_BIT & xEventGroupGetBits(client->status_bits);
+
+    switch ((int)client->state) {
+    case WEBSOCKET_STATE_CONNECTED:
+        if (close_sent) {
+            return WEBSOCKET_SHARED_TASK_MAX_WAIT_MS;
+        }
+        deadline = client->ping_tick_ms + client->config->ping_interval_sec * 1000;
+        if (client->wait_for_pong_resp && client->config->pingpong_timeout_sec &&
+                client->pingpong_tick_ms + client->config->pingpong_timeout_sec * 1000 < deadline) {
+            deadline = client->pingpong_tick_ms + client->config->pingpong_timeout_sec * 1000;
+        }
+        break;
+    case WEBSOCKET_STATE_WAIT_TIMEOUT:
+        if (!client->config->auto_reconnect) {
+            return 0;
+        }
+        deadline = client->reconnect_tick_ms + client->reconnect_delay_ms;
+        break;
+    case WEBSOCKET_STATE_CLOSING:
+        if (!close_sent) {
+            return 0;
+        }
+        deadline = client->close_tick_ms + WEBSOCKET_CLOSE_WAIT_MS;
+        break;
+    default:
+        return 0;
+    }
+    int buf_timeout_ms = esp_websocket_idle_buf_timeout_ms(client, now);
+    // the state machine checks the timers with "elapsed > timeout", so run it just after the deadline
+    if (deadline < now) {
+        return 0;
+    }
+    if (deadline - now + 1 > WEBSOCKET_SHARED_TASK_MAX_WAIT_MS) {
+        deadline = now + WEBSOCKET_SHARED_TASK_MAX_WAIT_MS - 1;
+    }
+    if (buf_timeout_ms >= 0 && buf_timeout_ms < deadline - now + 1) {
+        return buf_timeout_ms;
+    }
+    return deadline - now + 1;
+}
+
+/**
+ * Runs the client from the shared task, clears client->run when the client has finished
+ */
+static void esp_websocket_client_shared_step(esp_websocket_client_handle_t client, const fd_set *read_set, uint64_t now)
+{
+    if (!client->run) {
+        return;
+    }
+    int sock = esp_websocket_client_shared_sock(client);
+    bool readable = client->shared_read_pending || (sock >= 0 && sock < FD_SETSIZE && FD_ISSET(sock, read_set));
+    client->shared_read_pending = false;
+
+    if (WEBSOCKET_STATE_CLOSING == client->state &&
+            (CLOSE_FRAME_SENT_BIT & xEventGroupGetBits(client->status_bits))) {
+        if (readable || now - client->close_tick_ms > WEBSOCKET_CLOSE_WAIT_MS) {
+            esp_websocket_client_wait_closed(client, 0);
+        }
+        return;
+    }
+    if (!readable && esp_websocket_client_next_timeout_ms(client, now) > 0) {
+        // nothing to do for this client
+        return;
+    }
+    if (esp_websocket_client_run_once(client, readable) != ESP_OK) {
+        client->run = false;
+        return;
+    }
+    if (WEBSOCKET_STATE_CONNECTED == client->state && readable) {
+        // the transport could have buffered more data (e.g. TLS records), check it before the next select()
+        client->shared_read_pending = true;
+    }
+}
+
+static void esp_websocket_shared_task(void *pv)
+{
+    while (true) {
+        fd_set read_set;
+        int max_fd = -1;
+        int wait_ms = WEBSOCKET_SHARED_TASK_MAX_WAIT_MS;
+        FD_ZERO(&read_set);
+
+        xSemaphoreTakeRecursive(s_shared_task.lock, portMAX_DELAY);
+        if (s_shared_task.clients == NULL) {
+            s_shared_task.task_handle = NULL;
+            xSemaphoreGiveRecursive(s_shared_task.lock);
+            break;
+        }
+        uint64_t now = _tick_get_ms();
+        for (esp_websocket_client_handle_t client = s_shared_task.clients; client; client = client->shared_next) {
+            if (!client->run) {
+                wait_ms = 0;
+                continue;
+            }
+            if (client->shared_read_pending) {
+                client->shared_read_pending = esp_transport_poll_read(client->transport, 0) > 0;
+                if (client->shared_read_pending) {
+                    wait_ms = 0;
+                }
+            }
+            int sock = esp_websocket_client_shared_sock(client);
+            if (sock >= 0 && sock < FD_SETSIZE) {
+                FD_SET(sock, &read_set);
+                max_fd = sock > max_fd ? sock : max_fd;
+            }
+            int timeout_ms = esp_websocket_client_next_timeout_ms(client, now);
+            wait_ms = timeout_ms < wait_ms ? timeout_ms : wait_ms;
+        }
+        if (s_shared_task.wakeup_fd >= 0) {
+            FD_SET(s_shared_task.wakeup_fd, &read_set);
+            max_fd = s_shared_task.wakeup_fd > max_fd ? s_shared_task.wakeup_fd : max_fd;
+        }
+        xSemaphoreGiveRecursive(s_shared_task.lock);
+
+        struct timeval timeout = {
+            .tv_sec = wait_ms / 1000,
+            .tv_usec = (wait_ms % 1000) * 1000,
+        };
+        int ret = select(max_fd + 1, &read_set, NULL, NULL, &timeout);
+        if (ret < 0) {
+            // a socket might have been closed by a failed send from another task, its client is not connected anymore
+            ESP_LOGD(TAG, "Shared task select() failed, errno=%d", errno);
+            FD_ZERO(&read_set);
+        } else if (s_shared_task.wakeup_fd >= 0 && FD_ISSET(s_shared_task.wakeup_fd, &read_set)) {
+            char drain[8];
+            while (recv(s_shared_task.wakeup_fd, drain, sizeof(drain), MSG_DONTWAIT) > 0) {
+            }
+        }
+
+        // the clients run without the lock, so that a blocking connect doesn't stall starting and stopping
+        // other clients; new clients are only added to the head of the list and only this task removes them
+        xSemaphoreTakeRecursive(s_shared_task.lock, portMAX_DELAY);
+        esp_websocket_client_handle_t first = s_shared_task.clients;
+        xSemaphoreGiveRecursive(s_shared_task.lock);
+        for (esp_websocket_client_handle_t client = first; client; client = client->shared_next) {
+            esp_websocket_client_shared_step(client, &read_set, _tick_get_ms());
+        }
+
+        xSemaphoreTakeRecursive(s_shared_task.lock, portMAX_DELAY);
+        esp_websocket_client_handle_t *link = &s_shared_task.clients;
+        while (*link) {
+            esp_websocket_client_handle_t client = *link;
+            if (client->run) {
+                link = &client->shared_next;
+                continue;
+            }
+            *link = client->shared_next;
+            client->shared_next = NULL;
+            esp_websocket_client_finish_run(client);
+        }
+        xSemaphoreGiveRecursive(s_shared_task.lock);
     }
     vTaskDelete(NULL);
 }
 
+static esp_err_t esp_websocket_shared_task_register(esp_websocket_client_handle_t client)
+{
+    esp_err_t ret = ESP_OK;
+    pthread_once(&s_shared_task_once, esp_websocket_shared_task_init);
+    ESP_WS_CLIENT_MEM_CHECK(TAG, s_shared_task.lock, return ESP_ERR_NO_MEM);
+
+    xSemaphoreTakeRecursive(s_shared_task.lock, portMAX_DELAY);
+    if (s_shared_task.task_handle == NULL &&
+            xTaskCreate(esp_websocket_shared_task, "websocket_shared", CONFIG_ESP_WS_CLIENT_SHARED_TASK_STACK, NULL,
+                        CONFIG_ESP_WS_CLIENT_SHARED_TASK_PRIORITY, &s_shared_task.task_handle) != pdTRUE) {
+        ESP_LOGE(TAG, "Error create websocket shared task");
+        s_shared_task.task_handle = NULL;
+        ret = ESP_FAIL;
+    } else {
+        esp_websocket_client_prepare_run(client);
+        client->task_handle = s_shared_task.task_handle;
+        client->shared_read_pending = false;
+        client->shared_next = s_shared_task.clients;
+        s_shared_task.clients = client;
+    }
+    xSemaphoreGiveRecursive(s_shared_task.lock);
+    esp_websocket_shared_task_wakeup();
+    return ret;
+}
+#endif // CONFIG_ESP_WS_CLIENT_SHARED_TASK
+
 esp_err_t esp_websocket_client_start(esp_websocket_client_handle_t client)
 {
     if (client == NULL) {
@@ -1105,6 +1715,11 @@ esp_err_t esp_websocket_client_start(esp_websocket_client_handle_t client)
         return ESP_FAIL;
     }
 
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+    if (client->config->use_shared_task) {
+        return esp_websocket_shared_task_register(client);
+    }
+#endif
     if (xTaskCreate(esp_websocket_client_task, client->config->task_name ? client->config->task_name : "websocket_task",
                     client->config->task_stack, client, client->config->task_prio, &client->task_handle) != pdTRUE) {
         ESP_LOGE(TAG, "Error create websocket task");
@@ -1133,6 +1748,11 @@ esp_err_t esp_websocket_client_stop(esp_websocket_client_handle_t client)
 
 
     client->run = false;
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+    if (client->config->use_shared_task) {
+        esp_websocket_shared_task_wakeup();
+    }
+#endif
     xEventGroupWaitBits(client->status_bits, STOPPED_BIT, false, true, portMAX_DELAY);
     client->state = WEBSOCKET_STATE_UNKNOW;
     return ESP_OK;
@@ -1188,6 +1808,11 @@ static esp_err_t esp_websocket_client_close_with_optional_body(esp_websocket_cli
 
     // If could not close gracefully within timeout, stop the client and disconnect
     client->run = false;
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+    if (client->config->use_shared_task) {
+        esp_websocket_shared_task_wakeup();
+    }
+#endif
     xEventGroupWaitBits(client->status_bits, STOPPED_BIT, false, true, portMAX_DELAY);
     client->state = WEBSOCKET_STATE_UNKNOW;
     return ESP_OK;
@@ -1246,6 +1871,22 @@ bool esp_websocket_client_is_connected(esp_websocket_client_handle_t client)
     return client->state == WEBSOCKET_STATE_CONNECTED;
 }
 
+esp_err_t esp_websocket_client_get_buffer_stats(esp_websocket_client_handle_t client, esp_websocket_buffer_stats_t *stats)
+{
+    if (client == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
+    stats->allocations = client->rx_stats.allocations + client->tx_stats.allocations;
+    stats->releases = client->rx_stats.releases + client->tx_stats.releases;
+    stats->allocated = client->rx_stats.allocated + client->tx_stats.allocated;
+    stats->peak = client->rx_stats.peak + client->tx_stats.peak;
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
 size_t esp_websocket_client_get_ping_interval_sec(esp_websocket_client_handle_t client)
 {
     if (client == NULL) {
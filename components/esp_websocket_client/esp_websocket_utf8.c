@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "esp_websocket_utf8.h"
+
+#define UTF8_CONT_MIN   0x80
+#define UTF8_CONT_MAX   0xBF
+
+typedef uintptr_t utf8_word_t;
+
+// 0x8080...80 of the native word size, to test the high bits of all bytes in one go
+#define UTF8_WORD_HIGH_BITS ((utf8_word_t)-1 / 0xFF * 0x80)
+
+void esp_websocket_utf8_init(esp_websocket_utf8_state_t *state)
+{
+    state->need = 0;
+    state->lower = UTF8_CONT_MIN;
+    state->upper = UTF8_CONT_MAX;
+}
+
+/**
+ * Checks the lead byte of a multi-byte sequence (RFC 3629, section 4) and sets up the expected continuation bytes,
+ * the restricted ranges of the first continuation byte reject overlong encodings, surrogates and code points above U+10FFFF
+ */
+static bool utf8_lead_byte(esp_websocket_utf8_state_t *state, uint8_t byte)
+{
+    state->lower = UTF8_CONT_MIN;
+    state->upper = UTF8_CONT_MAX;
+    if (byte >= 0xC2 && byte <= 0xDF) {
+        state->need = 1;
+    } else if (byte >= 0xE0 && byte <= 0xEF) {
+        state->need = 2;
+        if (byte == 0xE0) {
+            state->lower = 0xA0;
+        } else if (byte == 0xED) {
+            state->upper = 0x9F;
+        }
+    } else if (byte >= 0xF0 && byte <= 0xF4) {
+        state->need = 3;
+        if (byte == 0xF0) {
+            state->lower = 0x90;
+        } else if (byte == 0xF4) {
+            state->upper = 0x8F;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool esp_websocket_utf8_validate(esp_websocket_utf8_state_t *state, const uint8_t *data, size_t len)
+{
+    const uint8_t *end = data + len;
+    while (data < end) {
+        if (state->need == 0) {
+            if (*data >= 0x80) {
+                if (!utf8_lead_byte(state, *data++)) {
+                    return false;
+                }
+                continue;
+            }
+            data++;
+            // ASCII fast path: once aligned, check a whole word at a time
+            if ((uintptr_t)data % sizeof(utf8_word_t) == 0) {
+                while (end - data >= (ptrdiff_t)sizeof(utf8_word_t)) {
+                    utf8_word_t word;
+                    memcpy(&word, data, sizeof(word));
+                    if (word & UTF8_WORD_HIGH_BITS) {
+                        break;
+                    }
+                    data += sizeof(word);
+                }
+            }
+            continue;
+        }
+        if (*data < state->lower || *data > state->upper) {
+            return false;
+        }
+        data++;
+        state->lower = UTF8_CONT_MIN;
+        state->upper = UTF8_CONT_MAX;
+        // the remaining continuation bytes of the sequence have no extra restrictions
+        while (--state->need > 0 && data < end) {
+            if ((*data++ & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,566 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_websocket_client.h"
+#include "esp_websocket_utf8.h"
+#include "echo_server.h"
+
+#define CONNECTED_BIT           BIT0
+#define DISCONNECTED_BIT        BIT1
+#define RESPONSE_TIMEOUT_MS     5000
+#define LATENCY_MSG_SIZE        64
+#define FRAGMENTS_PER_MSG       4
+#define MAX_MSGS_PER_RUN        50000
+#define MIN_MSGS_PER_RUN        100
+#define UTF8_PAYLOAD_SIZE       (1024 * 1024)
+#define UTF8_ROUNDS             20
+#define SHARED_CONNECTED        1
+#define SHARED_ECHOED           2
+
+static const char *TAG = "ws_benchmark";
+
+static const int s_msg_sizes[] = { 16, 128, 1024, 4096, 16384 };
+
+typedef struct {
+    QueueHandle_t       done;       /*!< One item per fully echoed message */
+    EventGroupHandle_t  events;
+} bench_ctx_t;
+
+typedef struct {
+    const char          *name;
+    char                uri[64];
+    const char          *cert_pem;
+} bench_transport_t;
+
+static FILE *s_output;
+static int s_results;
+
+static void websocket_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    bench_ctx_t *ctx = handler_args;
+    esp_websocket_event_data_t *data = (esp_websocket_event_data_t *)event_data;
+    switch (event_id) {
+    case WEBSOCKET_EVENT_CONNECTED:
+        xEventGroupSetBits(ctx->events, CONNECTED_BIT);
+        break;
+    case WEBSOCKET_EVENT_DISCONNECTED:
+    case WEBSOCKET_EVENT_CLOSED:
+        xEventGroupSetBits(ctx->events, DISCONNECTED_BIT);
+        break;
+    case WEBSOCKET_EVENT_DATA:
+        if (data->op_code >= WS_TRANSPORT_OPCODES_CLOSE) {
+            break;  // control frames
+        }
+        // the last event of the last frame completes the message, long frames are posted in several events
+        if (data->fin && data->payload_offset + data->data_len >= data->payload_len) {
+            uint8_t one = 1;
+            xQueueSend(ctx->done, &one, 0);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void drain_done(bench_ctx_t *ctx)
+{
+    uint8_t item;
+    while (xQueueReceive(ctx->done, &item, 0) == pdTRUE) {
+    }
+}
+
+static esp_websocket_client_handle_t bench_connect(bench_ctx_t *ctx, const bench_transport_t *transport, int64_t *connect_us)
+{
+    esp_websocket_client_config_t websocket_cfg = {
+        .uri = transport->uri,
+        .cert_pem = transport->cert_pem,
+        .skip_cert_common_name_check = true,
+        .disable_auto_reconnect = true,
+        .buffer_size = CONFIG_WEBSOCKET_BENCHMARK_BUFFER_SIZE,
+        .network_timeout_ms = RESPONSE_TIMEOUT_MS,
+    };
+    xEventGroupClearBits(ctx->events, CONNECTED_BIT | DISCONNECTED_BIT);
+    drain_done(ctx);
+
+    esp_websocket_client_handle_t client = esp_websocket_client_init(&websocket_cfg);
+    if (client == NULL) {
+        return NULL;
+    }
+    esp_websocket_register_events(client, WEBSOCKET_EVENT_ANY, websocket_event_handler, ctx);
+
+    int64_t start = esp_timer_get_time();
+    if (esp_websocket_client_start(client) != ESP_OK) {
+        esp_websocket_client_destroy(client);
+        return NULL;
+    }
+    EventBits_t bits = xEventGroupWaitBits(ctx->events, CONNECTED_BIT | DISCONNECTED_BIT, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS));
+    if (!(bits & CONNECTED_BIT)) {
+        ESP_LOGE(TAG, "Failed to connect to %s", transport->uri);
+        esp_websocket_client_destroy(client);
+        return NULL;
+    }
+    if (connect_us) {
+        *connect_us = esp_timer_get_time() - start;
+    }
+    return client;
+}
+
+static void bench_disconnect(esp_websocket_client_handle_t client)
+{
+    if (esp_websocket_client_close(client, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != ESP_OK) {
+        esp_websocket_client_stop(client);
+    }
+    esp_websocket_client_destroy(client);
+}
+
+static int compare_int64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void begin_result(const char *transport, const char *test)
+{
+    fprintf(s_output, "%s\n  {\"test\": \"%s\"", s_results++ ? "," : "", test);
+    if (transport) {
+        fprintf(s_output, ", \"transport\": \"%s\"", transport);
+    }
+}
+
+static void report_percentiles(const char *transport, const char *test, int64_t *samples, int count)
+{
+    qsort(samples, count, sizeof(int64_t), compare_int64);
+    int64_t p50 = samples[count * 50 / 100];
+    int64_t p90 = samples[count * 90 / 100];
+    int64_t p99 = samples[count * 99 / 100];
+    int64_t max = samples[count - 1];
+
+    ESP_LOGI(TAG, "%-3s %-8s samples=%d p50=%" PRId64 " us p90=%" PRId64 " us p99=%" PRId64 " us max=%" PRId64 " us",
+             transport, test, count, p50, p90, p99, max);
+    begin_result(transport, test);
+    fprintf(s_output, ", \"samples\": %d, \"p50_us\": %" PRId64 ", \"p90_us\": %" PRId64 ", \"p99_us\": %" PRId64 ", \"max_us\": %" PRId64 "}",
+            count, p50, p90, p99, max);
+}
+
+static void bench_connect_time(bench_ctx_t *ctx, const bench_transport_t *transport)
+{
+    int64_t samples[CONFIG_WEBSOCKET_BENCHMARK_CONNECT_SAMPLES];
+    int count = 0;
+    for (int i = 0; i < CONFIG_WEBSOCKET_BENCHMARK_CONNECT_SAMPLES; ++i) {
+        esp_websocket_client_handle_t client = bench_connect(ctx, transport, &samples[count]);
+        if (client == NULL) {
+            continue;
+        }
+        count++;
+        bench_disconnect(client);
+    }
+    if (count > 0) {
+        report_percentiles(transport->name, "connect", samples, count);
+    }
+}
+
+static void bench_latency(bench_ctx_t *ctx, esp_websocket_client_handle_t client, const bench_transport_t *transport)
+{
+    static int64_t samples[CONFIG_WEBSOCKET_BENCHMARK_LATENCY_SAMPLES];
+    char msg[LATENCY_MSG_SIZE];
+    uint8_t item;
+    int count = 0;
+
+    memset(msg, 'l', sizeof(msg));
+    for (int i = 0; i < CONFIG_WEBSOCKET_BENCHMARK_LATENCY_SAMPLES; ++i) {
+        int64_t start = esp_timer_get_time();
+        if (esp_websocket_client_send_bin(client, msg, sizeof(msg), pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) < 0 ||
+                xQueueReceive(ctx->done, &item, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "Latency test failed after %d samples", count);
+            break;
+        }
+        samples[count++] = esp_timer_get_time() - start;
+    }
+    if (count > 0) {
+        report_percentiles(transport->name, "rtt", samples, count);
+    }
+}
+
+static int send_message(esp_websocket_client_handle_t client, const char *msg, int size, bool fragmented)
+{
+    TickType_t timeout = pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS);
+    if (!fragmented) {
+        return esp_websocket_client_send_bin(client, msg, size, timeout);
+    }
+    int chunk = (size + FRAGMENTS_PER_MSG - 1) / FRAGMENTS_PER_MSG;
+    if (esp_websocket_client_send_bin_partial(client, msg, chunk, timeout) < 0) {
+        return -1;
+    }
+    for (int offset = chunk; offset < size; offset += chunk) {
+        int len = size - offset < chunk ? size - offset : chunk;
+        if (esp_websocket_client_send_cont_msg(client, msg + offset, len, timeout) < 0) {
+            return -1;
+        }
+    }
+    return esp_websocket_client_send_fin(client, timeout);
+}
+
+static double cpu_time_ms(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+static void bench_throughput(bench_ctx_t *ctx, esp_websocket_client_handle_t client, const bench_transport_t *transport,
+                             int size, bool fragmented)
+{
+    int messages = CONFIG_WEBSOCKET_BENCHMARK_BYTES_PER_RUN / size;
+    messages = messages < MIN_MSGS_PER_RUN ? MIN_MSGS_PER_RUN : messages > MAX_MSGS_PER_RUN ? MAX_MSGS_PER_RUN : messages;
+    char *msg = malloc(size);
+    if (msg == NULL) {
+        return;
+    }
+    memset(msg, 't', size);
+    drain_done(ctx);
+
+    int sent = 0, received = 0;
+    uint8_t item;
+    esp_websocket_buffer_stats_t buf_start = {}, buf_end = {};
+    bool buf_stats = esp_websocket_client_get_buffer_stats(client, &buf_start) == ESP_OK;
+    double cpu_start = cpu_time_ms();
+    int64_t start = esp_timer_get_time();
+    while (received < messages) {
+        // keep up to WINDOW messages in flight, then wait for the echoes
+        if (sent < messages && sent - received < CONFIG_WEBSOCKET_BENCHMARK_WINDOW) {
+            if (send_message(client, msg, size, fragmented) < 0) {
+                break;
+            }
+            sent++;
+            continue;
+        }
+        if (xQueueReceive(ctx->done, &item, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
+            break;
+        }
+        received++;
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+    double cpu_ms = cpu_time_ms() - cpu_start;
+    free(msg);
+    esp_websocket_client_get_buffer_stats(client, &buf_end);
+
+    if (received < messages) {
+        ESP_LOGE(TAG, "%s throughput test (size=%d, fragmented=%d) failed: sent=%d, received=%d",
+                 transport->name, size, fragmented, sent, received);
+        return;
+    }
+    double seconds = elapsed_us / 1e6;
+    double mbytes = (double)messages * size / 1e6;
+    ESP_LOGI(TAG, "%-3s %-10s size=%-5d msgs=%-6d %10.0f msgs/s %8.2f MB/s %8.1f cpu ms/MB",
+             transport->name, fragmented ? "fragmented" : "single", size, messages,
+             messages / seconds, mbytes / seconds, cpu_ms / mbytes);
+    begin_result(transport->name, "throughput");
+    fprintf(s_output, ", \"size\": %d, \"fragmented\": %s, \"messages\": %d, \"msgs_per_sec\": %.1f, \"mb_per_sec\": %.3f, \"cpu_ms_per_mb\": %.2f",
+            size, fragmented ? "true" : "false", messages, messages / seconds, mbytes / seconds, cpu_ms / mbytes);
+    if (buf_stats) {
+        // dynamic buffers: allocations per echoed message and the buffer memory
+        ESP_LOGI(TAG, "%-3s buffers: %.2f allocations per message, peak %zu bytes",
+                 transport->name, (double)(buf_end.allocations - buf_start.allocations) / messages, buf_end.peak);
+        fprintf(s_output, ", \"buffer_allocs_per_msg\": %.2f, \"buffer_peak_bytes\": %zu",
+                (double)(buf_end.allocations - buf_start.allocations) / messages, buf_end.peak);
+    }
+    fprintf(s_output, "}");
+}
+
+/**
+ * Byte by byte UTF-8 decoder, as typically used by applications to validate complete text messages
+ */
+static bool naive_utf8_validate(const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+    while (i < len) {
+        uint8_t byte = data[i];
+        uint32_t code_point;
+        int follow;
+        if (byte < 0x80) {
+            i++;
+            continue;
+        } else if ((byte & 0xE0) == 0xC0) {
+            code_point = byte & 0x1F;
+            follow = 1;
+        } else if ((byte & 0xF0) == 0xE0) {
+            code_point = byte & 0x0F;
+            follow = 2;
+        } else if ((byte & 0xF8) == 0xF0) {
+            code_point = byte & 0x07;
+            follow = 3;
+        } else {
+            return false;
+        }
+        if (len - i <= (size_t)follow) {
+            return false;
+        }
+        for (int k = 1; k <= follow; ++k) {
+            if ((data[i + k] & 0xC0) != 0x80) {
+                return false;
+            }
+            code_point = (code_point << 6) | (data[i + k] & 0x3F);
+        }
+        if ((follow == 1 && code_point < 0x80) || (follow == 2 && code_point < 0x800) || (follow == 3 && code_point < 0x10000) ||
+                code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+            return false;
+        }
+        i += follow + 1;
+    }
+    return true;
+}
+
+/**
+ * Client validates the text incrementally, as received in buffer sized chunks
+ */
+static bool client_utf8_validate(const uint8_t *data, size_t len)
+{
+    esp_websocket_utf8_state_t state;
+    esp_websocket_utf8_init(&state);
+    for (size_t offset = 0; offset < len; offset += CONFIG_WEBSOCKET_BENCHMARK_BUFFER_SIZE) {
+        size_t chunk = len - offset < CONFIG_WEBSOCKET_BENCHMARK_BUFFER_SIZE ? len - offset : CONFIG_WEBSOCKET_BENCHMARK_BUFFER_SIZE;
+        if (!esp_websocket_utf8_validate(&state, data + offset, chunk)) {
+            return false;
+        }
+    }
+    return esp_websocket_utf8_is_complete(&state);
+}
+
+static void bench_utf8_validator(const char *payload_name, const uint8_t *payload, size_t len,
+                                 const char *validator_name, bool (*validate)(const uint8_t *, size_t))
+{
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < UTF8_ROUNDS; ++i) {
+        if (!validate(payload, len)) {
+            ESP_LOGE(TAG, "%s validator rejected valid %s text", validator_name, payload_name);
+            return;
+        }
+    }
+    double mb_per_sec = (double)len * UTF8_ROUNDS / (esp_timer_get_time() - start);
+    ESP_LOGI(TAG, "utf8 %-5s %-6s validator %8.1f MB/s", payload_name, validator_name, mb_per_sec);
+    begin_result(NULL, "utf8");
+    fprintf(s_output, ", \"payload\": \"%s\", \"validator\": \"%s\", \"size\": %zu, \"mb_per_sec\": %.1f}",
+            payload_name, validator_name, len, mb_per_sec);
+}
+
+static void bench_utf8(void)
+{
+    // mostly ASCII text with some two, three and four byte sequences
+    static const char mixed[] = "Websocket p\xc5\x99\xc3\xadli\xc5\xa1 \xe2\x82\xac 100, \xe4\xbd\xa0\xe5\xa5\xbd \xf0\x9f\x98\x80\n";
+    uint8_t *payload = malloc(UTF8_PAYLOAD_SIZE);
+    if (payload == NULL) {
+        return;
+    }
+    memset(payload, 'a', UTF8_PAYLOAD_SIZE);
+    bench_utf8_validator("ascii", payload, UTF8_PAYLOAD_SIZE, "naive", naive_utf8_validate);
+    bench_utf8_validator("ascii", payload, UTF8_PAYLOAD_SIZE, "client", client_utf8_validate);
+
+    size_t len = 0;
+    while (len + sizeof(mixed) - 1 <= UTF8_PAYLOAD_SIZE) {
+        memcpy(payload + len, mixed, sizeof(mixed) - 1);
+        len += sizeof(mixed) - 1;
+    }
+    bench_utf8_validator("mixed", payload, len, "naive", naive_utf8_validate);
+    bench_utf8_validator("mixed", payload, len, "client", client_utf8_validate);
+    free(payload);
+}
+
+static void bench_transport(bench_ctx_t *ctx, const bench_transport_t *transport)
+{
+    ESP_LOGI(TAG, "Benchmarking %s", transport->uri);
+    bench_connect_time(ctx, transport);
+
+    esp_websocket_client_handle_t client = bench_connect(ctx, transport, NULL);
+    if (client == NULL) {
+        return;
+    }
+    bench_latency(ctx, client, transport);
+    for (int i = 0; i < sizeof(s_msg_sizes) / sizeof(s_msg_sizes[0]); ++i) {
+        bench_throughput(ctx, client, transport, s_msg_sizes[i], false);
+        bench_throughput(ctx, client, transport, s_msg_sizes[i], true);
+    }
+    bench_disconnect(client);
+}
+
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+static void shared_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    QueueHandle_t events = handler_args;
+    esp_websocket_event_data_t *data = (esp_websocket_event_data_t *)event_data;
+    uint8_t item = 0;
+    if (event_id == WEBSOCKET_EVENT_CONNECTED) {
+        item = SHARED_CONNECTED;
+    } else if (event_id == WEBSOCKET_EVENT_DATA && data->op_code < WS_TRANSPORT_OPCODES_CLOSE &&
+               data->fin && data->payload_offset + data->data_len >= data->payload_len) {
+        item = SHARED_ECHOED;
+    }
+    if (item) {
+        xQueueSend(events, &item, 0);
+    }
+}
+
+/**
+ * Runs many clients from the shared task at the same time: all of them connect, echo one message and close
+ */
+static bool test_shared_task(const bench_transport_t *transport)
+{
+    static esp_websocket_client_handle_t clients[CONFIG_WEBSOCKET_BENCHMARK_SHARED_CLIENTS];
+    esp_websocket_client_config_t websocket_cfg = {
+        .uri = transport->uri,
+        .cert_pem = transport->cert_pem,
+        .skip_cert_common_name_check = true,
+        .disable_auto_reconnect = true,
+        .network_timeout_ms = RESPONSE_TIMEOUT_MS,
+        .use_shared_task = true,
+    };
+    QueueHandle_t events = xQueueCreate(2 * CONFIG_WEBSOCKET_BENCHMARK_SHARED_CLIENTS, sizeof(uint8_t));
+    int started = 0, connected = 0, echoed = 0;
+    bool ok = events != NULL;
+    uint8_t item;
+
+    int64_t start = esp_timer_get_time();
+    for (; ok && started < CONFIG_WEBSOCKET_BENCHMARK_SHARED_CLIENTS; ++started) {
+        clients[started] = esp_websocket_client_init(&websocket_cfg);
+        if (clients[started] == NULL) {
+            ok = false;
+            break;
+        }
+        esp_websocket_register_events(clients[started], WEBSOCKET_EVENT_ANY, shared_event_handler, events);
+        if (esp_websocket_client_start(clients[started]) != ESP_OK) {
+            esp_websocket_client_destroy(clients[started]);
+            ok = false;
+            break;
+        }
+    }
+    while (ok && connected < started) {
+        ok = xQueueReceive(events, &item, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) == pdTRUE && item == SHARED_CONNECTED;
+        connected += ok;
+    }
+    for (int i = 0; ok && i < started; ++i) {
+        ok = esp_websocket_client_send_text(clients[i], "shared", 6, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) == 6;
+    }
+    while (ok && echoed < started) {
+        ok = xQueueReceive(events, &item, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) == pdTRUE && item == SHARED_ECHOED;
+        echoed += ok;
+    }
+    double elapsed_ms = (esp_timer_get_time() - start) / 1000.0;
+
+    for (int i = 0; i < started; ++i) {
+        bench_disconnect(clients[i]);
+    }
+    if (events) {
+        vQueueDelete(events);
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "%s shared task test failed: started=%d, connected=%d, echoed=%d", transport->name, started, connected, echoed);
+        return false;
+    }
+    ESP_LOGI(TAG, "%-3s shared task: %d clients connected and echoed in %.1f ms", transport->name, echoed, elapsed_ms);
+    begin_result(transport->name, "shared_task");
+    fprintf(s_output, ", \"clients\": %d, \"ms\": %.1f}", echoed, elapsed_ms);
+    return true;
+}
+#endif // CONFIG_ESP_WS_CLIENT_SHARED_TASK
+
+static char *read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *content = calloc(1, size + 1);
+    if (content && fread(content, 1, size, f) != size) {
+        free(content);
+        content = NULL;
+    }
+    fclose(f);
+    return content;
+}
+
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_log_level_set(TAG, ESP_LOG_INFO);
+
+    // echo server runs in a separate process, so the CPU usage of the client could be measured alone
+    int ready[2];
+    if (pipe(ready) != 0) {
+        return 1;
+    }
+    pid_t server = fork();
+    if (server == 0) {
+        close(ready[0]);
+        echo_server_run(CONFIG_WEBSOCKET_BENCHMARK_WS_PORT, CONFIG_WEBSOCKET_BENCHMARK_WSS_PORT, ready[1]);
+        _exit(1);
+    }
+    close(ready[1]);
+    char byte;
+    if (server < 0 || read(ready[0], &byte, 1) != 1) {
+        ESP_LOGE(TAG, "Failed to start the echo server");
+        return 1;
+    }
+    close(ready[0]);
+
+    char *ca_cert = read_file(BENCHMARK_CERTS_DIR "/ca_cert.pem");
+    bench_transport_t transports[] = {
+        { .name = "ws" },
+        { .name = "wss", .cert_pem = ca_cert },
+    };
+    snprintf(transports[0].uri, sizeof(transports[0].uri), "ws://127.0.0.1:%d", CONFIG_WEBSOCKET_BENCHMARK_WS_PORT);
+    snprintf(transports[1].uri, sizeof(transports[1].uri), "wss://127.0.0.1:%d", CONFIG_WEBSOCKET_BENCHMARK_WSS_PORT);
+
+    bench_ctx_t ctx = {
+        .done = xQueueCreate(CONFIG_WEBSOCKET_BENCHMARK_WINDOW + 1, sizeof(uint8_t)),
+        .events = xEventGroupCreate(),
+    };
+    s_output = fopen(CONFIG_WEBSOCKET_BENCHMARK_OUTPUT_FILE, "w");
+    if (ctx.done == NULL || ctx.events == NULL || s_output == NULL || ca_cert == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize the benchmark");
+        kill(server, SIGTERM);
+        return 1;
+    }
+
+    fprintf(s_output, "[");
+    bench_utf8();
+    bool ok = true;
+    for (int i = 0; i < sizeof(transports) / sizeof(transports[0]); ++i) {
+        bench_transport(&ctx, &transports[i]);
+#ifdef CONFIG_ESP_WS_CLIENT_SHARED_TASK
+        ok = test_shared_task(&transports[i]) && ok;
+#endif
+    }
+    fprintf(s_output, "\n]\n");
+    fclose(s_output);
+    ESP_LOGI(TAG, "Results written to %s", CONFIG_WEBSOCKET_BENCHMARK_OUTPUT_FILE);
+
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+    free(ca_cert);
+    vQueueDelete(ctx.done);
+    vEventGroupDelete(ctx.events);
+    return s_results > 0 && ok ? 0 : 1;
+}
@@ -0,0 +1,369 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/base64.h"
+#include "echo_server.h"
+
+#define MAX_PAYLOAD         (64*1024)
+#define MAX_FRAME_HEADER    (14)
+#define MAX_REQUEST         (2048)
+#define WS_GUID             "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_OPCODE_CLOSE     0x08
+#define WS_OPCODE_PING      0x09
+#define WS_OPCODE_PONG      0x0A
+
+typedef struct {
+    int fd;
+    mbedtls_ssl_context *ssl;   // NULL for plain websocket
+} connection_t;
+
+typedef struct {
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_x509_crt cert;
+    mbedtls_pk_context key;
+    mbedtls_ssl_config conf;
+} tls_server_t;
+
+static char *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = calloc(1, size + 1);   // zero terminated for PEM parsing
+    if (data && fread(data, 1, size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len = size + 1;
+    return data;
+}
+
+static int bio_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    int ret = send(*(int *)ctx, buf, len, MSG_NOSIGNAL);
+    return ret < 0 ? MBEDTLS_ERR_SSL_INTERNAL_ERROR : ret;
+}
+
+static int bio_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    int ret = recv(*(int *)ctx, buf, len, 0);
+    return ret < 0 ? MBEDTLS_ERR_SSL_INTERNAL_ERROR : ret;
+}
+
+static bool tls_server_init(tls_server_t *tls)
+{
+    size_t cert_len, key_len;
+    char *cert = read_file(BENCHMARK_CERTS_DIR "/server_cert.pem", &cert_len);
+    char *key = read_file(BENCHMARK_CERTS_DIR "/server_key.pem", &key_len);
+    bool ok = false;
+
+    mbedtls_entropy_init(&tls->entropy);
+    mbedtls_ctr_drbg_init(&tls->ctr_drbg);
+    mbedtls_x509_crt_init(&tls->cert);
+    mbedtls_pk_init(&tls->key);
+    mbedtls_ssl_config_init(&tls->conf);
+    if (cert == NULL || key == NULL) {
+        fprintf(stderr, "echo_server: failed to read certificates from %s\n", BENCHMARK_CERTS_DIR);
+        goto exit;
+    }
+    if (mbedtls_ctr_drbg_seed(&tls->ctr_drbg, mbedtls_entropy_func, &tls->entropy, NULL, 0) != 0 ||
+            mbedtls_x509_crt_parse(&tls->cert, (const unsigned char *)cert, cert_len) != 0 ||
+            mbedtls_pk_parse_key(&tls->key, (const unsigned char *)key, key_len, NULL, 0, mbedtls_ctr_drbg_random, &tls->ctr_drbg) != 0 ||
+            mbedtls_ssl_config_defaults(&tls->conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0 ||
+            mbedtls_ssl_conf_own_cert(&tls->conf, &tls->cert, &tls->key) != 0) {
+        fprintf(stderr, "echo_server: failed to setup TLS\n");
+        goto exit;
+    }
+    mbedtls_ssl_conf_rng(&tls->conf, mbedtls_ctr_drbg_random, &tls->ctr_drbg);
+    ok = true;
+exit:
+    free(cert);
+    free(key);
+    return ok;
+}
+
+static int conn_read(connection_t *conn, uint8_t *buf, size_t len)
+{
+    if (conn->ssl == NULL) {
+        return recv(conn->fd, buf, len, 0);
+    }
+    int ret;
+    do {
+        ret = mbedtls_ssl_read(conn->ssl, buf, len);
+    } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+    return ret;
+}
+
+static bool conn_read_exact(connection_t *conn, uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int ret = conn_read(conn, buf, len);
+        if (ret <= 0) {
+            return false;
+        }
+        buf += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+static bool conn_write_all(connection_t *conn, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int ret;
+        if (conn->ssl == NULL) {
+            ret = send(conn->fd, buf, len, MSG_NOSIGNAL);
+        } else {
+            ret = mbedtls_ssl_write(conn->ssl, buf, len);
+            if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                continue;
+            }
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        buf += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+static bool ws_handshake(connection_t *conn)
+{
+    char request[MAX_REQUEST + 1] = "";
+    size_t len = 0;
+    // the client doesn't send any frame before receiving the response, so we can't over-read here
+    while (strstr(request, "\r\n\r\n") == NULL) {
+        if (len == MAX_REQUEST) {
+            return false;
+        }
+        int ret = conn_read(conn, (uint8_t *)request + len, MAX_REQUEST - len);
+        if (ret <= 0) {
+            return false;
+        }
+        len += ret;
+        request[len] = '\0';
+    }
+    char *key = strcasestr(request, "Sec-WebSocket-Key:");
+    if (key == NULL) {
+        return false;
+    }
+    key += strlen("Sec-WebSocket-Key:");
+    key += strspn(key, " ");
+    size_t key_len = strcspn(key, "\r\n ");
+
+    char accept_src[64 + sizeof(WS_GUID)];
+    if (key_len > 64) {
+        return false;
+    }
+    int src_len = snprintf(accept_src, sizeof(accept_src), "%.*s%s", (int)key_len, key, WS_GUID);
+    unsigned char sha1[20];
+    unsigned char accept[32];
+    size_t accept_len = 0;
+    if (mbedtls_sha1((const unsigned char *)accept_src, src_len, sha1) != 0 ||
+            mbedtls_base64_encode(accept, sizeof(accept) - 1, &accept_len, sha1, sizeof(sha1)) != 0) {
+        return false;
+    }
+    accept[accept_len] = '\0';
+
+    char response[256];
+    int response_len = snprintf(response, sizeof(response),
+                                "HTTP/1.1 101 Switching Protocols\r\n"
+                                "Upgrade: websocket\r\n"
+                                "Connection: Upgrade\r\n"
+                                "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    return conn_write_all(conn, (const uint8_t *)response, response_len);
+}
+
+static void ws_echo(connection_t *conn)
+{
+    // payload is read after the headroom, so that the echoed frame header could be prepended without copying
+    static uint8_t frame[MAX_FRAME_HEADER + MAX_PAYLOAD];
+    uint8_t *payload = frame + MAX_FRAME_HEADER;
+
+    while (true) {
+        uint8_t hdr[2];
+        uint8_t mask[4] = { 0 };
+        if (!conn_read_exact(conn, hdr, sizeof(hdr))) {
+            return;
+        }
+        uint8_t opcode = hdr[0] & 0x0F;
+        uint64_t len = hdr[1] & 0x7F;
+        if (len == 126) {
+            uint8_t ext[2];
+            if (!conn_read_exact(conn, ext, sizeof(ext))) {
+                return;
+            }
+            len = (ext[0] << 8) | ext[1];
+        } else if (len == 127) {
+            uint8_t ext[8];
+            if (!conn_read_exact(conn, ext, sizeof(ext))) {
+                return;
+            }
+            len = 0;
+            for (int i = 0; i < 8; ++i) {
+                len = (len << 8) | ext[i];
+            }
+        }
+        if (len > MAX_PAYLOAD) {
+            fprintf(stderr, "echo_server: frame too long (%llu bytes)\n", (unsigned long long)len);
+            return;
+        }
+        if ((hdr[1] & 0x80) && !conn_read_exact(conn, mask, sizeof(mask))) {
+            return;
+        }
+        if (!conn_read_exact(conn, payload, len)) {
+            return;
+        }
+        for (size_t i = 0; i < len; ++i) {
+            payload[i] ^= mask[i % 4];
+        }
+        if (opcode == WS_OPCODE_PONG) {
+            continue;
+        }
+
+        // server frames are not masked
+        uint8_t first = opcode == WS_OPCODE_PING ? (0x80 | WS_OPCODE_PONG) : hdr[0];
+        uint8_t *start;
+        if (len < 126) {
+            start = payload - 2;
+            start[1] = len;
+        } else if (len <= 0xFFFF) {
+            start = payload - 4;
+            start[1] = 126;
+            start[2] = len >> 8;
+            start[3] = len & 0xFF;
+        } else {
+            start = payload - 10;
+            start[1] = 127;
+            for (int i = 0; i < 8; ++i) {
+                start[2 + i] = (len >> (8 * (7 - i))) & 0xFF;
+            }
+        }
+        start[0] = first;
+        if (!conn_write_all(conn, start, payload + len - start) || opcode == WS_OPCODE_CLOSE) {
+            return;
+        }
+    }
+}
+
+static int listen_on(int port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        .sin_port = htons(port),
+    };
+    int opt = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        fprintf(stderr, "echo_server: cannot listen on port %d, errno=%d\n", port, errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void serve_connection(tls_server_t *tls, connection_t *conn, bool secure)
+{
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_init(&ssl);
+    bool connected = true;
+    if (secure) {
+        // the random generator state is inherited from the parent, make it unique for this connection
+        pid_t pid = getpid();
+        mbedtls_ctr_drbg_reseed(&tls->ctr_drbg, (const unsigned char *)&pid, sizeof(pid));
+        conn->ssl = &ssl;
+        int ret;
+        if (mbedtls_ssl_setup(&ssl, &tls->conf) != 0) {
+            connected = false;
+        } else {
+            mbedtls_ssl_set_bio(&ssl, &conn->fd, bio_send, bio_recv, NULL);
+            while ((ret = mbedtls_ssl_handshake(&ssl)) == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            }
+            connected = ret == 0;
+        }
+    }
+    if (connected && ws_handshake(conn)) {
+        ws_echo(conn);
+    }
+    if (conn->ssl) {
+        mbedtls_ssl_close_notify(&ssl);
+    }
+    mbedtls_ssl_free(&ssl);
+    close(conn->fd);
+}
+
+void echo_server_run(int ws_port, int wss_port, int ready_fd)
+{
+    static tls_server_t tls;
+    struct pollfd fds[2] = {
+        { .fd = listen_on(ws_port), .events = POLLIN },
+        { .fd = listen_on(wss_port), .events = POLLIN },
+    };
+    if (fds[0].fd < 0 || fds[1].fd < 0 || !tls_server_init(&tls)) {
+        exit(1);
+    }
+    const char ready = 1;
+    if (write(ready_fd, &ready, sizeof(ready)) != sizeof(ready)) {
+        exit(1);
+    }
+    close(ready_fd);
+
+    // every connection is served by a child process, so that many clients could be connected at the same time
+    signal(SIGCHLD, SIG_IGN);
+    while (true) {
+        if (poll(fds, 2, -1) <= 0) {
+            continue;
+        }
+        for (int i = 0; i < 2; ++i) {
+            if ((fds[i].revents & POLLIN) == 0) {
+                continue;
+            }
+            int opt = 1;
+            connection_t conn = { .fd = accept(fds[i].fd, NULL, NULL) };
+            if (conn.fd < 0) {
+                continue;
+            }
+            if (fork() != 0) {
+                close(conn.fd);
+                continue;
+            }
+            close(fds[0].fd);
+            close(fds[1].fd);
+            setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            serve_connection(&tls, &conn, i == 1);
+            _exit(0);
+        }
+    }
+}
@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Runs a minimal WS and WSS echo server, serving every connection from a child process
+ *
+ * Every received frame is echoed back with the same opcode and FIN flag, PINGs are answered with PONGs.
+ * This function is supposed to run in a separate process and never returns.
+ *
+ * @param ws_port   Port of the plain websocket server
+ * @param wss_port  Port of the websocket over TLS server
+ * @param ready_fd  File descriptor to which one byte is written when both servers are listening
+ */
+void echo_server_run(int ws_port, int wss_port, int ready_fd);
+
+#ifdef __cplusplus
+}
+#endif
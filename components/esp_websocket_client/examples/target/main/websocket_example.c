@@ -28,14 +28,18 @@
 #include "esp_log.h"
 #include "esp_websocket_client.h"
 #include "esp_event.h"
+#include "esp_timer.h"
 #include <cJSON.h>
 
 #define NO_DATA_TIMEOUT_SEC 5
+#define SLOW_HANDLER_DELAY_MS 200
 
 static const char *TAG = "websocket";
 
 static TimerHandle_t shutdown_signal_timer;
 static SemaphoreHandle_t shutdown_sema;
+static SemaphoreHandle_t flood_sema;
+static bool slow_data_handler = false;
 
 static void log_error_if_nonzero(const char *message, int error_code)
 {
@@ -75,6 +79,8 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base, i
     switch (event_id) {
     case WEBSOCKET_EVENT_CONNECTED:
         ESP_LOGI(TAG, "WEBSOCKET_EVENT_CONNECTED");
+        ESP_LOGI(TAG, "Connected in %d ms (%d failed attempts, %d ms disconnected)", data->timing.connect_time_ms,
+                 data->timing.reconnect_attempts, data->timing.disconnected_time_ms);
         break;
     case WEBSOCKET_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "WEBSOCKET_EVENT_DISCONNECTED");
@@ -111,6 +117,12 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base, i
         ESP_LOGW(TAG, "Total payload length=%d, data_len=%d, current payload offset=%d\r\n", data->payload_len, data->data_len, data->payload_offset);
 
         xTimerReset(shutdown_signal_timer, portMAX_DELAY);
+
+        // Simulate a slow event handler while the server floods us with data
+        if (slow_data_handler && data->data_len >= 5 && memcmp(data->data_ptr, "flood", 5) == 0) {
+            xSemaphoreGive(flood_sema);
+            vTaskDelay(SLOW_HANDLER_DELAY_MS / portTICK_PERIOD_MS);
+        }
         break;
     case WEBSOCKET_EVENT_ERROR:
         ESP_LOGI(TAG, "WEBSOCKET_EVENT_ERROR");
@@ -131,6 +143,7 @@ static void websocket_app_start(void)
     shutdown_signal_timer = xTimerCreate("Websocket shutdown timer", NO_DATA_TIMEOUT_SEC * 1000 / portTICK_PERIOD_MS,
                                          pdFALSE, NULL, shutdown_signaler);
     shutdown_sema = xSemaphoreCreateBinary();
+    flood_sema = xSemaphoreCreateBinary();
 
 #if CONFIG_WEBSOCKET_URI_FROM_STDIN
     char line[128];
@@ -211,6 +224,25 @@ static void websocket_app_start(void)
     char *long_data = malloc(size);
     memset(long_data, 'a', size);
     esp_websocket_client_send_text(client, long_data, size, portMAX_DELAY);
+    free(long_data);
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+
+    // Sending while the client task is busy with processing incoming data
+    slow_data_handler = true;
+    ESP_LOGI(TAG, "Measuring send latency under inbound load");
+    if (xSemaphoreTake(flood_sema, 10000 / portTICK_PERIOD_MS) == pdTRUE) {
+        int64_t max_latency_us = 0;
+        for (int j = 0; j < 20; ++j) {
+            int len = sprintf(data, "latency %04d", j);
+            int64_t start = esp_timer_get_time();
+            esp_websocket_client_send_text(client, data, len, portMAX_DELAY);
+            int64_t latency_us = esp_timer_get_time() - start;
+            max_latency_us = latency_us > max_latency_us ? latency_us : max_latency_us;
+            vTaskDelay(100 / portTICK_PERIOD_MS);
+        }
+        ESP_LOGI(TAG, "Send latency under inbound load: max=%" PRId64 " us", max_latency_us);
+    }
+    slow_data_handler = false;
 
     xSemaphoreTake(shutdown_sema, portMAX_DELAY);
     esp_websocket_client_close(client, portMAX_DELAY);
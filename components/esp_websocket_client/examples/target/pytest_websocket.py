@@ -178,6 +178,18 @@ def test_examples_protocol_websocket(dut):
         dut.expect('Received=' + 32 * 'a' + 32 * 'b')
         print('\nFragmented data received\n')
 
+    # Test for send latency under inbound load:
+    # Floods the DUT with messages, while its event handler processes them slowly,
+    # and checks that sending is not blocked behind the receive processing.
+    def test_send_latency_under_load(dut, websocket):
+        dut.expect('Measuring send latency under inbound load')
+        for i in range(30):
+            websocket.send_data('flood {:04d}'.format(i))
+        latency = int(dut.expect(re.compile(b'Send latency under inbound load: max=(\\d+) us')).group(1).decode())
+        print('Max send latency under inbound load: {} us'.format(latency))
+        # the event handler blocks for 200ms on each flood message, sending must not wait for it
+        assert latency < 100000, 'Sending was blocked by receive processing'
+
     # Extract the hexdump portion of the log line
     def parse_hexdump(line):
         match = re.search(r'\(.*\) Received binary data: ([0-9A-Fa-f ]+)', line)
@@ -243,6 +255,7 @@ def test_examples_protocol_websocket(dut):
             test_fragmented_binary_msg(dut)
             test_recv_fragmented_msg1(dut)
             test_recv_fragmented_msg2(dut)
+            test_send_latency_under_load(dut, ws)
             test_close(dut)
     else:
         print('DUT connecting to {}'.format(uri))
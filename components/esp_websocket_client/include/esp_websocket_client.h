@@ -46,7 +46,8 @@ typedef enum {
     WEBSOCKET_ERROR_TYPE_NONE = 0,
     WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT,
     WEBSOCKET_ERROR_TYPE_PONG_TIMEOUT,
-    WEBSOCKET_ERROR_TYPE_HANDSHAKE
+    WEBSOCKET_ERROR_TYPE_HANDSHAKE,
+    WEBSOCKET_ERROR_TYPE_INVALID_PAYLOAD    /*!< Received text message is not valid UTF-8, connection was closed with code 1007 */
 } esp_websocket_error_type_t;
 
 /**
@@ -64,6 +65,26 @@ typedef struct {
     int       esp_transport_sock_errno;         /*!< errno from the underlying socket */
 } esp_websocket_error_codes_t;
 
+/**
+ * @brief Websocket connection timing, reported in CONNECTED and DISCONNECTED events
+ */
+typedef struct {
+    int reconnect_attempts;                 /*!< Number of failed connection attempts since the connection was lost or the client was started */
+    int connect_time_ms;                    /*!< Duration of the last connection attempt, including DNS lookup, TCP connect, TLS and websocket handshakes */
+    int disconnected_time_ms;               /*!< Time since the connection was lost or the client was started, in CONNECTED event this is the total reconnection time */
+    int reconnect_delay_ms;                 /*!< Delay before the next connection attempt, reported in DISCONNECTED event if the client reconnects automatically */
+} esp_websocket_connection_timing_t;
+
+/**
+ * @brief Statistics of the dynamic rx/tx buffers (CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER)
+ */
+typedef struct {
+    uint32_t allocations;                   /*!< Number of rx and tx buffer allocations since the client was created */
+    uint32_t releases;                      /*!< Number of rx and tx buffers released since the client was created */
+    size_t allocated;                       /*!< Bytes currently allocated for the rx and tx buffers */
+    size_t peak;                            /*!< Highest number of bytes allocated for the rx buffer plus the highest for the tx buffer */
+} esp_websocket_buffer_stats_t;
+
 /**
  * @brief Websocket event data
  */
@@ -77,6 +98,7 @@ typedef struct {
     int payload_len;                        /*!< Total payload length, payloads exceeding buffer will be posted through multiple events */
     int payload_offset;                     /*!< Actual offset for the data associated with this event */
     esp_websocket_error_codes_t error_handle; /*!< esp-websocket error handle including esp-tls errors as well as internal websocket errors */
+    esp_websocket_connection_timing_t timing; /*!< Connection timing, valid in WEBSOCKET_EVENT_CONNECTED and WEBSOCKET_EVENT_DISCONNECTED */
 } esp_websocket_event_data_t;
 
 /**
@@ -124,9 +146,11 @@ typedef struct {
     int                         keep_alive_interval;        /*!< Keep-alive interval time. Default is 5 (second) */
     int                         keep_alive_count;           /*!< Keep-alive packet retry send count. Default is 3 counts */
     int                         reconnect_timeout_ms;       /*!< Reconnect after this value in miliseconds if disable_auto_reconnect is not enabled (defaults to 10s) */
+    int                         reconnect_timeout_max_ms;   /*!< If set, the reconnect timeout doubles after each failed connection attempt up to this value and is randomized (half of the timeout plus random jitter), so that many clients don't reconnect at the same time. Disabled by default */
     int                         network_timeout_ms;         /*!< Abort network operation if it is not completed after this value, in milliseconds (defaults to 10s) */
     size_t                      ping_interval_sec;          /*!< Websocket ping interval, defaults to 10 seconds if not set */
     struct ifreq                *if_name;                   /*!< The name of interface for data to go through. Use the default interface without setting */
+    bool                        use_shared_task;            /*!< Run this client from the shared websocket task instead of creating a dedicated task; `task_name`, `task_stack` and `task_prio` are ignored. Requires CONFIG_ESP_WS_CLIENT_SHARED_TASK */
 } esp_websocket_client_config_t;
 
 /**
@@ -186,6 +210,10 @@ esp_err_t esp_websocket_client_append_header(esp_websocket_client_handle_t clien
 /**
  * @brief      Open the WebSocket connection
  *
+ *  Notes:
+ *  - If the client was configured with `use_shared_task`, it is registered with the shared websocket task
+ *    (created on first use) and no dedicated task is created
+ *
  * @param[in]  client  The client
  *
  * @return     esp_err_t
@@ -416,6 +444,22 @@ size_t esp_websocket_client_get_ping_interval_sec(esp_websocket_client_handle_t
  */
 esp_err_t esp_websocket_client_set_ping_interval_sec(esp_websocket_client_handle_t client, size_t ping_interval_sec);
 
+/**
+ * @brief      Get statistics of the dynamic rx/tx buffers
+ *
+ * The values are updated by the client task and the sending tasks, so they might be slightly
+ * inconsistent with each other while data are being sent or received.
+ *
+ * @param[in]  client  The client handle
+ * @param[out] stats   The buffer statistics
+ *
+ * @return
+ *     - ESP_OK on success
+ *     - ESP_ERR_INVALID_ARG if the client or stats is NULL
+ *     - ESP_ERR_NOT_SUPPORTED if CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER is disabled
+ */
+esp_err_t esp_websocket_client_get_buffer_stats(esp_websocket_client_handle_t client, esp_websocket_buffer_stats_t *stats);
+
 /**
  * @brief Register the Websocket Events
  *
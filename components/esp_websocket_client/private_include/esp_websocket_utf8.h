@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief State of incremental UTF-8 validation, kept between fragments of one text message
+ */
+typedef struct {
+    uint8_t need;       /*!< Number of continuation bytes still expected */
+    uint8_t lower;      /*!< Lowest allowed value of the next continuation byte */
+    uint8_t upper;      /*!< Highest allowed value of the next continuation byte */
+} esp_websocket_utf8_state_t;
+
+/**
+ * @brief Resets the validation state at the beginning of a text message
+ */
+void esp_websocket_utf8_init(esp_websocket_utf8_state_t *state);
+
+/**
+ * @brief Validates the next chunk of a text message
+ *
+ * The chunk could end in the middle of a multi-byte sequence, which is then continued by the next chunk.
+ * Runs of ASCII characters are checked a machine word at a time.
+ *
+ * @return false if the data are not valid UTF-8
+ */
+bool esp_websocket_utf8_validate(esp_websocket_utf8_state_t *state, const uint8_t *data, size_t len);
+
+/**
+ * @brief Checks that the message doesn't end in the middle of a multi-byte sequence
+ */
+static inline bool esp_websocket_utf8_is_complete(const esp_websocket_utf8_state_t *state)
+{
+    return state->need == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <esp_websocket_client.h>
+#include "esp_websocket_utf8.h"
 #include "esp_event.h"
 #include "unity.h"
 #include "test_utils.h"
@@ -70,11 +71,45 @@ TEST(websocket, websocket_set_invalid_url)
     esp_websocket_client_destroy(client);
 }
 
+static bool utf8_valid_in_chunks(const char *text, size_t chunk)
+{
+    esp_websocket_utf8_state_t state;
+    esp_websocket_utf8_init(&state);
+    size_t len = strlen(text);
+    for (size_t offset = 0; offset < len; offset += chunk) {
+        if (!esp_websocket_utf8_validate(&state, (const uint8_t *)text + offset, len - offset < chunk ? len - offset : chunk)) {
+            return false;
+        }
+    }
+    return esp_websocket_utf8_is_complete(&state);
+}
+
+TEST(websocket, websocket_utf8_validation)
+{
+    const char *valid = "plain ASCII text longer than a word, \xc5\x99 \xe2\x82\xac \xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf";
+    const char *invalid[] = {
+        "overlong \xc0\xaf",
+        "surrogate \xed\xa0\x80",
+        "above U+10FFFF \xf4\x90\x80\x80",
+        "stray continuation \x80",
+        "truncated \xe2\x82",
+    };
+    // sequences split across chunks are validated the same way as in one piece
+    for (size_t chunk = 1; chunk <= strlen(valid); ++chunk) {
+        TEST_ASSERT_TRUE(utf8_valid_in_chunks(valid, chunk));
+    }
+    for (int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+        TEST_ASSERT_FALSE(utf8_valid_in_chunks(invalid[i], 1));
+        TEST_ASSERT_FALSE(utf8_valid_in_chunks(invalid[i], strlen(invalid[i])));
+    }
+}
+
 TEST_GROUP_RUNNER(websocket)
 {
     RUN_TEST_CASE(websocket, websocket_init_deinit)
     RUN_TEST_CASE(websocket, websocket_init_invalid_url)
     RUN_TEST_CASE(websocket, websocket_set_invalid_url)
+    RUN_TEST_CASE(websocket, websocket_utf8_validation)
 }
 
 void app_main(void)
@@ -0,0 +1,511 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// This file is auto-generated
+#pragma once
+
+#include "esp_wifi.h"
+#include "wifi_remote_rpc_ids.hpp"
+
+namespace eppp_rpc {
+
+class RpcEngine;
+struct RpcHeader;
+
+/**
+ * @brief How the client treats its cached responses when calling an API
+ */
+enum class cache_policy {
+    NONE,           // the call doesn't change the state
+    CACHED,         // read-mostly getter, served from the cache
+    INVALIDATE,     // the call might change the state, cached responses are dropped
+};
+
+constexpr cache_policy cache(api_id id)
+{
+    switch (id) {
+    case api_id::GET_MODE:
+    case api_id::GET_PS:
+    case api_id::GET_PROTOCOL:
+    case api_id::GET_BANDWIDTH:
+    case api_id::GET_COUNTRY:
+    case api_id::GET_MAC:
+    case api_id::GET_PROMISCUOUS:
+    case api_id::GET_PROMISCUOUS_FILTER:
+    case api_id::GET_PROMISCUOUS_CTRL_FILTER:
+    case api_id::GET_CONFIG:
+    case api_id::GET_MAX_TX_POWER:
+    case api_id::GET_EVENT_MASK:
+    case api_id::GET_INACTIVE_TIME:
+    case api_id::GET_COUNTRY_CODE:
+        return cache_policy::CACHED;
+    case api_id::SCAN_GET_AP_NUM:
+    case api_id::SCAN_GET_AP_RECORDS:
+    case api_id::SCAN_GET_AP_RECORD:
+    case api_id::STA_GET_AP_INFO:
+    case api_id::GET_CHANNEL:
+    case api_id::AP_GET_STA_LIST:
+    case api_id::AP_GET_STA_AID:
+    case api_id::GET_TSF_TIME:
+    case api_id::STA_GET_AID:
+    case api_id::STA_GET_NEGOTIATED_PHYMODE:
+    case api_id::STA_GET_RSSI:
+        return cache_policy::NONE;
+    default:
+        return cache_policy::INVALIDATE;
+    }
+}
+
+/**
+ * @brief Parameters of the requests and responses, every response starts with the return value
+ */
+namespace api {
+
+struct deinit_resp {
+    esp_err_t ret;
+};
+
+struct set_mode_req {
+    wifi_mode_t mode;
+};
+
+struct set_mode_resp {
+    esp_err_t ret;
+};
+
+struct get_mode_resp {
+    esp_err_t ret;
+    wifi_mode_t mode;
+};
+
+struct start_resp {
+    esp_err_t ret;
+};
+
+struct stop_resp {
+    esp_err_t ret;
+};
+
+struct restore_resp {
+    esp_err_t ret;
+};
+
+struct connect_resp {
+    esp_err_t ret;
+};
+
+struct disconnect_resp {
+    esp_err_t ret;
+};
+
+struct clear_fast_connect_resp {
+    esp_err_t ret;
+};
+
+struct deauth_sta_req {
+    uint16_t aid;
+};
+
+struct deauth_sta_resp {
+    esp_err_t ret;
+};
+
+struct scan_stop_resp {
+    esp_err_t ret;
+};
+
+struct scan_get_ap_num_resp {
+    esp_err_t ret;
+    uint16_t number;
+};
+
+struct scan_get_ap_record_resp {
+    esp_err_t ret;
+    wifi_ap_record_t ap_record;
+};
+
+struct clear_ap_list_resp {
+    esp_err_t ret;
+};
+
+struct sta_get_ap_info_resp {
+    esp_err_t ret;
+    wifi_ap_record_t ap_info;
+};
+
+struct set_ps_req {
+    wifi_ps_type_t type;
+};
+
+struct set_ps_resp {
+    esp_err_t ret;
+};
+
+struct get_ps_resp {
+    esp_err_t ret;
+    wifi_ps_type_t type;
+};
+
+struct set_protocol_req {
+    wifi_interface_t ifx;
+    uint8_t protocol_bitmap;
+};
+
+struct set_protocol_resp {
+    esp_err_t ret;
+};
+
+struct get_protocol_req {
+    wifi_interface_t ifx;
+};
+
+struct get_protocol_resp {
+    esp_err_t ret;
+    uint8_t protocol_bitmap;
+};
+
+struct set_bandwidth_req {
+    wifi_interface_t ifx;
+    wifi_bandwidth_t bw;
+};
+
+struct set_bandwidth_resp {
+    esp_err_t ret;
+};
+
+struct get_bandwidth_req {
+    wifi_interface_t ifx;
+};
+
+struct get_bandwidth_resp {
+    esp_err_t ret;
+    wifi_bandwidth_t bw;
+};
+
+struct set_channel_req {
+    uint8_t primary;
+    wifi_second_chan_t second;
+};
+
+struct set_channel_resp {
+    esp_err_t ret;
+};
+
+struct get_channel_resp {
+    esp_err_t ret;
+    uint8_t primary;
+    wifi_second_chan_t second;
+};
+
+struct set_country_req {
+    wifi_country_t country;
+};
+
+struct set_country_resp {
+    esp_err_t ret;
+};
+
+struct get_country_resp {
+    esp_err_t ret;
+    wifi_country_t country;
+};
+
+struct set_mac_req {
+    wifi_interface_t ifx;
+    uint8_t mac[6];
+};
+
+struct set_mac_resp {
+    esp_err_t ret;
+};
+
+struct get_mac_req {
+    wifi_interface_t ifx;
+};
+
+struct get_mac_resp {
+    esp_err_t ret;
+    uint8_t mac[6];
+};
+
+struct set_promiscuous_req {
+    bool en;
+};
+
+struct set_promiscuous_resp {
+    esp_err_t ret;
+};
+
+struct get_promiscuous_resp {
+    esp_err_t ret;
+    bool en;
+};
+
+struct set_promiscuous_filter_req {
+    wifi_promiscuous_filter_t filter;
+};
+
+struct set_promiscuous_filter_resp {
+    esp_err_t ret;
+};
+
+struct get_promiscuous_filter_resp {
+    esp_err_t ret;
+    wifi_promiscuous_filter_t filter;
+};
+
+struct set_promiscuous_ctrl_filter_req {
+    wifi_promiscuous_filter_t filter;
+};
+
+struct set_promiscuous_ctrl_filter_resp {
+    esp_err_t ret;
+};
+
+struct get_promiscuous_ctrl_filter_resp {
+    esp_err_t ret;
+    wifi_promiscuous_filter_t filter;
+};
+
+struct set_config_req {
+    wifi_interface_t interface;
+    wifi_config_t conf;
+};
+
+struct set_config_resp {
+    esp_err_t ret;
+};
+
+struct get_config_req {
+    wifi_interface_t interface;
+};
+
+struct get_config_resp {
+    esp_err_t ret;
+    wifi_config_t conf;
+};
+
+struct ap_get_sta_list_resp {
+    esp_err_t ret;
+    wifi_sta_list_t sta;
+};
+
+struct ap_get_sta_aid_req {
+    uint8_t mac[6];
+};
+
+struct ap_get_sta_aid_resp {
+    esp_err_t ret;
+    uint16_t aid;
+};
+
+struct set_storage_req {
+    wifi_storage_t storage;
+};
+
+struct set_storage_resp {
+    esp_err_t ret;
+};
+
+struct set_max_tx_power_req {
+    int8_t power;
+};
+
+struct set_max_tx_power_resp {
+    esp_err_t ret;
+};
+
+struct get_max_tx_power_resp {
+    esp_err_t ret;
+    int8_t power;
+};
+
+struct set_event_mask_req {
+    uint32_t mask;
+};
+
+struct set_event_mask_resp {
+    esp_err_t ret;
+};
+
+struct get_event_mask_resp {
+    esp_err_t ret;
+    uint32_t mask;
+};
+
+struct set_csi_config_req {
+    wifi_csi_config_t config;
+};
+
+struct set_csi_config_resp {
+    esp_err_t ret;
+};
+
+struct set_csi_req {
+    bool en;
+};
+
+struct set_csi_resp {
+    esp_err_t ret;
+};
+
+struct get_tsf_time_req {
+    wifi_interface_t interface;
+};
+
+struct get_tsf_time_resp {
+    int64_t ret;
+};
+
+struct set_inactive_time_req {
+    wifi_interface_t ifx;
+    uint16_t sec;
+};
+
+struct set_inactive_time_resp {
+    esp_err_t ret;
+};
+
+struct get_inactive_time_req {
+    wifi_interface_t ifx;
+};
+
+struct get_inactive_time_resp {
+    esp_err_t ret;
+    uint16_t sec;
+};
+
+struct statis_dump_req {
+    uint32_t modules;
+};
+
+struct statis_dump_resp {
+    esp_err_t ret;
+};
+
+struct set_rssi_threshold_req {
+    int32_t rssi;
+};
+
+struct set_rssi_threshold_resp {
+    esp_err_t ret;
+};
+
+struct ftm_initiate_session_req {
+    wifi_ftm_initiator_cfg_t cfg;
+};
+
+struct ftm_initiate_session_resp {
+    esp_err_t ret;
+};
+
+struct ftm_end_session_resp {
+    esp_err_t ret;
+};
+
+struct ftm_resp_set_offset_req {
+    int16_t offset_cm;
+};
+
+struct ftm_resp_set_offset_resp {
+    esp_err_t ret;
+};
+
+struct config_11b_rate_req {
+    wifi_interface_t ifx;
+    bool disable;
+};
+
+struct config_11b_rate_resp {
+    esp_err_t ret;
+};
+
+struct connectionless_module_set_wake_interval_req {
+    uint16_t wake_interval;
+};
+
+struct connectionless_module_set_wake_interval_resp {
+    esp_err_t ret;
+};
+
+struct force_wakeup_acquire_resp {
+    esp_err_t ret;
+};
+
+struct force_wakeup_release_resp {
+    esp_err_t ret;
+};
+
+struct set_country_code_req {
+    char country[3];
+    bool ieee80211d_enabled;
+};
+
+struct set_country_code_resp {
+    esp_err_t ret;
+};
+
+struct get_country_code_resp {
+    esp_err_t ret;
+    char country[3];
+};
+
+struct config_80211_tx_rate_req {
+    wifi_interface_t ifx;
+    wifi_phy_rate_t rate;
+};
+
+struct config_80211_tx_rate_resp {
+    esp_err_t ret;
+};
+
+struct disable_pmf_config_req {
+    wifi_interface_t ifx;
+};
+
+struct disable_pmf_config_resp {
+    esp_err_t ret;
+};
+
+struct sta_get_aid_resp {
+    esp_err_t ret;
+    uint16_t aid;
+};
+
+struct sta_get_negotiated_phymode_resp {
+    esp_err_t ret;
+    wifi_phy_mode_t phymode;
+};
+
+struct set_dynamic_cs_req {
+    bool enabled;
+};
+
+struct set_dynamic_cs_resp {
+    esp_err_t ret;
+};
+
+struct sta_get_rssi_resp {
+    esp_err_t ret;
+    int rssi;
+};
+
+}   // namespace api
+
+namespace client {
+/**
+ * @brief Sends the request and waits for the response (or returns the cached one)
+ */
+esp_err_t call(api_id id, const void *req, size_t req_size, void *resp, size_t resp_size);
+}
+
+namespace server {
+/**
+ * @brief Calls the API of the received request and sends the response
+ */
+esp_err_t dispatch(RpcEngine &rpc, RpcHeader &header);
+}
+
+}   // namespace eppp_rpc
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+#include <cstring>
+#include <new>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "wifi_remote_rpc_ids.hpp"
+
+namespace eppp_rpc {
+
+/**
+ * @brief Responses of read-mostly getters (client side)
+ *
+ * Entries are keyed by the API and the request. Calls which might change the state, events
+ * from the server and reconnections drop all of them. A response is stored only if no drop
+ * happened since its request was sent, so a getter racing with a setter doesn't store old data.
+ */
+class ResponseCache {
+public:
+    static constexpr int max_entries = 16;
+
+    esp_err_t init()
+    {
+        if (lock_ == nullptr) {
+            lock_ = xSemaphoreCreateMutex();
+        }
+        return lock_ == nullptr ? ESP_ERR_NO_MEM : ESP_OK;
+    }
+
+    bool get(api_id id, const void *req, size_t req_size, void *resp, size_t resp_size)
+    {
+        bool found = false;
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        for (auto &entry : entries_) {
+            if (entry.data != nullptr && entry.id == id && entry.req_size == req_size && entry.resp_size == resp_size &&
+                    (req_size == 0 || memcmp(entry.data, req, req_size) == 0)) {
+                memcpy(resp, entry.data + req_size, resp_size);
+                found = true;
+                break;
+            }
+        }
+        xSemaphoreGive(lock_);
+        return found;
+    }
+
+    /**
+     * @brief Stores the response, unless the cache has been invalidated after reading the generation
+     */
+    void put(api_id id, const void *req, size_t req_size, const void *resp, size_t resp_size, uint32_t generation)
+    {
+        auto data = new (std::nothrow) uint8_t[req_size + resp_size];
+        if (data == nullptr) {
+            return;
+        }
+        if (req_size > 0) {
+            memcpy(data, req, req_size);
+        }
+        memcpy(data + req_size, resp, resp_size);
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        if (generation == generation_) {
+            auto &entry = entries_[next_];  // replaces the oldest entry when full
+            next_ = (next_ + 1) % max_entries;
+            delete[] entry.data;
+            entry = { .id = id, .req_size = static_cast<uint32_t>(req_size), .resp_size = static_cast<uint32_t>(resp_size), .data = data };
+            data = nullptr;
+        }
+        xSemaphoreGive(lock_);
+        delete[] data;
+    }
+
+    uint32_t generation()
+    {
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        uint32_t generation = generation_;
+        xSemaphoreGive(lock_);
+        return generation;
+    }
+
+    void invalidate()
+    {
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        ++generation_;
+        for (auto &entry : entries_) {
+            delete[] entry.data;
+            entry.data = nullptr;
+        }
+        xSemaphoreGive(lock_);
+    }
+
+private:
+    struct Entry {
+        api_id id;
+        uint32_t req_size;
+        uint32_t resp_size;
+        uint8_t *data;      // request followed by the response
+    };
+    Entry entries_[max_entries] {};
+    int next_{0};
+    uint32_t generation_{0};
+    SemaphoreHandle_t lock_{nullptr};
+};
+
+}   // namespace eppp_rpc
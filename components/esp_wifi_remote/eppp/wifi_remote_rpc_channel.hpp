@@ -0,0 +1,542 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+#include <cstring>
+#include <cerrno>
+#include <cinttypes>
+#include <new>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/message_buffer.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/md.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/constant_time.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <sys/eventfd.h>
+#else
+#include "esp_random.h"
+#include "esp_vfs_eventfd.h"
+#endif
+
+namespace eppp_rpc {
+
+/**
+ * @brief Encrypted and authenticated message channel based on a pre-shared key
+ *
+ * Carries the RPC messages directly over the control channel of the eppp link, instead of TLS over TCP.
+ * The client opens a session in one round trip:
+ *   client -> server: HELLO | client nonce | tag |
+ *   server -> client: READY | server nonce | tag |
+ * Both ends derive the keys of both directions from the pre-shared key and the nonces (HMAC-SHA256)
+ * and seal every message with AES-256-GCM. The header of the message (type and counter) is the nonce
+ * of GCM, the counter grows with every message of one direction and older messages are dropped, so
+ * that they couldn't be replayed. The tag of HELLO (HMAC of the pre-shared key) proves that the client
+ * knows the key, the tag of READY proves that the server does. The server keeps its current session
+ * until the first request of the new one, so that a replayed HELLO can't break it.
+ * The server answers messages of an unknown session with RESET, so that the client opens a new one:
+ *   server -> client: RESET | tag |
+ * The counter and the tag of RESET are bound to the rejected message, the client accepts it only
+ * for one of its recent messages.
+ */
+class RpcChannel {
+public:
+    static constexpr size_t key_size = 32;
+    static constexpr size_t nonce_size = 16;
+    static constexpr size_t tag_size = 16;
+
+    enum class type : uint8_t {
+        HELLO = 1,
+        READY,
+        DATA,
+        RESET,
+    };
+
+    struct Header {
+        type t;
+        uint8_t reserved[3];
+        uint64_t counter;
+    } __attribute((__packed__));
+    static_assert(sizeof(Header) == 12, "Header is the nonce of GCM");
+
+    static constexpr size_t overhead = sizeof(Header) + tag_size;
+    static constexpr size_t reset_window = 16;     // recent messages of the client, which RESET might refer to
+
+    /**
+     * @brief Sends one message of the channel to the peer
+     */
+    using transmit_t = esp_err_t (*)(void *ctx, const void *data, size_t len);
+
+    /**
+     * @brief Allocates the buffers, the first call only (the peer's messages might arrive any time)
+     *
+     * @param server Server end of the channel
+     * @param psk Pre-shared key in hex (key_size bytes)
+     * @param max_message Largest plain message
+     * @param rx_size Size of the buffer of received messages, which wait for read()
+     */
+    esp_err_t open(bool server, const char *psk, size_t max_message, size_t rx_size, transmit_t transmit, void *ctx)
+    {
+        if (s_ != nullptr) {
+            return ESP_OK;
+        }
+        auto s = new (std::nothrow) Session();
+        if (s == nullptr) {
+            return ESP_ERR_NO_MEM;
+        }
+        if (!parse_key(psk, s->psk)) {
+            ESP_LOGE(TAG, "Pre-shared key has to be %d bytes in hex", (int) key_size);
+            delete s;
+            return ESP_ERR_INVALID_ARG;
+        }
+        s->tx = new (std::nothrow) uint8_t[max_message + overhead];
+        s->rx = new (std::nothrow) uint8_t[max_message + overhead];
+        s->messages = xMessageBufferCreate(rx_size);
+        s->lock = xSemaphoreCreateMutex();
+#if CONFIG_IDF_TARGET_LINUX
+        s->fd = eventfd(0, EFD_NONBLOCK);
+#else
+        esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+        esp_vfs_eventfd_register(&config);  // might have been registered already
+        s->fd = eventfd(0, 0);              // reads of eventfd don't block
+#endif
+        if (s->tx == nullptr || s->rx == nullptr || s->messages == nullptr || s->lock == nullptr || s->fd < 0) {
+            ESP_LOGE(TAG, "Failed to allocate the channel");
+            s->free();
+            delete s;
+            return ESP_ERR_NO_MEM;
+        }
+        for (auto &keys : s->keys) {
+            mbedtls_gcm_init(&keys.tx_gcm);
+            mbedtls_gcm_init(&keys.rx_gcm);
+        }
+        s->server = server;
+        s->max_message = max_message;
+        s->transmit = transmit;
+        s->ctx = ctx;
+        s_ = s;
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Receiver of the peer's messages (eppp_channel_rx_t), called from the I/O task of the link
+     */
+    static void receive(void *ctx, const void *data, size_t len)
+    {
+        auto s = static_cast<RpcChannel *>(ctx)->s_;
+        if (len < sizeof(Header) || len > s->max_message + overhead) {
+            return;
+        }
+        // decrypted in the reading task, so that the link isn't blocked by the crypto
+        if (xMessageBufferSend(s->messages, data, len, 0) != len) {
+            ESP_LOGW(TAG, "Receive buffer full, dropping a message of %d bytes", (int) len);
+            return;
+        }
+        uint64_t notify = 1;
+        ::write(s->fd, &notify, sizeof(notify));
+    }
+
+    /**
+     * @brief Client: opens a new session
+     */
+    esp_err_t connect(TickType_t timeout)
+    {
+        reset();
+        fill_random(s_->client_nonce, nonce_size);
+        auto hello = s_->tx;
+        Header head = { .t = type::HELLO, .reserved = {}, .counter = 0 };
+        memcpy(hello, &head, sizeof(head));
+        memcpy(hello + sizeof(head), s_->client_nonce, nonce_size);
+        ESP_RETURN_ON_FALSE(psk_tag(hello_label, hello, sizeof(head) + nonce_size, hello + sizeof(head) + nonce_size),
+                            ESP_FAIL, TAG, "Failed to authenticate HELLO");
+        ESP_RETURN_ON_ERROR(s_->transmit(s_->ctx, hello, sizeof(head) + nonce_size + tag_size), TAG, "Failed to send HELLO");
+        TickType_t start = xTaskGetTickCount();
+        while (!s_->established) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= timeout) {
+                return ESP_ERR_TIMEOUT;
+            }
+            size_t len = xMessageBufferReceive(s_->messages, s_->rx, s_->max_message + overhead, timeout - elapsed);
+            if (len > 0) {
+                process_ready(s_->rx, len);
+            }
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Server: waits for the first session, it is established by the client's first request
+     */
+    esp_err_t accept()
+    {
+        while (!s_->established && !s_->pending) {
+            size_t len = xMessageBufferReceive(s_->messages, s_->rx, s_->max_message + overhead, portMAX_DELAY);
+            if (len > 0) {
+                process(s_->rx, len, nullptr, 0);
+            }
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Closes the session, the next one is opened by connect() or by the client
+     */
+    void reset()
+    {
+        if (s_ == nullptr) {
+            return;
+        }
+        s_->established = false;
+        s_->pending = false;
+        xMessageBufferReset(s_->messages);
+    }
+
+    bool is_open()
+    {
+        return s_ != nullptr && (s_->established || s_->pending);
+    }
+
+    /**
+     * @brief Seals and sends one message, not thread safe
+     *
+     * @return len, or -1 on failure
+     */
+    int write(const uint8_t *data, size_t len)
+    {
+        if (!(s_->established || s_->pending) || len > s_->max_message) {
+            return -1;
+        }
+        // the server answers with the keys of the new session only after its first request
+        auto &keys = s_->established ? s_->keys[s_->current] : s_->keys[s_->current ^ 1];
+        Header head = { .t = type::DATA, .reserved = {}, .counter = ++keys.tx_counter };
+        auto out = s_->tx;
+        uint8_t *tag = out + sizeof(head) + len;
+        memcpy(out, &head, sizeof(head));
+        if (mbedtls_gcm_crypt_and_tag(&keys.tx_gcm, MBEDTLS_GCM_ENCRYPT, len, out, sizeof(head), out, sizeof(head),
+                                      data, out + sizeof(head), tag_size, tag) != 0) {
+            return -1;
+        }
+        if (!s_->server) {
+            auto &sent = s_->sent[head.counter % reset_window];
+            xSemaphoreTake(s_->lock, portMAX_DELAY);
+            sent.counter = head.counter;
+            memcpy(sent.tag, tag, tag_size);
+            xSemaphoreGive(s_->lock);
+        }
+        return s_->transmit(s_->ctx, out, sizeof(head) + len + tag_size) == ESP_OK ? len : -1;
+    }
+
+    /**
+     * @brief Reads one message, the whole message or nothing
+     *
+     * @return Size of the message, 0 if no message came in time (or it was a handshake or invalid),
+     *         -1 with errno ECONNRESET if the server lost the session
+     */
+    int read(uint8_t *data, size_t len, TickType_t timeout)
+    {
+        if (xMessageBufferIsEmpty(s_->messages)) {
+            uint64_t notified;
+            ::read(s_->fd, &notified, sizeof(notified));    // the next message notifies again
+        }
+        size_t size = xMessageBufferReceive(s_->messages, s_->rx, s_->max_message + overhead, timeout);
+        if (size == 0) {
+            return 0;
+        }
+        return process(s_->rx, size, data, len);
+    }
+
+    /**
+     * @brief Checks whether a message could be read without waiting
+     */
+    bool pending()
+    {
+        return !xMessageBufferIsEmpty(s_->messages);
+    }
+
+    /**
+     * @brief File descriptor, which is readable if a message has been received (for select())
+     */
+    int fd()
+    {
+        return s_ == nullptr ? -1 : s_->fd;
+    }
+
+private:
+    static constexpr const char *TAG = "rpc_channel";
+    static constexpr char hello_label[4] = "hlo";
+    static constexpr char reset_label[4] = "rst";
+    static_assert(tag_size == nonce_size, "HELLO and RESET authenticate a header and one block");
+
+    struct Keys {
+        mbedtls_gcm_context tx_gcm;
+        mbedtls_gcm_context rx_gcm;
+        uint64_t tx_counter;
+        uint64_t rx_counter;    // last accepted counter of the peer
+    };
+
+    struct Sent {
+        uint64_t counter;
+        uint8_t tag[tag_size];
+    };
+
+    struct Session {
+        bool server;
+        bool established;
+        bool pending;           // server: the keys of a new session wait for its first request
+        size_t max_message;
+        transmit_t transmit;
+        void *ctx;
+        MessageBufferHandle_t messages;
+        SemaphoreHandle_t lock;     // client: protects sent, written by the calling tasks, read by the receiving one
+        int fd{-1};
+        uint8_t *tx;
+        uint8_t *rx;
+        uint8_t psk[key_size];
+        uint8_t client_nonce[nonce_size];
+        Keys keys[2];               // current session and the next one
+        int current;
+        Sent sent[reset_window];
+
+        void free()
+        {
+            delete[] tx;
+            delete[] rx;
+            if (messages) {
+                vMessageBufferDelete(messages);
+            }
+            if (lock) {
+                vSemaphoreDelete(lock);
+            }
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    };
+
+    static bool parse_key(const char *hex, uint8_t *key)
+    {
+        if (strlen(hex) != 2 * key_size) {
+            return false;
+        }
+        for (size_t i = 0; i < 2 * key_size; ++i) {
+            char c = hex[i];
+            int nibble = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (nibble < 0) {
+                return false;
+            }
+            key[i / 2] = (i % 2) ? (key[i / 2] | nibble) : (nibble << 4);
+        }
+        return true;
+    }
+
+    static void fill_random(uint8_t *buf, size_t len)
+    {
+#if CONFIG_IDF_TARGET_LINUX
+        if (getentropy(buf, len) != 0) {
+            ESP_LOGE(TAG, "Failed to get random nonce");
+        }
+#else
+        esp_fill_random(buf, len);
+#endif
+    }
+
+    /**
+     * @brief Tag of HELLO and RESET: authenticates the header and the data with the pre-shared key
+     */
+    bool psk_tag(const char *label, const uint8_t *data, size_t len, uint8_t *tag)
+    {
+        uint8_t input[sizeof(hello_label) + sizeof(Header) + nonce_size];
+        uint8_t mac[32];    // SHA256
+        if (sizeof(hello_label) + len > sizeof(input)) {
+            return false;
+        }
+        memcpy(input, label, sizeof(hello_label));
+        memcpy(input + sizeof(hello_label), data, len);
+        bool ok = mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), s_->psk, key_size, input, sizeof(hello_label) + len, mac) == 0;
+        memcpy(tag, mac, tag_size);
+        return ok;
+    }
+
+    /**
+     * @brief Derives the keys of both directions of the session from the pre-shared key and the nonces
+     */
+    bool derive_keys(Keys &keys, const uint8_t *server_nonce)
+    {
+        static constexpr char client_label[4] = "c2s";
+        static constexpr char server_label[4] = "s2c";
+        uint8_t input[sizeof(client_label) + 2 * nonce_size];
+        uint8_t key[key_size];
+        auto md = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+        bool ok = true;
+        memcpy(input + sizeof(client_label), s_->client_nonce, nonce_size);
+        memcpy(input + sizeof(client_label) + nonce_size, server_nonce, nonce_size);
+        static constexpr bool directions[] = { true, false };    // client to server, server to client
+        for (bool client_to_server : directions) {
+            memcpy(input, client_to_server ? client_label : server_label, sizeof(client_label));
+            bool tx = client_to_server != s_->server;
+            ok = ok && mbedtls_md_hmac(md, s_->psk, key_size, input, sizeof(input), key) == 0 &&
+                 mbedtls_gcm_setkey(tx ? &keys.tx_gcm : &keys.rx_gcm, MBEDTLS_CIPHER_ID_AES, key, key_size * 8) == 0;
+        }
+        mbedtls_platform_zeroize(key, sizeof(key));
+        keys.tx_counter = 0;
+        keys.rx_counter = 0;
+        return ok;
+    }
+
+    /**
+     * @brief Tag of READY: authenticates the server's nonce and binds it to the client's one
+     */
+    bool ready_tag(Keys &keys, const Header &head, const uint8_t *server_nonce, uint8_t *tag)
+    {
+        uint8_t aad[2 * nonce_size];
+        memcpy(aad, s_->client_nonce, nonce_size);
+        memcpy(aad + nonce_size, server_nonce, nonce_size);
+        auto gcm = s_->server ? &keys.tx_gcm : &keys.rx_gcm;
+        return mbedtls_gcm_crypt_and_tag(gcm, MBEDTLS_GCM_ENCRYPT, 0, reinterpret_cast<const uint8_t *>(&head), sizeof(head),
+                                         aad, sizeof(aad), nullptr, nullptr, tag_size, tag) == 0;
+    }
+
+    void process_ready(const uint8_t *msg, size_t len)
+    {
+        Header head;
+        memcpy(&head, msg, sizeof(head));
+        if (head.t != type::READY || len != sizeof(head) + nonce_size + tag_size) {
+            return;
+        }
+        const uint8_t *server_nonce = msg + sizeof(head);
+        uint8_t tag[tag_size];
+        auto &keys = s_->keys[s_->current ^ 1];
+        if (!derive_keys(keys, server_nonce) || !ready_tag(keys, head, server_nonce, tag) ||
+                mbedtls_ct_memcmp(tag, server_nonce + nonce_size, tag_size) != 0) {
+            ESP_LOGE(TAG, "Server failed to authenticate, check the pre-shared key");
+            return;
+        }
+        s_->current ^= 1;
+        s_->established = true;
+    }
+
+    void process_hello(const uint8_t *msg, size_t len)
+    {
+        uint8_t tag[tag_size];
+        if (len != sizeof(Header) + nonce_size + tag_size || !psk_tag(hello_label, msg, sizeof(Header) + nonce_size, tag) ||
+                mbedtls_ct_memcmp(tag, msg + sizeof(Header) + nonce_size, tag_size) != 0) {
+            ESP_LOGW(TAG, "Client failed to authenticate, check the pre-shared key");
+            return;
+        }
+        memcpy(s_->client_nonce, msg + sizeof(Header), nonce_size);
+        Header head = { .t = type::READY, .reserved = {}, .counter = 0 };
+        auto ready = s_->tx;
+        uint8_t *server_nonce = ready + sizeof(head);
+        auto &keys = s_->keys[s_->current ^ 1];
+        fill_random(server_nonce, nonce_size);
+        memcpy(ready, &head, sizeof(head));
+        if (!derive_keys(keys, server_nonce) || !ready_tag(keys, head, server_nonce, server_nonce + nonce_size)) {
+            s_->pending = false;
+            return;
+        }
+        // the client is authenticated by its first request, until then the current session stays
+        s_->pending = s_->transmit(s_->ctx, ready, sizeof(head) + nonce_size + tag_size) == ESP_OK;
+    }
+
+    /**
+     * @brief Server: answers a message of an unknown session, the tag binds RESET to the message
+     */
+    void send_reset(const Header &rejected_head, const uint8_t *msg, size_t size)
+    {
+        uint8_t rejected[sizeof(Header) + tag_size];
+        memcpy(rejected, msg, sizeof(Header));
+        memcpy(rejected + sizeof(Header), msg + sizeof(Header) + size, tag_size);
+        uint8_t reset[sizeof(Header) + tag_size];
+        Header head = { .t = type::RESET, .reserved = {}, .counter = rejected_head.counter };
+        memcpy(reset, &head, sizeof(head));
+        if (psk_tag(reset_label, rejected, sizeof(rejected), reset + sizeof(head))) {
+            s_->transmit(s_->ctx, reset, sizeof(reset));
+        }
+    }
+
+    /**
+     * @brief Client: checks that RESET comes from the server and refers to one of our recent messages
+     */
+    bool process_reset(const Header &head, const uint8_t *msg, size_t len)
+    {
+        if (len != sizeof(Header) + tag_size || head.counter == 0) {
+            return false;
+        }
+        uint8_t rejected[sizeof(Header) + tag_size];
+        Header data = { .t = type::DATA, .reserved = {}, .counter = head.counter };
+        memcpy(rejected, &data, sizeof(data));
+        auto &sent = s_->sent[head.counter % reset_window];
+        xSemaphoreTake(s_->lock, portMAX_DELAY);
+        bool recent = sent.counter == head.counter;
+        memcpy(rejected + sizeof(data), sent.tag, tag_size);
+        xSemaphoreGive(s_->lock);
+        uint8_t tag[tag_size];
+        return recent && psk_tag(reset_label, rejected, sizeof(rejected), tag) &&
+               mbedtls_ct_memcmp(tag, msg + sizeof(Header), tag_size) == 0;
+    }
+
+    bool decrypt(Keys &keys, const Header &head, const uint8_t *msg, size_t size, uint8_t *data)
+    {
+        if (head.counter <= keys.rx_counter ||
+                mbedtls_gcm_auth_decrypt(&keys.rx_gcm, size, msg, sizeof(head), msg, sizeof(head),
+                                         msg + sizeof(head) + size, tag_size, msg + sizeof(head), data) != 0) {
+            return false;
+        }
+        keys.rx_counter = head.counter;
+        return true;
+    }
+
+    int process(const uint8_t *msg, size_t len, uint8_t *data, size_t data_len)
+    {
+        Header head;
+        memcpy(&head, msg, sizeof(head));
+        if (head.t == type::HELLO && s_->server) {
+            process_hello(msg, len);
+            return 0;
+        }
+        if (head.t == type::RESET && !s_->server) {
+            if (!process_reset(head, msg, len)) {
+                ESP_LOGW(TAG, "Dropping invalid RESET (counter %" PRIu64 ")", head.counter);
+                return 0;
+            }
+            ESP_LOGW(TAG, "Server lost the session");
+            s_->established = false;
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (head.t != type::DATA || len < overhead) {
+            return 0;
+        }
+        size_t size = len - overhead;
+        if (size <= data_len) {
+            if (s_->established && decrypt(s_->keys[s_->current], head, msg, size, data)) {
+                return size;
+            }
+            if (s_->pending && decrypt(s_->keys[s_->current ^ 1], head, msg, size, data)) {
+                // the first request of the new session authenticates the client
+                s_->current ^= 1;
+                s_->pending = false;
+                s_->established = true;
+                ESP_LOGI(TAG, "New session");
+                return size;
+            }
+        }
+        if (s_->server && !s_->established) {
+            send_reset(head, msg, size);
+            return 0;
+        }
+        ESP_LOGW(TAG, "Dropping invalid or replayed message (counter %" PRIu64 ")", head.counter);
+        return 0;
+    }
+
+    Session *s_{nullptr};
+};
+
+}   // namespace eppp_rpc
@@ -0,0 +1,740 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// This file is auto-generated
+#include <cstring>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "wifi_remote_rpc_api.hpp"
+
+using namespace eppp_rpc;
+
+static const char *TAG = "rpc_client";
+
+
+extern "C" esp_err_t esp_wifi_remote_deinit(void)
+{
+    api::deinit_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::DEINIT, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call DEINIT");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_mode(wifi_mode_t mode)
+{
+    api::set_mode_req req = {};
+    req.mode = mode;
+    api::set_mode_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_MODE, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_MODE");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_mode(wifi_mode_t *mode)
+{
+    if (mode == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_mode_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_MODE, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_MODE");
+    if (resp.ret == ESP_OK) {
+        *mode = resp.mode;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_start(void)
+{
+    api::start_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::START, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call START");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_stop(void)
+{
+    api::stop_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::STOP, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call STOP");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_restore(void)
+{
+    api::restore_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::RESTORE, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call RESTORE");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_connect(void)
+{
+    api::connect_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::CONNECT, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call CONNECT");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_disconnect(void)
+{
+    api::disconnect_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::DISCONNECT, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call DISCONNECT");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_clear_fast_connect(void)
+{
+    api::clear_fast_connect_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::CLEAR_FAST_CONNECT, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call CLEAR_FAST_CONNECT");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_deauth_sta(uint16_t aid)
+{
+    api::deauth_sta_req req = {};
+    req.aid = aid;
+    api::deauth_sta_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::DEAUTH_STA, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call DEAUTH_STA");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_scan_stop(void)
+{
+    api::scan_stop_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SCAN_STOP, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call SCAN_STOP");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_scan_get_ap_num(uint16_t *number)
+{
+    if (number == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::scan_get_ap_num_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SCAN_GET_AP_NUM, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call SCAN_GET_AP_NUM");
+    if (resp.ret == ESP_OK) {
+        *number = resp.number;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_scan_get_ap_record(wifi_ap_record_t *ap_record)
+{
+    if (ap_record == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::scan_get_ap_record_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SCAN_GET_AP_RECORD, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call SCAN_GET_AP_RECORD");
+    if (resp.ret == ESP_OK) {
+        *ap_record = resp.ap_record;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_clear_ap_list(void)
+{
+    api::clear_ap_list_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::CLEAR_AP_LIST, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call CLEAR_AP_LIST");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_sta_get_ap_info(wifi_ap_record_t *ap_info)
+{
+    if (ap_info == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::sta_get_ap_info_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::STA_GET_AP_INFO, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call STA_GET_AP_INFO");
+    if (resp.ret == ESP_OK) {
+        *ap_info = resp.ap_info;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_ps(wifi_ps_type_t type)
+{
+    api::set_ps_req req = {};
+    req.type = type;
+    api::set_ps_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_PS, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_PS");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_ps(wifi_ps_type_t *type)
+{
+    if (type == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_ps_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_PS, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_PS");
+    if (resp.ret == ESP_OK) {
+        *type = resp.type;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_protocol(wifi_interface_t ifx, uint8_t protocol_bitmap)
+{
+    api::set_protocol_req req = {};
+    req.ifx = ifx;
+    req.protocol_bitmap = protocol_bitmap;
+    api::set_protocol_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_PROTOCOL, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_PROTOCOL");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_protocol(wifi_interface_t ifx, uint8_t *protocol_bitmap)
+{
+    if (protocol_bitmap == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_protocol_req req = {};
+    req.ifx = ifx;
+    api::get_protocol_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_PROTOCOL, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call GET_PROTOCOL");
+    if (resp.ret == ESP_OK) {
+        *protocol_bitmap = resp.protocol_bitmap;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_bandwidth(wifi_interface_t ifx, wifi_bandwidth_t bw)
+{
+    api::set_bandwidth_req req = {};
+    req.ifx = ifx;
+    req.bw = bw;
+    api::set_bandwidth_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_BANDWIDTH, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_BANDWIDTH");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_bandwidth(wifi_interface_t ifx, wifi_bandwidth_t *bw)
+{
+    if (bw == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_bandwidth_req req = {};
+    req.ifx = ifx;
+    api::get_bandwidth_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_BANDWIDTH, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call GET_BANDWIDTH");
+    if (resp.ret == ESP_OK) {
+        *bw = resp.bw;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+    api::set_channel_req req = {};
+    req.primary = primary;
+    req.second = second;
+    api::set_channel_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_CHANNEL, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_CHANNEL");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_channel(uint8_t *primary, wifi_second_chan_t *second)
+{
+    if (primary == nullptr || second == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_channel_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_CHANNEL, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_CHANNEL");
+    if (resp.ret == ESP_OK) {
+        *primary = resp.primary;
+        *second = resp.second;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_country(const wifi_country_t *country)
+{
+    if (country == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::set_country_req req = {};
+    req.country = *country;
+    api::set_country_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_COUNTRY, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_COUNTRY");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_country(wifi_country_t *country)
+{
+    if (country == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_country_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_COUNTRY, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_COUNTRY");
+    if (resp.ret == ESP_OK) {
+        *country = resp.country;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_mac(wifi_interface_t ifx, const uint8_t mac[6])
+{
+    if (mac == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::set_mac_req req = {};
+    req.ifx = ifx;
+    memcpy(req.mac, mac, sizeof(req.mac));
+    api::set_mac_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_MAC, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_MAC");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+    if (mac == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_mac_req req = {};
+    req.ifx = ifx;
+    api::get_mac_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_MAC, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call GET_MAC");
+    if (resp.ret == ESP_OK) {
+        memcpy(mac, resp.mac, sizeof(resp.mac));
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_promiscuous(bool en)
+{
+    api::set_promiscuous_req req = {};
+    req.en = en;
+    api::set_promiscuous_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_PROMISCUOUS, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_PROMISCUOUS");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_promiscuous(bool *en)
+{
+    if (en == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_promiscuous_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_PROMISCUOUS, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_PROMISCUOUS");
+    if (resp.ret == ESP_OK) {
+        *en = resp.en;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_promiscuous_filter(const wifi_promiscuous_filter_t *filter)
+{
+    if (filter == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::set_promiscuous_filter_req req = {};
+    req.filter = *filter;
+    api::set_promiscuous_filter_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_PROMISCUOUS_FILTER, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_PROMISCUOUS_FILTER");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_promiscuous_filter(wifi_promiscuous_filter_t *filter)
+{
+    if (filter == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_promiscuous_filter_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_PROMISCUOUS_FILTER, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_PROMISCUOUS_FILTER");
+    if (resp.ret == ESP_OK) {
+        *filter = resp.filter;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_promiscuous_ctrl_filter(const wifi_promiscuous_filter_t *filter)
+{
+    if (filter == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::set_promiscuous_ctrl_filter_req req = {};
+    req.filter = *filter;
+    api::set_promiscuous_ctrl_filter_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_PROMISCUOUS_CTRL_FILTER, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_PROMISCUOUS_CTRL_FILTER");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_promiscuous_ctrl_filter(wifi_promiscuous_filter_t *filter)
+{
+    if (filter == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_promiscuous_ctrl_filter_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_PROMISCUOUS_CTRL_FILTER, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_PROMISCUOUS_CTRL_FILTER");
+    if (resp.ret == ESP_OK) {
+        *filter = resp.filter;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (conf == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::set_config_req req = {};
+    req.interface = interface;
+    req.conf = *conf;
+    api::set_config_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_CONFIG, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_CONFIG");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (conf == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_config_req req = {};
+    req.interface = interface;
+    api::get_config_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_CONFIG, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call GET_CONFIG");
+    if (resp.ret == ESP_OK) {
+        *conf = resp.conf;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_ap_get_sta_list(wifi_sta_list_t *sta)
+{
+    if (sta == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::ap_get_sta_list_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::AP_GET_STA_LIST, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call AP_GET_STA_LIST");
+    if (resp.ret == ESP_OK) {
+        *sta = resp.sta;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_ap_get_sta_aid(const uint8_t mac[6], uint16_t *aid)
+{
+    if (mac == nullptr || aid == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::ap_get_sta_aid_req req = {};
+    memcpy(req.mac, mac, sizeof(req.mac));
+    api::ap_get_sta_aid_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::AP_GET_STA_AID, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call AP_GET_STA_AID");
+    if (resp.ret == ESP_OK) {
+        *aid = resp.aid;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_storage(wifi_storage_t storage)
+{
+    api::set_storage_req req = {};
+    req.storage = storage;
+    api::set_storage_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_STORAGE, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_STORAGE");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_max_tx_power(int8_t power)
+{
+    api::set_max_tx_power_req req = {};
+    req.power = power;
+    api::set_max_tx_power_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_MAX_TX_POWER, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_MAX_TX_POWER");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_max_tx_power(int8_t *power)
+{
+    if (power == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_max_tx_power_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_MAX_TX_POWER, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_MAX_TX_POWER");
+    if (resp.ret == ESP_OK) {
+        *power = resp.power;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_event_mask(uint32_t mask)
+{
+    api::set_event_mask_req req = {};
+    req.mask = mask;
+    api::set_event_mask_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_EVENT_MASK, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_EVENT_MASK");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_event_mask(uint32_t *mask)
+{
+    if (mask == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_event_mask_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_EVENT_MASK, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_EVENT_MASK");
+    if (resp.ret == ESP_OK) {
+        *mask = resp.mask;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_csi_config(const wifi_csi_config_t *config)
+{
+    if (config == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::set_csi_config_req req = {};
+    req.config = *config;
+    api::set_csi_config_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_CSI_CONFIG, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_CSI_CONFIG");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_csi(bool en)
+{
+    api::set_csi_req req = {};
+    req.en = en;
+    api::set_csi_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_CSI, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_CSI");
+    return resp.ret;
+}
+
+extern "C" int64_t esp_wifi_remote_get_tsf_time(wifi_interface_t interface)
+{
+    api::get_tsf_time_req req = {};
+    req.interface = interface;
+    api::get_tsf_time_resp resp = {};
+    ESP_RETURN_ON_FALSE(client::call(api_id::GET_TSF_TIME, &req, sizeof(req), &resp, sizeof(resp)) == ESP_OK, -1, TAG, "Failed to call GET_TSF_TIME");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_inactive_time(wifi_interface_t ifx, uint16_t sec)
+{
+    api::set_inactive_time_req req = {};
+    req.ifx = ifx;
+    req.sec = sec;
+    api::set_inactive_time_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_INACTIVE_TIME, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_INACTIVE_TIME");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_inactive_time(wifi_interface_t ifx, uint16_t *sec)
+{
+    if (sec == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_inactive_time_req req = {};
+    req.ifx = ifx;
+    api::get_inactive_time_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_INACTIVE_TIME, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call GET_INACTIVE_TIME");
+    if (resp.ret == ESP_OK) {
+        *sec = resp.sec;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_statis_dump(uint32_t modules)
+{
+    api::statis_dump_req req = {};
+    req.modules = modules;
+    api::statis_dump_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::STATIS_DUMP, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call STATIS_DUMP");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_rssi_threshold(int32_t rssi)
+{
+    api::set_rssi_threshold_req req = {};
+    req.rssi = rssi;
+    api::set_rssi_threshold_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_RSSI_THRESHOLD, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_RSSI_THRESHOLD");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_ftm_initiate_session(wifi_ftm_initiator_cfg_t *cfg)
+{
+    if (cfg == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::ftm_initiate_session_req req = {};
+    req.cfg = *cfg;
+    api::ftm_initiate_session_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::FTM_INITIATE_SESSION, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call FTM_INITIATE_SESSION");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_ftm_end_session(void)
+{
+    api::ftm_end_session_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::FTM_END_SESSION, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call FTM_END_SESSION");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_ftm_resp_set_offset(int16_t offset_cm)
+{
+    api::ftm_resp_set_offset_req req = {};
+    req.offset_cm = offset_cm;
+    api::ftm_resp_set_offset_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::FTM_RESP_SET_OFFSET, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call FTM_RESP_SET_OFFSET");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_config_11b_rate(wifi_interface_t ifx, bool disable)
+{
+    api::config_11b_rate_req req = {};
+    req.ifx = ifx;
+    req.disable = disable;
+    api::config_11b_rate_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::CONFIG_11B_RATE, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call CONFIG_11B_RATE");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_connectionless_module_set_wake_interval(uint16_t wake_interval)
+{
+    api::connectionless_module_set_wake_interval_req req = {};
+    req.wake_interval = wake_interval;
+    api::connectionless_module_set_wake_interval_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::CONNECTIONLESS_MODULE_SET_WAKE_INTERVAL, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call CONNECTIONLESS_MODULE_SET_WAKE_INTERVAL");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_force_wakeup_acquire(void)
+{
+    api::force_wakeup_acquire_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::FORCE_WAKEUP_ACQUIRE, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call FORCE_WAKEUP_ACQUIRE");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_force_wakeup_release(void)
+{
+    api::force_wakeup_release_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::FORCE_WAKEUP_RELEASE, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call FORCE_WAKEUP_RELEASE");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_country_code(const char *country, bool ieee80211d_enabled)
+{
+    if (country == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::set_country_code_req req = {};
+    memcpy(req.country, country, sizeof(req.country));
+    req.ieee80211d_enabled = ieee80211d_enabled;
+    api::set_country_code_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_COUNTRY_CODE, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_COUNTRY_CODE");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_get_country_code(char *country)
+{
+    if (country == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::get_country_code_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::GET_COUNTRY_CODE, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call GET_COUNTRY_CODE");
+    if (resp.ret == ESP_OK) {
+        memcpy(country, resp.country, sizeof(resp.country));
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_config_80211_tx_rate(wifi_interface_t ifx, wifi_phy_rate_t rate)
+{
+    api::config_80211_tx_rate_req req = {};
+    req.ifx = ifx;
+    req.rate = rate;
+    api::config_80211_tx_rate_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::CONFIG_80211_TX_RATE, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call CONFIG_80211_TX_RATE");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_disable_pmf_config(wifi_interface_t ifx)
+{
+    api::disable_pmf_config_req req = {};
+    req.ifx = ifx;
+    api::disable_pmf_config_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::DISABLE_PMF_CONFIG, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call DISABLE_PMF_CONFIG");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_sta_get_aid(uint16_t *aid)
+{
+    if (aid == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::sta_get_aid_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::STA_GET_AID, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call STA_GET_AID");
+    if (resp.ret == ESP_OK) {
+        *aid = resp.aid;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_sta_get_negotiated_phymode(wifi_phy_mode_t *phymode)
+{
+    if (phymode == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::sta_get_negotiated_phymode_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::STA_GET_NEGOTIATED_PHYMODE, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call STA_GET_NEGOTIATED_PHYMODE");
+    if (resp.ret == ESP_OK) {
+        *phymode = resp.phymode;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_dynamic_cs(bool enabled)
+{
+    api::set_dynamic_cs_req req = {};
+    req.enabled = enabled;
+    api::set_dynamic_cs_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::SET_DYNAMIC_CS, &req, sizeof(req), &resp, sizeof(resp)), TAG, "Failed to call SET_DYNAMIC_CS");
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_sta_get_rssi(int *rssi)
+{
+    if (rssi == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    api::sta_get_rssi_resp resp = {};
+    ESP_RETURN_ON_ERROR(client::call(api_id::STA_GET_RSSI, nullptr, 0, &resp, sizeof(resp)), TAG, "Failed to call STA_GET_RSSI");
+    if (resp.ret == ESP_OK) {
+        *rssi = resp.rssi;
+    }
+    return resp.ret;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb)
+{
+    // not marshalled: callbacks or variable length data
+    ESP_LOGW(TAG, "%s unsupported", __func__);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_vendor_ie_cb(esp_vendor_ie_cb_t cb, void *ctx)
+{
+    // not marshalled: callbacks or variable length data
+    ESP_LOGW(TAG, "%s unsupported", __func__);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" esp_err_t esp_wifi_remote_80211_tx(wifi_interface_t ifx, const void *buffer, int len, bool en_sys_seq)
+{
+    // not marshalled: callbacks or variable length data
+    ESP_LOGW(TAG, "%s unsupported", __func__);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" esp_err_t esp_wifi_remote_set_csi_rx_cb(wifi_csi_cb_t cb, void *ctx)
+{
+    // not marshalled: callbacks or variable length data
+    ESP_LOGW(TAG, "%s unsupported", __func__);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" esp_err_t esp_wifi_remote_ftm_get_report(wifi_ftm_report_entry_t *report, uint8_t num_entries)
+{
+    // not marshalled: callbacks or variable length data
+    ESP_LOGW(TAG, "%s unsupported", __func__);
+    return ESP_ERR_NOT_SUPPORTED;
+}
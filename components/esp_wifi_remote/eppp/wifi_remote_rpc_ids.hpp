@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// This file is auto-generated
+#pragma once
+
+#include <cstdint>
+
+namespace eppp_rpc {
+
+/**
+ * @brief Currently supported RPC commands/events
+ */
+enum class api_id : uint32_t {
+    ERROR,
+    UNDEF,
+    WIFI_EVENT,
+    IP_EVENT,
+    INIT,
+    DEINIT,
+    SET_MODE,
+    GET_MODE,
+    START,
+    STOP,
+    RESTORE,
+    CONNECT,
+    DISCONNECT,
+    CLEAR_FAST_CONNECT,
+    DEAUTH_STA,
+    SCAN_START,
+    SCAN_STOP,
+    SCAN_GET_AP_NUM,
+    SCAN_GET_AP_RECORDS,
+    SCAN_GET_AP_RECORD,
+    CLEAR_AP_LIST,
+    STA_GET_AP_INFO,
+    SET_PS,
+    GET_PS,
+    SET_PROTOCOL,
+    GET_PROTOCOL,
+    SET_BANDWIDTH,
+    GET_BANDWIDTH,
+    SET_CHANNEL,
+    GET_CHANNEL,
+    SET_COUNTRY,
+    GET_COUNTRY,
+    SET_MAC,
+    GET_MAC,
+    SET_PROMISCUOUS,
+    GET_PROMISCUOUS,
+    SET_PROMISCUOUS_FILTER,
+    GET_PROMISCUOUS_FILTER,
+    SET_PROMISCUOUS_CTRL_FILTER,
+    GET_PROMISCUOUS_CTRL_FILTER,
+    SET_CONFIG,
+    GET_CONFIG,
+    AP_GET_STA_LIST,
+    AP_GET_STA_AID,
+    SET_STORAGE,
+    SET_VENDOR_IE,
+    SET_MAX_TX_POWER,
+    GET_MAX_TX_POWER,
+    SET_EVENT_MASK,
+    GET_EVENT_MASK,
+    SET_CSI_CONFIG,
+    SET_CSI,
+    GET_TSF_TIME,
+    SET_INACTIVE_TIME,
+    GET_INACTIVE_TIME,
+    STATIS_DUMP,
+    SET_RSSI_THRESHOLD,
+    FTM_INITIATE_SESSION,
+    FTM_END_SESSION,
+    FTM_RESP_SET_OFFSET,
+    CONFIG_11B_RATE,
+    CONNECTIONLESS_MODULE_SET_WAKE_INTERVAL,
+    FORCE_WAKEUP_ACQUIRE,
+    FORCE_WAKEUP_RELEASE,
+    SET_COUNTRY_CODE,
+    GET_COUNTRY_CODE,
+    CONFIG_80211_TX_RATE,
+    DISABLE_PMF_CONFIG,
+    STA_GET_AID,
+    STA_GET_NEGOTIATED_PHYMODE,
+    SET_DYNAMIC_CS,
+    STA_GET_RSSI,
+};
+
+}   // namespace eppp_rpc
@@ -6,30 +6,20 @@
 #pragma once
 #include <cstring>
 #include <cerrno>
+#include <new>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "wifi_remote_rpc_ids.hpp"
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+#include "wifi_remote_rpc_channel.hpp"
+#endif
 
 namespace eppp_rpc {
 
 static constexpr int rpc_port = 3333;
-
-/**
- * @brief Currently supported RPC commands/events
- */
-enum class api_id : uint32_t {
-    ERROR,
-    UNDEF,
-    INIT,
-    DEINIT,
-    SET_MODE,
-    SET_CONFIG,
-    START,
-    STOP,
-    CONNECT,
-    DISCONNECT,
-    GET_MAC,
-    SET_STORAGE,
-    WIFI_EVENT,
-    IP_EVENT,
-};
+static constexpr uint32_t event_seq = 0;         // correlation ID of the events sent by the server
+static constexpr size_t max_message_size = 1024; // header and payload of one RPC message
 
 enum class role {
     SERVER,
@@ -38,6 +28,7 @@ enum class role {
 
 struct RpcHeader {
     api_id id;
+    uint32_t seq;       // correlation ID: responses carry the ID of their request
     uint32_t size;
 } __attribute((__packed__));
 
@@ -48,19 +39,12 @@ template<typename T>
 struct RpcData {
     RpcHeader head;
     T value_{};
-    explicit RpcData(api_id id) : head{id, sizeof(T)} {}
+    RpcData(api_id id, uint32_t seq) : head{id, seq, sizeof(T)} {}
 
     uint8_t *value()
     {
         return (uint8_t *) &value_;
     }
-
-    uint8_t *marshall(T *t, size_t &size)
-    {
-        size = head.size + sizeof(RpcHeader);
-        memcpy(value(), t, sizeof(T));
-        return (uint8_t *) this;
-    }
 } __attribute((__packed__));
 
 /**
@@ -70,58 +54,70 @@ class RpcInstance;
 
 /**
  * @brief Engine that implements a simple RPC mechanism
+ *
+ * The messages are exchanged over TLS connection, or over the PSK authenticated control channel
+ * of the eppp link (CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL).
  */
 class RpcEngine {
 public:
-    constexpr explicit RpcEngine(role r) : tls_(nullptr), role_(r) {}
+    constexpr explicit RpcEngine(role r) : role_(r) {}
 
     esp_err_t init()
     {
-        if (tls_ != nullptr) {
+        if (connected()) {
             return ESP_OK;
         }
+        int64_t start = esp_timer_get_time();
         if (role_ == role::CLIENT) {
             instance = init_client();
         }
         if (role_ == role::SERVER) {
             instance = init_server();
         }
-        return instance == nullptr ? ESP_FAIL : ESP_OK;
+        if (instance == nullptr) {
+            return ESP_FAIL;
+        }
+        ESP_LOGI("rpc", "Connected in %" PRIi64 " ms", (esp_timer_get_time() - start) / 1000);
+        return ESP_OK;
     }
 
     void deinit()
     {
-        if (tls_ == nullptr) {
+        if (!connected()) {
             return;
         }
-        if (role_ == role::CLIENT) {
-            esp_tls_conn_destroy(tls_);
-        } else if (role_ == role::SERVER) {
-            esp_tls_server_session_delete(tls_);
-        }
-        tls_ = nullptr;
+        disconnect();
+        rx_start_ = rx_fill_ = 0;
     }
 
-    template<typename T>
-    esp_err_t send(api_id id, T *t)
-    {
-        RpcData<T> req(id);
-        size_t size;
-        auto buf = req.marshall(t, size);
-        ESP_LOGD("rpc", "Sending API id:%d", (int) id);
-        ESP_LOG_BUFFER_HEXDUMP("rpc", buf, size, ESP_LOG_VERBOSE);
-        int len = esp_tls_conn_write(tls_, buf, size);
-        if (len <= 0) {
-            ESP_LOGE("rpc", "Failed to write data to the connection");
-            return ESP_FAIL;
-        }
-        return ESP_OK;
+    /**
+     * @brief Sends one message, the header and the payload in one write
+     *
+     * Not thread safe, the callers serialize the messages they send.
+     */
+    esp_err_t send(api_id id, uint32_t seq, const void *data, size_t size)
+    {
+        return send(id, seq, data, size, size);
     }
 
-    esp_err_t send(api_id id) // overload for (void)
+    /**
+     * @brief Sends a payload of size bytes, of which only the first data_len bytes come from data, the rest is zeroed
+     */
+    esp_err_t send(api_id id, uint32_t seq, const void *data, size_t data_len, size_t size)
     {
-        RpcHeader head = {.id = id, .size = 0};
-        int len = esp_tls_conn_write(tls_, &head, sizeof(head));
+        RpcHeader head = {.id = id, .seq = seq, .size = static_cast<uint32_t>(size)};
+        if (sizeof(head) + size > sizeof(tx_) || data_len > size) {
+            ESP_LOGE("rpc", "Message of %d bytes exceeds the send buffer", (int) size);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(tx_, &head, sizeof(head));
+        if (data_len > 0) {
+            memcpy(tx_ + sizeof(head), data, data_len);
+        }
+        memset(tx_ + sizeof(head) + data_len, 0, size - data_len);
+        ESP_LOGD("rpc", "Sending API id:%d seq:%" PRIu32, (int) id, seq);
+        ESP_LOG_BUFFER_HEXDUMP("rpc", tx_, sizeof(head) + size, ESP_LOG_VERBOSE);
+        int len = write(tx_, sizeof(head) + size);
         if (len <= 0) {
             ESP_LOGE("rpc", "Failed to write data to the connection");
             return ESP_FAIL;
@@ -129,51 +125,311 @@ public:
         return ESP_OK;
     }
 
+    template<typename T>
+    esp_err_t send(api_id id, uint32_t seq, T *t)
+    {
+        static_assert(sizeof(RpcHeader) + sizeof(T) <= max_message_size, "RPC message exceeds max_message_size");
+        return send(id, seq, t, sizeof(T));
+    }
+
+    esp_err_t send(api_id id, uint32_t seq) // overload for (void)
+    {
+        return send(id, seq, nullptr, 0);
+    }
+
+    /**
+     * @brief File descriptor to select() on, readable when a message comes
+     */
     int get_socket_fd()
     {
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+        return channel_.fd();
+#else
         int sock;
         if (esp_tls_get_conn_sockfd(tls_, &sock) != ESP_OK) {
             return -1;
         }
         return sock;
+#endif
     }
 
+    /**
+     * @brief Returns the header of the next complete message, its payload stays in the receive buffer
+     *
+     * Reads from the connection only if no complete message is buffered. One read takes whatever
+     * is available, usually the header and the payload together, or several pipelined messages.
+     *
+     * @return Header with api_id::UNDEF if the message is not complete yet, api_id::ERROR on failure
+     */
     RpcHeader get_header()
     {
         RpcHeader header{};
-        int len = esp_tls_conn_read(tls_, (char *) &header, sizeof(header));
-        if (len <= 0) {
-            if (len < 0 && errno != EAGAIN) {
-                ESP_LOGE("rpc", "Failed to read header data from the connection %d %s", errno, strerror(errno));
-                return {.id = api_id::ERROR, .size = 0};
+        if (!buffered_message(header)) {
+            memmove(rx_, rx_ + rx_start_, rx_fill_ - rx_start_);
+            rx_fill_ -= rx_start_;
+            rx_start_ = 0;
+            int len = read(rx_ + rx_fill_, sizeof(rx_) - rx_fill_);
+            if (len <= 0) {
+                if (len < 0 && errno != EAGAIN) {
+                    ESP_LOGE("rpc", "Failed to read data from the connection %d %s", errno, strerror(errno));
+                    return {.id = api_id::ERROR, .seq = 0, .size = 0};
+                }
+                return {.id = api_id::UNDEF, .seq = 0, .size = 0};
+            }
+            rx_fill_ += len;
+            if (!buffered_message(header)) {
+                if (rx_fill_ == sizeof(rx_)) {
+                    ESP_LOGE("rpc", "Message of %" PRIu32 " bytes exceeds the receive buffer", header.size);
+                    return {.id = api_id::ERROR, .seq = 0, .size = 0};
+                }
+                return {.id = api_id::UNDEF, .seq = 0, .size = 0};
             }
-            return {.id = api_id::UNDEF, .size = 0};
         }
+        payload_ = rx_ + rx_start_ + sizeof(header);
+        rx_start_ += sizeof(header) + header.size;
         return header;
     }
 
+    /**
+     * @brief Payload of the message returned by the last get_header(), valid until the next one
+     */
+    const uint8_t *get_payload()
+    {
+        return payload_;
+    }
+
     template<typename T>
     T get_payload(api_id id, RpcHeader &head)
     {
-        RpcData<T> resp(id);
+        RpcData<T> resp(id, head.seq);
         if (head.id != id || head.size != resp.head.size) {
             ESP_LOGE("rpc", "unexpected header %d %d or sizes %" PRIu32 " %" PRIu32, (int)head.id, (int)id, head.size, resp.head.size);
             return {};
         }
-        int len = esp_tls_conn_read(tls_, (char *) resp.value(), resp.head.size);
-        if (len <= 0) {
-            ESP_LOGE("rpc", "Failed to read data from the connection");
-            return {};
-        }
+        memcpy(resp.value(), payload_, resp.head.size);
         return resp.value_;
     }
 
+    /**
+     * @brief Checks whether another message could be processed without waiting for the socket
+     *
+     * The messages might be in our receive buffer or decrypted in the TLS layer, select() doesn't see either of them.
+     */
+    bool has_data()
+    {
+        RpcHeader header;
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+        return buffered_message(header) || channel_.pending();
+#else
+        return buffered_message(header) || esp_tls_get_bytes_avail(tls_) > 0;
+#endif
+    }
+
 private:
     RpcInstance *init_server();
     RpcInstance *init_client();
-    esp_tls_t *tls_;
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+    static constexpr size_t channel_queue = 10;    // received messages waiting for the RPC task
+    static constexpr size_t channel_rx_size = channel_queue * (max_message_size + RpcChannel::overhead + sizeof(size_t));
+    static constexpr TickType_t channel_read_timeout = pdMS_TO_TICKS(1000);
+
+    bool connected()
+    {
+        return channel_.is_open();
+    }
+    void disconnect()
+    {
+        channel_.reset();
+    }
+    int write(const uint8_t *data, size_t len)
+    {
+        return channel_.write(data, len);
+    }
+    int read(uint8_t *data, size_t len)
+    {
+        // the server reads only when select() reported a message, the client waits in its task
+        return channel_.read(data, len, role_ == role::CLIENT ? channel_read_timeout : 0);
+    }
+    RpcChannel channel_;
+#else
+    bool connected()
+    {
+        return tls_ != nullptr;
+    }
+    void disconnect()
+    {
+        if (role_ == role::CLIENT) {
+            esp_tls_conn_destroy(tls_);
+        } else if (role_ == role::SERVER) {
+            esp_tls_server_session_delete(tls_);
+        }
+        tls_ = nullptr;
+    }
+    int write(const uint8_t *data, size_t len)
+    {
+        return esp_tls_conn_write(tls_, data, len);
+    }
+    int read(uint8_t *data, size_t len)
+    {
+        return esp_tls_conn_read(tls_, (char *) data, len);
+    }
+    esp_tls_t *tls_{nullptr};
+#endif
+    bool buffered_message(RpcHeader &header)
+    {
+        if (rx_fill_ - rx_start_ < sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, rx_ + rx_start_, sizeof(header));
+        return rx_fill_ - rx_start_ - sizeof(header) >= header.size;
+    }
     role role_;
     RpcInstance *instance{nullptr};
+    uint8_t rx_[max_message_size] {};
+    uint8_t tx_[max_message_size] {};
+    size_t rx_start_{0};    // first unprocessed byte in rx_
+    size_t rx_fill_{0};
+    const uint8_t *payload_{nullptr};
+};
+
+/**
+ * @brief Calls waiting for their responses (client side)
+ *
+ * Every call gets a unique correlation ID, so that several calls could be in flight
+ * and their responses matched in any order.
+ */
+class PendingCalls {
+public:
+    static constexpr int max_calls = 8;
+
+    struct Call {
+        uint32_t seq;       // 0 if the slot is free
+        api_id id;
+        void *resp;
+        uint32_t size;
+        bool answered;
+        esp_err_t err;
+        SemaphoreHandle_t done;
+    };
+
+    esp_err_t init()
+    {
+        if (lock_ == nullptr) {
+            lock_ = xSemaphoreCreateMutex();
+            free_ = xSemaphoreCreateCounting(max_calls, max_calls);
+        }
+        if (lock_ == nullptr || free_ == nullptr) {
+            return ESP_ERR_NO_MEM;
+        }
+        for (auto &call : calls_) {
+            if (call.done == nullptr && (call.done = xSemaphoreCreateBinary()) == nullptr) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Reserves a slot for the call, blocks if max_calls are already in flight
+     */
+    Call *add(api_id id, void *resp, uint32_t size)
+    {
+        xSemaphoreTake(free_, portMAX_DELAY);
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        Call *call = &calls_[0];
+        while (call->seq != 0) {    // the counting semaphore guarantees a free slot
+            ++call;
+        }
+        if (++next_seq_ == event_seq) {
+            ++next_seq_;
+        }
+        *call = { .seq = next_seq_, .id = id, .resp = resp, .size = size, .answered = false, .err = ESP_FAIL, .done = call->done };
+        xSemaphoreGive(lock_);
+        return call;
+    }
+
+    /**
+     * @brief Waits for the response and releases the slot
+     *
+     * The messages are not retransmitted, so the call fails with ESP_ERR_TIMEOUT if its request
+     * or response has been lost. A response coming later doesn't find the call any more.
+     */
+    esp_err_t wait(Call *call, TickType_t timeout)
+    {
+        if (xSemaphoreTake(call->done, timeout) != pdTRUE) {
+            xSemaphoreTake(lock_, portMAX_DELAY);
+            if (!call->answered) {  // the response might have come meanwhile
+                call->err = ESP_ERR_TIMEOUT;
+                call->answered = true;
+            }
+            xSemaphoreGive(lock_);
+        }
+        esp_err_t err = call->err;
+        release(call);
+        return err;
+    }
+
+    /**
+     * @brief Releases the slot of a call, which hasn't been sent
+     */
+    void release(Call *call)
+    {
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        call->seq = 0;
+        xSemaphoreTake(call->done, 0);  // in case it has been failed meanwhile
+        xSemaphoreGive(lock_);
+        xSemaphoreGive(free_);
+    }
+
+    /**
+     * @brief Passes the response to its caller
+     *
+     * @return ESP_ERR_NOT_FOUND if no call waits for this response
+     */
+    esp_err_t complete(const RpcHeader &head, const uint8_t *payload)
+    {
+        esp_err_t ret = ESP_ERR_NOT_FOUND;
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        for (auto &call : calls_) {
+            if (call.seq == head.seq && call.seq != 0 && !call.answered) {
+                if (call.id == head.id && call.size == head.size) {
+                    memcpy(call.resp, payload, call.size);
+                    call.err = ESP_OK;
+                } else {
+                    ESP_LOGE("rpc", "unexpected response %d to %d or sizes %" PRIu32 " %" PRIu32, (int)head.id, (int)call.id, head.size, call.size);
+                    call.err = ESP_ERR_INVALID_RESPONSE;
+                }
+                call.answered = true;
+                xSemaphoreGive(call.done);
+                ret = ESP_OK;
+                break;
+            }
+        }
+        xSemaphoreGive(lock_);
+        return ret;
+    }
+
+    /**
+     * @brief Fails all calls in flight, as their responses won't come (connection lost)
+     */
+    void fail_all()
+    {
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        for (auto &call : calls_) {
+            if (call.seq != 0 && !call.answered) {
+                call.err = ESP_FAIL;
+                call.answered = true;
+                xSemaphoreGive(call.done);
+            }
+        }
+        xSemaphoreGive(lock_);
+    }
+
+private:
+    Call calls_[max_calls] {};
+    SemaphoreHandle_t lock_{nullptr};
+    SemaphoreHandle_t free_{nullptr};
+    uint32_t next_seq_{event_seq};
 };
 
 };
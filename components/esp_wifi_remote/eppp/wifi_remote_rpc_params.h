@@ -5,14 +5,36 @@
  */
 #pragma once
 
-struct esp_wifi_remote_config {
-    wifi_interface_t interface;
-    wifi_config_t conf;
+struct esp_wifi_remote_scan_config {
+    wifi_scan_config_t config;  // ssid and bssid are set to the arrays below on the server
+    uint8_t ssid[33];
+    uint8_t bssid[6];
+    bool has_config;
+    bool has_ssid;
+    bool has_bssid;
+    bool block;
 };
 
-struct esp_wifi_remote_mac_t {
-    esp_err_t err;
-    uint8_t mac[6];
+// records of SCAN_GET_AP_RECORDS per response, so that it fits to one RPC message
+#define ESP_WIFI_REMOTE_AP_RECORDS_BATCH 8
+
+struct esp_wifi_remote_ap_records_req {
+    uint16_t number;            // records wanted in this batch, up to ESP_WIFI_REMOTE_AP_RECORDS_BATCH
+    bool last;                  // free the rest of the list afterwards, like esp_wifi_scan_get_ap_records()
+};
+
+struct esp_wifi_remote_ap_records_resp {
+    esp_err_t ret;
+    uint16_t number;
+    wifi_ap_record_t records[ESP_WIFI_REMOTE_AP_RECORDS_BATCH];
+};
+
+struct esp_wifi_remote_vendor_ie {
+    bool enable;
+    wifi_vendor_ie_type_t type;
+    wifi_vendor_ie_id_t idx;
+    bool has_ie;
+    uint8_t ie[2 + UINT8_MAX];  // vendor_ie_data_t: element ID and length, followed by up to 255 bytes
 };
 
 struct esp_wifi_remote_eppp_ip_event {
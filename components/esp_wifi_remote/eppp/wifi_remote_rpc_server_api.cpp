@@ -0,0 +1,571 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// This file is auto-generated
+#include <cinttypes>
+#include "esp_log.h"
+#include "esp_tls.h"
+#include "wifi_remote_rpc_impl.hpp"
+#include "wifi_remote_rpc_api.hpp"
+
+namespace eppp_rpc::server {
+
+esp_err_t dispatch(RpcEngine &rpc, RpcHeader &header)
+{
+    switch (header.id) {
+    case api_id::DEINIT: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::deinit_resp resp = {};
+        resp.ret = esp_wifi_deinit();
+        return rpc.send(api_id::DEINIT, header.seq, &resp);
+    }
+    case api_id::SET_MODE: {
+        if (header.size != sizeof(api::set_mode_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_mode_req>(api_id::SET_MODE, header);
+        api::set_mode_resp resp = {};
+        resp.ret = esp_wifi_set_mode(req.mode);
+        return rpc.send(api_id::SET_MODE, header.seq, &resp);
+    }
+    case api_id::GET_MODE: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_mode_resp resp = {};
+        resp.ret = esp_wifi_get_mode(&resp.mode);
+        return rpc.send(api_id::GET_MODE, header.seq, &resp);
+    }
+    case api_id::START: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::start_resp resp = {};
+        resp.ret = esp_wifi_start();
+        return rpc.send(api_id::START, header.seq, &resp);
+    }
+    case api_id::STOP: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::stop_resp resp = {};
+        resp.ret = esp_wifi_stop();
+        return rpc.send(api_id::STOP, header.seq, &resp);
+    }
+    case api_id::RESTORE: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::restore_resp resp = {};
+        resp.ret = esp_wifi_restore();
+        return rpc.send(api_id::RESTORE, header.seq, &resp);
+    }
+    case api_id::CONNECT: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::connect_resp resp = {};
+        resp.ret = esp_wifi_connect();
+        return rpc.send(api_id::CONNECT, header.seq, &resp);
+    }
+    case api_id::DISCONNECT: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::disconnect_resp resp = {};
+        resp.ret = esp_wifi_disconnect();
+        return rpc.send(api_id::DISCONNECT, header.seq, &resp);
+    }
+    case api_id::CLEAR_FAST_CONNECT: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::clear_fast_connect_resp resp = {};
+        resp.ret = esp_wifi_clear_fast_connect();
+        return rpc.send(api_id::CLEAR_FAST_CONNECT, header.seq, &resp);
+    }
+    case api_id::DEAUTH_STA: {
+        if (header.size != sizeof(api::deauth_sta_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::deauth_sta_req>(api_id::DEAUTH_STA, header);
+        api::deauth_sta_resp resp = {};
+        resp.ret = esp_wifi_deauth_sta(req.aid);
+        return rpc.send(api_id::DEAUTH_STA, header.seq, &resp);
+    }
+    case api_id::SCAN_STOP: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::scan_stop_resp resp = {};
+        resp.ret = esp_wifi_scan_stop();
+        return rpc.send(api_id::SCAN_STOP, header.seq, &resp);
+    }
+    case api_id::SCAN_GET_AP_NUM: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::scan_get_ap_num_resp resp = {};
+        resp.ret = esp_wifi_scan_get_ap_num(&resp.number);
+        return rpc.send(api_id::SCAN_GET_AP_NUM, header.seq, &resp);
+    }
+    case api_id::SCAN_GET_AP_RECORD: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::scan_get_ap_record_resp resp = {};
+        resp.ret = esp_wifi_scan_get_ap_record(&resp.ap_record);
+        return rpc.send(api_id::SCAN_GET_AP_RECORD, header.seq, &resp);
+    }
+    case api_id::CLEAR_AP_LIST: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::clear_ap_list_resp resp = {};
+        resp.ret = esp_wifi_clear_ap_list();
+        return rpc.send(api_id::CLEAR_AP_LIST, header.seq, &resp);
+    }
+    case api_id::STA_GET_AP_INFO: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::sta_get_ap_info_resp resp = {};
+        resp.ret = esp_wifi_sta_get_ap_info(&resp.ap_info);
+        return rpc.send(api_id::STA_GET_AP_INFO, header.seq, &resp);
+    }
+    case api_id::SET_PS: {
+        if (header.size != sizeof(api::set_ps_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_ps_req>(api_id::SET_PS, header);
+        api::set_ps_resp resp = {};
+        resp.ret = esp_wifi_set_ps(req.type);
+        return rpc.send(api_id::SET_PS, header.seq, &resp);
+    }
+    case api_id::GET_PS: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_ps_resp resp = {};
+        resp.ret = esp_wifi_get_ps(&resp.type);
+        return rpc.send(api_id::GET_PS, header.seq, &resp);
+    }
+    case api_id::SET_PROTOCOL: {
+        if (header.size != sizeof(api::set_protocol_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_protocol_req>(api_id::SET_PROTOCOL, header);
+        api::set_protocol_resp resp = {};
+        resp.ret = esp_wifi_set_protocol(req.ifx, req.protocol_bitmap);
+        return rpc.send(api_id::SET_PROTOCOL, header.seq, &resp);
+    }
+    case api_id::GET_PROTOCOL: {
+        if (header.size != sizeof(api::get_protocol_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::get_protocol_req>(api_id::GET_PROTOCOL, header);
+        api::get_protocol_resp resp = {};
+        resp.ret = esp_wifi_get_protocol(req.ifx, &resp.protocol_bitmap);
+        return rpc.send(api_id::GET_PROTOCOL, header.seq, &resp);
+    }
+    case api_id::SET_BANDWIDTH: {
+        if (header.size != sizeof(api::set_bandwidth_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_bandwidth_req>(api_id::SET_BANDWIDTH, header);
+        api::set_bandwidth_resp resp = {};
+        resp.ret = esp_wifi_set_bandwidth(req.ifx, req.bw);
+        return rpc.send(api_id::SET_BANDWIDTH, header.seq, &resp);
+    }
+    case api_id::GET_BANDWIDTH: {
+        if (header.size != sizeof(api::get_bandwidth_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::get_bandwidth_req>(api_id::GET_BANDWIDTH, header);
+        api::get_bandwidth_resp resp = {};
+        resp.ret = esp_wifi_get_bandwidth(req.ifx, &resp.bw);
+        return rpc.send(api_id::GET_BANDWIDTH, header.seq, &resp);
+    }
+    case api_id::SET_CHANNEL: {
+        if (header.size != sizeof(api::set_channel_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_channel_req>(api_id::SET_CHANNEL, header);
+        api::set_channel_resp resp = {};
+        resp.ret = esp_wifi_set_channel(req.primary, req.second);
+        return rpc.send(api_id::SET_CHANNEL, header.seq, &resp);
+    }
+    case api_id::GET_CHANNEL: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_channel_resp resp = {};
+        resp.ret = esp_wifi_get_channel(&resp.primary, &resp.second);
+        return rpc.send(api_id::GET_CHANNEL, header.seq, &resp);
+    }
+    case api_id::SET_COUNTRY: {
+        if (header.size != sizeof(api::set_country_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_country_req>(api_id::SET_COUNTRY, header);
+        api::set_country_resp resp = {};
+        resp.ret = esp_wifi_set_country(&req.country);
+        return rpc.send(api_id::SET_COUNTRY, header.seq, &resp);
+    }
+    case api_id::GET_COUNTRY: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_country_resp resp = {};
+        resp.ret = esp_wifi_get_country(&resp.country);
+        return rpc.send(api_id::GET_COUNTRY, header.seq, &resp);
+    }
+    case api_id::SET_MAC: {
+        if (header.size != sizeof(api::set_mac_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_mac_req>(api_id::SET_MAC, header);
+        api::set_mac_resp resp = {};
+        resp.ret = esp_wifi_set_mac(req.ifx, req.mac);
+        return rpc.send(api_id::SET_MAC, header.seq, &resp);
+    }
+    case api_id::GET_MAC: {
+        if (header.size != sizeof(api::get_mac_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::get_mac_req>(api_id::GET_MAC, header);
+        api::get_mac_resp resp = {};
+        resp.ret = esp_wifi_get_mac(req.ifx, resp.mac);
+        return rpc.send(api_id::GET_MAC, header.seq, &resp);
+    }
+    case api_id::SET_PROMISCUOUS: {
+        if (header.size != sizeof(api::set_promiscuous_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_promiscuous_req>(api_id::SET_PROMISCUOUS, header);
+        api::set_promiscuous_resp resp = {};
+        resp.ret = esp_wifi_set_promiscuous(req.en);
+        return rpc.send(api_id::SET_PROMISCUOUS, header.seq, &resp);
+    }
+    case api_id::GET_PROMISCUOUS: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_promiscuous_resp resp = {};
+        resp.ret = esp_wifi_get_promiscuous(&resp.en);
+        return rpc.send(api_id::GET_PROMISCUOUS, header.seq, &resp);
+    }
+    case api_id::SET_PROMISCUOUS_FILTER: {
+        if (header.size != sizeof(api::set_promiscuous_filter_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_promiscuous_filter_req>(api_id::SET_PROMISCUOUS_FILTER, header);
+        api::set_promiscuous_filter_resp resp = {};
+        resp.ret = esp_wifi_set_promiscuous_filter(&req.filter);
+        return rpc.send(api_id::SET_PROMISCUOUS_FILTER, header.seq, &resp);
+    }
+    case api_id::GET_PROMISCUOUS_FILTER: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_promiscuous_filter_resp resp = {};
+        resp.ret = esp_wifi_get_promiscuous_filter(&resp.filter);
+        return rpc.send(api_id::GET_PROMISCUOUS_FILTER, header.seq, &resp);
+    }
+    case api_id::SET_PROMISCUOUS_CTRL_FILTER: {
+        if (header.size != sizeof(api::set_promiscuous_ctrl_filter_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_promiscuous_ctrl_filter_req>(api_id::SET_PROMISCUOUS_CTRL_FILTER, header);
+        api::set_promiscuous_ctrl_filter_resp resp = {};
+        resp.ret = esp_wifi_set_promiscuous_ctrl_filter(&req.filter);
+        return rpc.send(api_id::SET_PROMISCUOUS_CTRL_FILTER, header.seq, &resp);
+    }
+    case api_id::GET_PROMISCUOUS_CTRL_FILTER: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_promiscuous_ctrl_filter_resp resp = {};
+        resp.ret = esp_wifi_get_promiscuous_ctrl_filter(&resp.filter);
+        return rpc.send(api_id::GET_PROMISCUOUS_CTRL_FILTER, header.seq, &resp);
+    }
+    case api_id::SET_CONFIG: {
+        if (header.size != sizeof(api::set_config_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_config_req>(api_id::SET_CONFIG, header);
+        api::set_config_resp resp = {};
+        resp.ret = esp_wifi_set_config(req.interface, &req.conf);
+        return rpc.send(api_id::SET_CONFIG, header.seq, &resp);
+    }
+    case api_id::GET_CONFIG: {
+        if (header.size != sizeof(api::get_config_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::get_config_req>(api_id::GET_CONFIG, header);
+        api::get_config_resp resp = {};
+        resp.ret = esp_wifi_get_config(req.interface, &resp.conf);
+        return rpc.send(api_id::GET_CONFIG, header.seq, &resp);
+    }
+    case api_id::AP_GET_STA_LIST: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::ap_get_sta_list_resp resp = {};
+        resp.ret = esp_wifi_ap_get_sta_list(&resp.sta);
+        return rpc.send(api_id::AP_GET_STA_LIST, header.seq, &resp);
+    }
+    case api_id::AP_GET_STA_AID: {
+        if (header.size != sizeof(api::ap_get_sta_aid_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::ap_get_sta_aid_req>(api_id::AP_GET_STA_AID, header);
+        api::ap_get_sta_aid_resp resp = {};
+        resp.ret = esp_wifi_ap_get_sta_aid(req.mac, &resp.aid);
+        return rpc.send(api_id::AP_GET_STA_AID, header.seq, &resp);
+    }
+    case api_id::SET_STORAGE: {
+        if (header.size != sizeof(api::set_storage_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_storage_req>(api_id::SET_STORAGE, header);
+        api::set_storage_resp resp = {};
+        resp.ret = esp_wifi_set_storage(req.storage);
+        return rpc.send(api_id::SET_STORAGE, header.seq, &resp);
+    }
+    case api_id::SET_MAX_TX_POWER: {
+        if (header.size != sizeof(api::set_max_tx_power_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_max_tx_power_req>(api_id::SET_MAX_TX_POWER, header);
+        api::set_max_tx_power_resp resp = {};
+        resp.ret = esp_wifi_set_max_tx_power(req.power);
+        return rpc.send(api_id::SET_MAX_TX_POWER, header.seq, &resp);
+    }
+    case api_id::GET_MAX_TX_POWER: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_max_tx_power_resp resp = {};
+        resp.ret = esp_wifi_get_max_tx_power(&resp.power);
+        return rpc.send(api_id::GET_MAX_TX_POWER, header.seq, &resp);
+    }
+    case api_id::SET_EVENT_MASK: {
+        if (header.size != sizeof(api::set_event_mask_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_event_mask_req>(api_id::SET_EVENT_MASK, header);
+        api::set_event_mask_resp resp = {};
+        resp.ret = esp_wifi_set_event_mask(req.mask);
+        return rpc.send(api_id::SET_EVENT_MASK, header.seq, &resp);
+    }
+    case api_id::GET_EVENT_MASK: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_event_mask_resp resp = {};
+        resp.ret = esp_wifi_get_event_mask(&resp.mask);
+        return rpc.send(api_id::GET_EVENT_MASK, header.seq, &resp);
+    }
+    case api_id::SET_CSI_CONFIG: {
+        if (header.size != sizeof(api::set_csi_config_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_csi_config_req>(api_id::SET_CSI_CONFIG, header);
+        api::set_csi_config_resp resp = {};
+        resp.ret = esp_wifi_set_csi_config(&req.config);
+        return rpc.send(api_id::SET_CSI_CONFIG, header.seq, &resp);
+    }
+    case api_id::SET_CSI: {
+        if (header.size != sizeof(api::set_csi_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_csi_req>(api_id::SET_CSI, header);
+        api::set_csi_resp resp = {};
+        resp.ret = esp_wifi_set_csi(req.en);
+        return rpc.send(api_id::SET_CSI, header.seq, &resp);
+    }
+    case api_id::GET_TSF_TIME: {
+        if (header.size != sizeof(api::get_tsf_time_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::get_tsf_time_req>(api_id::GET_TSF_TIME, header);
+        api::get_tsf_time_resp resp = {};
+        resp.ret = esp_wifi_get_tsf_time(req.interface);
+        return rpc.send(api_id::GET_TSF_TIME, header.seq, &resp);
+    }
+    case api_id::SET_INACTIVE_TIME: {
+        if (header.size != sizeof(api::set_inactive_time_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_inactive_time_req>(api_id::SET_INACTIVE_TIME, header);
+        api::set_inactive_time_resp resp = {};
+        resp.ret = esp_wifi_set_inactive_time(req.ifx, req.sec);
+        return rpc.send(api_id::SET_INACTIVE_TIME, header.seq, &resp);
+    }
+    case api_id::GET_INACTIVE_TIME: {
+        if (header.size != sizeof(api::get_inactive_time_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::get_inactive_time_req>(api_id::GET_INACTIVE_TIME, header);
+        api::get_inactive_time_resp resp = {};
+        resp.ret = esp_wifi_get_inactive_time(req.ifx, &resp.sec);
+        return rpc.send(api_id::GET_INACTIVE_TIME, header.seq, &resp);
+    }
+    case api_id::STATIS_DUMP: {
+        if (header.size != sizeof(api::statis_dump_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::statis_dump_req>(api_id::STATIS_DUMP, header);
+        api::statis_dump_resp resp = {};
+        resp.ret = esp_wifi_statis_dump(req.modules);
+        return rpc.send(api_id::STATIS_DUMP, header.seq, &resp);
+    }
+    case api_id::SET_RSSI_THRESHOLD: {
+        if (header.size != sizeof(api::set_rssi_threshold_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_rssi_threshold_req>(api_id::SET_RSSI_THRESHOLD, header);
+        api::set_rssi_threshold_resp resp = {};
+        resp.ret = esp_wifi_set_rssi_threshold(req.rssi);
+        return rpc.send(api_id::SET_RSSI_THRESHOLD, header.seq, &resp);
+    }
+    case api_id::FTM_INITIATE_SESSION: {
+        if (header.size != sizeof(api::ftm_initiate_session_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::ftm_initiate_session_req>(api_id::FTM_INITIATE_SESSION, header);
+        api::ftm_initiate_session_resp resp = {};
+        resp.ret = esp_wifi_ftm_initiate_session(&req.cfg);
+        return rpc.send(api_id::FTM_INITIATE_SESSION, header.seq, &resp);
+    }
+    case api_id::FTM_END_SESSION: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::ftm_end_session_resp resp = {};
+        resp.ret = esp_wifi_ftm_end_session();
+        return rpc.send(api_id::FTM_END_SESSION, header.seq, &resp);
+    }
+    case api_id::FTM_RESP_SET_OFFSET: {
+        if (header.size != sizeof(api::ftm_resp_set_offset_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::ftm_resp_set_offset_req>(api_id::FTM_RESP_SET_OFFSET, header);
+        api::ftm_resp_set_offset_resp resp = {};
+        resp.ret = esp_wifi_ftm_resp_set_offset(req.offset_cm);
+        return rpc.send(api_id::FTM_RESP_SET_OFFSET, header.seq, &resp);
+    }
+    case api_id::CONFIG_11B_RATE: {
+        if (header.size != sizeof(api::config_11b_rate_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::config_11b_rate_req>(api_id::CONFIG_11B_RATE, header);
+        api::config_11b_rate_resp resp = {};
+        resp.ret = esp_wifi_config_11b_rate(req.ifx, req.disable);
+        return rpc.send(api_id::CONFIG_11B_RATE, header.seq, &resp);
+    }
+    case api_id::CONNECTIONLESS_MODULE_SET_WAKE_INTERVAL: {
+        if (header.size != sizeof(api::connectionless_module_set_wake_interval_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::connectionless_module_set_wake_interval_req>(api_id::CONNECTIONLESS_MODULE_SET_WAKE_INTERVAL, header);
+        api::connectionless_module_set_wake_interval_resp resp = {};
+        resp.ret = esp_wifi_connectionless_module_set_wake_interval(req.wake_interval);
+        return rpc.send(api_id::CONNECTIONLESS_MODULE_SET_WAKE_INTERVAL, header.seq, &resp);
+    }
+    case api_id::FORCE_WAKEUP_ACQUIRE: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::force_wakeup_acquire_resp resp = {};
+        resp.ret = esp_wifi_force_wakeup_acquire();
+        return rpc.send(api_id::FORCE_WAKEUP_ACQUIRE, header.seq, &resp);
+    }
+    case api_id::FORCE_WAKEUP_RELEASE: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::force_wakeup_release_resp resp = {};
+        resp.ret = esp_wifi_force_wakeup_release();
+        return rpc.send(api_id::FORCE_WAKEUP_RELEASE, header.seq, &resp);
+    }
+    case api_id::SET_COUNTRY_CODE: {
+        if (header.size != sizeof(api::set_country_code_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_country_code_req>(api_id::SET_COUNTRY_CODE, header);
+        api::set_country_code_resp resp = {};
+        resp.ret = esp_wifi_set_country_code(req.country, req.ieee80211d_enabled);
+        return rpc.send(api_id::SET_COUNTRY_CODE, header.seq, &resp);
+    }
+    case api_id::GET_COUNTRY_CODE: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::get_country_code_resp resp = {};
+        resp.ret = esp_wifi_get_country_code(resp.country);
+        return rpc.send(api_id::GET_COUNTRY_CODE, header.seq, &resp);
+    }
+    case api_id::CONFIG_80211_TX_RATE: {
+        if (header.size != sizeof(api::config_80211_tx_rate_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::config_80211_tx_rate_req>(api_id::CONFIG_80211_TX_RATE, header);
+        api::config_80211_tx_rate_resp resp = {};
+        resp.ret = esp_wifi_config_80211_tx_rate(req.ifx, req.rate);
+        return rpc.send(api_id::CONFIG_80211_TX_RATE, header.seq, &resp);
+    }
+    case api_id::DISABLE_PMF_CONFIG: {
+        if (header.size != sizeof(api::disable_pmf_config_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::disable_pmf_config_req>(api_id::DISABLE_PMF_CONFIG, header);
+        api::disable_pmf_config_resp resp = {};
+        resp.ret = esp_wifi_disable_pmf_config(req.ifx);
+        return rpc.send(api_id::DISABLE_PMF_CONFIG, header.seq, &resp);
+    }
+    case api_id::STA_GET_AID: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::sta_get_aid_resp resp = {};
+        resp.ret = esp_wifi_sta_get_aid(&resp.aid);
+        return rpc.send(api_id::STA_GET_AID, header.seq, &resp);
+    }
+    case api_id::STA_GET_NEGOTIATED_PHYMODE: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::sta_get_negotiated_phymode_resp resp = {};
+        resp.ret = esp_wifi_sta_get_negotiated_phymode(&resp.phymode);
+        return rpc.send(api_id::STA_GET_NEGOTIATED_PHYMODE, header.seq, &resp);
+    }
+    case api_id::SET_DYNAMIC_CS: {
+        if (header.size != sizeof(api::set_dynamic_cs_req)) {
+            return ESP_FAIL;
+        }
+        auto req = rpc.get_payload<api::set_dynamic_cs_req>(api_id::SET_DYNAMIC_CS, header);
+        api::set_dynamic_cs_resp resp = {};
+        resp.ret = esp_wifi_set_dynamic_cs(req.enabled);
+        return rpc.send(api_id::SET_DYNAMIC_CS, header.seq, &resp);
+    }
+    case api_id::STA_GET_RSSI: {
+        if (header.size != 0) {
+            return ESP_FAIL;
+        }
+        api::sta_get_rssi_resp resp = {};
+        resp.ret = esp_wifi_sta_get_rssi(&resp.rssi);
+        return rpc.send(api_id::STA_GET_RSSI, header.seq, &resp);
+    }
+    default:
+        ESP_LOGE("rpc_server", "Unknown API id %d", (int)header.id);
+        return ESP_FAIL;
+    }
+}
+
+}   // namespace eppp_rpc::server
@@ -17,6 +17,21 @@ COPYRIGHT_HEADER = open('copyright_header.h', 'r').read()
 NAMESPACE = re.compile(r'^esp_wifi')
 DEPRECATED_API = ['esp_wifi_set_ant_gpio', 'esp_wifi_get_ant', 'esp_wifi_get_ant_gpio', 'esp_wifi_set_ant']
 
+# EPPP RPC: APIs with hand written marshalling, only their IDs are generated (configs with pointers, variable length data)
+RPC_MANUAL_API = ['esp_wifi_init', 'esp_wifi_scan_start', 'esp_wifi_scan_get_ap_records', 'esp_wifi_set_vendor_ie']
+# EPPP RPC: APIs with data bigger than one RPC message, these are not marshalled (stubs return ESP_ERR_NOT_SUPPORTED)
+RPC_VARIABLE_SIZE_API = ['esp_wifi_80211_tx', 'esp_wifi_ftm_get_report']
+# EPPP RPC: non-const pointer parameters, which are inputs
+RPC_INPUT_POINTER_API = ['esp_wifi_set_config', 'esp_wifi_ftm_initiate_session']
+# EPPP RPC: char pointer parameters, which point to a fixed size array
+RPC_FIXED_SIZE_API = {'esp_wifi_set_country_code': 3, 'esp_wifi_get_country_code': 3}
+# EPPP RPC: read-mostly getters, the client serves these from its cache until an event or a setter invalidates it
+RPC_CACHED_API = ['esp_wifi_get_mode', 'esp_wifi_get_mac', 'esp_wifi_get_config', 'esp_wifi_get_country', 'esp_wifi_get_country_code',
+                  'esp_wifi_get_ps', 'esp_wifi_get_protocol', 'esp_wifi_get_bandwidth', 'esp_wifi_get_max_tx_power', 'esp_wifi_get_event_mask',
+                  'esp_wifi_get_inactive_time', 'esp_wifi_get_promiscuous', 'esp_wifi_get_promiscuous_filter', 'esp_wifi_get_promiscuous_ctrl_filter']
+
+RpcParam = namedtuple('RpcParam', ['kind', 'direction', 'type', 'array', 'name'])
+
 
 class FunctionVisitor(c_ast.NodeVisitor):
     def __init__(self, header):
@@ -290,6 +305,215 @@ def generate_test_cases(function_prototypes, component_path):
     return [wifi_cases, remote_wifi_cases]
 
 
+def get_rpc_params(func_name, parameters):
+    """Returns how the parameters are marshalled over EPPP RPC, or None if the API can't be called remotely"""
+    if func_name in RPC_VARIABLE_SIZE_API:
+        return None
+    rpc_params = []
+    for param in parameters:
+        if param.type == 'void' and param.ptr == 0 and param.name is None:
+            continue
+        if param.type.endswith('_cb_t') or param.ptr > 1:
+            return None     # callbacks or pointers to pointers
+        typename = 'bool' if param.type == '_Bool' else param.type
+        if param.ptr == 1 and param.type in ['void', 'char']:
+            if func_name not in RPC_FIXED_SIZE_API:
+                return None
+            kind, array = 'array', RPC_FIXED_SIZE_API[func_name]
+        elif param.array > 0:
+            kind, array = 'array', param.array
+        elif param.ptr == 1:
+            kind, array = 'pointer', 0
+        else:
+            kind, array = 'value', 0
+        direction = 'in'
+        if kind != 'value' and 'const' not in param.qual and func_name not in RPC_INPUT_POINTER_API:
+            direction = 'out'
+        rpc_params.append(RpcParam(kind=kind, direction=direction, type=typename, array=array, name=param.name))
+    return rpc_params
+
+
+def get_rpc_struct(name, members):
+    struct = f'struct {name} {{\n'
+    for typename, member, array in members:
+        struct += f'    {typename} {member}[{array}];\n' if array > 0 else f'    {typename} {member};\n'
+    return struct + '};\n'
+
+
+def generate_eppp_rpc(function_prototypes, component_path):
+    ids_header = os.path.join(component_path, 'eppp', 'wifi_remote_rpc_ids.hpp')
+    api_header = os.path.join(component_path, 'eppp', 'wifi_remote_rpc_api.hpp')
+    client_source = os.path.join(component_path, 'eppp', 'wifi_remote_rpc_client_api.cpp')
+    server_source = os.path.join(component_path, 'eppp', 'wifi_remote_rpc_server_api.cpp')
+    apis = []
+    unsupported = []
+    for func_name, args in function_prototypes.items():
+        rpc_params = [] if func_name in RPC_MANUAL_API else get_rpc_params(func_name, args[1])
+        if rpc_params is None:
+            unsupported.append((func_name, args))
+            continue
+        short_name = NAMESPACE.sub('', func_name)[1:]
+        if not short_name.isidentifier():
+            raise RuntimeError(f'Cannot create RPC identifier for {func_name}')
+        apis.append((func_name, short_name, args[0], args[1], rpc_params))
+
+    with open(ids_header, 'w') as f:
+        f.write(COPYRIGHT_HEADER)
+        f.write('#pragma once\n\n')
+        f.write('#include <cstdint>\n\n')
+        f.write('namespace eppp_rpc {\n\n')
+        f.write('/**\n * @brief Currently supported RPC commands/events\n */\n')
+        f.write('enum class api_id : uint32_t {\n')
+        for id in ['ERROR', 'UNDEF', 'WIFI_EVENT', 'IP_EVENT']:
+            f.write(f'    {id},\n')
+        for _, short_name, _, _, _ in apis:
+            f.write(f'    {short_name.upper()},\n')
+        f.write('};\n\n')
+        f.write('}   // namespace eppp_rpc\n')
+
+    with open(api_header, 'w') as f:
+        f.write(COPYRIGHT_HEADER)
+        f.write('#pragma once\n\n')
+        f.write('#include "esp_wifi.h"\n')
+        f.write('#include "wifi_remote_rpc_ids.hpp"\n\n')
+        f.write('namespace eppp_rpc {\n\n')
+        f.write('class RpcEngine;\nstruct RpcHeader;\n\n')
+        f.write('/**\n * @brief How the client treats its cached responses when calling an API\n */\n')
+        f.write('enum class cache_policy {\n')
+        f.write('    NONE,           // the call doesn\'t change the state\n')
+        f.write('    CACHED,         // read-mostly getter, served from the cache\n')
+        f.write('    INVALIDATE,     // the call might change the state, cached responses are dropped\n')
+        f.write('};\n\n')
+        f.write('constexpr cache_policy cache(api_id id)\n{\n')
+        f.write('    switch (id) {\n')
+        cached = [short_name for func_name, short_name, _, _, _ in apis if func_name in RPC_CACHED_API]
+        getters = [short_name for func_name, short_name, _, _, _ in apis if func_name not in RPC_CACHED_API and '_get_' in func_name]
+        for short_name in cached:
+            f.write(f'    case api_id::{short_name.upper()}:\n')
+        f.write('        return cache_policy::CACHED;\n')
+        for short_name in getters:
+            f.write(f'    case api_id::{short_name.upper()}:\n')
+        f.write('        return cache_policy::NONE;\n')
+        f.write('    default:\n')
+        f.write('        return cache_policy::INVALIDATE;\n')
+        f.write('    }\n}\n\n')
+        f.write('/**\n * @brief Parameters of the requests and responses, every response starts with the return value\n */\n')
+        f.write('namespace api {\n')
+        for func_name, short_name, ret_type, _, rpc_params in apis:
+            if func_name in RPC_MANUAL_API:
+                continue
+            inputs = [(p.type, p.name, p.array) for p in rpc_params if p.direction == 'in']
+            outputs = [(p.type, p.name, p.array) for p in rpc_params if p.direction == 'out']
+            if inputs:
+                f.write('\n' + get_rpc_struct(f'{short_name}_req', inputs))
+            f.write('\n' + get_rpc_struct(f'{short_name}_resp', [(ret_type, 'ret', 0)] + outputs))
+        f.write('\n}   // namespace api\n\n')
+        f.write('namespace client {\n')
+        f.write('/**\n * @brief Sends the request and waits for the response (or returns the cached one)\n */\n')
+        f.write('esp_err_t call(api_id id, const void *req, size_t req_size, void *resp, size_t resp_size);\n')
+        f.write('}\n\n')
+        f.write('namespace server {\n')
+        f.write('/**\n * @brief Calls the API of the received request and sends the response\n */\n')
+        f.write('esp_err_t dispatch(RpcEngine &rpc, RpcHeader &header);\n')
+        f.write('}\n\n')
+        f.write('}   // namespace eppp_rpc\n')
+
+    with open(client_source, 'w') as f:
+        f.write(COPYRIGHT_HEADER)
+        f.write('#include <cstring>\n')
+        f.write('#include "esp_log.h"\n')
+        f.write('#include "esp_check.h"\n')
+        f.write('#include "wifi_remote_rpc_api.hpp"\n\n')
+        f.write('using namespace eppp_rpc;\n\n')
+        f.write('static const char *TAG = "rpc_client";\n\n')
+        for func_name, short_name, ret_type, args, rpc_params in apis:
+            if func_name in RPC_MANUAL_API:
+                continue
+            id = short_name.upper()
+            params, _ = get_args(args)
+            params = re.sub(r'\b_Bool\b', 'bool', params)
+            f.write(f'\nextern "C" {ret_type} {NAMESPACE.sub("esp_wifi_remote", func_name)}({params})\n')
+            f.write('{\n')
+            pointers = [p.name for p in rpc_params if p.kind != 'value']
+            if pointers:
+                f.write(f'    if ({" || ".join(f"{name} == nullptr" for name in pointers)}) {{\n')
+                f.write(f'        return {"ESP_ERR_INVALID_ARG" if ret_type == "esp_err_t" else "-1"};\n')
+                f.write('    }\n')
+            inputs = [p for p in rpc_params if p.direction == 'in']
+            outputs = [p for p in rpc_params if p.direction == 'out']
+            req = 'nullptr, 0'
+            if inputs:
+                req = '&req, sizeof(req)'
+                f.write(f'    api::{short_name}_req req = {{}};\n')
+                for p in inputs:
+                    if p.kind == 'array':
+                        f.write(f'    memcpy(req.{p.name}, {p.name}, sizeof(req.{p.name}));\n')
+                    else:
+                        f.write(f'    req.{p.name} = {"*" if p.kind == "pointer" else ""}{p.name};\n')
+            f.write(f'    api::{short_name}_resp resp = {{}};\n')
+            call = f'client::call(api_id::{id}, {req}, &resp, sizeof(resp))'
+            if ret_type == 'esp_err_t':
+                f.write(f'    ESP_RETURN_ON_ERROR({call}, TAG, "Failed to call {id}");\n')
+            else:
+                f.write(f'    ESP_RETURN_ON_FALSE({call} == ESP_OK, -1, TAG, "Failed to call {id}");\n')
+            if outputs:
+                f.write('    if (resp.ret == ESP_OK) {\n')
+                for p in outputs:
+                    if p.kind == 'array':
+                        f.write(f'        memcpy({p.name}, resp.{p.name}, sizeof(resp.{p.name}));\n')
+                    else:
+                        f.write(f'        *{p.name} = resp.{p.name};\n')
+                f.write('    }\n')
+            f.write('    return resp.ret;\n')
+            f.write('}\n')
+        for func_name, args in unsupported:
+            params, _ = get_args(args[1])
+            params = re.sub(r'\b_Bool\b', 'bool', params)
+            f.write(f'\nextern "C" {args[0]} {NAMESPACE.sub("esp_wifi_remote", func_name)}({params})\n')
+            f.write('{\n')
+            f.write('    // not marshalled: callbacks or variable length data\n')
+            f.write(f'    ESP_LOGW(TAG, "%s unsupported", __func__);\n')
+            f.write(f'    return {"ESP_ERR_NOT_SUPPORTED" if args[0] == "esp_err_t" else "-1"};\n')
+            f.write('}\n')
+
+    with open(server_source, 'w') as f:
+        f.write(COPYRIGHT_HEADER)
+        f.write('#include <cinttypes>\n')
+        f.write('#include "esp_log.h"\n')
+        f.write('#include "esp_tls.h"\n')
+        f.write('#include "wifi_remote_rpc_impl.hpp"\n')
+        f.write('#include "wifi_remote_rpc_api.hpp"\n\n')
+        f.write('namespace eppp_rpc::server {\n\n')
+        f.write('esp_err_t dispatch(RpcEngine &rpc, RpcHeader &header)\n{\n')
+        f.write('    switch (header.id) {\n')
+        for func_name, short_name, ret_type, args, rpc_params in apis:
+            if func_name in RPC_MANUAL_API:
+                continue
+            id = short_name.upper()
+            f.write(f'    case api_id::{id}: {{\n')
+            inputs = [p for p in rpc_params if p.direction == 'in']
+            f.write(f'        if (header.size != {f"sizeof(api::{short_name}_req)" if inputs else "0"}) {{\n')
+            f.write('            return ESP_FAIL;\n')
+            f.write('        }\n')
+            if inputs:
+                f.write(f'        auto req = rpc.get_payload<api::{short_name}_req>(api_id::{id}, header);\n')
+            f.write(f'        api::{short_name}_resp resp = {{}};\n')
+            call_args = []
+            for p in rpc_params:
+                prefix = '&' if p.kind == 'pointer' else ''
+                call_args.append(f'{prefix}{"req" if p.direction == "in" else "resp"}.{p.name}')
+            f.write(f'        resp.ret = {func_name}({", ".join(call_args)});\n')
+            f.write(f'        return rpc.send(api_id::{id}, header.seq, &resp);\n')
+            f.write('    }\n')
+        f.write('    default:\n')
+        f.write('        ESP_LOGE("rpc_server", "Unknown API id %d", (int)header.id);\n')
+        f.write('        return ESP_FAIL;\n')
+        f.write('    }\n}\n\n')
+        f.write('}   // namespace eppp_rpc::server\n')
+
+    return [ids_header, api_header, client_source, server_source]
+
+
 def generate_wifi_native(idf_path, component_path):
     wifi_native = os.path.join(component_path, 'include', 'esp_wifi_types_native.h')
     native_header = os.path.join(idf_path, 'components', 'esp_wifi', 'include', 'local', 'esp_wifi_types_native.h')
@@ -367,6 +591,8 @@ making changes you might need to modify 'copyright_header.h' in the script direc
 
     files_to_check += generate_test_cases(function_prototypes, component_path)
 
+    files_to_check += generate_eppp_rpc(function_prototypes, component_path)
+
     files_to_check += generate_wifi_native(idf_path, component_path)
 
     files_to_check += generate_kconfig(idf_path, component_path)
@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#pragma once
+
+/*
+ * Stand-in for the control channel of the eppp link used by RpcEngine (CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL),
+ * which passes every message directly to the receiver of the other end, so that the benchmark measures
+ * the RPC engine with the channel's handshake and encryption, not an eppp transport
+ */
+#include <cstddef>
+#include "esp_err.h"
+
+#define EPPP_CHANNEL_MAX_SIZE 1400
+
+typedef void (*eppp_channel_rx_t)(void *ctx, const void *data, size_t len);
+
+struct esp_netif_obj {
+    eppp_channel_rx_t rx;
+    void *ctx;
+    struct esp_netif_obj *peer;
+};
+typedef struct esp_netif_obj esp_netif_t;
+
+static inline esp_err_t eppp_channel_register(esp_netif_t *netif, eppp_channel_rx_t rx, void *ctx)
+{
+    netif->ctx = ctx;
+    netif->rx = rx;
+    return ESP_OK;
+}
+
+static inline esp_err_t eppp_channel_send(esp_netif_t *netif, const void *data, size_t len)
+{
+    if (len > EPPP_CHANNEL_MAX_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_netif_t *peer = netif->peer;
+    if (peer->rx) {
+        peer->rx(peer->ctx, data, len);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,196 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#pragma once
+
+/*
+ * Stand-in for the esp_tls calls used by RpcEngine over one end of a socket pair:
+ * - plain socket, so that the benchmark measures the RPC engine itself
+ * - with CONFIG_RPC_BENCHMARK_TLS mbedTLS with mutual certificate authentication, as esp_tls
+ *   configures it for the RPC, so that the engine is measured with the cost of TLS
+ */
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "esp_err.h"
+#if CONFIG_RPC_BENCHMARK_TLS
+#include "mbedtls/ssl.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#if CONFIG_MBEDTLS_SSL_PROTO_TLS1_3
+#include "psa/crypto.h"
+#endif
+#include "rpc_bench_certs.h"
+#endif
+
+struct esp_tls {
+    int sockfd;
+#if CONFIG_RPC_BENCHMARK_TLS
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt ca;
+    mbedtls_x509_crt crt;
+    mbedtls_pk_context key;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+#endif
+};
+typedef struct esp_tls esp_tls_t;
+
+#if CONFIG_RPC_BENCHMARK_TLS
+static inline int rpc_bench_tls_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    ssize_t ret = send(*static_cast<int *>(ctx), buf, len, MSG_NOSIGNAL);
+    if (ret < 0) {
+        return errno == EINTR || errno == EAGAIN ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+    return ret;
+}
+
+static inline int rpc_bench_tls_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    ssize_t ret = recv(*static_cast<int *>(ctx), buf, len, 0);
+    if (ret < 0) {
+        return errno == EINTR || errno == EAGAIN ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+    return ret;
+}
+
+static inline void rpc_bench_tls_free(esp_tls_t *tls)
+{
+    mbedtls_ssl_free(&tls->ssl);
+    mbedtls_ssl_config_free(&tls->conf);
+    mbedtls_x509_crt_free(&tls->ca);
+    mbedtls_x509_crt_free(&tls->crt);
+    mbedtls_pk_free(&tls->key);
+    mbedtls_ctr_drbg_free(&tls->ctr_drbg);
+    mbedtls_entropy_free(&tls->entropy);
+}
+
+/**
+ * @brief Configures one end of the connection, the socket has to be set already
+ */
+static inline esp_err_t rpc_bench_tls_init(esp_tls_t *tls, bool server)
+{
+    mbedtls_ssl_init(&tls->ssl);
+    mbedtls_ssl_config_init(&tls->conf);
+    mbedtls_x509_crt_init(&tls->ca);
+    mbedtls_x509_crt_init(&tls->crt);
+    mbedtls_pk_init(&tls->key);
+    mbedtls_entropy_init(&tls->entropy);
+    mbedtls_ctr_drbg_init(&tls->ctr_drbg);
+#if CONFIG_MBEDTLS_SSL_PROTO_TLS1_3
+    if (psa_crypto_init() != PSA_SUCCESS) {
+        return ESP_FAIL;
+    }
+#endif
+    const char *crt = server ? rpc_bench_server_crt : rpc_bench_client_crt;
+    const char *key = server ? rpc_bench_server_key : rpc_bench_client_key;
+    if (mbedtls_ctr_drbg_seed(&tls->ctr_drbg, mbedtls_entropy_func, &tls->entropy, nullptr, 0) != 0 ||
+            mbedtls_x509_crt_parse(&tls->ca, (const unsigned char *)rpc_bench_ca_crt, sizeof(rpc_bench_ca_crt)) != 0 ||
+            mbedtls_x509_crt_parse(&tls->crt, (const unsigned char *)crt, strlen(crt) + 1) != 0 ||
+            mbedtls_pk_parse_key(&tls->key, (const unsigned char *)key, strlen(key) + 1, nullptr, 0, mbedtls_ctr_drbg_random, &tls->ctr_drbg) != 0 ||
+            mbedtls_ssl_config_defaults(&tls->conf, server ? MBEDTLS_SSL_IS_SERVER : MBEDTLS_SSL_IS_CLIENT,
+                                        MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        return ESP_FAIL;
+    }
+    mbedtls_ssl_conf_rng(&tls->conf, mbedtls_ctr_drbg_random, &tls->ctr_drbg);
+    mbedtls_ssl_conf_authmode(&tls->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&tls->conf, &tls->ca, nullptr);
+    if (mbedtls_ssl_conf_own_cert(&tls->conf, &tls->crt, &tls->key) != 0 ||
+            mbedtls_ssl_setup(&tls->ssl, &tls->conf) != 0 ||
+            (!server && mbedtls_ssl_set_hostname(&tls->ssl, "espressif.local") != 0)) {
+        return ESP_FAIL;
+    }
+    mbedtls_ssl_set_bio(&tls->ssl, &tls->sockfd, rpc_bench_tls_send, rpc_bench_tls_recv, nullptr);
+    return ESP_OK;
+}
+
+/**
+ * @brief Runs the handshake, the server's end is also completed by its first read
+ */
+static inline esp_err_t rpc_bench_tls_handshake(esp_tls_t *tls)
+{
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&tls->ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+#endif
+
+static inline ssize_t esp_tls_conn_write(esp_tls_t *tls, const void *data, size_t datalen)
+{
+    size_t written = 0;
+    while (written < datalen) {
+#if CONFIG_RPC_BENCHMARK_TLS
+        int len = mbedtls_ssl_write(&tls->ssl, (const unsigned char *)data + written, datalen - written);
+        if (len < 0) {
+            if (len == MBEDTLS_ERR_SSL_WANT_WRITE || len == MBEDTLS_ERR_SSL_WANT_READ) {
+                continue;
+            }
+            return -1;
+        }
+#else
+        ssize_t len = send(tls->sockfd, (const char *)data + written, datalen - written, MSG_NOSIGNAL);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+#endif
+        written += len;
+    }
+    return written;
+}
+
+static inline ssize_t esp_tls_conn_read(esp_tls_t *tls, void *data, size_t datalen)
+{
+#if CONFIG_RPC_BENCHMARK_TLS
+    int len = mbedtls_ssl_read(&tls->ssl, (unsigned char *)data, datalen);
+    if (len == MBEDTLS_ERR_SSL_WANT_READ || len == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        errno = EAGAIN;     // receive timeout of the client's socket
+        return -1;
+    }
+    if (len < 0) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    return len;
+#else
+    return recv(tls->sockfd, data, datalen, 0);
+#endif
+}
+
+static inline ssize_t esp_tls_get_bytes_avail(esp_tls_t *tls)
+{
+#if CONFIG_RPC_BENCHMARK_TLS
+    return mbedtls_ssl_get_bytes_avail(&tls->ssl);  // decrypted data, which select() on the socket doesn't see
+#else
+    return 0;   // no decrypted data is held back, select() on the socket sees everything
+#endif
+}
+
+static inline esp_err_t esp_tls_get_conn_sockfd(esp_tls_t *tls, int *sockfd)
+{
+    *sockfd = tls->sockfd;
+    return ESP_OK;
+}
+
+static inline int esp_tls_conn_destroy(esp_tls_t *tls)
+{
+    return 0;   // the socket pair is closed and the TLS contexts are freed by the benchmark
+}
+
+static inline void esp_tls_server_session_delete(esp_tls_t *tls)
+{
+}
@@ -0,0 +1,396 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cinttypes>
+#include <ctime>
+#include <algorithm>
+#include <sys/select.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+#include "rpc_bench_channel.h"
+#else
+#include "rpc_bench_tls.h"
+#endif
+#include "wifi_remote_rpc_impl.hpp"
+
+using namespace eppp_rpc;
+
+static const char *TAG = "rpc_benchmark";
+
+static constexpr int max_responses = PendingCalls::max_calls;
+static constexpr int callers[] = { 1, 2, 4, PendingCalls::max_calls };
+static constexpr int task_prio = 5;
+static constexpr int task_stack = 8192;
+static constexpr TickType_t call_timeout = pdMS_TO_TICKS(1000);
+static constexpr int connects = 100;
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+static constexpr const char *transport = "channel";
+static const char *psk = "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+#elif CONFIG_RPC_BENCHMARK_TLS
+static constexpr const char *transport = "tls";
+#else
+static constexpr const char *transport = "socket";
+#endif
+
+namespace eppp_rpc {
+
+/**
+ * @brief Both ends of the RPC connection in one process
+ */
+class RpcInstance {
+public:
+    RpcEngine client{role::CLIENT};
+    RpcEngine server{role::SERVER};
+    PendingCalls calls;
+    SemaphoreHandle_t write_lock{nullptr};  // serializes the requests of the calling tasks
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+    esp_netif_t netif[2] {};                // server's and client's end of the channel
+#else
+    esp_tls_t tls[2] {};                    // server's and client's end of the socket pair
+#endif
+};
+
+static RpcInstance s_rpc;
+
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+static esp_err_t channel_send(void *netif, const void *data, size_t len)
+{
+    return eppp_channel_send(static_cast<esp_netif_t *>(netif), data, len);
+}
+
+RpcInstance *RpcEngine::init_server()
+{
+    // the session is opened when the server task reads the client's HELLO
+    ESP_RETURN_ON_FALSE(channel_.open(true, psk, max_message_size, channel_rx_size, channel_send, &s_rpc.netif[0]) == ESP_OK &&
+                        eppp_channel_register(&s_rpc.netif[0], RpcChannel::receive, &channel_) == ESP_OK, nullptr, TAG, "Failed to open the channel");
+    return &s_rpc;
+}
+
+RpcInstance *RpcEngine::init_client()
+{
+    ESP_RETURN_ON_FALSE(channel_.open(false, psk, max_message_size, channel_rx_size, channel_send, &s_rpc.netif[1]) == ESP_OK &&
+                        eppp_channel_register(&s_rpc.netif[1], RpcChannel::receive, &channel_) == ESP_OK, nullptr, TAG, "Failed to open the channel");
+    return channel_.connect(pdMS_TO_TICKS(1000)) == ESP_OK ? &s_rpc : nullptr;
+}
+#elif CONFIG_RPC_BENCHMARK_TLS
+RpcInstance *RpcEngine::init_server()
+{
+    // the handshake is completed when the server task reads the first request
+    tls_ = &s_rpc.tls[0];
+    ESP_RETURN_ON_FALSE(rpc_bench_tls_init(tls_, true) == ESP_OK, nullptr, TAG, "Failed to configure TLS server");
+    return &s_rpc;
+}
+
+RpcInstance *RpcEngine::init_client()
+{
+    tls_ = &s_rpc.tls[1];
+    ESP_RETURN_ON_FALSE(rpc_bench_tls_init(tls_, false) == ESP_OK && rpc_bench_tls_handshake(tls_) == ESP_OK,
+                        nullptr, TAG, "Failed to connect TLS client");
+    return &s_rpc;
+}
+#else
+RpcInstance *RpcEngine::init_server()
+{
+    tls_ = &s_rpc.tls[0];
+    return &s_rpc;
+}
+
+RpcInstance *RpcEngine::init_client()
+{
+    tls_ = &s_rpc.tls[1];
+    return &s_rpc;
+}
+#endif
+
+}   // namespace eppp_rpc
+
+static struct {
+    volatile bool stop;         // stops the server and the client's receiving task
+    volatile bool run_stop;     // stops the calling tasks of one run
+    SemaphoreHandle_t done;
+    uint32_t completed[PendingCalls::max_calls];
+    uint32_t errors;
+} s_bench;
+
+static int64_t now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Answers every request after the simulated round-trip time (1x to 2x, depending on the correlation ID),
+ * without blocking the next requests, so that the responses come in a different order than the requests
+ */
+static void server_task(void *arg)
+{
+    struct Response {
+        uint32_t seq;
+        int32_t value;
+        int64_t due_us;
+    } queued[max_responses];
+    int count = 0;
+    auto &server = s_rpc.server;
+    int fd = server.get_socket_fd();
+
+    while (!s_bench.stop) {
+        int64_t wait_us = 10000;
+        for (int i = 0; i < count; ++i) {
+            wait_us = std::min(wait_us, queued[i].due_us - now_us());
+        }
+        bool readable = server.has_data();
+        if (!readable && wait_us > 0) {
+            fd_set readset;
+            FD_ZERO(&readset);
+            FD_SET(fd, &readset);
+            struct timeval timeout = { .tv_sec = 0, .tv_usec = (suseconds_t)wait_us };
+            readable = select(fd + 1, &readset, nullptr, nullptr, &timeout) > 0;
+        }
+        while (readable && count < max_responses) {
+            auto header = server.get_header();
+            if (header.id == api_id::ERROR) {
+                ESP_LOGE(TAG, "Server failed to read the request");
+                s_bench.stop = true;
+                break;
+            }
+            if (header.id == api_id::UNDEF) {
+                break;
+            }
+            auto value = server.get_payload<int32_t>(api_id::SET_MODE, header);
+            int64_t latency = CONFIG_RPC_BENCHMARK_LATENCY_US + (header.seq % 3) * CONFIG_RPC_BENCHMARK_LATENCY_US / 2;
+            queued[count++] = { .seq = header.seq, .value = value + 1, .due_us = now_us() + latency };
+            readable = server.has_data();
+        }
+        int64_t now = now_us();
+        for (int i = 0; i < count;) {
+            if (queued[i].due_us > now) {
+                ++i;
+                continue;
+            }
+            if (server.send(api_id::SET_MODE, queued[i].seq, &queued[i].value) != ESP_OK) {
+                s_bench.stop = true;
+            }
+            queued[i] = queued[--count];
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+static void client_task(void *arg)
+{
+    auto &client = s_rpc.client;
+    while (!s_bench.stop) {
+        auto header = client.get_header();
+        if (header.id == api_id::ERROR) {
+            break;
+        }
+        if (header.id == api_id::UNDEF) {   // receive timeout
+            continue;
+        }
+        if (s_rpc.calls.complete(header, client.get_payload()) != ESP_OK) {
+            ESP_LOGE(TAG, "Unexpected response seq %" PRIu32, header.seq);
+            s_bench.errors++;
+        }
+    }
+    s_rpc.calls.fail_all();
+    vTaskDelete(nullptr);
+}
+
+static esp_err_t call(int32_t value, int32_t *resp)
+{
+    auto pending = s_rpc.calls.add(api_id::SET_MODE, resp, sizeof(*resp));
+    xSemaphoreTake(s_rpc.write_lock, portMAX_DELAY);
+    esp_err_t ret = s_rpc.client.send(api_id::SET_MODE, pending->seq, &value);
+    xSemaphoreGive(s_rpc.write_lock);
+    if (ret != ESP_OK) {
+        s_rpc.calls.release(pending);
+        return ret;
+    }
+    return s_rpc.calls.wait(pending, call_timeout);
+}
+
+static void caller_task(void *arg)
+{
+    int index = (intptr_t)arg;
+    int32_t value = index * 1000000;
+    while (!s_bench.run_stop && !s_bench.stop) {
+        int32_t resp = 0;
+        if (call(value, &resp) != ESP_OK || resp != value + 1) {
+            s_bench.errors++;
+        } else {
+            s_bench.completed[index]++;
+        }
+        value++;
+    }
+    xSemaphoreGive(s_bench.done);
+    vTaskDelete(nullptr);
+}
+
+static esp_err_t bench_calls(FILE *output, int tasks, bool first)
+{
+    for (auto &completed : s_bench.completed) {
+        completed = 0;
+    }
+    s_bench.errors = 0;
+    s_bench.run_stop = false;
+    for (int i = 0; i < tasks; ++i) {
+        ESP_RETURN_ON_FALSE(xTaskCreate(caller_task, "caller", task_stack, (void *)(intptr_t)i, task_prio, nullptr) == pdTRUE,
+                            ESP_FAIL, TAG, "Failed to create the caller task");
+    }
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_RPC_BENCHMARK_DURATION_MS));
+    s_bench.run_stop = true;
+    for (int i = 0; i < tasks; ++i) {
+        xSemaphoreTake(s_bench.done, portMAX_DELAY);
+    }
+    uint32_t completed = 0;
+    for (int i = 0; i < tasks; ++i) {
+        completed += s_bench.completed[i];
+    }
+    double calls_per_sec = completed * 1000.0 / CONFIG_RPC_BENCHMARK_DURATION_MS;
+    ESP_LOGI(TAG, "calls in flight=%d  %9.1f calls/s  errors=%" PRIu32, tasks, calls_per_sec, s_bench.errors);
+    fprintf(output, "%s\n  {\"test\": \"calls\", \"transport\": \"%s\", \"in_flight\": %d, \"latency_us\": %d, \"calls\": %" PRIu32 ", \"calls_per_sec\": %.1f, \"errors\": %" PRIu32 "}",
+            first ? "" : ",", transport, tasks, CONFIG_RPC_BENCHMARK_LATENCY_US, completed, calls_per_sec, s_bench.errors);
+    return s_bench.errors == 0 ? ESP_OK : ESP_FAIL;
+}
+
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+/*
+ * Opens new sessions of the channel one after another (handshake and key derivation on both ends),
+ * the server task answers the client's HELLO
+ */
+static esp_err_t bench_connect(FILE *output)
+{
+    esp_log_level_set("rpc", ESP_LOG_WARN);
+    esp_log_level_set("rpc_channel", ESP_LOG_WARN);
+    int64_t start = now_us();
+    for (int i = 0; i < connects; ++i) {
+        s_rpc.client.deinit();
+        ESP_RETURN_ON_ERROR(s_rpc.client.init(), TAG, "Failed to reconnect");
+    }
+    int64_t connect_us = (now_us() - start) / connects;
+    esp_log_level_set("rpc", ESP_LOG_INFO);
+    esp_log_level_set("rpc_channel", ESP_LOG_INFO);
+    ESP_LOGI(TAG, "connect  %6" PRIi64 " us", connect_us);
+    fprintf(output, "\n  {\"test\": \"connect\", \"transport\": \"%s\", \"connects\": %d, \"connect_us\": %" PRIi64 "},", transport, connects, connect_us);
+    return ESP_OK;
+}
+#elif CONFIG_RPC_BENCHMARK_TLS
+static void handshake_task(void *arg)
+{
+    if (rpc_bench_tls_handshake(static_cast<esp_tls_t *>(arg)) != ESP_OK) {
+        s_bench.errors++;
+    }
+    xSemaphoreGive(s_bench.done);
+    vTaskDelete(nullptr);
+}
+
+/*
+ * Opens new TLS connections one after another (certificate parsing and the handshake with mutual
+ * authentication on both ends, as esp_tls_conn_new_sync() and esp_tls_server_session_create() do),
+ * each over a new socket pair, as the engine's connection is in use by the server task
+ */
+static esp_err_t bench_connect(FILE *output)
+{
+    int64_t start = now_us();
+    for (int i = 0; i < connects; ++i) {
+        static esp_tls_t tls[2];
+        int fds[2];
+        ESP_RETURN_ON_FALSE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0, ESP_FAIL, TAG, "Failed to create socketpair");
+        tls[0].sockfd = fds[0];
+        tls[1].sockfd = fds[1];
+        esp_err_t ret = ESP_FAIL;
+        if (rpc_bench_tls_init(&tls[0], true) == ESP_OK && rpc_bench_tls_init(&tls[1], false) == ESP_OK &&
+                xTaskCreate(handshake_task, "handshake", task_stack, &tls[0], task_prio, nullptr) == pdTRUE) {
+            ret = rpc_bench_tls_handshake(&tls[1]);
+            if (ret != ESP_OK) {
+                shutdown(fds[1], SHUT_RDWR);    // the server's end fails too
+            }
+            xSemaphoreTake(s_bench.done, portMAX_DELAY);
+        }
+        rpc_bench_tls_free(&tls[0]);
+        rpc_bench_tls_free(&tls[1]);
+        close(fds[0]);
+        close(fds[1]);
+        ESP_RETURN_ON_FALSE(ret == ESP_OK && s_bench.errors == 0, ESP_FAIL, TAG, "Failed to connect");
+    }
+    int64_t connect_us = (now_us() - start) / connects;
+    ESP_LOGI(TAG, "connect  %6" PRIi64 " us", connect_us);
+    fprintf(output, "\n  {\"test\": \"connect\", \"transport\": \"%s\", \"connects\": %d, \"connect_us\": %" PRIi64 "},", transport, connects, connect_us);
+    return ESP_OK;
+}
+#endif
+
+extern "C" void app_main(void)
+{
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+    s_rpc.netif[0].peer = &s_rpc.netif[1];
+    s_rpc.netif[1].peer = &s_rpc.netif[0];
+#else
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        ESP_LOGE(TAG, "Failed to create socketpair");
+        exit(1);
+    }
+    // the client's receiving task wakes up periodically to check for the end of the benchmark
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = 100000 };
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    s_rpc.tls[0].sockfd = fds[0];
+    s_rpc.tls[1].sockfd = fds[1];
+#endif
+
+    s_bench.done = xSemaphoreCreateCounting(PendingCalls::max_calls, 0);
+    s_rpc.write_lock = xSemaphoreCreateMutex();
+    FILE *output = fopen(CONFIG_RPC_BENCHMARK_OUTPUT_FILE, "w");
+    if (s_bench.done == nullptr || s_rpc.write_lock == nullptr || output == nullptr ||
+            s_rpc.calls.init() != ESP_OK || s_rpc.server.init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize the benchmark");
+        exit(1);
+    }
+    // the server task runs first, as the client's handshake waits for its answer
+    xTaskCreate(server_task, "server", task_stack, nullptr, task_prio + 1, nullptr);
+    if (s_rpc.client.init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to connect the client");
+        exit(1);
+    }
+    fprintf(output, "[");
+    int ret = 0;
+#if CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL || CONFIG_RPC_BENCHMARK_TLS
+    if (bench_connect(output) != ESP_OK) {
+        exit(1);
+    }
+#endif
+    xTaskCreate(client_task, "client", task_stack, nullptr, task_prio + 1, nullptr);
+
+    // one call in flight is how the engine worked before pipelining: every call waits for the previous one
+    for (int tasks : callers) {
+        if (bench_calls(output, tasks, tasks == callers[0]) != ESP_OK) {
+            ret = 1;
+        }
+    }
+    fprintf(output, "\n]\n");
+    fclose(output);
+    ESP_LOGI(TAG, "Results written to %s", CONFIG_RPC_BENCHMARK_OUTPUT_FILE);
+
+    s_bench.stop = true;
+    vTaskDelay(pdMS_TO_TICKS(200));
+    s_rpc.client.deinit();
+    s_rpc.server.deinit();
+#if CONFIG_RPC_BENCHMARK_TLS
+    rpc_bench_tls_free(&s_rpc.tls[0]);
+    rpc_bench_tls_free(&s_rpc.tls[1]);
+#endif
+#if !CONFIG_ESP_WIFI_REMOTE_EPPP_RPC_CHANNEL
+    close(fds[0]);
+    close(fds[1]);
+#endif
+    exit(ret);
+}
@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include "esp_log.h"
+#include "wifi_remote_rpc_cache.hpp"
+
+using namespace eppp_rpc;
+
+static const char *TAG = "rpc_cache";
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                 \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            ESP_LOGE(TAG, "%s:%d: %s failed", __func__, __LINE__, #cond); \
+            s_failures++;                                           \
+        }                                                           \
+    } while (0)
+
+// response of a getter: every response starts with the return value
+struct Response {
+    esp_err_t ret;
+    uint32_t value;
+};
+
+static bool get(ResponseCache &cache, api_id id, uint32_t req, uint32_t *value)
+{
+    Response resp = {};
+    if (!cache.get(id, &req, sizeof(req), &resp, sizeof(resp))) {
+        return false;
+    }
+    *value = resp.value;
+    return true;
+}
+
+static void put(ResponseCache &cache, api_id id, uint32_t req, uint32_t value)
+{
+    Response resp = { ESP_OK, value };
+    cache.put(id, &req, sizeof(req), &resp, sizeof(resp), cache.generation());
+}
+
+static void test_hit_and_miss(ResponseCache &cache)
+{
+    uint32_t value = 0;
+    CHECK(!get(cache, api_id::GET_MODE, 1, &value));
+    put(cache, api_id::GET_MODE, 1, 42);
+    CHECK(get(cache, api_id::GET_MODE, 1, &value) && value == 42);
+    // keyed by the API and the whole request
+    CHECK(!get(cache, api_id::GET_MODE, 2, &value));
+    CHECK(!get(cache, api_id::GET_MAC, 1, &value));
+    // a different response size doesn't match either
+    Response resp;
+    uint32_t req = 1;
+    CHECK(!cache.get(api_id::GET_MODE, &req, sizeof(req), &resp, sizeof(resp.ret)));
+    cache.invalidate();
+}
+
+static void test_invalidate(ResponseCache &cache)
+{
+    uint32_t value = 0;
+    put(cache, api_id::GET_MODE, 1, 1);
+    put(cache, api_id::GET_MAC, 0, 2);
+    cache.invalidate();
+    CHECK(!get(cache, api_id::GET_MODE, 1, &value));
+    CHECK(!get(cache, api_id::GET_MAC, 0, &value));
+    // the cache is usable again after the invalidation
+    put(cache, api_id::GET_MODE, 1, 3);
+    CHECK(get(cache, api_id::GET_MODE, 1, &value) && value == 3);
+    cache.invalidate();
+}
+
+static void test_stale_response(ResponseCache &cache)
+{
+    // a getter sends its request, a setter invalidates the cache before the getter's response arrives
+    uint32_t generation = cache.generation();
+    cache.invalidate();
+    uint32_t req = 1;
+    Response resp = { ESP_OK, 7 };
+    cache.put(api_id::GET_MODE, &req, sizeof(req), &resp, sizeof(resp), generation);
+    uint32_t value = 0;
+    CHECK(!get(cache, api_id::GET_MODE, 1, &value));
+    // the response of a request sent after the invalidation is stored
+    cache.put(api_id::GET_MODE, &req, sizeof(req), &resp, sizeof(resp), cache.generation());
+    CHECK(get(cache, api_id::GET_MODE, 1, &value) && value == 7);
+    cache.invalidate();
+}
+
+static void test_no_request(ResponseCache &cache)
+{
+    Response resp = { ESP_OK, 5 };
+    cache.put(api_id::GET_PS, nullptr, 0, &resp, sizeof(resp), cache.generation());
+    Response cached = {};
+    CHECK(cache.get(api_id::GET_PS, nullptr, 0, &cached, sizeof(cached)) && cached.value == 5);
+    cache.invalidate();
+    CHECK(!cache.get(api_id::GET_PS, nullptr, 0, &cached, sizeof(cached)));
+}
+
+static void test_eviction(ResponseCache &cache)
+{
+    // the oldest entry is replaced when the cache is full
+    for (uint32_t i = 0; i <= ResponseCache::max_entries; ++i) {
+        put(cache, api_id::GET_CONFIG, i, i + 100);
+    }
+    uint32_t value = 0;
+    CHECK(!get(cache, api_id::GET_CONFIG, 0, &value));
+    for (uint32_t i = 1; i <= ResponseCache::max_entries; ++i) {
+        CHECK(get(cache, api_id::GET_CONFIG, i, &value) && value == i + 100);
+    }
+    cache.invalidate();
+}
+
+extern "C" void app_main(void)
+{
+    ResponseCache cache;
+    if (cache.init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize the cache");
+        exit(1);
+    }
+    test_hit_and_miss(cache);
+    test_invalidate(cache);
+    test_stale_response(cache);
+    test_no_request(cache);
+    test_eviction(cache);
+    if (s_failures) {
+        ESP_LOGE(TAG, "%d check(s) failed", s_failures);
+        exit(1);
+    }
+    ESP_LOGI(TAG, "All checks passed");
+    exit(0);
+}
@@ -0,0 +1,460 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <unistd.h>
+#include "dtls_server.hpp"
+
+using namespace idf::mbedtls_cxx;
+
+namespace {
+// record header of DTLS 1.2 with connection ID: type, version, epoch, sequence number, CID, length
+constexpr size_t cid_offset = 11;
+constexpr size_t wheel_slots = 64;
+// the whole datagram is read at once, it could carry a flight of several handshake messages
+constexpr size_t max_datagram = MBEDTLS_SSL_IN_CONTENT_LEN + 256;
+}
+
+void TimerWheel::schedule(Node *node)
+{
+    uint64_t tick = node->expires / tick_ms_;
+    if (tick <= current_) {
+        tick = current_ + 1;    // already expired, visited in the next advance()
+    }
+    node->slot = tick % slots_.size();
+    Node *&head = slots_[node->slot];
+    node->prev = nullptr;
+    node->next = head;
+    if (head) {
+        head->prev = node;
+    }
+    head = node;
+    node->linked = true;
+}
+
+void TimerWheel::cancel(Node *node)
+{
+    if (!node->linked) {
+        return;
+    }
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        slots_[node->slot] = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    node->prev = node->next = nullptr;
+    node->linked = false;
+}
+
+TimerWheel::Node *TimerWheel::advance(uint64_t now)
+{
+    Node *expired = nullptr;
+    uint64_t target = now / tick_ms_;
+    uint64_t first = std::max(current_ + 1, target >= slots_.size() ? target - slots_.size() + 1 : 0);
+    for (uint64_t tick = first; tick <= target; ++tick) {
+        Node *node = slots_[tick % slots_.size()];
+        while (node) {
+            Node *next = node->next;
+            if (node->expires <= now) {
+                cancel(node);
+                node->next = expired;
+                expired = node;
+            } else if ((node->expires / tick_ms_) % slots_.size() != tick % slots_.size()) {
+                // postponed since scheduled
+                cancel(node);
+                schedule(node);
+            }
+            node = next;
+        }
+    }
+    // the current tick is visited again, its nodes could expire later within the tick
+    current_ = std::max(current_, target ? target - 1 : 0);
+    return expired;
+}
+
+int DtlsServer::Peer::send(const unsigned char *buf, size_t len)
+{
+    replied_ = true;
+    int ret = ::sendto(server_.sock_, buf, len, 0, address(), addr_len_);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    return ret;
+}
+
+int DtlsServer::Peer::recv(unsigned char *buf, size_t len)
+{
+    if (input_ == nullptr) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    len = std::min(len, input_len_);
+    memcpy(buf, input_, len);
+    input_ = nullptr;
+    return static_cast<int>(len);
+}
+
+void DtlsServer::Peer::close()
+{
+    if (connected_) {
+        mbedtls_ssl_close_notify(&ssl_);
+    }
+    closing_ = true;
+    expires = 0;
+    server_.wheel_->cancel(this);
+    server_.wheel_->schedule(this);
+}
+
+bool DtlsServer::Peer::start(const SharedConfig::ptr &config)
+{
+    if (!init(config)) {
+        return false;
+    }
+    mbedtls_ssl_set_bio(&ssl_, this, [](void *ctx, const unsigned char *buf, size_t len) {
+        return static_cast<Peer *>(ctx)->send(buf, len);
+    }, [](void *ctx, unsigned char *buf, size_t len) {
+        return static_cast<Peer *>(ctx)->recv(buf, len);
+    }, nullptr);
+    return true;
+}
+
+bool DtlsServer::Peer::accept(const sockaddr_storage &addr, socklen_t addr_len, const std::string &key)
+{
+    addr_ = addr;
+    addr_len_ = addr_len;
+    key_ = key;
+    client_id_ = const_buf{reinterpret_cast<const unsigned char *>(key_.data()), key_.size()};
+    if (!set_client_id()) {     // also resets the session
+        return false;
+    }
+    size_t cid_len = server_.config_->cid_len();
+    if (cid_len) {
+        cid_.resize(cid_len);
+        if (server_.config_->random(reinterpret_cast<unsigned char *>(&cid_[0]), cid_len) != 0 ||
+                !set_cid(const_buf{reinterpret_cast<const unsigned char *>(cid_.data()), cid_len})) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DtlsServer::~DtlsServer()
+{
+    close();
+}
+
+bool DtlsServer::open(const SharedConfig::ptr &config, const Config &server)
+{
+    if (config == nullptr || !config->is_server() || !config->is_dtls() || config->timeout() == 0) {
+        printf("DTLS server needs a shared DTLS server config with non-zero timeout\n");
+        return false;
+    }
+    close();
+    config_ = config;
+    server_ = server;
+    sock_ = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock_ < 0) {
+        printf("Failed to create socket: errno %d\n", errno);
+        return false;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server.port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (::bind(sock_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        printf("Failed to bind socket: errno %d\n", errno);
+        close();
+        return false;
+    }
+    buffer_.resize(max_datagram);
+    wheel_ = std::make_unique<TimerWheel>(wheel_slots, server.tick_ms);
+    wheel_->advance(now_ms());
+    listener_.reset(new Peer(*this));
+    if (!listener_->start(config_)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void DtlsServer::close()
+{
+    for (auto &it : by_addr_) {
+        if (it.second->connected_ && !it.second->closing_) {
+            mbedtls_ssl_close_notify(&it.second->ssl_);
+        }
+    }
+    by_cid_.clear();
+    by_addr_.clear();
+    listener_.reset();
+    wheel_.reset();
+    handshakes_ = 0;
+    if (sock_ >= 0) {
+        ::close(sock_);
+        sock_ = -1;
+    }
+}
+
+bool DtlsServer::poll(uint32_t timeout_ms)
+{
+    if (sock_ < 0) {
+        return false;
+    }
+    timeout_ms = std::min(timeout_ms, server_.tick_ms);
+    timeval tv{ static_cast<time_t>(timeout_ms / 1000), static_cast<suseconds_t>((timeout_ms % 1000) * 1000) };
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET(sock_, &read_fds);
+    int ret = ::select(sock_ + 1, &read_fds, nullptr, nullptr, &tv);
+    if (ret < 0 && errno != EINTR) {
+        printf("select() failed: errno %d\n", errno);
+        return false;
+    }
+    while (ret > 0) {
+        sockaddr_storage addr{};
+        socklen_t addr_len = sizeof(addr);
+        int len = ::recvfrom(sock_, buffer_.data(), buffer_.size(), MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&addr), &addr_len);
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;
+            }
+            printf("recvfrom() failed: errno %d\n", errno);
+            return false;
+        }
+        dispatch(buffer_.data(), len, addr, addr_len);
+    }
+    expire();
+    return true;
+}
+
+void DtlsServer::dispatch(const unsigned char *data, size_t len, const sockaddr_storage &addr, socklen_t addr_len)
+{
+    std::string key = address_key(addr);
+    Peer *peer = find_by_cid(data, len);
+    if (peer == nullptr) {
+        auto it = by_addr_.find(key);
+        if (it == by_addr_.end()) {
+            listener_->input_ = data;
+            listener_->input_len_ = len;
+            accept(addr, addr_len, std::move(key));
+            listener_->input_ = nullptr;
+            return;
+        }
+        peer = it->second.get();
+    }
+    peer->input_ = data;
+    peer->input_len_ = len;
+    process(peer, addr, addr_len);
+}
+
+void DtlsServer::accept(const sockaddr_storage &addr, socklen_t addr_len, std::string key)
+{
+    if (listener_ == nullptr || by_addr_.size() >= server_.max_peers) {
+        return;
+    }
+    if (!listener_->accept(addr, addr_len, key)) {
+        return;
+    }
+    int ret = listener_->advance();
+    if (!listener_->hello_verified(ret)) {
+        // HelloVerifyRequest sent, or no complete ClientHello: nothing is kept for this peer
+        return;
+    }
+    // the ClientHello had a valid cookie: the listener continues as the session of this peer
+    Peer *peer = listener_.get();
+    by_addr_.emplace(std::move(key), std::move(listener_));
+    if (!peer->cid_.empty()) {
+        by_cid_.emplace(peer->cid_, peer);
+    }
+    ++handshakes_;
+    touch(peer);
+    wheel_->schedule(peer);
+    listener_.reset(new Peer(*this));
+    if (!listener_->start(config_)) {
+        listener_.reset();
+    }
+}
+
+int DtlsServer::Peer::advance()
+{
+    replied_ = false;
+    int ret = mbedtls_ssl_handshake(&ssl_);
+    input_ = nullptr;
+    return ret;
+}
+
+bool DtlsServer::Peer::hello_verified(int ret) const
+{
+    // only the public results of the handshake are used, not its internal state:
+    // - a missing or invalid cookie is answered by HelloVerifyRequest, mbedtls_ssl_handshake()
+    //   returns MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED
+    // - a ClientHello with a valid cookie is answered by the ServerHello flight, then the handshake
+    //   waits for the peer's flight
+    // - an incomplete or ignored record isn't answered at all
+    return (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) && replied_;
+}
+
+bool DtlsServer::Peer::set_transport_id()
+{
+    // unlike set_client_id(), the session is kept
+    int ret = mbedtls_ssl_set_client_transport_id(&ssl_, client_id_.first, client_id_.second);
+    if (ret != 0) {
+        printf("mbedtls_ssl_set_client_transport_id() returned -0x%04X\n", -ret);
+        return false;
+    }
+    return true;
+}
+
+void DtlsServer::process(Peer *peer, const sockaddr_storage &addr, socklen_t addr_len)
+{
+    if (!peer->connected_) {
+        int ret = peer->advance();
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            touch(peer);
+            return;
+        }
+        if (ret != 0) {
+            remove(peer);
+            return;
+        }
+        peer->connected_ = true;
+        --handshakes_;
+        touch(peer);
+        on_connect(*peer);
+    }
+    bool rebound = false;
+    while (true) {
+        // the datagram has been copied to the session before the plaintext is written to the buffer
+        int ret = mbedtls_ssl_read(&peer->ssl_, buffer_.data(), buffer_.size());
+        if (ret > 0) {
+            if (!rebound && address_key(addr) != peer->key_) {
+                // authenticated record with the peer's connection ID from a new address
+                std::string key = address_key(addr);
+                auto stale = by_addr_.find(key);
+                if (stale != by_addr_.end()) {
+                    remove(stale->second.get());
+                }
+                auto node = by_addr_.extract(peer->key_);
+                node.key() = key;
+                by_addr_.insert(std::move(node));
+                peer->addr_ = addr;
+                peer->addr_len_ = addr_len;
+                peer->key_ = std::move(key);
+                peer->client_id_ = const_buf{reinterpret_cast<const unsigned char *>(peer->key_.data()), peer->key_.size()};
+                // a reconnecting client is recognized by its new address
+                if (!peer->set_transport_id()) {
+                    remove(peer);
+                    return;
+                }
+            }
+            rebound = true;
+            touch(peer);
+            on_receive(*peer, buffer_.data(), ret);
+            continue;
+        }
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return;
+        }
+        if (ret == MBEDTLS_ERR_SSL_CLIENT_RECONNECT) {
+            // new handshake of the client from the same address, the session has been reset
+            peer->connected_ = false;
+            ++handshakes_;
+            on_close(*peer);
+            process(peer, addr, addr_len);
+            return;
+        }
+        remove(peer);   // close notify or a fatal error
+        return;
+    }
+}
+
+DtlsServer::Peer *DtlsServer::find_by_cid(const unsigned char *data, size_t len)
+{
+    size_t cid_len = config_->cid_len();
+    if (by_cid_.empty() || len < cid_offset + cid_len || data[0] != MBEDTLS_SSL_MSG_CID) {
+        return nullptr;
+    }
+    auto it = by_cid_.find(std::string(reinterpret_cast<const char *>(data + cid_offset), cid_len));
+    return it == by_cid_.end() ? nullptr : it->second;
+}
+
+void DtlsServer::remove(Peer *peer)
+{
+    if (peer->connected_) {
+        on_close(*peer);
+    } else {
+        --handshakes_;
+    }
+    wheel_->cancel(peer);
+    if (!peer->cid_.empty()) {
+        by_cid_.erase(peer->cid_);
+    }
+    std::string key = peer->key_;
+    by_addr_.erase(key);
+}
+
+void DtlsServer::touch(Peer *peer)
+{
+    if (!peer->closing_) {
+        peer->expires = now_ms() + server_.idle_timeout_ms;
+    }
+}
+
+void DtlsServer::expire()
+{
+    TimerWheel::Node *node = wheel_->advance(now_ms());
+    while (node) {
+        auto *peer = static_cast<Peer *>(node);
+        node = TimerWheel::next_expired(node);
+        if (peer->connected_ && !peer->closing_) {
+            mbedtls_ssl_close_notify(&peer->ssl_);
+        }
+        remove(peer);
+    }
+    if (handshakes_ == 0) {
+        return;
+    }
+    // retransmissions of the handshake flights
+    std::vector<Peer *> pending;
+    for (auto &it : by_addr_) {
+        if (!it.second->connected_ && mbedtls_timing_get_delay(&it.second->timer_) == 2) {
+            pending.push_back(it.second.get());
+        }
+    }
+    for (auto *peer : pending) {
+        process(peer, peer->addr_, peer->addr_len_);
+    }
+}
+
+std::string DtlsServer::address_key(const sockaddr_storage &addr)
+{
+    std::string key(1, static_cast<char>(addr.ss_family));
+    if (addr.ss_family == AF_INET) {
+        auto *in = reinterpret_cast<const sockaddr_in *>(&addr);
+        key.append(reinterpret_cast<const char *>(&in->sin_port), sizeof(in->sin_port));
+        key.append(reinterpret_cast<const char *>(&in->sin_addr), sizeof(in->sin_addr));
+    }
+#if CONFIG_LWIP_IPV6 || CONFIG_IDF_TARGET_LINUX
+    else if (addr.ss_family == AF_INET6) {
+        auto *in6 = reinterpret_cast<const sockaddr_in6 *>(&addr);
+        key.append(reinterpret_cast<const char *>(&in6->sin6_port), sizeof(in6->sin6_port));
+        key.append(reinterpret_cast<const char *>(&in6->sin6_addr), sizeof(in6->sin6_addr));
+    }
+#endif
+    return key;
+}
+
+uint64_t DtlsServer::now_ms()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "dtls_server.hpp"
+#include "test_certs.hpp"
+
+namespace {
+constexpr auto *TAG = "dtls_server";
+constexpr uint16_t port = 3334;
+constexpr int clients = 4;
+constexpr size_t cid_len = 8;
+constexpr uint32_t idle_timeout_ms = 3000;
+}
+
+using namespace idf::mbedtls_cxx;
+using namespace test_certs;
+
+/**
+ * @brief Echoes every message back to the peer
+ */
+class EchoServer: public DtlsServer {
+protected:
+    void on_connect(Peer &peer) override
+    {
+        ESP_LOGI(TAG, "[server] peer %d connected (%d sessions)", peer_port(peer), (int)peers());
+    }
+    void on_receive(Peer &peer, const unsigned char *data, size_t len) override
+    {
+        ESP_LOGI(TAG, "[server] received from %d: %.*s", peer_port(peer), (int)len, data);
+        peer.write(data, len);
+    }
+    void on_close(Peer &peer) override
+    {
+        ESP_LOGI(TAG, "[server] peer %d closed", peer_port(peer));
+    }
+
+private:
+    static int peer_port(const Peer &peer)
+    {
+        return ntohs(reinterpret_cast<const sockaddr_in *>(peer.address())->sin_port);
+    }
+};
+
+/**
+ * @brief DTLS client on a connected UDP socket, which could be replaced in the same session
+ */
+class Client: public Tls {
+public:
+    ~Client() override
+    {
+        if (sock >= 0) {
+            ::close(sock);
+        }
+    }
+    int send(const unsigned char *buf, size_t len) override
+    {
+        return ::send(sock, buf, len, 0);
+    }
+    int recv(unsigned char *buf, size_t len) override
+    {
+        return ::recv(sock, buf, len, 0);
+    }
+    int recv_timeout(unsigned char *buf, size_t len, int timeout) override
+    {
+        struct timeval tv {
+            timeout / 1000, (timeout % 1000 ) * 1000
+        };
+        fd_set read_fds;
+        FD_ZERO( &read_fds );
+        FD_SET( sock, &read_fds );
+
+        int ret = select(sock + 1, &read_fds, nullptr, nullptr, timeout == 0 ? nullptr : &tv);
+        if (ret == 0) {
+            return MBEDTLS_ERR_SSL_TIMEOUT;
+        }
+        if (ret < 0) {
+            if (errno == EINTR) {
+                return MBEDTLS_ERR_SSL_WANT_READ;
+            }
+            return ret;
+        }
+        return recv(buf, len);
+    }
+    /**
+     * @brief Opens a new socket with another local port, as if NAT changed the client's address
+     */
+    bool rebind()
+    {
+        if (sock >= 0) {
+            ::close(sock);
+        }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        return sock >= 0 && connect(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+    }
+    bool open(const SharedConfig::ptr &config)
+    {
+        // the client doesn't change the server's address, its own connection ID is empty
+        return rebind() && init(config) && set_hostname(get_server_cn()) && set_cid(const_buf{}) && handshake() == 0;
+    }
+    bool echo(const char *message)
+    {
+        unsigned char reply[64];
+        int len = strlen(message);
+        if (write(reinterpret_cast<const unsigned char *>(message), len) < 0) {
+            return false;
+        }
+        return read(reply, sizeof(reply)) == len;
+    }
+
+private:
+    int sock{-1};
+};
+
+namespace {
+
+void tls_client(int id, const SharedConfig::ptr &config, std::atomic<int> &done)
+{
+    Client client;
+    char message[32];
+    if (!client.open(config)) {
+        ESP_LOGE(TAG, "[client %d] Failed to connect", id);
+        return;
+    }
+    snprintf(message, sizeof(message), "Hello from %d", id);
+    if (!client.echo(message)) {
+        ESP_LOGE(TAG, "[client %d] Failed to exchange the message", id);
+        return;
+    }
+    if (id == 0) {
+        if (!client.rebind()) {
+            ESP_LOGE(TAG, "[client %d] Failed to open another socket", id);
+            return;
+        }
+        if (!client.echo("Hello again from a new address")) {
+            ESP_LOGE(TAG, "[client %d] Failed to exchange the message after rebinding", id);
+            return;
+        }
+    }
+    ESP_LOGI(TAG, "[client %d] done", id);
+    done++;
+}
+
+void dtls_server()
+{
+    TlsConfig server_config{};
+    server_config.is_dtls = true;
+    server_config.timeout = 10000;
+    server_config.cid_len = cid_len;
+    auto server_shared = SharedConfig::create(Tls::is_server{true}, Tls::do_verify{true},
+    { get_buf(type::servercert), get_buf(type::serverkey), get_buf(type::cacert) }, &server_config);
+    TlsConfig client_config{};
+    client_config.is_dtls = true;
+    client_config.timeout = 10000;
+    auto client_shared = SharedConfig::create(Tls::is_server{false}, Tls::do_verify{true},
+    { get_buf(type::clientcert), get_buf(type::clientkey), get_buf(type::cacert) }, &client_config);
+    if (server_shared == nullptr || client_shared == nullptr) {
+        ESP_LOGE(TAG, "Failed to create the configurations");
+        return;
+    }
+
+    EchoServer server;
+    DtlsServer::Config config{};
+    config.port = port;
+    config.idle_timeout_ms = idle_timeout_ms;
+    if (!server.open(server_shared, config)) {
+        ESP_LOGE(TAG, "Failed to open the server");
+        return;
+    }
+    std::atomic<int> done{0};
+    std::atomic<bool> finished{false};
+    std::thread server_task([&] {
+        while (!finished || server.peers() > 0) {
+            server.poll(100);
+        }
+    });
+    std::vector<std::thread> client_tasks;
+    for (int i = 0; i < clients; ++i) {
+        client_tasks.emplace_back(tls_client, i, std::cref(client_shared), std::ref(done));
+    }
+    for (auto &t : client_tasks) {
+        t.join();
+    }
+    ESP_LOGI(TAG, "%d of %d clients done, waiting for the sessions to age out", done.load(), clients);
+    finished = true;
+    server_task.join();
+    ESP_LOGI(TAG, "All sessions closed");
+}
+
+} // namespace
+
+#if CONFIG_IDF_TARGET_LINUX
+/**
+ * Linux target: We're already connected, just run the server and clients
+ */
+int main()
+{
+    dtls_server();
+    return 0;
+}
+#else
+/**
+ * ESP32 chipsets:  Need to initialize system components
+ *                  and connect to network
+ */
+
+#include "esp_event.h"
+#include "esp_netif.h"
+
+extern "C" void app_main()
+{
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+
+    dtls_server();
+}
+#endif
@@ -0,0 +1,202 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include "mbedtls_wrap.hpp"
+
+namespace idf::mbedtls_cxx {
+
+/**
+ * @brief Hashed timer wheel with a fixed number of slots
+ *
+ * Timers are intrusive nodes, scheduling and cancelling is O(1). The expiry time of a node
+ * could be postponed without touching the wheel, such a node is moved to its new slot when
+ * its old slot is visited.
+ */
+class TimerWheel {
+public:
+    struct Node {
+        uint64_t expires{0};    // ms
+    private:
+        friend class TimerWheel;
+        Node *prev{nullptr};
+        Node *next{nullptr};
+        size_t slot{0};
+        bool linked{false};
+    };
+
+    TimerWheel(size_t slots, uint32_t tick_ms) : slots_(slots), tick_ms_(tick_ms) {}
+
+    void schedule(Node *node);
+
+    void cancel(Node *node);
+
+    /**
+     * @brief Visits all slots up to now and returns the expired nodes (removed from the wheel)
+     */
+    Node *advance(uint64_t now);
+
+    static Node *next_expired(Node *node)
+    {
+        return node->next;
+    }
+
+    uint32_t tick_ms() const
+    {
+        return tick_ms_;
+    }
+
+private:
+    std::vector<Node *> slots_;
+    uint32_t tick_ms_;
+    uint64_t current_{0};   // last tick, which has fully elapsed
+};
+
+/**
+ * @brief DTLS server of many peers on one UDP socket
+ *
+ * Datagrams are dispatched to the sessions of the peers by the address of the sender, or by
+ * the connection ID (RFC 9146) if negotiated, which keeps the session alive when the address
+ * of the peer changes (NAT rebinding). New peers are verified statelessly with the DTLS cookies
+ * of the shared configuration: a ClientHello without a valid cookie is answered
+ * by HelloVerifyRequest without allocating any session. Sessions with no traffic for the idle
+ * timeout are removed by a timer wheel.
+ *
+ * The server runs in the task calling poll(), the callbacks are called from poll().
+ */
+class DtlsServer {
+public:
+    struct Config {
+        uint16_t port;
+        uint32_t idle_timeout_ms{60000};
+        size_t max_peers{16};
+        uint32_t tick_ms{100};          // resolution of the idle timeout and DTLS retransmissions
+    };
+
+    /**
+     * @brief Session of one peer, valid until on_close() returns
+     */
+    class Peer: public Tls, private TimerWheel::Node {
+    public:
+        int send(const unsigned char *buf, size_t len) override;
+
+        int recv(unsigned char *buf, size_t len) override;
+
+        /**
+         * @brief Sends close_notify, the session is removed in the next poll()
+         */
+        void close();
+
+        const sockaddr *address() const
+        {
+            return reinterpret_cast<const sockaddr *>(&addr_);
+        }
+
+        bool is_connected() const
+        {
+            return connected_;
+        }
+
+    private:
+        friend class DtlsServer;
+
+        explicit Peer(DtlsServer &server) : server_(server) {}
+
+        bool start(const SharedConfig::ptr &config);
+
+        bool accept(const sockaddr_storage &addr, socklen_t addr_len, const std::string &key);
+
+        int advance();
+
+        /**
+         * @brief Listener: the last advance() processed a ClientHello with a valid cookie
+         */
+        bool hello_verified(int ret) const;
+
+        bool set_transport_id();
+
+        DtlsServer &server_;
+        sockaddr_storage addr_{};
+        socklen_t addr_len_{0};
+        std::string key_;               // address of the peer, also the client ID of the cookies
+        std::string cid_;               // own connection ID, the peer adds it to every record
+        const unsigned char *input_{nullptr};
+        size_t input_len_{0};
+        bool connected_{false};
+        bool closing_{false};
+        bool replied_{false};           // advance() sent a record to the peer
+    };
+
+    DtlsServer() = default;
+
+    virtual ~DtlsServer();
+
+    /**
+     * @brief Opens the socket and the listening session
+     *
+     * @param config Configuration of a DTLS server (TlsConfig::is_dtls) with non-zero timeout,
+     *               with TlsConfig::cid_len the peers get connection IDs
+     */
+    bool open(const SharedConfig::ptr &config, const Config &server);
+
+    void close();
+
+    /**
+     * @brief Waits up to timeout_ms for datagrams, processes them and the timers
+     *
+     * @return false on socket error
+     */
+    bool poll(uint32_t timeout_ms);
+
+    size_t peers() const
+    {
+        return by_addr_.size();
+    }
+
+protected:
+    virtual void on_connect(Peer &peer) {}
+
+    virtual void on_receive(Peer &peer, const unsigned char *data, size_t len) = 0;
+
+    virtual void on_close(Peer &peer) {}
+
+private:
+    void dispatch(const unsigned char *data, size_t len, const sockaddr_storage &addr, socklen_t addr_len);
+
+    void process(Peer *peer, const sockaddr_storage &addr, socklen_t addr_len);
+
+    void accept(const sockaddr_storage &addr, socklen_t addr_len, std::string key);
+
+    Peer *find_by_cid(const unsigned char *data, size_t len);
+
+    void remove(Peer *peer);
+
+    void touch(Peer *peer);
+
+    void expire();
+
+    static std::string address_key(const sockaddr_storage &addr);
+
+    static uint64_t now_ms();
+
+    SharedConfig::ptr config_;
+    Config server_{};
+    int sock_{-1};
+    std::vector<unsigned char> buffer_;
+    std::unique_ptr<Peer> listener_;    // verifies cookies of new peers, it becomes their session
+    std::unordered_map<std::string, std::unique_ptr<Peer>> by_addr_;
+    std::unordered_map<std::string, Peer *> by_cid_;
+    std::unique_ptr<TimerWheel> wheel_;
+    size_t handshakes_{0};              // peers with handshake in progress
+};
+
+}
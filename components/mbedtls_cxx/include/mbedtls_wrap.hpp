@@ -6,7 +6,10 @@
 #pragma once
 
 #include <utility>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <mbedtls/timing.h>
 #include <mbedtls/ssl_cookie.h>
 #include "mbedtls/ssl.h"
@@ -19,12 +22,46 @@ namespace idf::mbedtls_cxx {
 using const_buf = std::pair<const unsigned char *, std::size_t>;
 using buf = std::pair<unsigned char *, std::size_t>;
 
+class SessionCache;
+class SessionTickets;
+
+/**
+ * @brief Authentication of the handshake
+ *
+ * PSK modes don't send or verify certificates, which makes the handshake shorter on slow links.
+ * Pure PSK also skips the key exchange, but doesn't provide forward secrecy.
+ */
+enum class TlsAuth {
+    certificate,
+    psk,            // pre-shared key only
+    ecdhe_psk       // pre-shared key authenticating an ephemeral ECDH key exchange
+};
+
+/**
+ * @brief Server: returns the pre-shared key of the client identity, or an empty buffer to refuse the client
+ *
+ * The key is copied to the session, it doesn't need to outlive the call.
+ */
+using PskLookup = std::function<const_buf(const_buf identity)>;
+
 struct TlsConfig {
     bool is_dtls;
     uint32_t timeout;
     const_buf client_id;
+    size_t cid_len{0};  // DTLS: length of connection IDs (RFC 9146) of this endpoint, 0 to disable
+    std::shared_ptr<SessionCache> session_cache;        // client: resumes sessions stored in this cache
+    std::shared_ptr<SessionTickets> session_tickets;    // server: issues and accepts session tickets
+    const int *ciphersuites{nullptr};   // 0-terminated list of allowed ciphersuites (kept by the caller), nullptr for the defaults
+    TlsAuth auth{TlsAuth::certificate};
+    const_buf psk;              // PSK modes, client: the key, server: the key of psk_identity if no psk_lookup is set
+    const_buf psk_identity;     // PSK modes, client: identity sent to the server
+    PskLookup psk_lookup;       // PSK modes, server: finds the key of the client identity
+    size_t max_fragment_len{0}; // payload limit of records (RFC 6066): 512, 1024, 2048 or 4096, 0 for the default 16 KiB,
+                                // the I/O buffers shrink to it only with CONFIG_MBEDTLS_VARIABLE_BUFFER_LENGTH
 };
 
+class SharedConfig;
+
 /**
  * @brief Application wrapper of (D)TLS for authentication and creating encrypted communication channels
  */
@@ -46,6 +83,17 @@ public:
 
     bool init(is_server server, do_verify verify, TlsConfig *config = nullptr);
 
+    /**
+     * @brief Initializes the session with a configuration shared by many sessions
+     *
+     * The certificates, key and random generator of the shared configuration are used,
+     * set_own_cert() and set_ca_cert() of this session are not needed.
+     *
+     * @param config Shared configuration, kept alive by the session
+     * @param client_id DTLS server: transport ID of the client, used by the cookies
+     */
+    bool init(std::shared_ptr<const SharedConfig> config, const_buf client_id = {});
+
     bool init_dtls_cookies();
 
     bool set_client_id();
@@ -54,6 +102,31 @@ public:
 
     int handshake();
 
+    /**
+     * Progress of the non-blocking handshake
+     */
+    enum class state {
+        done,
+        want_read,      // wait until the transport is readable (or the timeout expires)
+        want_write,     // wait until the transport is writable
+        failed
+    };
+
+    struct StepResult {
+        state status;
+        int timeout_ms;     // DTLS: time to the next retransmission, -1 if no timer is running
+        int error;          // mbedtls error code if failed
+    };
+
+    /**
+     * @brief Advances the handshake as far as possible without blocking
+     *
+     * The send() and recv() of the session should return MBEDTLS_ERR_SSL_WANT_WRITE/WANT_READ
+     * instead of blocking. Call step() again when the transport is ready or the timeout expires,
+     * until it returns done or failed. handshake() is a blocking loop of step().
+     */
+    StepResult step();
+
     int write(const unsigned char *buf, size_t len);
 
     int read(unsigned char *buf, size_t len);
@@ -64,6 +137,27 @@ public:
 
     bool set_hostname(const char *name);
 
+    /**
+     * @brief DTLS: Negotiates connection ID (RFC 9146) in the handshake
+     *
+     * Needs TlsConfig::cid_len set, the peer then adds own_cid to every record, so that the session
+     * could be identified after the peer's address changes. The client could pass an empty CID,
+     * if the server is not expected to change its address.
+     */
+    bool set_cid(const_buf own_cid);
+
+    /**
+     * @brief Client: Sets the key of this peer in the session cache (TlsConfig::session_cache)
+     *
+     * The hostname (set_hostname()) is used if no key is set, e.g. for peers on serial links.
+     */
+    void set_session_key(std::string key);
+
+    /**
+     * @brief Checks if the last handshake resumed a session
+     */
+    bool is_resumed();
+
     virtual int send(const unsigned char *buf, size_t len) = 0;
 
     virtual int recv(unsigned char *buf, size_t len) = 0;
@@ -75,19 +169,20 @@ public:
 
     size_t get_available_bytes();
 
+    /**
+     * @brief Maximum payload of one record, as negotiated in the handshake (negative mbedtls error on failure)
+     */
+    int get_max_record_size();
+
 protected:
     /**
      * mbedTLS internal structures (available after inheritance)
+     *
+     * Only the per-session state is kept here, the configuration, certificates, random generator
+     * and DTLS cookies are held by the SharedConfig of the session
      */
     mbedtls_ssl_context ssl_{};
-    mbedtls_x509_crt public_cert_{};
-    mbedtls_pk_context pk_key_{};
-    mbedtls_x509_crt ca_cert_{};
-    mbedtls_ssl_config conf_{};
-    mbedtls_ctr_drbg_context ctr_drbg_{};
-    mbedtls_entropy_context entropy_{};
     mbedtls_timing_delay_context timer_{};
-    mbedtls_ssl_cookie_ctx cookie_{};
     const_buf client_id_{};
 
     virtual void delay() {}
@@ -104,17 +199,29 @@ protected:
     bool is_session_loaded();
 
 private:
+    friend class SharedConfig;
+
     static void print_error(const char *function, int error_code);
 
+    static bool conf_psk(mbedtls_ssl_config *conf, bool server, const TlsConfig &config, const PskLookup *lookup);
+
+    static int psk_callback(void *ctx, mbedtls_ssl_context *ssl, const unsigned char *identity, size_t identity_len);
+
+    static bool conf_max_fragment_len(mbedtls_ssl_config *conf, size_t len);
+
+    bool setup(const mbedtls_ssl_config *conf, uint32_t timeout, const_buf client_id);
+
     static int bio_write(void *ctx, const unsigned char *buf, size_t len);
 
     static int bio_read(void *ctx, unsigned char *buf, size_t len);
 
     static int bio_read_tout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout);
 
-    int mbedtls_pk_parse_key(mbedtls_pk_context *ctx,
-                             const unsigned char *key, size_t keylen,
-                             const unsigned char *pwd, size_t pwdlen);
+    static void set_timer(void *ctx, uint32_t int_ms, uint32_t fin_ms);
+
+    static int get_timer(void *ctx);
+
+    SharedConfig *own_config();
 
     struct unique_session {
         unique_session()
@@ -137,5 +244,121 @@ private:
 
     std::unique_ptr<unique_session> session_;
 
+    std::shared_ptr<const SharedConfig> shared_;
+
+    std::shared_ptr<SharedConfig> own_config_;     // legacy init(): private configuration filled by set_own_cert() and set_ca_cert()
+
+    std::shared_ptr<SessionCache> session_cache_;
+
+    std::string session_key_;
+
+    bool in_handshake_{false};
+
+    bool resuming_{false};
+
+    uint64_t timer_deadline_{0};    // ms, 0 if the timer is stopped
+
+};
+
+/**
+ * @brief Immutable (D)TLS configuration shared by many sessions
+ *
+ * Holds the parsed certificates and key, the random generator and mbedtls_ssl_config, so that
+ * a new session doesn't parse the certificates and seed the random generator again, and the sessions
+ * don't keep copies of them. Sessions could run in different tasks, the random generator and the DTLS
+ * cookies are serialized internally.
+ */
+class SharedConfig {
+public:
+    using ptr = std::shared_ptr<const SharedConfig>;
+
+    struct Certs {
+        const_buf own_crt;
+        const_buf own_key;
+        const_buf ca_crt;   // CA of the peer, needed with do_verify{true}
+    };  // not used in PSK modes (TlsConfig::auth)
+
+    /**
+     * @brief Parses the certificates and creates the configuration
+     *
+     * @param config Transport and read timeout, the client_id is set per session (Tls::init())
+     * @return The configuration, nullptr on failure
+     */
+    static ptr create(Tls::is_server server, Tls::do_verify verify, const Certs &certs, const TlsConfig *config = nullptr);
+
+    SharedConfig(const SharedConfig &) = delete;
+    SharedConfig &operator=(const SharedConfig &) = delete;
+
+    ~SharedConfig();
+
+    const mbedtls_ssl_config *get() const
+    {
+        return &conf_;
+    }
+
+    bool is_server() const
+    {
+        return is_server_;
+    }
+
+    bool is_dtls() const
+    {
+        return is_dtls_;
+    }
+
+    uint32_t timeout() const
+    {
+        return timeout_;
+    }
+
+    size_t cid_len() const
+    {
+        return cid_len_;
+    }
+
+    const std::shared_ptr<SessionCache> &session_cache() const
+    {
+        return session_cache_;
+    }
+
+    /**
+     * @brief Reads random bytes from the random generator of this configuration
+     */
+    int random(unsigned char *buf, size_t len) const;
+
+private:
+    friend class Tls;
+
+    SharedConfig();
+
+    static std::shared_ptr<SharedConfig> make();
+
+    bool parse_own_cert(const_buf crt, const_buf key);
+
+    bool parse_ca_cert(const_buf crt);
+
+    bool setup(Tls::is_server server, Tls::do_verify verify, const TlsConfig *config);
+
+    static int rng(void *ctx, unsigned char *buf, size_t len);
+
+    static int cookie_write(void *ctx, unsigned char **p, unsigned char *end, const unsigned char *cli_id, size_t cli_id_len);
+
+    static int cookie_check(void *ctx, const unsigned char *cookie, size_t cookie_len, const unsigned char *cli_id, size_t cli_id_len);
+
+    mbedtls_ssl_config conf_{};
+    mbedtls_x509_crt own_cert_{};
+    mbedtls_pk_context own_key_{};
+    mbedtls_x509_crt ca_cert_{};
+    mutable mbedtls_ctr_drbg_context ctr_drbg_{};
+    mbedtls_entropy_context entropy_{};
+    mbedtls_ssl_cookie_ctx cookie_{};
+    mutable std::mutex lock_;   // random generator and cookies are used by all sessions
+    bool is_server_{false};
+    bool is_dtls_{false};
+    uint32_t timeout_{0};
+    size_t cid_len_{0};
+    std::shared_ptr<SessionCache> session_cache_;
+    std::shared_ptr<SessionTickets> session_tickets_;
+    PskLookup psk_lookup_;
 };
 }
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls_wrap.hpp"
+
+namespace idf::mbedtls_cxx {
+
+/**
+ * @brief Client store of sessions for resumption, keyed by the server's hostname or another peer ID
+ *
+ * Sessions (with the server's ticket, if any) are kept serialized, until they expire or are replaced
+ * by a newer one. When full, the least recently used session is dropped. One cache could be used
+ * by many sessions in different tasks.
+ */
+class SessionCache {
+public:
+    /**
+     * @param max_entries Number of peers kept in the cache
+     * @param lifetime_s Time in seconds to keep a session, should not exceed the server's ticket lifetime
+     */
+    explicit SessionCache(size_t max_entries = 4, uint32_t lifetime_s = 3600);
+
+    /**
+     * @brief Stores the session of a completed handshake
+     */
+    bool store(const std::string &key, const mbedtls_ssl_context *ssl);
+
+    /**
+     * @brief Sets the stored session to a new connection (before its handshake)
+     *
+     * @return true if a valid session was found
+     */
+    bool load(const std::string &key, mbedtls_ssl_context *ssl);
+
+    void remove(const std::string &key);
+
+    void clear();
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::vector<unsigned char> session;
+        uint64_t expires;   // s
+        uint64_t used;      // s
+    };
+
+    static uint64_t now();
+
+    mutable std::mutex lock_;
+    std::unordered_map<std::string, Entry> entries_;
+    size_t max_entries_;
+    uint32_t lifetime_s_;
+};
+
+/**
+ * @brief Server keys of session tickets (RFC 5077)
+ *
+ * Tickets are sealed with AES-256-GCM, the key is replaced every lifetime_s, and the tickets sealed
+ * by the previous key are still accepted. rotate() sets the key explicitly, e.g. to share it among
+ * several servers. Needs CONFIG_MBEDTLS_SERVER_SSL_SESSION_TICKETS.
+ */
+class SessionTickets {
+public:
+    using ptr = std::shared_ptr<SessionTickets>;
+
+    static ptr create(uint32_t lifetime_s = 86400);
+
+    SessionTickets(const SessionTickets &) = delete;
+    SessionTickets &operator=(const SessionTickets &) = delete;
+
+    ~SessionTickets();
+
+    /**
+     * @brief Replaces the key used for new tickets, tickets of the current key remain valid
+     *
+     * @param name Key name (4 bytes) added to the tickets
+     * @param key Key material, at least 32 bytes
+     * @param lifetime_s Lifetime of the key, 0 to keep it until the next rotate()
+     */
+    bool rotate(const_buf name, const_buf key, uint32_t lifetime_s = 0);
+
+    /**
+     * @brief Enables tickets in the server configuration
+     */
+    void configure(mbedtls_ssl_config *conf);
+
+private:
+    SessionTickets();
+
+    bool setup(uint32_t lifetime_s);
+
+    static int write(void *ctx, const mbedtls_ssl_session *session, unsigned char *start, const unsigned char *end, size_t *len, uint32_t *lifetime);
+
+    static int parse(void *ctx, mbedtls_ssl_session *session, unsigned char *buf, size_t len);
+
+    std::mutex lock_;   // tickets are sealed and opened by all sessions
+    mbedtls_ssl_ticket_context ticket_{};
+    mbedtls_ctr_drbg_context ctr_drbg_{};
+    mbedtls_entropy_context entropy_{};
+};
+
+}
@@ -0,0 +1,253 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "mbedtls_wrap.hpp"
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+namespace idf::mbedtls_cxx {
+
+/**
+ * @brief Runs many non-blocking sessions in one task
+ *
+ * Waits for the sockets of the sessions with select() or, on Linux, with epoll, and calls back
+ * when a socket is ready or its timeout expires. Sessions are driven by their step() results,
+ * from the task calling run_once(). Every socket could have one wait at a time.
+ */
+class EventLoop {
+public:
+    enum class backend {
+        select,
+        epoll       // Linux target only
+    };
+
+    using callback = std::function<void()>;
+
+    explicit EventLoop(backend type = backend::select);
+
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    /**
+     * @brief Calls cb once, when the socket is ready for the operation or after timeout_ms (-1 for no timeout)
+     *
+     * @return false if the socket already has a wait, or can't be waited for (fd >= FD_SETSIZE with select)
+     */
+    bool wait(int fd, Tls::state want, int timeout_ms, callback cb);
+
+    /**
+     * @brief Drives the handshake of the session on the socket fd, done(0) is called on success, done(error) on failure
+     */
+    void handshake(Tls &tls, int fd, std::function<void(int)> done);
+
+    /**
+     * @brief Waits up to timeout_ms (-1 for no timeout) and calls back the ready sockets and expired timeouts
+     *
+     * @return Number of waits still pending, -1 on failure of select() or epoll
+     */
+    int run_once(int timeout_ms);
+
+    /**
+     * @brief Calls run_once() until there's nothing to wait for
+     */
+    bool run();
+
+    size_t pending() const
+    {
+        return waits_.size();
+    }
+
+#if defined(__cpp_impl_coroutine)
+    /**
+     * @brief Coroutine task started eagerly and not awaited, the loop resumes it
+     */
+    struct Task {
+        struct promise_type {
+            Task get_return_object()
+            {
+                return {};
+            }
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+            std::suspend_never final_suspend() noexcept
+            {
+                return {};
+            }
+            void return_void() {}
+            void unhandled_exception() {}
+        };
+    };
+
+    /**
+     * @brief Awaits until the socket is ready for the operation, or the timeout expires
+     *
+     * Returns false if the socket couldn't be waited for (see wait())
+     */
+    auto ready(int fd, Tls::state want, int timeout_ms = -1)
+    {
+        struct Awaiter {
+            EventLoop &loop;
+            int fd;
+            Tls::state want;
+            int timeout_ms;
+            bool ok{true};
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+            bool await_suspend(std::coroutine_handle<> h)
+            {
+                ok = loop.wait(fd, want, timeout_ms, [h] { h.resume(); });
+                return ok;
+            }
+            bool await_resume() const noexcept
+            {
+                return ok;
+            }
+        };
+        return Awaiter{*this, fd, want, timeout_ms};
+    }
+
+    /**
+     * @brief Completes the handshake, returns 0 or mbedtls error
+     */
+    auto handshake(Tls &tls, int fd)
+    {
+        struct Awaiter {
+            EventLoop &loop;
+            Tls &tls;
+            int fd;
+            int error{0};
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+            bool await_suspend(std::coroutine_handle<> h)
+            {
+                auto first_step = [this, h] {
+                    loop.handshake(tls, fd, [this, h](int err) {
+                        error = err;
+                        h.resume();
+                    });
+                };
+                // the first step runs from the loop, so that the coroutine is never resumed inside await_suspend()
+                if (!loop.wait(fd, Tls::state::want_write, 0, first_step)) {
+                    error = MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+                    return false;   // not suspended, resumes with the error
+                }
+                return true;
+            }
+            int await_resume() const noexcept
+            {
+                return error;
+            }
+        };
+        return Awaiter{*this, tls, fd};
+    }
+
+    /**
+     * @brief Reads at least one byte, returns the length or mbedtls error
+     */
+    auto read(Tls &tls, int fd, unsigned char *buf, size_t len)
+    {
+        return io_awaiter<false> {*this, tls, fd, buf, len};
+    }
+
+    /**
+     * @brief Writes the whole buffer, returns the length or mbedtls error
+     */
+    auto write(Tls &tls, int fd, const unsigned char *buf, size_t len)
+    {
+        return io_awaiter<true> {*this, tls, fd, const_cast<unsigned char *>(buf), len};
+    }
+
+private:
+    template<bool is_write>
+    struct io_awaiter {
+        EventLoop &loop;
+        Tls &tls;
+        int fd;
+        unsigned char *buf;
+        size_t len;
+        size_t done{0};
+        int ret{0};
+        Tls::state want{Tls::state::want_read};
+
+        bool attempt()
+        {
+            while (true) {
+                ret = is_write ? tls.write(buf + done, len - done) : tls.read(buf, len);
+                if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                    want = ret == MBEDTLS_ERR_SSL_WANT_READ ? Tls::state::want_read : Tls::state::want_write;
+                    return false;
+                }
+                if (ret < 0 || !is_write) {
+                    return true;
+                }
+                done += ret;
+                if (done == len) {
+                    ret = static_cast<int>(len);
+                    return true;
+                }
+            }
+        }
+        bool await_ready()
+        {
+            return attempt();
+        }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            if (!loop.wait(fd, want, -1, [this, h] { retry(h); })) {
+                ret = MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+                return false;
+            }
+            return true;
+        }
+        void retry(std::coroutine_handle<> h)
+        {
+            if (attempt()) {
+                h.resume();
+            } else if (!loop.wait(fd, want, -1, [this, h] { retry(h); })) {
+                ret = MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+                h.resume();
+            }
+        }
+        int await_resume() const noexcept
+        {
+            return ret;
+        }
+    };
+#endif // __cpp_impl_coroutine
+
+private:
+    struct Wait {
+        Tls::state want;
+        int64_t deadline;   // ms, -1 for no timeout
+        callback cb;
+    };
+
+    int wait_select(int timeout_ms, std::vector<int> &ready);
+
+    int wait_epoll(int timeout_ms, std::vector<int> &ready);
+
+    static int64_t now_ms();
+
+    backend type_;
+    int epoll_fd_{-1};
+    std::unordered_map<int, Wait> waits_;
+};
+
+}
@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include "mbedtls_wrap.hpp"
+
+namespace idf::mbedtls_cxx {
+
+/**
+ * @brief Coalesces application writes of a session into full records
+ *
+ * Writes are collected up to the maximum record payload of the session (negotiated in the handshake),
+ * full records are sent as soon as they're complete, the rest is sent by flush(), or by poll()
+ * once the oldest buffered byte waited for the latency budget. While corked, the data are sent
+ * only in full records or by flush()/uncork(), regardless of the budget.
+ *
+ * Functions return the number of bytes accepted or a negative mbedtls error, as Tls::write().
+ * MBEDTLS_ERR_SSL_WANT_READ/WANT_WRITE leave the unsent data in the buffer. Data which were not accepted
+ * have to be written again, as with Tls::write().
+ */
+class TlsWriter {
+public:
+    /**
+     * @param tls Session with completed handshake
+     * @param latency_ms Time the data could wait in the buffer, 0 to send the data at the end of every write
+     */
+    explicit TlsWriter(Tls &tls, uint32_t latency_ms = 0);
+
+    int write(const unsigned char *buf, size_t len);
+
+    /**
+     * @brief Writes several buffers as one contiguous stream
+     */
+    int writev(const const_buf *bufs, size_t count);
+
+    int flush();
+
+    /**
+     * @brief Holds partial records until uncork() or flush()
+     */
+    void cork();
+
+    int uncork();
+
+    /**
+     * @brief Flushes the buffer if the latency budget has expired, to be called from the application's loop
+     */
+    int poll();
+
+    /**
+     * @brief Time in ms until the latency budget expires, -1 if there's nothing to flush by poll()
+     */
+    int expires_in() const;
+
+    size_t pending() const
+    {
+        return len_;
+    }
+
+private:
+    bool reserve();
+
+    int send(const unsigned char *buf, size_t len);
+
+    int append(const unsigned char *buf, size_t len);
+
+    static uint64_t now_ms();
+
+    Tls &tls_;
+    uint32_t latency_ms_;
+    std::unique_ptr<unsigned char[]> buf_;
+    size_t size_{0};
+    size_t len_{0};
+    size_t retry_len_{0};   // length of the record held by mbedtls after WANT_WRITE/WANT_READ
+    uint64_t deadline_{0};
+    bool corked_{false};
+};
+
+}
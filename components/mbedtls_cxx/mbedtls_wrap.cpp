@@ -3,63 +3,54 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#include <algorithm>
+#include <chrono>
+#include <new>
 #include <mbedtls/timing.h>
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/ssl.h"
 #include "mbedtls_wrap.hpp"
+#include "session_cache.hpp"
 
 using namespace idf::mbedtls_cxx;
 
 bool Tls::init(is_server server, do_verify verify, TlsConfig *config)
 {
-    const char pers[] = "mbedtls_wrapper";
-    is_server_ = server == is_server{true};
-    is_dtls_ = config ? config->is_dtls : false;
-    uint32_t timeout = config ? config->timeout : 0;
-    mbedtls_entropy_init(&entropy_);
-    mbedtls_ctr_drbg_seed(&ctr_drbg_, mbedtls_entropy_func, &entropy_, (const unsigned char *)pers, sizeof(pers));
-    int endpoint = server == is_server{true} ? MBEDTLS_SSL_IS_SERVER : MBEDTLS_SSL_IS_CLIENT;
-    int transport = is_dtls_ ? MBEDTLS_SSL_TRANSPORT_DATAGRAM : MBEDTLS_SSL_TRANSPORT_STREAM;
-    int ret = mbedtls_ssl_config_defaults(&conf_, endpoint, transport, MBEDTLS_SSL_PRESET_DEFAULT);
-    if (ret) {
-        print_error("mbedtls_ssl_config_defaults", ret);
+    // the certificates were parsed to the private configuration by set_own_cert() and set_ca_cert()
+    SharedConfig *own = own_config();
+    if (own == nullptr || !own->setup(server, verify, config)) {
         return false;
     }
-    mbedtls_ssl_conf_rng(&conf_, mbedtls_ctr_drbg_random, &ctr_drbg_);
-    if (timeout) {
-        mbedtls_ssl_conf_read_timeout(&conf_, timeout);
-    }
-    mbedtls_ssl_conf_authmode(&conf_, verify == do_verify{true} ? MBEDTLS_SSL_VERIFY_REQUIRED : MBEDTLS_SSL_VERIFY_NONE);
-    ret = mbedtls_ssl_conf_own_cert(&conf_, &public_cert_, &pk_key_);
-    if (ret) {
-        print_error("mbedtls_ssl_conf_own_cert", ret);
-        return false;
-    }
-    if (verify == do_verify{true}) {
-        mbedtls_ssl_conf_ca_chain(&conf_, &ca_cert_, nullptr);
-    }
+    return init(own_config_, config ? config->client_id : const_buf{});
+}
 
-#if CONFIG_MBEDTLS_SSL_PROTO_DTLS
-    if (is_server_ && is_dtls_) {
-        if (!init_dtls_cookies()) {
-            return false;
-        }
+bool Tls::init(std::shared_ptr<const SharedConfig> config, const_buf client_id)
+{
+    if (config == nullptr) {
+        return false;
     }
-#endif // MBEDTLS_SSL_PROTO_DTLS
+    shared_ = std::move(config);
+    is_server_ = shared_->is_server();
+    is_dtls_ = shared_->is_dtls();
+    session_cache_ = shared_->session_cache();
+    return setup(shared_->get(), shared_->timeout(), client_id);
+}
 
-    ret = mbedtls_ssl_setup(&ssl_, &conf_);
+bool Tls::setup(const mbedtls_ssl_config *conf, uint32_t timeout, const_buf client_id)
+{
+    int ret = mbedtls_ssl_setup(&ssl_, conf);
     if (ret) {
         print_error("mbedtls_ssl_setup", ret);
         return false;
     }
 
     if (timeout) {
-        mbedtls_ssl_set_timer_cb(&ssl_, &timer_, mbedtls_timing_set_delay, mbedtls_timing_get_delay);
+        mbedtls_ssl_set_timer_cb(&ssl_, this, set_timer, get_timer);
     }
 
 #if CONFIG_MBEDTLS_SSL_PROTO_DTLS
-    if (is_server_ && is_dtls_ && config && config->client_id != const_buf {}) {
-        client_id_ = config->client_id;
+    if (is_server_ && is_dtls_ && client_id != const_buf {}) {
+        client_id_ = client_id;
         if (!set_client_id()) {
             return false;
         }
@@ -71,45 +62,158 @@ bool Tls::init(is_server server, do_verify verify, TlsConfig *config)
 
 bool Tls::deinit()
 {
-    ::mbedtls_ssl_config_free(&conf_);
     ::mbedtls_ssl_free(&ssl_);
-    ::mbedtls_pk_free(&pk_key_);
-    ::mbedtls_x509_crt_free(&public_cert_);
-    ::mbedtls_x509_crt_free(&ca_cert_);
+    shared_.reset();
+    own_config_.reset();
+    session_cache_.reset();
     return true;
 }
 
 void Tls::print_error(const char *function, int error_code)
 {
-    static char error_buf[100];
+    char error_buf[100];
     mbedtls_strerror(error_code, error_buf, sizeof(error_buf));
 
     printf("%s() returned -0x%04X\n", function, -error_code);
     printf("-0x%04X: %s\n", -error_code, error_buf);
 }
 
+bool Tls::conf_psk(mbedtls_ssl_config *conf, bool server, const TlsConfig &config, const PskLookup *lookup)
+{
+#if CONFIG_MBEDTLS_PSK_MODES
+    static const int psk_ciphersuites[] = {
+        MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,
+        MBEDTLS_TLS_PSK_WITH_AES_128_CCM,
+        MBEDTLS_TLS_PSK_WITH_CHACHA20_POLY1305_SHA256,
+        MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA256,
+        0
+    };
+    static const int ecdhe_psk_ciphersuites[] = {
+        MBEDTLS_TLS_ECDHE_PSK_WITH_CHACHA20_POLY1305_SHA256,
+        MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256,
+        0
+    };
+    bool pure = config.auth == TlsAuth::psk;
+    mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
+    if (config.ciphersuites == nullptr) {
+        mbedtls_ssl_conf_ciphersuites(conf, pure ? psk_ciphersuites : ecdhe_psk_ciphersuites);
+    }
+    if (server && lookup && *lookup) {
+        mbedtls_ssl_conf_psk_cb(conf, psk_callback, const_cast<PskLookup *>(lookup));
+        return true;
+    }
+    int ret = mbedtls_ssl_conf_psk(conf, config.psk.first, config.psk.second, config.psk_identity.first, config.psk_identity.second);
+    if (ret) {
+        print_error("mbedtls_ssl_conf_psk", ret);
+        return false;
+    }
+    return true;
+#else
+    printf("PSK is not supported, enable CONFIG_MBEDTLS_PSK_MODES\n");
+    return false;
+#endif
+}
+
+int Tls::psk_callback(void *ctx, mbedtls_ssl_context *ssl, const unsigned char *identity, size_t identity_len)
+{
+    auto lookup = static_cast<const PskLookup *>(ctx);
+    const_buf key = (*lookup)({ identity, identity_len });
+    if (key.first == nullptr || key.second == 0) {
+        return MBEDTLS_ERR_SSL_UNKNOWN_IDENTITY;
+    }
+    return mbedtls_ssl_set_hs_psk(ssl, key.first, key.second);
+}
+
+bool Tls::conf_max_fragment_len(mbedtls_ssl_config *conf, size_t len)
+{
+#if CONFIG_MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+    unsigned char code;
+    switch (len) {
+    case 512:
+        code = MBEDTLS_SSL_MAX_FRAG_LEN_512;
+        break;
+    case 1024:
+        code = MBEDTLS_SSL_MAX_FRAG_LEN_1024;
+        break;
+    case 2048:
+        code = MBEDTLS_SSL_MAX_FRAG_LEN_2048;
+        break;
+    case 4096:
+        code = MBEDTLS_SSL_MAX_FRAG_LEN_4096;
+        break;
+    default:
+        printf("Invalid max fragment length %u, use 512, 1024, 2048 or 4096\n", static_cast<unsigned>(len));
+        return false;
+    }
+    // the client requests the limit, the server applies it to its own records too
+    int ret = mbedtls_ssl_conf_max_frag_len(conf, code);
+    if (ret) {
+        print_error("mbedtls_ssl_conf_max_frag_len", ret);
+        return false;
+    }
+    return true;
+#else
+    printf("Max fragment length is not supported, enable CONFIG_MBEDTLS_SSL_MAX_FRAGMENT_LENGTH\n");
+    return false;
+#endif
+}
+
 int Tls::handshake()
 {
-    int ret = 0;
+    StepResult result;
+    while ((result = step()).status != state::done) {
+        if (result.status == state::failed) {
+            return -1;
+        }
+        delay();
+    }
+    return 0;
+}
+
+Tls::StepResult Tls::step()
+{
     mbedtls_ssl_set_bio(&ssl_, this, bio_write, bio_read, is_dtls_ ? bio_read_tout : nullptr);
+    if (!in_handshake_) {
+        in_handshake_ = true;
+        resuming_ = false;
+        if (!is_server_ && session_cache_ && !session_key_.empty()) {
+            resuming_ = session_cache_->load(session_key_, &ssl_);
+        }
+    }
 
+    int ret;
     while ( ( ret = mbedtls_ssl_handshake( &ssl_ ) ) != 0 ) {
-        if ( ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE ) {
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            int timeout = -1;
+            if (timer_deadline_) {
+                using namespace std::chrono;
+                int64_t now = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+                timeout = std::max<int64_t>(static_cast<int64_t>(timer_deadline_) - now, 0);
+            }
+            return { ret == MBEDTLS_ERR_SSL_WANT_READ ? state::want_read : state::want_write, timeout, 0 };
+        }
 #if CONFIG_MBEDTLS_SSL_PROTO_DTLS
-            if (is_server_ && is_dtls_ && ret == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
-                // hello verification requested -> restart the session with this client_id
-                if (!set_client_id()) {
-                    return -1;
-                }
-                continue;
+        if (is_server_ && is_dtls_ && ret == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
+            // hello verification requested -> restart the session with this client_id
+            if (!set_client_id()) {
+                in_handshake_ = false;
+                return { state::failed, -1, ret };
             }
+            continue;
+        }
 #endif // MBEDTLS_SSL_PROTO_DTLS
-            print_error( "mbedtls_ssl_handshake returned", ret );
-            return -1;
+        print_error( "mbedtls_ssl_handshake returned", ret );
+        if (resuming_) {
+            session_cache_->remove(session_key_);
         }
-        delay();
+        in_handshake_ = false;
+        return { state::failed, -1, ret };
+    }
+    if (!is_server_ && session_cache_ && !session_key_.empty()) {
+        session_cache_->store(session_key_, &ssl_);
     }
-    return ret;
+    in_handshake_ = false;
+    return { state::done, -1, 0 };
 }
 
 int Tls::bio_write(void *ctx, const unsigned char *buf, size_t len)
@@ -124,6 +228,24 @@ int Tls::bio_read(void *ctx, unsigned char *buf, size_t len)
     return s->recv(buf, len);
 }
 
+void Tls::set_timer(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+{
+    auto s = static_cast<Tls *>(ctx);
+    mbedtls_timing_set_delay(&s->timer_, int_ms, fin_ms);
+    if (fin_ms == 0) {
+        s->timer_deadline_ = 0;
+        return;
+    }
+    using namespace std::chrono;
+    s->timer_deadline_ = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count() + fin_ms;
+}
+
+int Tls::get_timer(void *ctx)
+{
+    auto s = static_cast<Tls *>(ctx);
+    return mbedtls_timing_get_delay(&s->timer_);
+}
+
 int Tls::bio_read_tout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
 {
     auto s = static_cast<Tls *>(ctx);
@@ -142,27 +264,41 @@ int Tls::read(unsigned char *buf, size_t len)
 
 bool Tls::set_own_cert(const_buf crt, const_buf key)
 {
-    int ret = mbedtls_x509_crt_parse(&public_cert_, crt.first, crt.second);
-    if (ret < 0) {
-        print_error("mbedtls_x509_crt_parse", ret);
-        return false;
-    }
-    ret = mbedtls_pk_parse_key(&pk_key_, key.first, key.second, nullptr, 0);
-    if (ret < 0) {
-        print_error("mbedtls_pk_parse_keyfile", ret);
-        return false;
-    }
-    return true;
+    SharedConfig *own = own_config();
+    return own != nullptr && own->parse_own_cert(crt, key);
 }
 
 bool Tls::set_ca_cert(const_buf crt)
 {
-    int ret = mbedtls_x509_crt_parse(&ca_cert_, crt.first, crt.second);
-    if (ret < 0) {
-        print_error("mbedtls_x509_crt_parse", ret);
+    SharedConfig *own = own_config();
+    return own != nullptr && own->parse_ca_cert(crt);
+}
+
+SharedConfig *Tls::own_config()
+{
+    if (own_config_ == nullptr) {
+        if (shared_) {
+            printf("The certificates of a shared configuration can't be changed\n");
+            return nullptr;
+        }
+        own_config_ = SharedConfig::make();
+    }
+    return own_config_.get();
+}
+
+bool Tls::set_cid(const_buf own_cid)
+{
+#if CONFIG_MBEDTLS_SSL_DTLS_CONNECTION_ID
+    int ret = mbedtls_ssl_set_cid(&ssl_, MBEDTLS_SSL_CID_ENABLED, own_cid.first, own_cid.second);
+    if (ret != 0) {
+        print_error("mbedtls_ssl_set_cid", ret);
         return false;
     }
     return true;
+#else
+    printf("DTLS connection ID is not supported, enable CONFIG_MBEDTLS_SSL_DTLS_CONNECTION_ID\n");
+    return false;
+#endif
 }
 
 bool Tls::set_hostname(const char *name)
@@ -172,34 +308,38 @@ bool Tls::set_hostname(const char *name)
         print_error("mbedtls_ssl_set_hostname", ret);
         return false;
     }
+    if (session_key_.empty() && name) {
+        session_key_ = name;
+    }
     return true;
 }
 
-Tls::Tls()
+void Tls::set_session_key(std::string key)
 {
-    mbedtls_x509_crt_init(&public_cert_);
-    mbedtls_pk_init(&pk_key_);
-    mbedtls_x509_crt_init(&ca_cert_);
+    session_key_ = std::move(key);
 }
 
-int Tls::mbedtls_pk_parse_key(mbedtls_pk_context *ctx, const unsigned char *key, size_t keylen, const unsigned char *pwd, size_t pwdlen)
+bool Tls::is_resumed()
 {
-
-    return ::mbedtls_pk_parse_key(ctx, key, keylen, pwd, pwdlen, nullptr, nullptr);
+    return mbedtls_ssl_session_reused(&ssl_) == 1;
 }
 
+Tls::Tls() = default;
+
 size_t Tls::get_available_bytes()
 {
     return ::mbedtls_ssl_get_bytes_avail(&ssl_);
 }
 
+int Tls::get_max_record_size()
+{
+    return ::mbedtls_ssl_get_max_out_record_payload(&ssl_);
+}
+
 Tls::~Tls()
 {
-    ::mbedtls_ssl_config_free(&conf_);
+    // the session refers to the configuration, which is released after this
     ::mbedtls_ssl_free(&ssl_);
-    ::mbedtls_pk_free(&pk_key_);
-    ::mbedtls_x509_crt_free(&public_cert_);
-    ::mbedtls_x509_crt_free(&ca_cert_);
 }
 
 bool Tls::get_session()
@@ -241,14 +381,8 @@ bool Tls::is_session_loaded()
 #if CONFIG_MBEDTLS_SSL_PROTO_DTLS
 bool Tls::init_dtls_cookies()
 {
-    int ret = mbedtls_ssl_cookie_setup(&cookie_, mbedtls_ctr_drbg_random, &ctr_drbg_);
-    if (ret != 0) {
-        print_error("mbedtls_ssl_cookie_setup() failed", ret);
-        return false;
-    }
-    mbedtls_ssl_conf_dtls_cookies(&conf_, mbedtls_ssl_cookie_write, mbedtls_ssl_cookie_check, &cookie_);
-
-    return true;
+    // the cookies are set up by the configuration of a DTLS server (SharedConfig)
+    return shared_ && shared_->is_server() && shared_->is_dtls();
 }
 
 bool Tls::set_client_id()
@@ -266,3 +400,181 @@ bool Tls::set_client_id()
     return true;
 }
 #endif
+
+SharedConfig::SharedConfig()
+{
+    mbedtls_ssl_config_init(&conf_);
+    mbedtls_x509_crt_init(&own_cert_);
+    mbedtls_pk_init(&own_key_);
+    mbedtls_x509_crt_init(&ca_cert_);
+    mbedtls_ctr_drbg_init(&ctr_drbg_);
+    mbedtls_entropy_init(&entropy_);
+#if CONFIG_MBEDTLS_SSL_PROTO_DTLS
+    mbedtls_ssl_cookie_init(&cookie_);
+#endif
+}
+
+SharedConfig::~SharedConfig()
+{
+#if CONFIG_MBEDTLS_SSL_PROTO_DTLS
+    mbedtls_ssl_cookie_free(&cookie_);
+#endif
+    mbedtls_ssl_config_free(&conf_);
+    mbedtls_pk_free(&own_key_);
+    mbedtls_x509_crt_free(&own_cert_);
+    mbedtls_x509_crt_free(&ca_cert_);
+    mbedtls_ctr_drbg_free(&ctr_drbg_);
+    mbedtls_entropy_free(&entropy_);
+}
+
+std::shared_ptr<SharedConfig> SharedConfig::make()
+{
+    const char pers[] = "mbedtls_wrapper";
+    std::shared_ptr<SharedConfig> shared(new (std::nothrow) SharedConfig());
+    if (shared == nullptr) {
+        return nullptr;
+    }
+    int ret = mbedtls_ctr_drbg_seed(&shared->ctr_drbg_, mbedtls_entropy_func, &shared->entropy_, (const unsigned char *)pers, sizeof(pers));
+    if (ret) {
+        Tls::print_error("mbedtls_ctr_drbg_seed", ret);
+        return nullptr;
+    }
+    return shared;
+}
+
+SharedConfig::ptr SharedConfig::create(Tls::is_server server, Tls::do_verify verify, const Certs &certs, const TlsConfig *config)
+{
+    std::shared_ptr<SharedConfig> shared = make();
+    if (shared == nullptr) {
+        return nullptr;
+    }
+    if (config == nullptr || config->auth == TlsAuth::certificate) {
+        if (!shared->parse_own_cert(certs.own_crt, certs.own_key) ||
+                (verify == Tls::do_verify{true} && !shared->parse_ca_cert(certs.ca_crt))) {
+            return nullptr;
+        }
+    }
+    if (!shared->setup(server, verify, config)) {
+        return nullptr;
+    }
+    return shared;
+}
+
+bool SharedConfig::parse_own_cert(const_buf crt, const_buf key)
+{
+    int ret = mbedtls_x509_crt_parse(&own_cert_, crt.first, crt.second);
+    if (ret < 0) {
+        Tls::print_error("mbedtls_x509_crt_parse", ret);
+        return false;
+    }
+    ret = mbedtls_pk_parse_key(&own_key_, key.first, key.second, nullptr, 0, rng, this);
+    if (ret < 0) {
+        Tls::print_error("mbedtls_pk_parse_key", ret);
+        return false;
+    }
+    return true;
+}
+
+bool SharedConfig::parse_ca_cert(const_buf crt)
+{
+    int ret = mbedtls_x509_crt_parse(&ca_cert_, crt.first, crt.second);
+    if (ret < 0) {
+        Tls::print_error("mbedtls_x509_crt_parse", ret);
+        return false;
+    }
+    return true;
+}
+
+bool SharedConfig::setup(Tls::is_server server, Tls::do_verify verify, const TlsConfig *config)
+{
+    is_server_ = server == Tls::is_server{true};
+    is_dtls_ = config ? config->is_dtls : false;
+    timeout_ = config ? config->timeout : 0;
+    cid_len_ = config && is_dtls_ ? config->cid_len : 0;
+    session_cache_ = config && !is_server_ ? config->session_cache : nullptr;
+    session_tickets_ = config && is_server_ ? config->session_tickets : nullptr;
+    bool use_certs = config == nullptr || config->auth == TlsAuth::certificate;
+    int endpoint = is_server_ ? MBEDTLS_SSL_IS_SERVER : MBEDTLS_SSL_IS_CLIENT;
+    int transport = is_dtls_ ? MBEDTLS_SSL_TRANSPORT_DATAGRAM : MBEDTLS_SSL_TRANSPORT_STREAM;
+    int ret = mbedtls_ssl_config_defaults(&conf_, endpoint, transport, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret) {
+        Tls::print_error("mbedtls_ssl_config_defaults", ret);
+        return false;
+    }
+    mbedtls_ssl_conf_rng(&conf_, rng, this);
+    if (timeout_) {
+        mbedtls_ssl_conf_read_timeout(&conf_, timeout_);
+    }
+    if (use_certs) {
+        mbedtls_ssl_conf_authmode(&conf_, verify == Tls::do_verify{true} ? MBEDTLS_SSL_VERIFY_REQUIRED : MBEDTLS_SSL_VERIFY_NONE);
+        ret = mbedtls_ssl_conf_own_cert(&conf_, &own_cert_, &own_key_);
+        if (ret) {
+            Tls::print_error("mbedtls_ssl_conf_own_cert", ret);
+            return false;
+        }
+        if (verify == Tls::do_verify{true}) {
+            mbedtls_ssl_conf_ca_chain(&conf_, &ca_cert_, nullptr);
+        }
+    } else {
+        psk_lookup_ = config->psk_lookup;
+        if (!Tls::conf_psk(&conf_, is_server_, *config, &psk_lookup_)) {
+            return false;
+        }
+    }
+#if CONFIG_MBEDTLS_SSL_DTLS_CONNECTION_ID
+    if (cid_len_) {
+        ret = mbedtls_ssl_conf_cid(&conf_, cid_len_, MBEDTLS_SSL_UNEXPECTED_CID_IGNORE);
+        if (ret) {
+            Tls::print_error("mbedtls_ssl_conf_cid", ret);
+            return false;
+        }
+    }
+#endif // MBEDTLS_SSL_DTLS_CONNECTION_ID
+    if (config && config->ciphersuites) {
+        mbedtls_ssl_conf_ciphersuites(&conf_, config->ciphersuites);
+    }
+    if (config && config->max_fragment_len && !Tls::conf_max_fragment_len(&conf_, config->max_fragment_len)) {
+        return false;
+    }
+    if (session_tickets_) {
+        session_tickets_->configure(&conf_);
+    }
+#if CONFIG_MBEDTLS_SSL_PROTO_DTLS
+    if (is_server_ && is_dtls_) {
+        ret = mbedtls_ssl_cookie_setup(&cookie_, rng, this);
+        if (ret != 0) {
+            Tls::print_error("mbedtls_ssl_cookie_setup() failed", ret);
+            return false;
+        }
+        mbedtls_ssl_conf_dtls_cookies(&conf_, cookie_write, cookie_check, this);
+    }
+#endif // MBEDTLS_SSL_PROTO_DTLS
+    return true;
+}
+
+int SharedConfig::rng(void *ctx, unsigned char *buf, size_t len)
+{
+    return static_cast<SharedConfig *>(ctx)->random(buf, len);
+}
+
+int SharedConfig::random(unsigned char *buf, size_t len) const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return mbedtls_ctr_drbg_random(&ctr_drbg_, buf, len);
+}
+
+#if CONFIG_MBEDTLS_SSL_PROTO_DTLS
+int SharedConfig::cookie_write(void *ctx, unsigned char **p, unsigned char *end, const unsigned char *cli_id, size_t cli_id_len)
+{
+    auto self = static_cast<SharedConfig *>(ctx);
+    std::lock_guard<std::mutex> lock(self->lock_);
+    return mbedtls_ssl_cookie_write(&self->cookie_, p, end, cli_id, cli_id_len);
+}
+
+int SharedConfig::cookie_check(void *ctx, const unsigned char *cookie, size_t cookie_len, const unsigned char *cli_id, size_t cli_id_len)
+{
+    auto self = static_cast<SharedConfig *>(ctx);
+    std::lock_guard<std::mutex> lock(self->lock_);
+    return mbedtls_ssl_cookie_check(&self->cookie_, cookie, cookie_len, cli_id, cli_id_len);
+}
+#endif // MBEDTLS_SSL_PROTO_DTLS
@@ -0,0 +1,191 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include "mbedtls/version.h"
+#include "session_cache.hpp"
+
+using namespace idf::mbedtls_cxx;
+
+SessionCache::SessionCache(size_t max_entries, uint32_t lifetime_s) : max_entries_(max_entries), lifetime_s_(lifetime_s) {}
+
+bool SessionCache::store(const std::string &key, const mbedtls_ssl_context *ssl)
+{
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    int ret = mbedtls_ssl_get_session(ssl, &session);
+    size_t len = 0;
+    if (ret == 0) {
+        ret = mbedtls_ssl_session_save(&session, nullptr, 0, &len);
+    }
+    std::vector<unsigned char> data;
+    if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+        data.resize(len);
+        ret = mbedtls_ssl_session_save(&session, data.data(), data.size(), &len);
+    }
+    mbedtls_ssl_session_free(&session);
+    if (ret != 0) {
+        printf("Failed to save the session: -0x%04X\n", -ret);
+        return false;
+    }
+    uint64_t time = now();
+    std::lock_guard<std::mutex> lock(lock_);
+    if (entries_.find(key) == entries_.end() && entries_.size() >= max_entries_) {
+        auto oldest = std::min_element(entries_.begin(), entries_.end(), [](const auto & a, const auto & b) {
+            return a.second.used < b.second.used;
+        });
+        entries_.erase(oldest);
+    }
+    entries_[key] = Entry{std::move(data), time + lifetime_s_, time};
+    return true;
+}
+
+bool SessionCache::load(const std::string &key, mbedtls_ssl_context *ssl)
+{
+    std::vector<unsigned char> data;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            return false;
+        }
+        uint64_t time = now();
+        if (it->second.expires <= time) {
+            entries_.erase(it);
+            return false;
+        }
+        it->second.used = time;
+        data = it->second.session;
+    }
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    int ret = mbedtls_ssl_session_load(&session, data.data(), data.size());
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_session(ssl, &session);
+    }
+    mbedtls_ssl_session_free(&session);
+    if (ret != 0) {
+        remove(key);
+        return false;
+    }
+    return true;
+}
+
+void SessionCache::remove(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    entries_.erase(key);
+}
+
+void SessionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    entries_.clear();
+}
+
+size_t SessionCache::size() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return entries_.size();
+}
+
+uint64_t SessionCache::now()
+{
+    using namespace std::chrono;
+    return duration_cast<seconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#if CONFIG_MBEDTLS_SERVER_SSL_SESSION_TICKETS
+SessionTickets::SessionTickets()
+{
+    mbedtls_ssl_ticket_init(&ticket_);
+    mbedtls_ctr_drbg_init(&ctr_drbg_);
+    mbedtls_entropy_init(&entropy_);
+}
+
+SessionTickets::~SessionTickets()
+{
+    mbedtls_ssl_ticket_free(&ticket_);
+    mbedtls_ctr_drbg_free(&ctr_drbg_);
+    mbedtls_entropy_free(&entropy_);
+}
+
+SessionTickets::ptr SessionTickets::create(uint32_t lifetime_s)
+{
+    std::shared_ptr<SessionTickets> tickets(new (std::nothrow) SessionTickets());
+    if (tickets == nullptr || !tickets->setup(lifetime_s)) {
+        return nullptr;
+    }
+    return tickets;
+}
+
+bool SessionTickets::setup(uint32_t lifetime_s)
+{
+    const char pers[] = "mbedtls_tickets";
+    int ret = mbedtls_ctr_drbg_seed(&ctr_drbg_, mbedtls_entropy_func, &entropy_, (const unsigned char *)pers, sizeof(pers));
+    if (ret == 0) {
+        ret = mbedtls_ssl_ticket_setup(&ticket_, mbedtls_ctr_drbg_random, &ctr_drbg_, MBEDTLS_CIPHER_AES_256_GCM, lifetime_s);
+    }
+    if (ret != 0) {
+        printf("Failed to setup session tickets: -0x%04X\n", -ret);
+        return false;
+    }
+    return true;
+}
+
+bool SessionTickets::rotate(const_buf name, const_buf key, uint32_t lifetime_s)
+{
+#if MBEDTLS_VERSION_NUMBER >= 0x03020000
+    std::lock_guard<std::mutex> lock(lock_);
+    int ret = mbedtls_ssl_ticket_rotate(&ticket_, name.first, name.second, key.first, key.second, lifetime_s);
+    if (ret != 0) {
+        printf("Failed to rotate ticket key: -0x%04X\n", -ret);
+        return false;
+    }
+    return true;
+#else
+    printf("Ticket key rotation needs mbedtls 3.2 or newer\n");
+    return false;
+#endif
+}
+
+void SessionTickets::configure(mbedtls_ssl_config *conf)
+{
+    mbedtls_ssl_conf_session_tickets_cb(conf, write, parse, this);
+}
+
+int SessionTickets::write(void *ctx, const mbedtls_ssl_session *session, unsigned char *start, const unsigned char *end, size_t *len, uint32_t *lifetime)
+{
+    auto self = static_cast<SessionTickets *>(ctx);
+    std::lock_guard<std::mutex> lock(self->lock_);
+    return mbedtls_ssl_ticket_write(&self->ticket_, session, start, end, len, lifetime);
+}
+
+int SessionTickets::parse(void *ctx, mbedtls_ssl_session *session, unsigned char *buf, size_t len)
+{
+    auto self = static_cast<SessionTickets *>(ctx);
+    std::lock_guard<std::mutex> lock(self->lock_);
+    return mbedtls_ssl_ticket_parse(&self->ticket_, session, buf, len);
+}
+#else
+SessionTickets::SessionTickets() = default;
+
+SessionTickets::~SessionTickets() = default;
+
+SessionTickets::ptr SessionTickets::create(uint32_t lifetime_s)
+{
+    printf("Session tickets are not supported, enable CONFIG_MBEDTLS_SERVER_SSL_SESSION_TICKETS\n");
+    return nullptr;
+}
+
+bool SessionTickets::rotate(const_buf name, const_buf key, uint32_t lifetime_s)
+{
+    return false;
+}
+
+void SessionTickets::configure(mbedtls_ssl_config *conf) {}
+#endif // CONFIG_MBEDTLS_SERVER_SSL_SESSION_TICKETS
@@ -0,0 +1,234 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "tls_event_loop.hpp"
+#include "test_certs.hpp"
+
+namespace {
+constexpr auto *TAG = "async_handshakes";
+constexpr int pairs = 256;
+}
+
+using namespace idf::mbedtls_cxx;
+using namespace test_certs;
+
+/**
+ * @brief One end of a TLS session over a non-blocking socket
+ */
+class Session: public Tls {
+public:
+    explicit Session(int fd) : Tls(), sock(fd)
+    {
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+    }
+    ~Session() override
+    {
+        ::close(sock);
+    }
+    int send(const unsigned char *buf, size_t len) override
+    {
+        int ret = ::send(sock, buf, len, 0);
+        return ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_WRITE : ret;
+    }
+    int recv(unsigned char *buf, size_t len) override
+    {
+        int ret = ::recv(sock, buf, len, 0);
+        return ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_READ : ret;
+    }
+    int fd() const
+    {
+        return sock;
+    }
+
+private:
+    int sock;
+};
+
+namespace {
+
+struct Pair {
+    std::unique_ptr<Session> server;
+    std::unique_ptr<Session> client;
+};
+
+SharedConfig::ptr s_server;
+SharedConfig::ptr s_client;
+
+bool create_pairs(std::vector<Pair> &sessions)
+{
+    sessions.clear();
+    for (int i = 0; i < pairs; ++i) {
+        int fd[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) < 0) {
+            ESP_LOGE(TAG, "Failed to create socket pair %d", i);
+            return false;
+        }
+        Pair p{std::make_unique<Session>(fd[0]), std::make_unique<Session>(fd[1])};
+        if (!p.server->init(s_server) || !p.client->init(s_client) || !p.client->set_hostname(get_server_cn())) {
+            return false;
+        }
+        sessions.push_back(std::move(p));
+    }
+    return true;
+}
+
+const char *backend_name(EventLoop::backend type)
+{
+    return type == EventLoop::backend::epoll ? "epoll" : "select";
+}
+
+/**
+ * All handshakes driven by callbacks of one event loop
+ */
+bool test_callbacks(EventLoop::backend type)
+{
+    std::vector<Pair> sessions;
+    if (!create_pairs(sessions)) {
+        return false;
+    }
+    EventLoop loop(type);
+    int done = 0;
+    int failed = 0;
+    auto on_done = [&](int error) {
+        error == 0 ? ++done : ++failed;
+    };
+    auto start = std::chrono::steady_clock::now();
+    for (auto &p : sessions) {
+        loop.handshake(*p.server, p.server->fd(), on_done);
+        loop.handshake(*p.client, p.client->fd(), on_done);
+    }
+    if (!loop.run()) {
+        ESP_LOGE(TAG, "Event loop failed");
+        return false;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ESP_LOGI(TAG, "callbacks/%s: %d of %d handshakes completed in %.2f s", backend_name(type), done / 2, pairs, secs);
+    return done == 2 * pairs && failed == 0;
+}
+
+#if defined(__cpp_impl_coroutine)
+EventLoop::Task server_task(EventLoop &loop, Session &s, int &done)
+{
+    unsigned char buf[64];
+    if (co_await loop.handshake(s, s.fd()) != 0) {
+        co_return;
+    }
+    int len = co_await loop.read(s, s.fd(), buf, sizeof(buf));
+    if (len > 0 && co_await loop.write(s, s.fd(), buf, len) == len) {
+        ++done;
+    }
+}
+
+EventLoop::Task client_task(EventLoop &loop, Session &s, int id, int &done)
+{
+    char message[32];
+    unsigned char reply[64];
+    int len = snprintf(message, sizeof(message), "Hello from %d", id);
+    if (co_await loop.handshake(s, s.fd()) != 0) {
+        co_return;
+    }
+    if (co_await loop.write(s, s.fd(), reinterpret_cast<const unsigned char *>(message), len) != len) {
+        co_return;
+    }
+    if (co_await loop.read(s, s.fd(), reply, sizeof(reply)) == len && memcmp(reply, message, len) == 0) {
+        ++done;
+    }
+}
+
+/**
+ * Every end of every session is a coroutine, which handshakes and exchanges one message
+ */
+bool test_coroutines(EventLoop::backend type)
+{
+    std::vector<Pair> sessions;
+    if (!create_pairs(sessions)) {
+        return false;
+    }
+    EventLoop loop(type);
+    int servers = 0;
+    int clients = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < pairs; ++i) {
+        server_task(loop, *sessions[i].server, servers);
+        client_task(loop, *sessions[i].client, i, clients);
+    }
+    if (!loop.run()) {
+        ESP_LOGE(TAG, "Event loop failed");
+        return false;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ESP_LOGI(TAG, "coroutines/%s: %d of %d sessions echoed in %.2f s", backend_name(type), clients, pairs, secs);
+    return servers == pairs && clients == pairs;
+}
+
+EventLoop::Task failing_handshake(EventLoop &loop, Session &s, int &error)
+{
+    error = co_await loop.handshake(s, s.fd());
+}
+#endif // __cpp_impl_coroutine
+
+/**
+ * Sockets, which can't be waited for, are refused and the awaiting coroutine resumes with an error
+ */
+bool test_wait_errors()
+{
+    EventLoop loop(EventLoop::backend::select);
+    bool ok = !loop.wait(FD_SETSIZE, Tls::state::want_read, -1, [] {});
+#if defined(__cpp_impl_coroutine)
+    int fd[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) < 0) {
+        ESP_LOGE(TAG, "Failed to create socket pair");
+        return false;
+    }
+    Session server(fd[0]);
+    Session client(fd[1]);
+    if (!server.init(s_server)) {
+        return false;
+    }
+    // the socket already has a wait, the handshake can't wait for it
+    ok = loop.wait(server.fd(), Tls::state::want_read, -1, [] {}) && ok;
+    int error = 0;
+    failing_handshake(loop, server, error);
+    ok = error == MBEDTLS_ERR_SSL_BAD_INPUT_DATA && ok;
+#endif
+    ESP_LOGI(TAG, "wait errors: %s", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+} // namespace
+
+/**
+ * Linux target only: hundreds of sessions in one task, over socket pairs
+ */
+int main()
+{
+    s_server = SharedConfig::create(Tls::is_server{true}, Tls::do_verify{true},
+    { get_buf(type::servercert), get_buf(type::serverkey), get_buf(type::cacert) });
+    s_client = SharedConfig::create(Tls::is_server{false}, Tls::do_verify{true},
+    { get_buf(type::clientcert), get_buf(type::clientkey), get_buf(type::cacert) });
+    if (s_server == nullptr || s_client == nullptr) {
+        ESP_LOGE(TAG, "Failed to create the configurations");
+        return 1;
+    }
+    bool ok = test_wait_errors();
+    for (auto type : { EventLoop::backend::select, EventLoop::backend::epoll }) {
+        ok = test_callbacks(type) && ok;
+#if defined(__cpp_impl_coroutine)
+        ok = test_coroutines(type) && ok;
+#endif
+    }
+    ESP_LOGI(TAG, "%s", ok ? "All tests passed" : "Some tests FAILED");
+    return ok ? 0 : 1;
+}
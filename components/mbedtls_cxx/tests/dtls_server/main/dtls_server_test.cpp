@@ -0,0 +1,341 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "dtls_server.hpp"
+#include "test_certs.hpp"
+
+namespace {
+constexpr auto *TAG = "dtls_server_test";
+constexpr uint16_t port = 3335;
+constexpr size_t cid_len = 8;
+constexpr uint32_t idle_timeout_ms = 500;
+constexpr uint32_t tick_ms = 50;
+int s_failures = 0;
+}
+
+#define CHECK(cond)                                                 \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            ESP_LOGE(TAG, "%s:%d: %s failed", __func__, __LINE__, #cond); \
+            s_failures++;                                           \
+        }                                                           \
+    } while (0)
+
+using namespace idf::mbedtls_cxx;
+using namespace test_certs;
+
+namespace {
+
+struct Timer: TimerWheel::Node {
+    int id{0};
+};
+
+std::vector<int> expired_ids(TimerWheel &wheel, uint64_t now)
+{
+    std::vector<int> ids;
+    for (auto *node = wheel.advance(now); node; node = TimerWheel::next_expired(node)) {
+        CHECK(node->expires <= now);
+        ids.push_back(static_cast<Timer *>(node)->id);
+    }
+    return ids;
+}
+
+/**
+ * Expiry, cancellation and postponing of the timers, with 8 slots of 10 ms (80 ms per revolution)
+ */
+void test_timer_wheel()
+{
+    TimerWheel wheel(8, 10);
+    wheel.advance(1000);
+    Timer t[6];
+    uint64_t expires[] = { 1005, 1025, 1035, 1200, 1000, 1050 };
+    for (int i = 0; i < 6; ++i) {
+        t[i].id = i;
+        t[i].expires = expires[i];
+        wheel.schedule(&t[i]);
+    }
+    // already expired when scheduled: visited in the next advance()
+    CHECK(expired_ids(wheel, 1009) == (std::vector<int>{ 0, 4 }));
+    // not expired before its time, even within its slot
+    CHECK(expired_ids(wheel, 1024).empty());
+    CHECK(expired_ids(wheel, 1025) == std::vector<int> { 1 });
+    // cancelled
+    wheel.cancel(&t[2]);
+    CHECK(expired_ids(wheel, 1040).empty());
+    // postponed without rescheduling (as touch() does), moved to its new slot when the old one is visited
+    t[5].expires = 1130;
+    CHECK(expired_ids(wheel, 1100).empty());
+    // more than one revolution ahead: its slot is visited before, but it isn't expired
+    CHECK(expired_ids(wheel, 1129).empty());
+    CHECK(expired_ids(wheel, 1139) == std::vector<int> { 5 });
+    // a jump over more than one revolution expires everything due
+    CHECK(expired_ids(wheel, 5000) == std::vector<int> { 3 });
+    CHECK(expired_ids(wheel, 6000).empty());
+}
+
+/**
+ * @brief Echoes every message back and records the events of the peers
+ */
+class EchoServer: public DtlsServer {
+public:
+    std::atomic<int> connects{0};
+    std::atomic<int> closes{0};
+    std::atomic<int> last_port{0};  // port of the peer, which sent the last message
+
+protected:
+    void on_connect(Peer &peer) override
+    {
+        connects++;
+    }
+    void on_receive(Peer &peer, const unsigned char *data, size_t len) override
+    {
+        last_port = ntohs(reinterpret_cast<const sockaddr_in *>(peer.address())->sin_port);
+        peer.write(data, len);
+    }
+    void on_close(Peer &peer) override
+    {
+        closes++;
+    }
+};
+
+/**
+ * @brief DTLS client on a connected UDP socket, which could be replaced in the same session
+ */
+class Client: public Tls {
+public:
+    ~Client() override
+    {
+        if (sock >= 0) {
+            ::close(sock);
+        }
+    }
+    int send(const unsigned char *buf, size_t len) override
+    {
+        return ::send(sock, buf, len, 0);
+    }
+    int recv(unsigned char *buf, size_t len) override
+    {
+        int ret = ::recv(sock, buf, len, 0);
+        // handshake record of epoch 0, its first message is HelloVerifyRequest
+        if (ret > hello_verify_offset && buf[0] == MBEDTLS_SSL_MSG_HANDSHAKE && buf[3] == 0 && buf[4] == 0 &&
+                buf[hello_verify_offset] == MBEDTLS_SSL_HS_HELLO_VERIFY_REQUEST) {
+            hello_verify_requests++;
+        }
+        return ret;
+    }
+    int recv_timeout(unsigned char *buf, size_t len, int timeout) override
+    {
+        struct timeval tv {
+            timeout / 1000, (timeout % 1000 ) * 1000
+        };
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(sock, &read_fds);
+        int ret = select(sock + 1, &read_fds, nullptr, nullptr, timeout == 0 ? nullptr : &tv);
+        if (ret == 0) {
+            return MBEDTLS_ERR_SSL_TIMEOUT;
+        }
+        if (ret < 0) {
+            return errno == EINTR ? MBEDTLS_ERR_SSL_WANT_READ : ret;
+        }
+        return recv(buf, len);
+    }
+    /**
+     * @brief Opens a new socket with another local port, as if NAT changed the client's address
+     */
+    bool rebind()
+    {
+        if (sock >= 0) {
+            ::close(sock);
+        }
+        sock = connected_socket();
+        return sock >= 0;
+    }
+    int local_port() const
+    {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        return getsockname(sock, reinterpret_cast<sockaddr *>(&addr), &len) == 0 ? ntohs(addr.sin_port) : -1;
+    }
+    bool open(const SharedConfig::ptr &config)
+    {
+        // the client doesn't change the server's address, its own connection ID is empty
+        return rebind() && init(config) && set_hostname(get_server_cn()) && set_cid(const_buf{}) && handshake() == 0;
+    }
+    bool echo(const char *message)
+    {
+        unsigned char reply[64];
+        int len = strlen(message);
+        if (write(reinterpret_cast<const unsigned char *>(message), len) != len) {
+            return false;
+        }
+        return read(reply, sizeof(reply)) == len && memcmp(reply, message, len) == 0;
+    }
+    static int connected_socket()
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int hello_verify_requests{0};
+
+private:
+    static constexpr int hello_verify_offset = 13;  // type of the first handshake message, after the record header
+    int sock{-1};
+};
+
+/**
+ * @brief Runs the blocking client code while the server is polled in another thread
+ */
+void with_server(EchoServer &server, const std::function<void()> &client)
+{
+    std::atomic<bool> finished{false};
+    std::thread server_task([&] {
+        while (!finished) {
+            server.poll(tick_ms);
+        }
+    });
+    client();
+    finished = true;
+    server_task.join();
+}
+
+/**
+ * Datagrams of unknown peers, which don't carry a ClientHello with a valid cookie, don't allocate sessions
+ */
+void test_no_session_without_cookie(EchoServer &server)
+{
+    int fd = Client::connected_socket();
+    CHECK(fd >= 0);
+    // handshake record (ClientHello, epoch 0) too short to be parsed, and a random datagram
+    const unsigned char truncated[] = { MBEDTLS_SSL_MSG_HANDSHAKE, 0xfe, 0xfd, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x20, 1 };
+    const unsigned char garbage[] = "not a DTLS record";
+    CHECK(::send(fd, truncated, sizeof(truncated), 0) == sizeof(truncated));
+    CHECK(::send(fd, garbage, sizeof(garbage), 0) == sizeof(garbage));
+    for (int i = 0; i < 5; ++i) {
+        server.poll(tick_ms);
+    }
+    CHECK(server.peers() == 0);
+    ::close(fd);
+}
+
+/**
+ * The first ClientHello is answered by HelloVerifyRequest, the session is created for the second one with the cookie.
+ * The session continues after the client's address changes, identified by the connection ID
+ */
+void test_rebind(EchoServer &server, const SharedConfig::ptr &client_config, Client &client)
+{
+    int first_port = 0;
+    int second_port = 0;
+    with_server(server, [&] {
+        CHECK(client.open(client_config));
+        CHECK(client.hello_verify_requests == 1);
+        CHECK(client.echo("Hello"));
+        first_port = client.local_port();
+    });
+    CHECK(server.peers() == 1);
+    CHECK(server.connects == 1);
+    CHECK(server.last_port == first_port);
+    with_server(server, [&] {
+        CHECK(client.rebind());
+        second_port = client.local_port();
+        CHECK(client.echo("Hello again from a new address"));
+    });
+    CHECK(second_port != first_port);
+    // the same session, no new handshake
+    CHECK(server.peers() == 1);
+    CHECK(server.connects == 1);
+    CHECK(server.closes == 0);
+    CHECK(server.last_port == second_port);
+}
+
+/**
+ * The idle session is removed by the timer wheel
+ */
+void test_idle_expiry(EchoServer &server)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint32_t elapsed = 0;
+    while (server.peers() > 0 && elapsed < 4 * idle_timeout_ms) {
+        server.poll(tick_ms);
+        elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    CHECK(server.peers() == 0);
+    CHECK(server.closes == 1);
+    // expired within a tick (and scheduling slack) after the idle timeout, counted from the last message
+    CHECK(elapsed + tick_ms >= idle_timeout_ms);
+    CHECK(elapsed <= idle_timeout_ms + 4 * tick_ms);
+}
+
+void test_dtls_server()
+{
+    TlsConfig server_config{};
+    server_config.is_dtls = true;
+    server_config.timeout = 5000;
+    server_config.cid_len = cid_len;
+    auto server_shared = SharedConfig::create(Tls::is_server{true}, Tls::do_verify{true},
+    { get_buf(type::servercert), get_buf(type::serverkey), get_buf(type::cacert) }, &server_config);
+    TlsConfig client_config{};
+    client_config.is_dtls = true;
+    client_config.timeout = 5000;
+    auto client_shared = SharedConfig::create(Tls::is_server{false}, Tls::do_verify{true},
+    { get_buf(type::clientcert), get_buf(type::clientkey), get_buf(type::cacert) }, &client_config);
+    if (server_shared == nullptr || client_shared == nullptr) {
+        ESP_LOGE(TAG, "Failed to create the configurations");
+        s_failures++;
+        return;
+    }
+    EchoServer server;
+    DtlsServer::Config config{};
+    config.port = port;
+    config.idle_timeout_ms = idle_timeout_ms;
+    config.tick_ms = tick_ms;
+    if (!server.open(server_shared, config)) {
+        ESP_LOGE(TAG, "Failed to open the server");
+        s_failures++;
+        return;
+    }
+    Client client;
+    test_no_session_without_cookie(server);
+    test_rebind(server, client_shared, client);
+    test_idle_expiry(server);
+}
+
+} // namespace
+
+/**
+ * Linux target only: the server and the client communicate over the loopback interface
+ */
+int main()
+{
+    test_timer_wheel();
+    test_dtls_server();
+    if (s_failures) {
+        ESP_LOGE(TAG, "%d check(s) failed", s_failures);
+        return 1;
+    }
+    ESP_LOGI(TAG, "All checks passed");
+    return 0;
+}
@@ -0,0 +1,621 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl_ciphersuites.h"
+#include "mbedtls_wrap.hpp"
+#include "session_cache.hpp"
+#include "test_certs.hpp"
+
+namespace {
+constexpr auto *TAG = "tls_benchmark";
+constexpr uint32_t dtls_timeout_ms = 5000;
+constexpr size_t max_payload = 16384;   // of one record
+}
+
+using namespace idf::mbedtls_cxx;
+using namespace test_certs;
+
+/**
+ * @brief One end of a TLS session over a local socket pair, or of a DTLS session over UDP loopback
+ */
+class Session: public Tls {
+public:
+    explicit Session(int fd) : Tls(), sock(fd) {}
+    ~Session() override
+    {
+        ::close(sock);
+    }
+    int send(const unsigned char *buf, size_t len) override
+    {
+        if (baud) {
+            std::this_thread::sleep_for(std::chrono::microseconds(len * 10 * 1000000ULL / baud));
+        }
+        int ret = ::send(sock, buf, len, 0);
+        bytes_sent += ret > 0 ? ret : 0;
+        return ret;
+    }
+    int recv(unsigned char *buf, size_t len) override
+    {
+        return ::recv(sock, buf, len, 0);
+    }
+    int recv_timeout(unsigned char *buf, size_t len, int timeout) override
+    {
+        pollfd fds = { sock, POLLIN, 0 };
+        int ret = ::poll(&fds, 1, timeout == 0 ? -1 : timeout);
+        if (ret == 0) {
+            return MBEDTLS_ERR_SSL_TIMEOUT;
+        }
+        return ret < 0 ? ret : recv(buf, len);
+    }
+    const char *ciphersuite()
+    {
+        return mbedtls_ssl_get_ciphersuite(&ssl_);
+    }
+    int fd() const
+    {
+        return sock;
+    }
+    sockaddr_in peer{};     // DTLS server: address of the client, used as its transport ID
+    size_t bytes_sent{0};
+    unsigned baud{0};       // emulates a serial link of this rate (8N1), 0 for no limit
+
+private:
+    int sock;
+};
+
+namespace {
+
+/**
+ * Configuration of one benchmarked setup
+ *
+ * per_session: each session parses the certificates and seeds its random generator (Tls::init(is_server, do_verify)),
+ * otherwise all sessions of one side use the same SharedConfig (Tls::init(SharedConfig::ptr)),
+ * optionally with session tickets, so that the client resumes the previous session, or with a pre-shared key
+ */
+struct Setup {
+    const char *name;
+    bool dtls;
+    bool resumed;
+    SharedConfig::ptr server;   // nullptr for per_session
+    SharedConfig::ptr client;
+    size_t config_bytes;        // heap of both shared configurations
+};
+
+FILE *s_output;
+int s_results;
+
+/*
+ * Heap of mbedtls, counted by its calloc()/free(), to get the peak of one session
+ */
+std::atomic<size_t> s_heap;
+std::atomic<size_t> s_heap_peak;
+
+#if defined(MBEDTLS_PLATFORM_C) && defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+#define HEAP_PEAK_SUPPORTED 1
+
+void *counting_calloc(size_t n, size_t size)
+{
+    void *ptr = calloc(n, size);
+    if (ptr) {
+        size_t now = s_heap += malloc_usable_size(ptr);
+        size_t peak = s_heap_peak;
+        while (now > peak && !s_heap_peak.compare_exchange_weak(peak, now)) {
+        }
+    }
+    return ptr;
+}
+
+void counting_free(void *ptr)
+{
+    if (ptr) {
+        s_heap -= malloc_usable_size(ptr);
+        free(ptr);
+    }
+}
+#else
+#define HEAP_PEAK_SUPPORTED 0
+#endif
+
+bool open_session(Session &s, bool server, const Setup &setup)
+{
+    const_buf client_id = { reinterpret_cast<const unsigned char *>(&s.peer), sizeof(s.peer) };
+    if (setup.server) {
+        if (!s.init(server ? setup.server : setup.client, setup.dtls && server ? client_id : const_buf{})) {
+            return false;
+        }
+    } else {
+        if (!s.set_own_cert(get_buf(server ? type::servercert : type::clientcert),
+                            get_buf(server ? type::serverkey : type::clientkey)) ||
+                !s.set_ca_cert(get_buf(type::cacert)) ||
+                !s.init(Tls::is_server{server}, Tls::do_verify{true})) {
+            return false;
+        }
+    }
+    if (!server && !s.set_hostname(get_server_cn())) {
+        return false;
+    }
+    return s.handshake() == 0;
+}
+
+/**
+ * @brief Creates two UDP sockets on the loopback, connected to each other
+ */
+bool udp_pair(int fd[2], sockaddr_in addr[2])
+{
+    for (int i = 0; i < 2; ++i) {
+        socklen_t len = sizeof(addr[i]);
+        int rcvbuf = 1 << 20;
+        addr[i] = {};
+        addr[i].sin_family = AF_INET;
+        addr[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd[i] = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd[i] < 0 || ::bind(fd[i], reinterpret_cast<sockaddr *>(&addr[i]), sizeof(addr[i])) < 0 ||
+                ::getsockname(fd[i], reinterpret_cast<sockaddr *>(&addr[i]), &len) < 0) {
+            return false;
+        }
+        setsockopt(fd[i], SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    return ::connect(fd[0], reinterpret_cast<sockaddr *>(&addr[1]), sizeof(addr[1])) == 0 &&
+           ::connect(fd[1], reinterpret_cast<sockaddr *>(&addr[0]), sizeof(addr[0])) == 0;
+}
+
+/**
+ * @brief Opens both ends of a session, the server in another thread
+ */
+bool connect_pair(const Setup &setup, std::unique_ptr<Session> &server, std::unique_ptr<Session> &client, int *resumed = nullptr)
+{
+    int fd[2];
+    sockaddr_in addr[2];
+    if (setup.dtls ? !udp_pair(fd, addr) : socketpair(AF_UNIX, SOCK_STREAM, 0, fd) < 0) {
+        ESP_LOGE(TAG, "Failed to create socket pair");
+        return false;
+    }
+    server = std::make_unique<Session>(fd[0]);
+    client = std::make_unique<Session>(fd[1]);
+    if (setup.dtls) {
+        server->peer = addr[1];
+    }
+    bool server_ok = false;
+    std::thread t([&] { server_ok = open_session(*server, true, setup); });
+    bool client_ok = open_session(*client, false, setup);
+    if (!client_ok) {
+        ::shutdown(fd[1], SHUT_RDWR);   // unblocks the TLS server, the DTLS server times out
+    }
+    t.join();
+    if (resumed && client_ok && client->is_resumed()) {
+        ++*resumed;
+    }
+    return server_ok && client_ok;
+}
+
+/**
+ * @brief Sends total bytes in writes of record_size bytes, the receiver acknowledges every window
+ *
+ * The acknowledgements keep DTLS within the socket buffers, as the datagrams lost on the loopback
+ * are not retransmitted.
+ */
+bool send_bulk(Session &s, size_t total, size_t record_size, size_t window)
+{
+    std::vector<unsigned char> data(record_size, 0x5a);
+    size_t sent = 0;
+    while (sent < total) {
+        size_t end = std::min(sent + window, total);
+        while (sent < end) {
+            int ret = s.write(data.data(), std::min(record_size, end - sent));
+            if (ret <= 0) {
+                return false;
+            }
+            sent += ret;
+        }
+        unsigned char ack;
+        if (s.read(&ack, 1) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool receive_bulk(Session &s, size_t total, size_t window)
+{
+    std::vector<unsigned char> data(max_payload);
+    size_t received = 0;
+    while (received < total) {
+        size_t end = std::min(received + window, total);
+        while (received < end) {
+            int ret = s.read(data.data(), std::min(data.size(), end - received));
+            if (ret <= 0) {
+                return false;
+            }
+            received += ret;
+        }
+        const unsigned char ack = 1;
+        if (s.write(&ack, 1) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t bulk_window(bool dtls, size_t record_size)
+{
+    return dtls ? std::min<size_t>(32 * 1024, 32 * record_size) : 1024 * 1024;
+}
+
+/**
+ * @brief Transfers total bytes from the client to the server, returns the time in seconds, negative on failure
+ */
+double transfer(Session &server, Session &client, bool dtls, size_t total, size_t record_size)
+{
+    using namespace std::chrono;
+    size_t window = bulk_window(dtls, record_size);
+    bool server_ok = false;
+    auto start = steady_clock::now();
+    std::thread t([&] { server_ok = receive_bulk(server, total, window); });
+    bool client_ok = send_bulk(client, total, record_size, window);
+    if (!client_ok) {
+        ::shutdown(client.fd(), SHUT_RDWR);
+    }
+    t.join();
+    double secs = duration<double>(steady_clock::now() - start).count();
+    return server_ok && client_ok ? secs : -1;
+}
+
+size_t heap_used()
+{
+    return mallinfo2().uordblks;
+}
+
+void result(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+void result(const char *fmt, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    printf("%s\n", line);
+    if (s_output) {
+        fprintf(s_output, "%s  %s", s_results++ ? ",\n" : "", line);
+    }
+}
+
+const char *transport(bool dtls)
+{
+    return dtls ? "dtls" : "tls";
+}
+
+bool bench_handshakes(const Setup &setup)
+{
+    using namespace std::chrono;
+    int handshakes = 0;
+    int resumed = 0;
+    size_t bytes = 0;
+    if (setup.resumed) {
+        // full handshake, which stores the session with the ticket in the cache
+        std::unique_ptr<Session> server, client;
+        if (!connect_pair(setup, server, client)) {
+            ESP_LOGE(TAG, "Handshake failed (%s)", setup.name);
+            return false;
+        }
+    }
+    auto start = steady_clock::now();
+    auto end = start + milliseconds(CONFIG_TLS_BENCHMARK_DURATION_MS);
+    while (steady_clock::now() < end) {
+        std::unique_ptr<Session> server, client;
+        if (!connect_pair(setup, server, client, &resumed)) {
+            ESP_LOGE(TAG, "Handshake failed (%s)", setup.name);
+            return false;
+        }
+        handshakes++;
+        bytes += server->bytes_sent + client->bytes_sent;
+    }
+    double secs = duration<double>(steady_clock::now() - start).count();
+    result(R"({"test": "handshakes", "config": "%s", "transport": "%s", "handshakes": %d, "resumed": %d, "handshakes_per_sec": %.1f, "avg_ms": %.3f, "bytes_per_handshake": %zu})",
+           setup.name, transport(setup.dtls), handshakes, resumed, handshakes / secs, secs * 1000 / handshakes, bytes / handshakes);
+    if (setup.resumed && resumed != handshakes) {
+        ESP_LOGE(TAG, "Only %d of %d handshakes resumed the session", resumed, handshakes);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Peak of the mbedtls heap of one session (both ends), over its handshake and one record in each direction
+ */
+bool heap_peak(const Setup &setup, std::string &peak)
+{
+#if HEAP_PEAK_SUPPORTED
+    if (setup.resumed) {
+        // the peak of the resumed handshake, the previous one left the session in the cache
+        std::unique_ptr<Session> server, client;
+        if (!connect_pair(setup, server, client)) {
+            return false;
+        }
+    }
+    size_t before = s_heap;
+    s_heap_peak = before;
+    std::unique_ptr<Session> server, client;
+    if (!connect_pair(setup, server, client)) {
+        return false;
+    }
+    size_t record_size = client->get_max_record_size();
+    if (transfer(*server, *client, setup.dtls, record_size, record_size) < 0 ||
+            transfer(*client, *server, setup.dtls, record_size, record_size) < 0) {
+        return false;
+    }
+    peak = std::to_string(s_heap_peak - before);
+#else
+    peak = "null";
+#endif
+    return true;
+}
+
+bool bench_memory(const Setup &setup)
+{
+    constexpr int sessions = CONFIG_TLS_BENCHMARK_SESSIONS;
+    std::string peak;
+    if (!heap_peak(setup, peak)) {
+        ESP_LOGE(TAG, "Handshake failed (%s)", setup.name);
+        return false;
+    }
+    std::vector<std::unique_ptr<Session>> open;
+    open.reserve(2 * sessions);
+    size_t before = heap_used();
+    for (int i = 0; i < sessions; ++i) {
+        std::unique_ptr<Session> server, client;
+        if (!connect_pair(setup, server, client)) {
+            ESP_LOGE(TAG, "Handshake failed (%s)", setup.name);
+            return false;
+        }
+        open.push_back(std::move(server));
+        open.push_back(std::move(client));
+    }
+    size_t per_pair = (heap_used() - before) / sessions;
+    result(R"({"test": "memory", "config": "%s", "transport": "%s", "sessions": %d, "bytes_per_session": %zu, "bytes_per_endpoint": %zu, "shared_config_bytes": %zu, "heap_peak_per_session": %s})",
+           setup.name, transport(setup.dtls), sessions, per_pair, per_pair / 2, setup.config_bytes, peak.c_str());
+    return true;
+}
+
+SharedConfig::ptr create_server(const TlsConfig *config)
+{
+    return SharedConfig::create(Tls::is_server{true}, Tls::do_verify{true},
+    { get_buf(type::servercert), get_buf(type::serverkey), get_buf(type::cacert) }, config);
+}
+
+SharedConfig::ptr create_client(const TlsConfig *config)
+{
+    return SharedConfig::create(Tls::is_server{false}, Tls::do_verify{true},
+    { get_buf(type::clientcert), get_buf(type::clientkey), get_buf(type::cacert) }, config);
+}
+
+Setup make_setup(const char *name, bool dtls, bool resumed, const TlsConfig *config)
+{
+    size_t before = heap_used();
+    Setup setup = { name, dtls, resumed, create_server(config), create_client(config), 0 };
+    setup.config_bytes = heap_used() - before;
+    return setup;
+}
+
+std::vector<std::string> split(const char *list)
+{
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (in >> item) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+/**
+ * @brief Bulk transfer over one session negotiating the ciphersuite, in writes of every configured record size
+ */
+bool bench_bulk(bool dtls, const std::string &name)
+{
+    const int ciphersuites[] = { mbedtls_ssl_get_ciphersuite_id(name.c_str()), 0 };
+    if (ciphersuites[0] == 0) {
+        ESP_LOGW(TAG, "Ciphersuite %s is not supported, skipped", name.c_str());
+        return true;
+    }
+    TlsConfig config{};
+    config.is_dtls = dtls;
+    config.timeout = dtls ? dtls_timeout_ms : 0;
+    config.ciphersuites = ciphersuites;
+    Setup setup = make_setup("bulk", dtls, false, &config);
+    std::unique_ptr<Session> server, client;
+    if (setup.server == nullptr || setup.client == nullptr || !connect_pair(setup, server, client)) {
+        ESP_LOGE(TAG, "Handshake failed (%s, %s)", transport(dtls), name.c_str());
+        return false;
+    }
+    size_t total = CONFIG_TLS_BENCHMARK_BULK_KB * 1024;
+    int max_record = client->get_max_record_size();
+    for (const auto &size : split(CONFIG_TLS_BENCHMARK_RECORD_SIZES)) {
+        int record_size = atoi(size.c_str());
+        if (record_size <= 0 || record_size > max_record) {
+            ESP_LOGW(TAG, "Record size %s exceeds the maximum of %d bytes, skipped", size.c_str(), max_record);
+            continue;
+        }
+        double secs = transfer(*server, *client, dtls, total, record_size);
+        if (secs < 0) {
+            ESP_LOGE(TAG, "Transfer failed (%s, %s, %d)", transport(dtls), name.c_str(), record_size);
+            return false;
+        }
+        result(R"({"test": "bulk", "transport": "%s", "ciphersuite": "%s", "record_size": %d, "bytes": %zu, "mb_per_sec": %.2f})",
+               transport(dtls), client->ciphersuite(), record_size, total, total / secs / 1e6);
+    }
+    return true;
+}
+
+/**
+ * @brief Memory of sessions limited to the fragment length, and the latency of one message over an emulated serial link
+ *
+ * The receiver decrypts a record only when it's complete, so the first byte of the message waits for the whole first record.
+ */
+bool bench_fragment(size_t max_fragment_len)
+{
+    using namespace std::chrono;
+    TlsConfig config{};
+    config.max_fragment_len = max_fragment_len;
+    std::string name = max_fragment_len ? "max_fragment_" + std::to_string(max_fragment_len) : "max_fragment_none";
+    Setup setup = make_setup(name.c_str(), false, false, &config);
+    if (setup.server == nullptr || setup.client == nullptr) {
+        ESP_LOGE(TAG, "Failed to create the configurations (%s)", setup.name);
+        return false;
+    }
+    if (!bench_memory(setup)) {
+        return false;
+    }
+    std::unique_ptr<Session> server, client;
+    if (!connect_pair(setup, server, client)) {
+        ESP_LOGE(TAG, "Handshake failed (%s)", setup.name);
+        return false;
+    }
+    constexpr size_t len = CONFIG_TLS_BENCHMARK_LATENCY_MESSAGE;
+    std::vector<unsigned char> message(len, 0x5a);
+    steady_clock::time_point first, last;
+    bool server_ok = false;
+    client->baud = CONFIG_TLS_BENCHMARK_LINK_BAUD;
+    auto start = steady_clock::now();
+    std::thread t([&] {
+        std::vector<unsigned char> data(max_payload);
+        size_t received = 0;
+        while (received < len) {
+            int ret = server->read(data.data(), data.size());
+            if (ret <= 0) {
+                return;
+            }
+            if (received == 0) {
+                first = steady_clock::now();
+            }
+            received += ret;
+        }
+        last = steady_clock::now();
+        server_ok = true;
+    });
+    size_t sent = 0;
+    while (sent < len) {
+        int ret = client->write(message.data() + sent, len - sent);
+        if (ret <= 0) {
+            ::shutdown(client->fd(), SHUT_RDWR);
+            break;
+        }
+        sent += ret;
+    }
+    t.join();
+    if (!server_ok) {
+        ESP_LOGE(TAG, "Transfer failed (%s)", setup.name);
+        return false;
+    }
+    result(R"({"test": "latency", "config": "%s", "max_record": %d, "baud": %d, "message": %zu, "first_byte_ms": %.1f, "last_byte_ms": %.1f})",
+           setup.name, client->get_max_record_size(), CONFIG_TLS_BENCHMARK_LINK_BAUD, len,
+           duration<double, std::milli>(first - start).count(), duration<double, std::milli>(last - start).count());
+    return true;
+}
+
+int run()
+{
+    // all threads allocate from the main arena, which is the one reported by mallinfo2()
+    mallopt(M_ARENA_MAX, 1);
+#if HEAP_PEAK_SUPPORTED
+    mbedtls_platform_set_calloc_free(counting_calloc, counting_free);
+#endif
+
+    TlsConfig resumed_config{};
+    resumed_config.session_tickets = SessionTickets::create();
+    resumed_config.session_cache = std::make_shared<SessionCache>();
+    std::vector<Setup> setups = {
+        { "per_session", false, false, nullptr, nullptr, 0 },
+        make_setup("shared", false, false, nullptr),
+        make_setup("resumed", false, true, &resumed_config)
+    };
+#if CONFIG_TLS_BENCHMARK_PSK
+    static const unsigned char psk[16] = { 0x3c, 0x51, 0x7e, 0x09, 0xa2, 0x6d, 0xf4, 0x18, 0x83, 0xc5, 0x2b, 0x90, 0x47, 0xee, 0x12, 0xd6 };
+    static const unsigned char identity[] = "tls_benchmark";
+    TlsConfig psk_config{};
+    psk_config.auth = TlsAuth::psk;
+    psk_config.psk = { psk, sizeof(psk) };
+    psk_config.psk_identity = { identity, sizeof(identity) - 1 };
+    psk_config.psk_lookup = [](const_buf id) {
+        bool known = id.second == sizeof(identity) - 1 && memcmp(id.first, identity, id.second) == 0;
+        return known ? const_buf{ psk, sizeof(psk) } : const_buf{};
+    };
+    TlsConfig ecdhe_psk_config = psk_config;
+    ecdhe_psk_config.auth = TlsAuth::ecdhe_psk;
+    setups.push_back(make_setup("psk", false, false, &psk_config));
+    setups.push_back(make_setup("ecdhe_psk", false, false, &ecdhe_psk_config));
+#endif
+#if CONFIG_TLS_BENCHMARK_DTLS
+    TlsConfig dtls_config{};
+    dtls_config.is_dtls = true;
+    dtls_config.timeout = dtls_timeout_ms;
+    TlsConfig dtls_resumed_config = dtls_config;
+    dtls_resumed_config.session_tickets = resumed_config.session_tickets;
+    dtls_resumed_config.session_cache = std::make_shared<SessionCache>();   // DTLS sessions apart from TLS ones
+    setups.push_back(make_setup("dtls", true, false, &dtls_config));
+    setups.push_back(make_setup("dtls_resumed", true, true, &dtls_resumed_config));
+#endif
+    for (const auto &setup : setups) {
+        if (strcmp(setup.name, "per_session") != 0 && (setup.server == nullptr || setup.client == nullptr)) {
+            ESP_LOGE(TAG, "Failed to create the configurations (%s)", setup.name);
+            return 1;
+        }
+    }
+
+    s_output = fopen(CONFIG_TLS_BENCHMARK_OUTPUT_FILE, "w");
+    if (s_output) {
+        fprintf(s_output, "[\n");
+    }
+    bool ok = true;
+    for (const auto &setup : setups) {
+        ok = ok && bench_handshakes(setup);
+        ok = ok && bench_memory(setup);
+    }
+#if CONFIG_MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+    for (const auto &len : split(CONFIG_TLS_BENCHMARK_FRAGMENT_LENGTHS)) {
+        ok = ok && bench_fragment(atoi(len.c_str()));
+    }
+#endif
+    for (const auto &name : split(CONFIG_TLS_BENCHMARK_CIPHERSUITES)) {
+        ok = ok && bench_bulk(false, name);
+#if CONFIG_TLS_BENCHMARK_DTLS
+        ok = ok && bench_bulk(true, name);
+#endif
+    }
+    if (s_output) {
+        fprintf(s_output, "\n]\n");
+        fclose(s_output);
+    }
+    return ok ? 0 : 1;
+}
+
+} // namespace
+
+/**
+ * Linux target only: both ends run in this process, the heap is measured by glibc
+ */
+int main()
+{
+    return run();
+}
@@ -0,0 +1,278 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include "esp_log.h"
+#include "tls_writer.hpp"
+#include "test_certs.hpp"
+
+namespace {
+constexpr auto *TAG = "tls_writer_test";
+constexpr size_t record_size = 512;     // max fragment length of the sessions
+int s_failures = 0;
+}
+
+#define CHECK(cond)                                                 \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            ESP_LOGE(TAG, "%s:%d: %s failed", __func__, __LINE__, #cond); \
+            s_failures++;                                           \
+        }                                                           \
+    } while (0)
+
+using namespace idf::mbedtls_cxx;
+using namespace test_certs;
+
+namespace {
+
+/**
+ * @brief One end of a session over in-memory pipes, whose transport could write short or block
+ */
+class Session: public Tls {
+public:
+    Session(std::deque<unsigned char> &in, std::deque<unsigned char> &out) : in_(in), out_(out) {}
+
+    int send(const unsigned char *buf, size_t len) override
+    {
+        if (block_every && ++sends % block_every == 0) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+        len = std::min(len, max_chunk);
+        out_.insert(out_.end(), buf, buf + len);
+        return static_cast<int>(len);
+    }
+
+    int recv(unsigned char *buf, size_t len) override
+    {
+        if (in_.empty()) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+        len = std::min(len, in_.size());
+        std::copy(in_.begin(), in_.begin() + len, buf);
+        in_.erase(in_.begin(), in_.begin() + len);
+        return static_cast<int>(len);
+    }
+
+    /**
+     * @brief Reads all received records, appends their plaintext to the stream
+     *
+     * @return Number of records read
+     */
+    int drain(std::string &stream)
+    {
+        unsigned char buf[2 * record_size];
+        int records = 0;
+        int ret;
+        while ((ret = read(buf, sizeof(buf))) > 0) {
+            stream.append(reinterpret_cast<const char *>(buf), ret);
+            ++records;
+        }
+        CHECK(ret == MBEDTLS_ERR_SSL_WANT_READ);
+        return records;
+    }
+
+    size_t max_chunk{SIZE_MAX};     // bytes written by one send()
+    unsigned block_every{0};        // every n-th send() returns WANT_WRITE, 0 to never block
+    unsigned sends{0};
+
+private:
+    std::deque<unsigned char> &in_;
+    std::deque<unsigned char> &out_;
+};
+
+struct Pair {
+    std::deque<unsigned char> to_server;
+    std::deque<unsigned char> to_client;
+    Session server{to_server, to_client};
+    Session client{to_client, to_server};
+};
+
+SharedConfig::ptr s_server;
+SharedConfig::ptr s_client;
+
+bool connect(Pair &p)
+{
+    if (!p.server.init(s_server) || !p.client.init(s_client) || !p.client.set_hostname(get_server_cn())) {
+        return false;
+    }
+    bool server_done = false;
+    bool client_done = false;
+    for (int i = 0; i < 100 && !(server_done && client_done); ++i) {
+        for (auto [s, done] : { std::pair{&p.server, &server_done}, std::pair{&p.client, &client_done} }) {
+            if (!*done) {
+                Tls::StepResult result = s->step();
+                if (result.status == Tls::state::failed) {
+                    return false;
+                }
+                *done = result.status == Tls::state::done;
+            }
+        }
+    }
+    return server_done && client_done && p.client.get_max_record_size() == static_cast<int>(record_size);
+}
+
+std::string pattern(size_t len)
+{
+    std::string data(len, 0);
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = static_cast<char>('A' + i % 26 + (i / 26) % 7);
+    }
+    return data;
+}
+
+const unsigned char *bytes(const std::string &s)
+{
+    return reinterpret_cast<const unsigned char *>(s.data());
+}
+
+/**
+ * @brief Flushes until everything is sent, every flush() returns 0 or WANT_WRITE
+ */
+void flush_all(TlsWriter &writer)
+{
+    int ret;
+    for (int i = 0; i < 1000 && (ret = writer.flush()) != 0; ++i) {
+        CHECK(ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+    }
+    CHECK(writer.pending() == 0);
+}
+
+/**
+ * Pieces of a message written together go out in one record
+ */
+void test_coalescing()
+{
+    Pair p;
+    CHECK(connect(p));
+    TlsWriter writer(p.client);
+    std::string header = "HDR:", body = pattern(300), trailer = ":END";
+    const_buf bufs[] = { { bytes(header), header.size() }, { bytes(body), body.size() }, { bytes(trailer), trailer.size() } };
+    CHECK(writer.writev(bufs, 3) == static_cast<int>(header.size() + body.size() + trailer.size()));
+    CHECK(writer.pending() == 0);
+    std::string stream;
+    CHECK(p.server.drain(stream) == 1);
+    CHECK(stream == header + body + trailer);
+}
+
+/**
+ * Full records are sent at once, the rest waits for the latency budget or flush()
+ */
+void test_full_records()
+{
+    Pair p;
+    CHECK(connect(p));
+    TlsWriter writer(p.client, 1000);
+    std::string data = pattern(3 * record_size + 100);
+    CHECK(writer.write(bytes(data), data.size()) == static_cast<int>(data.size()));
+    CHECK(writer.pending() == 100);
+    CHECK(writer.expires_in() > 0);
+    std::string stream;
+    CHECK(p.server.drain(stream) == 3);
+    CHECK(writer.flush() == 0);
+    CHECK(p.server.drain(stream) == 1);
+    CHECK(stream == data);
+}
+
+/**
+ * The transport accepts only a few bytes per send()
+ */
+void test_short_writes()
+{
+    Pair p;
+    CHECK(connect(p));
+    p.client.max_chunk = 7;
+    TlsWriter writer(p.client);
+    std::string data = pattern(2 * record_size + 33);
+    CHECK(writer.write(bytes(data), 10) == 10);
+    CHECK(writer.write(bytes(data) + 10, data.size() - 10) == static_cast<int>(data.size() - 10));
+    CHECK(writer.pending() == 0);
+    std::string stream;
+    p.server.drain(stream);
+    CHECK(stream == data);
+}
+
+/**
+ * Data appended behind a record, whose sending was interrupted by WANT_WRITE, are not lost
+ */
+void test_want_write_buffered()
+{
+    Pair p;
+    CHECK(connect(p));
+    p.client.max_chunk = 16;
+    TlsWriter writer(p.client, 1000);
+    std::string first = pattern(10), second = pattern(40).substr(10, 30);
+    CHECK(writer.write(bytes(first), first.size()) == static_cast<int>(first.size()));
+    p.client.block_every = 2;   // the record is encrypted, its second part blocks
+    p.client.sends = 0;
+    CHECK(writer.flush() == MBEDTLS_ERR_SSL_WANT_WRITE);
+    CHECK(writer.write(bytes(second), second.size()) == static_cast<int>(second.size()));
+    flush_all(writer);
+    std::string stream;
+    p.server.drain(stream);
+    CHECK(stream == first + second);
+}
+
+/**
+ * A long stream of writes of various sizes over a transport, which writes short and blocks often
+ */
+void test_want_write_stream()
+{
+    Pair p;
+    CHECK(connect(p));
+    p.client.max_chunk = 64;
+    p.client.block_every = 3;
+    TlsWriter writer(p.client);
+    std::string data = pattern(20 * record_size + 77);
+    std::string stream;
+    size_t done = 0;
+    size_t sizes[] = { 1, 100, record_size, 3 * record_size + 5, 17, record_size - 1 };
+    for (int i = 0; done < data.size() && i < 10000; ++i) {
+        size_t len = std::min(sizes[i % 6], data.size() - done);
+        int ret = writer.write(bytes(data) + done, len);
+        CHECK(ret == MBEDTLS_ERR_SSL_WANT_WRITE || (ret >= 0 && static_cast<size_t>(ret) <= len));
+        if (ret > 0) {
+            done += ret;
+        }
+        p.server.drain(stream);
+    }
+    CHECK(done == data.size());
+    flush_all(writer);
+    p.server.drain(stream);
+    CHECK(stream == data);
+}
+
+} // namespace
+
+/**
+ * Linux target only: both ends of the sessions run in one task
+ */
+int main()
+{
+    TlsConfig config{};
+    config.max_fragment_len = record_size;
+    s_server = SharedConfig::create(Tls::is_server{true}, Tls::do_verify{true},
+    { get_buf(type::servercert), get_buf(type::serverkey), get_buf(type::cacert) }, &config);
+    s_client = SharedConfig::create(Tls::is_server{false}, Tls::do_verify{true},
+    { get_buf(type::clientcert), get_buf(type::clientkey), get_buf(type::cacert) }, &config);
+    if (s_server == nullptr || s_client == nullptr) {
+        ESP_LOGE(TAG, "Failed to create the configurations");
+        return 1;
+    }
+    test_coalescing();
+    test_full_records();
+    test_short_writes();
+    test_want_write_buffered();
+    test_want_write_stream();
+    if (s_failures) {
+        ESP_LOGE(TAG, "%d check(s) failed", s_failures);
+        return 1;
+    }
+    ESP_LOGI(TAG, "All checks passed");
+    return 0;
+}
@@ -3,6 +3,8 @@
  *
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
+#include <chrono>
+#include <cstring>
 #include <thread>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -32,6 +34,14 @@ const bool use_dgrams = false;
 #elif CONFIG_TEST_DTLS
 const bool use_dgrams = true;
 #endif
+
+#if CONFIG_TEST_PSK
+/**
+ * Pre-shared key of the client identity, authenticates both ends without certificates
+ */
+const unsigned char psk[] = { 0x1f, 0x8a, 0x42, 0xd7, 0x65, 0x0c, 0xb3, 0x29, 0x9e, 0x70, 0x14, 0xc8, 0x5b, 0xe6, 0x3d, 0xa1 };
+const unsigned char psk_identity[] = "uart_client";
+#endif
 }
 
 using namespace idf::mbedtls_cxx;
@@ -90,11 +100,26 @@ private:
             const unsigned char client_id[] = "Client1";
             config.client_id = std::make_pair(client_id, sizeof(client_id));
         }
+#if CONFIG_TEST_PSK
+        config.auth = TlsAuth::ecdhe_psk;
+        config.psk = std::make_pair(psk, sizeof(psk));
+        config.psk_identity = std::make_pair(psk_identity, sizeof(psk_identity) - 1);
+        config.psk_lookup = [](const_buf identity) {
+            bool known = identity.second == sizeof(psk_identity) - 1 && memcmp(identity.first, psk_identity, identity.second) == 0;
+            return known ? std::make_pair(psk, sizeof(psk)) : const_buf{};
+        };
+#endif
         if (!init(is_server{server_not_client}, do_verify{true}, &config)) {
             return false;
         }
 
-        return handshake() == 0;
+        auto start = std::chrono::steady_clock::now();
+        if (handshake() != 0) {
+            return false;
+        }
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        ESP_LOGI(TAG, "%s handshake took %lld ms", server_not_client ? "server" : "client", static_cast<long long>(ms));
+        return true;
     }
 
     /**
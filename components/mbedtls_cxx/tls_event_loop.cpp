@@ -0,0 +1,170 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <sys/select.h>
+#include <unistd.h>
+#if CONFIG_IDF_TARGET_LINUX
+#include <sys/epoll.h>
+#endif
+#include "tls_event_loop.hpp"
+
+using namespace idf::mbedtls_cxx;
+
+EventLoop::EventLoop(backend type) : type_(type)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    if (type_ == backend::epoll) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    }
+#endif
+    if (epoll_fd_ < 0) {
+        type_ = backend::select;
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    if (epoll_fd_ >= 0) {
+        ::close(epoll_fd_);
+    }
+}
+
+bool EventLoop::wait(int fd, Tls::state want, int timeout_ms, callback cb)
+{
+    if (fd < 0 || waits_.find(fd) != waits_.end()) {
+        return false;
+    }
+    if (type_ == backend::select && fd >= FD_SETSIZE) {
+        return false;   // FD_SET() would write past the fd_set
+    }
+#if CONFIG_IDF_TARGET_LINUX
+    if (type_ == backend::epoll) {
+        epoll_event ev{};
+        ev.events = (want == Tls::state::want_write ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+        ev.data.fd = fd;
+        // sockets stay registered after their wait completed (disabled by EPOLLONESHOT)
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0 &&
+                (errno != ENOENT || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0)) {
+            return false;
+        }
+    }
+#endif
+    waits_.emplace(fd, Wait{want, timeout_ms < 0 ? -1 : now_ms() + timeout_ms, std::move(cb)});
+    return true;
+}
+
+void EventLoop::handshake(Tls &tls, int fd, std::function<void(int)> done)
+{
+    Tls::StepResult result = tls.step();
+    if (result.status == Tls::state::done) {
+        done(0);
+        return;
+    }
+    if (result.status == Tls::state::failed) {
+        done(result.error);
+        return;
+    }
+    auto next = [this, &tls, fd, done] {
+        handshake(tls, fd, done);
+    };
+    if (!wait(fd, result.status, result.timeout_ms, std::move(next))) {
+        done(MBEDTLS_ERR_SSL_BAD_INPUT_DATA);
+    }
+}
+
+int EventLoop::run_once(int timeout_ms)
+{
+    if (waits_.empty()) {
+        return 0;
+    }
+    int64_t now = now_ms();
+    for (const auto &it : waits_) {
+        if (it.second.deadline >= 0) {
+            int left = static_cast<int>(std::max<int64_t>(it.second.deadline - now, 0));
+            timeout_ms = timeout_ms < 0 ? left : std::min(timeout_ms, left);
+        }
+    }
+    std::vector<int> ready;
+    int ret = type_ == backend::epoll ? wait_epoll(timeout_ms, ready) : wait_select(timeout_ms, ready);
+    if (ret < 0) {
+        return -1;
+    }
+    now = now_ms();
+    for (const auto &it : waits_) {
+        if (it.second.deadline >= 0 && it.second.deadline <= now &&
+                std::find(ready.begin(), ready.end(), it.first) == ready.end()) {
+            ready.push_back(it.first);
+        }
+    }
+    for (int fd : ready) {
+        auto it = waits_.find(fd);
+        if (it == waits_.end()) {
+            continue;
+        }
+        // the callback could wait on the same socket again
+        callback cb = std::move(it->second.cb);
+        waits_.erase(it);
+        cb();
+    }
+    return static_cast<int>(waits_.size());
+}
+
+bool EventLoop::run()
+{
+    int ret;
+    while ((ret = run_once(-1)) > 0) {
+    }
+    return ret == 0;
+}
+
+int EventLoop::wait_select(int timeout_ms, std::vector<int> &ready)
+{
+    fd_set read_fds;
+    fd_set write_fds;
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    int max_fd = -1;
+    for (const auto &it : waits_) {
+        FD_SET(it.first, it.second.want == Tls::state::want_write ? &write_fds : &read_fds);
+        max_fd = std::max(max_fd, it.first);
+    }
+    timeval tv{ timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+    int ret = ::select(max_fd + 1, &read_fds, &write_fds, nullptr, timeout_ms < 0 ? nullptr : &tv);
+    if (ret < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    for (const auto &it : waits_) {
+        if (FD_ISSET(it.first, &read_fds) || FD_ISSET(it.first, &write_fds)) {
+            ready.push_back(it.first);
+        }
+    }
+    return ret;
+}
+
+int EventLoop::wait_epoll(int timeout_ms, std::vector<int> &ready)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    epoll_event events[64];
+    int ret = epoll_wait(epoll_fd_, events, sizeof(events) / sizeof(events[0]), timeout_ms);
+    if (ret < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    for (int i = 0; i < ret; ++i) {
+        ready.push_back(events[i].data.fd);
+    }
+    return ret;
+#else
+    return -1;
+#endif
+}
+
+int64_t EventLoop::now_ms()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
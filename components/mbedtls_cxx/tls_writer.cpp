@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include "tls_writer.hpp"
+
+using namespace idf::mbedtls_cxx;
+
+TlsWriter::TlsWriter(Tls &tls, uint32_t latency_ms) : tls_(tls), latency_ms_(latency_ms) {}
+
+bool TlsWriter::reserve()
+{
+    if (buf_) {
+        return true;
+    }
+    int size = tls_.get_max_record_size();
+    if (size <= 0) {
+        return false;
+    }
+    buf_.reset(new (std::nothrow) unsigned char[size]);
+    size_ = buf_ ? size : 0;
+    return buf_ != nullptr;
+}
+
+int TlsWriter::send(const unsigned char *buf, size_t len)
+{
+    size_t sent = 0;
+    while (sent < len) {
+        // after WANT_WRITE/WANT_READ mbedtls holds the encrypted record and returns the length passed
+        // to the next call, which has to be the same data as the record
+        size_t chunk = retry_len_ ? retry_len_ : std::min(len - sent, size_);
+        int ret = tls_.write(buf + sent, chunk);
+        if (ret < 0) {
+            if (ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ) {
+                retry_len_ = chunk;
+            }
+            return sent > 0 ? static_cast<int>(sent) : ret;
+        }
+        retry_len_ = 0;
+        sent += ret;
+    }
+    return static_cast<int>(sent);
+}
+
+int TlsWriter::flush()
+{
+    if (len_ == 0) {
+        return 0;
+    }
+    int ret = send(buf_.get(), len_);
+    if (ret < 0) {
+        return ret;
+    }
+    len_ -= ret;
+    if (len_ > 0) {
+        memmove(buf_.get(), buf_.get() + ret, len_);
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    return 0;
+}
+
+int TlsWriter::append(const unsigned char *buf, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        if (len_ == 0 && len - done >= size_) {
+            // full records are sent directly from the caller's buffer
+            int ret = send(buf + done, (len - done) / size_ * size_);
+            if (ret < 0 && retry_len_ == 0) {
+                return done > 0 ? static_cast<int>(done) : ret;
+            }
+            done += std::max(ret, 0);
+            if (retry_len_) {
+                // the transport is busy, the record held by mbedtls is kept to be retried with the same data
+                memcpy(buf_.get(), buf + done, retry_len_);
+                len_ = retry_len_;
+                done += retry_len_;
+                deadline_ = now_ms() + latency_ms_;
+                break;
+            }
+            continue;
+        }
+        if (len_ == 0) {
+            deadline_ = now_ms() + latency_ms_;
+        }
+        size_t chunk = std::min(size_ - len_, len - done);
+        memcpy(buf_.get() + len_, buf + done, chunk);
+        len_ += chunk;
+        done += chunk;
+        if (len_ == size_) {
+            int ret = flush();
+            if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+                return ret;
+            }
+            if (len_ == size_) {
+                break;  // nothing sent, the buffer is still full
+            }
+        }
+    }
+    return static_cast<int>(done);
+}
+
+int TlsWriter::write(const unsigned char *buf, size_t len)
+{
+    const_buf one{buf, len};
+    return writev(&one, 1);
+}
+
+int TlsWriter::writev(const const_buf *bufs, size_t count)
+{
+    if (!reserve()) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int ret = append(bufs[i].first, bufs[i].second);
+        if (ret < 0) {
+            return total > 0 ? static_cast<int>(total) : ret;
+        }
+        total += ret;
+        if (static_cast<size_t>(ret) < bufs[i].second) {
+            break;
+        }
+    }
+    if (!corked_ && latency_ms_ == 0) {
+        int ret = flush();
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return ret;
+        }
+    }
+    return static_cast<int>(total);
+}
+
+void TlsWriter::cork()
+{
+    corked_ = true;
+}
+
+int TlsWriter::uncork()
+{
+    corked_ = false;
+    return flush();
+}
+
+int TlsWriter::poll()
+{
+    if (len_ == 0 || corked_ || now_ms() < deadline_) {
+        return 0;
+    }
+    return flush();
+}
+
+int TlsWriter::expires_in() const
+{
+    if (len_ == 0 || corked_) {
+        return -1;
+    }
+    uint64_t now = now_ms();
+    return deadline_ > now ? static_cast<int>(deadline_ - now) : 0;
+}
+
+uint64_t TlsWriter::now_ms()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}